@@ -21,10 +21,14 @@
 #include <direct.h>
 #endif
 #include <sys/stat.h>
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <sys/mman.h>
+#endif
 #include <string>
 #include "OnDiskWrapper.h"
 #include "moses/Util.h"
 #include "util/exception.hh"
+#include "util/file.hh"
 #include "util/string_stream.hh"
 
 using namespace std;
@@ -58,20 +62,9 @@ void OnDiskWrapper::BeginLoad(const std::string &filePath)
 
 bool OnDiskWrapper::OpenForLoad(const std::string &filePath)
 {
-  m_fileSource.open((filePath + "/Source.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileSource.is_open(),
-                util::FileOpenException,
-                "Couldn't open file " << filePath << "/Source.dat");
-
-  m_fileTargetInd.open((filePath + "/TargetInd.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileTargetInd.is_open(),
-                util::FileOpenException,
-                "Couldn't open file " << filePath << "/TargetInd.dat");
-
-  m_fileTargetColl.open((filePath + "/TargetColl.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileTargetColl.is_open(),
-                util::FileOpenException,
-                "Couldn't open file " << filePath << "/TargetColl.dat");
+  MapForLoad(filePath + "/Source.dat", m_memSource);
+  MapForLoad(filePath + "/TargetInd.dat", m_memTargetInd);
+  MapForLoad(filePath + "/TargetColl.dat", m_memTargetColl);
 
   m_fileVocab.open((filePath + "/Vocab.dat").c_str(), ios::in);
   UTIL_THROW_IF(!m_fileVocab.is_open(),
@@ -92,6 +85,31 @@ bool OnDiskWrapper::OpenForLoad(const std::string &filePath)
   return true;
 }
 
+void OnDiskWrapper::MapForLoad(const std::string &path, util::scoped_memory &mem)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(path.c_str()));
+  uint64_t size = util::SizeOrThrow(file.get());
+  if (size == 0) {
+    return;
+  }
+  util::MapRead(util::LAZY, file.get(), 0, size, mem);
+
+#if !defined(_WIN32) && !defined(_WIN64)
+  // lookups jump between nodes and phrases, read ahead is mostly wasted
+  madvise(mem.get(), mem.size(), MADV_RANDOM);
+#endif
+}
+
+void OnDiskWrapper::WillNeed(const char *mem, size_t size) const
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+  // madvise wants the start of a page
+  uintptr_t page = util::SizePage();
+  uintptr_t begin = (uintptr_t) mem & ~(page - 1);
+  madvise((void*) begin, (uintptr_t) mem + size - begin, MADV_WILLNEED);
+#endif
+}
+
 bool OnDiskWrapper::LoadMisc()
 {
   char line[100000];
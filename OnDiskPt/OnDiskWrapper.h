@@ -22,6 +22,7 @@
 #include <fstream>
 #include "Vocab.h"
 #include "PhraseNode.h"
+#include "util/mmap.hh"
 
 namespace OnDiskPt
 {
@@ -44,9 +45,13 @@ protected:
 
   std::map<std::string, uint64_t> m_miscInfo;
 
+  // when loading, the source trie and target phrases are read in place
+  util::scoped_memory m_memSource, m_memTargetInd, m_memTargetColl;
+
   void SaveMisc();
   bool OpenForLoad(const std::string &filePath);
   bool LoadMisc();
+  void MapForLoad(const std::string &path, util::scoped_memory &mem);
 
 public:
   static int VERSION_NUM;
@@ -83,6 +88,19 @@ public:
     return m_fileVocab;
   }
 
+  const char *GetMemSource() const {
+    return (const char*) m_memSource.get();
+  }
+  const char *GetMemTargetInd() const {
+    return (const char*) m_memTargetInd.get();
+  }
+  const char *GetMemTargetColl() const {
+    return (const char*) m_memTargetColl.get();
+  }
+
+  //! ask the kernel to read ahead part of a mapped file, eg. the children of a node
+  void WillNeed(const char *mem, size_t size) const;
+
   size_t GetNumSourceFactors() const {
     return m_numSourceFactors;
   }
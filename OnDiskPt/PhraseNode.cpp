@@ -23,6 +23,7 @@
 #include "SourcePhrase.h"
 #include "moses/Util.h"
 #include "util/exception.hh"
+#include "util/mmap.hh"
 
 using namespace std;
 
@@ -53,28 +54,21 @@ PhraseNode::PhraseNode(uint64_t filePos, OnDiskWrapper &onDiskWrapper)
 
   size_t countSize = onDiskWrapper.GetNumCounts();
 
-  std::fstream &file = onDiskWrapper.GetFileSource();
-  file.seekg(filePos);
-  assert(filePos == (uint64_t)file.tellg());
-
-  file.read((char*) &m_numChildrenLoad, sizeof(uint64_t));
+  // the node is decoded in place from the mapped source file
+  m_memLoad = onDiskWrapper.GetMemSource() + filePos;
+  m_numChildrenLoad = ((const uint64_t*)m_memLoad)[0];
 
   size_t memAlloc = GetNodeSize(m_numChildrenLoad, onDiskWrapper.GetSourceWordSize(), countSize);
-  m_memLoad = (char*) malloc(memAlloc);
-
-  // go to start of node again
-  file.seekg(filePos);
-  assert(filePos == (uint64_t)file.tellg());
-
-  // read everything into memory
-  file.read(m_memLoad, memAlloc);
-  assert(filePos + memAlloc == (uint64_t)file.tellg());
+  if (memAlloc > util::SizePage()) {
+    // binary search over many children touches several pages
+    onDiskWrapper.WillNeed(m_memLoad, memAlloc);
+  }
 
   // get value
-  m_value = ((uint64_t*)m_memLoad)[1];
+  m_value = ((const uint64_t*)m_memLoad)[1];
 
   // get counts
-  float *memFloat = (float*) (m_memLoad + sizeof(uint64_t) * 2);
+  const float *memFloat = (const float*) (m_memLoad + sizeof(uint64_t) * 2);
 
   assert(countSize == 1);
   m_counts[0] = memFloat[0];
@@ -84,7 +78,6 @@ PhraseNode::PhraseNode(uint64_t filePos, OnDiskWrapper &onDiskWrapper)
 
 PhraseNode::~PhraseNode()
 {
-  free(m_memLoad);
 }
 
 float PhraseNode::GetCount(size_t ind) const
@@ -228,7 +221,7 @@ void PhraseNode::GetChild(Word &wordFound, uint64_t &childFilePos, size_t ind, O
   size_t wordSize = onDiskWrapper.GetSourceWordSize();
   size_t childSize = wordSize + sizeof(uint64_t);
 
-  char *currMem = m_memLoad
+  const char *currMem = m_memLoad
                   + sizeof(uint64_t) * 2 // size & file pos of target phrase coll
                   + sizeof(float) * onDiskWrapper.GetNumCounts() // count info
                   + childSize * ind;
@@ -19,6 +19,7 @@
  ***********************************************************************/
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "moses/Util.h"
 #include "TargetPhraseCollection.h"
@@ -114,32 +115,30 @@ void TargetPhraseCollection::Save(OnDiskWrapper &onDiskWrapper)
 
 void TargetPhraseCollection::ReadFromFile(size_t tableLimit, uint64_t filePos, OnDiskWrapper &onDiskWrapper)
 {
-  fstream &fileTPColl = onDiskWrapper.GetFileTargetColl();
-  fstream &fileTP = onDiskWrapper.GetFileTargetInd();
+  const char *memTPColl = onDiskWrapper.GetMemTargetColl() + filePos;
+  const char *memTP = onDiskWrapper.GetMemTargetInd();
 
   size_t numScores = onDiskWrapper.GetNumScores();
 
 
   uint64_t numPhrases;
-
-  uint64_t currFilePos = filePos;
-  fileTPColl.seekg(filePos);
-  fileTPColl.read((char*) &numPhrases, sizeof(uint64_t));
+  memcpy(&numPhrases, memTPColl, sizeof(uint64_t));
 
   // table limit
   if (tableLimit) {
     numPhrases = std::min(numPhrases, (uint64_t) tableLimit);
   }
 
-  currFilePos += sizeof(uint64_t);
+  uint64_t memUsed = sizeof(uint64_t);
 
+  m_coll.reserve(numPhrases);
   for (size_t ind = 0; ind < numPhrases; ++ind) {
     TargetPhrase *tp = new TargetPhrase(numScores);
 
-    uint64_t sizeOtherInfo = tp->ReadOtherInfoFromFile(currFilePos, fileTPColl);
-    tp->ReadFromFile(fileTP);
+    uint64_t sizeOtherInfo = tp->ReadOtherInfoFromMemory(memTPColl + memUsed);
+    tp->ReadFromMemory(memTP);
 
-    currFilePos += sizeOtherInfo;
+    memUsed += sizeOtherInfo;
 
     m_coll.push_back(tp);
   }
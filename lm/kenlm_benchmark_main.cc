@@ -5,6 +5,7 @@
 #include "util/usage.hh"
 
 #include <stdint.h>
+#include <vector>
 
 namespace {
 
@@ -64,56 +65,148 @@ template <class Model, class Width> void QueryFromBytes(const Model &model, int
   std::cerr << "Probability sum is " << total << std::endl;
   std::cout << "Queries: " << completed << std::endl;
   std::cout << "CPU_excluding_load: " << (after - loaded) << "\nCPU_per_query: " << ((after - loaded) / static_cast<double>(completed)) << std::endl;
+  std::cout << "Queries_per_second: " << (static_cast<double>(completed) / (after - loaded)) << std::endl;
   std::cout << "RSSMax: " << util::RSSMax() << std::endl;
 }
 
-template <class Model, class Width> void DispatchFunction(const Model &model, bool query) {
-  if (query) {
-    QueryFromBytes<Model, Width>(model, 0);
-  } else {
-    ConvertToBytes<Model, Width>(model, 0);
+// Same queries and probability sum as QueryFromBytes, but through
+// FullScoreBatch.  Queries within a sentence depend on each other, so each
+// buffer is split into sentences and one word from every sentence is scored
+// per batch.
+template <class Model, class Width> void QueryBatchFromBytes(const Model &model, int fd_in) {
+  const lm::ngram::State *const begin_state = &model.BeginSentenceState();
+  // State carried over from a sentence that crosses the buffer boundary.
+  lm::ngram::State carry = *begin_state;
+  Width kEOS = model.GetVocabulary().EndSentence();
+  Width buf[4096];
+  float probs[4096];
+
+  // Per sentence: start offset, length, and two alternating states.
+  std::vector<std::size_t> starts, lengths;
+  std::vector<lm::ngram::State> states[2];
+  std::vector<const lm::ngram::State*> in;
+  std::vector<lm::ngram::State*> out;
+  std::vector<lm::WordIndex> words;
+  std::vector<lm::FullScoreReturn> ret;
+
+  uint64_t completed = 0;
+  double loaded = util::CPUTime();
+
+  std::cout << "CPU_to_load: " << loaded << std::endl;
+
+  double total = 0.0;
+  while (std::size_t got = util::ReadOrEOF(fd_in, buf, sizeof(buf))) {
+    UTIL_THROW_IF2(got % sizeof(Width), "File size not a multiple of vocab id size " << sizeof(Width));
+    got /= sizeof(Width);
+    completed += got;
+
+    starts.clear();
+    lengths.clear();
+    std::size_t longest = 0;
+    for (std::size_t begin = 0; begin < got;) {
+      std::size_t end = begin;
+      while (end < got && buf[end++] != kEOS) {}
+      starts.push_back(begin);
+      lengths.push_back(end - begin);
+      longest = std::max(longest, end - begin);
+      begin = end;
+    }
+    for (unsigned int i = 0; i < 2; ++i) states[i].resize(starts.size());
+
+    for (std::size_t pos = 0; pos < longest; ++pos) {
+      std::vector<lm::ngram::State> &from = states[pos & 1], &to = states[(pos + 1) & 1];
+      in.clear();
+      out.clear();
+      words.clear();
+      for (std::size_t s = 0; s < starts.size(); ++s) {
+        if (pos >= lengths[s]) continue;
+        if (pos) {
+          in.push_back(&from[s]);
+        } else {
+          in.push_back(s ? begin_state : &carry);
+        }
+        out.push_back(&to[s]);
+        words.push_back(buf[starts[s] + pos]);
+      }
+      ret.resize(in.size());
+      model.FullScoreBatch(&in[0], &words[0], &out[0], &ret[0], in.size());
+      for (std::size_t s = 0, q = 0; s < starts.size(); ++s) {
+        if (pos < lengths[s]) probs[starts[s] + pos] = ret[q++].prob;
+      }
+    }
+
+    // Sum in the same order as QueryFromBytes.
+    float sum = 0.0;
+    for (std::size_t i = 0; i < got; ++i) {
+      sum += probs[i];
+    }
+    total += sum;
+
+    carry = (buf[got - 1] == kEOS) ? *begin_state : states[lengths.back() & 1].back();
+  }
+  double after = util::CPUTime();
+  std::cerr << "Probability sum is " << total << std::endl;
+  std::cout << "Queries: " << completed << std::endl;
+  std::cout << "CPU_excluding_load: " << (after - loaded) << "\nCPU_per_query: " << ((after - loaded) / static_cast<double>(completed)) << std::endl;
+  std::cout << "Queries_per_second: " << (static_cast<double>(completed) / (after - loaded)) << std::endl;
+  std::cout << "RSSMax: " << util::RSSMax() << std::endl;
+}
+
+enum Command { kVocab, kQuery, kBatch };
+
+template <class Model, class Width> void DispatchFunction(const Model &model, Command command) {
+  switch (command) {
+    case kVocab:
+      ConvertToBytes<Model, Width>(model, 0);
+      break;
+    case kQuery:
+      QueryFromBytes<Model, Width>(model, 0);
+      break;
+    case kBatch:
+      QueryBatchFromBytes<Model, Width>(model, 0);
+      break;
   }
 }
 
-template <class Model> void DispatchWidth(const char *file, bool query) {
+template <class Model> void DispatchWidth(const char *file, Command command) {
   lm::ngram::Config config;
   config.load_method = util::READ;
   std::cerr << "Using load_method = READ." << std::endl;
   Model model(file, config);
   lm::WordIndex bound = model.GetVocabulary().Bound();
   if (bound <= 256) {
-    DispatchFunction<Model, uint8_t>(model, query);
+    DispatchFunction<Model, uint8_t>(model, command);
   } else if (bound <= 65536) {
-    DispatchFunction<Model, uint16_t>(model, query);
+    DispatchFunction<Model, uint16_t>(model, command);
   } else if (bound <= (1ULL << 32)) {
-    DispatchFunction<Model, uint32_t>(model, query);
+    DispatchFunction<Model, uint32_t>(model, command);
   } else {
-    DispatchFunction<Model, uint64_t>(model, query);
+    DispatchFunction<Model, uint64_t>(model, command);
   }
 }
 
-void Dispatch(const char *file, bool query) {
+void Dispatch(const char *file, Command command) {
   using namespace lm::ngram;
   lm::ngram::ModelType model_type;
   if (lm::ngram::RecognizeBinary(file, model_type)) {
     switch(model_type) {
       case PROBING:
-        DispatchWidth<lm::ngram::ProbingModel>(file, query);
+        DispatchWidth<lm::ngram::ProbingModel>(file, command);
         break;
       case REST_PROBING:
-        DispatchWidth<lm::ngram::RestProbingModel>(file, query);
+        DispatchWidth<lm::ngram::RestProbingModel>(file, command);
         break;
       case TRIE:
-        DispatchWidth<lm::ngram::TrieModel>(file, query);
+        DispatchWidth<lm::ngram::TrieModel>(file, command);
         break;
       case QUANT_TRIE:
-        DispatchWidth<lm::ngram::QuantTrieModel>(file, query);
+        DispatchWidth<lm::ngram::QuantTrieModel>(file, command);
         break;
       case ARRAY_TRIE:
-        DispatchWidth<lm::ngram::ArrayTrieModel>(file, query);
+        DispatchWidth<lm::ngram::ArrayTrieModel>(file, command);
         break;
       case QUANT_ARRAY_TRIE:
-        DispatchWidth<lm::ngram::QuantArrayTrieModel>(file, query);
+        DispatchWidth<lm::ngram::QuantArrayTrieModel>(file, command);
         break;
       default:
         UTIL_THROW(util::Exception, "Unrecognized kenlm model type " << model_type);
@@ -126,7 +219,7 @@ void Dispatch(const char *file, bool query) {
 } // namespace
 
 int main(int argc, char *argv[]) {
-  if (argc != 3 || (strcmp(argv[1], "vocab") && strcmp(argv[1], "query"))) {
+  if (argc != 3 || (strcmp(argv[1], "vocab") && strcmp(argv[1], "query") && strcmp(argv[1], "batch"))) {
     std::cerr
       << "Benchmark program for KenLM.  Intended usage:\n"
       << "#Convert text to vocabulary ids offline.  These ids are tied to a model.\n"
@@ -134,9 +227,14 @@ int main(int argc, char *argv[]) {
       << "#Ensure files are in RAM.\n"
       << "cat $text.vocab $model >/dev/null\n"
       << "#Timed query against the model.\n"
-      << argv[0] << " query $model <$text.vocab\n";
+      << argv[0] << " query $model <$text.vocab\n"
+      << "#Same queries through the batched, prefetching FullScoreBatch.\n"
+      << argv[0] << " batch $model <$text.vocab\n";
     return 1;
   }
-  Dispatch(argv[2], !strcmp(argv[1], "query"));
+  Command command = kVocab;
+  if (!strcmp(argv[1], "query")) command = kQuery;
+  if (!strcmp(argv[1], "batch")) command = kBatch;
+  Dispatch(argv[2], command);
   return 0;
 }
@@ -139,6 +139,20 @@ template <class Search, class VocabularyT> FullScoreReturn GenericModel<Search,
   return ret;
 }
 
+template <class Search, class VocabularyT> void GenericModel<Search, VocabularyT>::FullScoreBatch(const State *const *in_states, const WordIndex *new_words, State *const *out_states, FullScoreReturn *ret, std::size_t count) const {
+  // How many queries ahead to prefetch.  Enough to cover memory latency
+  // without evicting the buckets before they are used.
+  const std::size_t kPrefetchDistance = 8;
+  std::size_t ahead = std::min(count, kPrefetchDistance);
+  for (std::size_t i = 0; i < ahead; ++i) {
+    Prefetch(*in_states[i], new_words[i]);
+  }
+  for (std::size_t i = 0; i < count; ++i, ++ahead) {
+    if (ahead < count) Prefetch(*in_states[ahead], new_words[ahead]);
+    ret[i] = FullScore(*in_states[i], new_words[i], *out_states[i]);
+  }
+}
+
 template <class Search, class VocabularyT> FullScoreReturn GenericModel<Search, VocabularyT>::FullScoreForgotState(const WordIndex *context_rbegin, const WordIndex *context_rend, const WordIndex new_word, State &out_state) const {
   context_rend = std::min(context_rend, context_rbegin + P::Order() - 1);
   FullScoreReturn ret = ScoreExceptBackoff(context_rbegin, context_rend, new_word, out_state);
@@ -56,6 +56,15 @@ template <class Search, class VocabularyT> class GenericModel : public base::Mod
      */
     FullScoreReturn FullScore(const State &in_state, const WordIndex new_word, State &out_state) const;
 
+    /* Score count independent queries:
+     *   ret[i] = FullScore(*in_states[i], new_words[i], *out_states[i])
+     * Results are identical to calling FullScore in a loop, but the hash
+     * table probes of later queries are prefetched while earlier ones are
+     * scored so their cache misses overlap.  No out_states[i] may alias any
+     * of the in_states.
+     */
+    void FullScoreBatch(const State *const *in_states, const WordIndex *new_words, State *const *out_states, FullScoreReturn *ret, std::size_t count) const;
+
     /* Slower call without in_state.  Try to remember state, but sometimes it
      * would cost too much memory or your decoder isn't setup properly.
      * To use this function, make an array of WordIndex containing the context
@@ -93,6 +102,15 @@ template <class Search, class VocabularyT> class GenericModel : public base::Mod
         // Amount of additional content that should be considered by the next call.
         unsigned char &next_use) const;
 
+    /* Hint that FullScore(in_state, new_word, ...) will be called soon.  For
+     * probing models this prefetches the hash table buckets the query will
+     * start at.  Issue it for several independent queries before scoring any
+     * of them so their cache misses overlap.
+     */
+    void Prefetch(const State &in_state, const WordIndex new_word) const {
+      search_.Prefetch(in_state.words, in_state.words + in_state.length, new_word);
+    }
+
     /* Return probabilities minus rest costs for an array of pointers.  The
      * first length should be the length of the n-gram to which pointers_begin
      * points.
@@ -278,6 +278,44 @@ template <class M> void Stateless(const M &model) {
   BOOST_CHECK_EQUAL(static_cast<WordIndex>(0), state.words[0]);
 }
 
+template <class M> void BatchTest(const M &model) {
+  const char *words[] = {"looking", "on", "a", "little", "the", "biarritz", "not_found", "more", ".", "</s>", "loin", "also", "would", "consider"};
+  const std::size_t kWords = sizeof(words) / sizeof(const char*);
+
+  // A mix of contexts: every prefix of a sentence plus the null context.
+  std::vector<State> contexts(1, model.BeginSentenceState());
+  for (std::size_t i = 0; i < 5; ++i) {
+    State next;
+    model.FullScore(contexts.back(), model.GetVocabulary().Index(words[i]), next);
+    contexts.push_back(next);
+  }
+  contexts.push_back(model.NullContextState());
+
+  std::vector<const State*> in;
+  std::vector<WordIndex> new_words;
+  for (std::size_t c = 0; c < contexts.size(); ++c) {
+    for (std::size_t w = 0; w < kWords; ++w) {
+      in.push_back(&contexts[c]);
+      new_words.push_back(model.GetVocabulary().Index(words[w]));
+    }
+  }
+  std::vector<State> out(in.size());
+  std::vector<State*> out_ptrs(in.size());
+  for (std::size_t i = 0; i < out.size(); ++i) out_ptrs[i] = &out[i];
+  std::vector<FullScoreReturn> ret(in.size());
+  model.FullScoreBatch(&in[0], &new_words[0], &out_ptrs[0], &ret[0], in.size());
+
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    State expect_state;
+    FullScoreReturn expect = model.FullScore(*in[i], new_words[i], expect_state);
+    BOOST_CHECK_EQUAL(expect.prob, ret[i].prob);
+    BOOST_CHECK_EQUAL(expect.rest, ret[i].rest);
+    BOOST_CHECK_EQUAL(static_cast<unsigned int>(expect.ngram_length), static_cast<unsigned int>(ret[i].ngram_length));
+    BOOST_CHECK_EQUAL(expect.independent_left, ret[i].independent_left);
+    BOOST_CHECK_EQUAL(expect_state, out[i]);
+  }
+}
+
 template <class M> void NoUnkCheck(const M &model) {
   WordIndex unk_index = 0;
   State state;
@@ -294,6 +332,7 @@ template <class M> void Everything(const M &m) {
   MinimalState(m);
   ExtendLeftTest(m);
   Stateless(m);
+  BatchTest(m);
 }
 
 class ExpectEnumerateVocab : public EnumerateVocab {
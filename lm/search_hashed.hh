@@ -125,6 +125,22 @@ template <class Value> class HashedSearch {
       return LongestPointer(found->value.prob);
     }
 
+    // Prefetch every bucket that scoring new_word after [context_rbegin,
+    // context_rend) will start probing at.  The hashes only depend on word ids
+    // so, unlike the lookups themselves, these do not wait on each other.
+    void Prefetch(const WordIndex *context_rbegin, const WordIndex *context_rend, WordIndex new_word) const {
+      unigram_.Prefetch(new_word);
+      Node node = static_cast<Node>(new_word);
+      for (unsigned char order_minus_2 = 0; context_rbegin != context_rend; ++context_rbegin, ++order_minus_2) {
+        node = CombineWordHash(node, *context_rbegin);
+        if (order_minus_2 == middle_.size()) {
+          longest_.Prefetch(node);
+          return;
+        }
+        middle_[order_minus_2].Prefetch(node);
+      }
+    }
+
     // Generate a node without necessarily checking that it actually exists.
     // Optionally return false if it's know to not exist.
     bool FastMakeNode(const WordIndex *begin, const WordIndex *end, Node &node) const {
@@ -164,6 +180,12 @@ template <class Value> class HashedSearch {
           return unigram_[index];
         }
 
+        void Prefetch(WordIndex index) const {
+#if defined(__GNUC__)
+          __builtin_prefetch(unigram_ + index);
+#endif
+        }
+
         typename Value::Weights &Unknown() { return unigram_[0]; }
 
         // For building.
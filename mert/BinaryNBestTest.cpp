@@ -0,0 +1,196 @@
+#include "moses/BinaryNBest.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "util/exception.hh"
+
+#define BOOST_TEST_MODULE MertBinaryNBest
+#include <boost/test/unit_test.hpp>
+
+using namespace Moses;
+
+namespace
+{
+
+class TempFile
+{
+public:
+  TempFile()
+    : m_path((boost::filesystem::temp_directory_path() /
+              boost::filesystem::unique_path("binary_nbest_test_%%%%%%")).string()) {}
+  ~TempFile() {
+    boost::filesystem::remove(m_path);
+  }
+  const std::string &path() const {
+    return m_path;
+  }
+private:
+  std::string m_path;
+};
+
+std::vector<std::pair<std::string, std::size_t> > Labels()
+{
+  std::vector<std::pair<std::string, std::size_t> > labels;
+  labels.push_back(std::make_pair("LM0", 2));
+  labels.push_back(std::make_pair("TM0", 1));
+  return labels;
+}
+
+std::vector<float> Dense(float a, float b, float c)
+{
+  std::vector<float> dense;
+  dense.push_back(a);
+  dense.push_back(b);
+  dense.push_back(c);
+  return dense;
+}
+
+const std::vector<std::pair<std::string, float> > kNoSparse;
+
+void WriteFile(const std::string &path, const std::string &data, std::size_t size)
+{
+  std::ofstream out(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  out.write(data.data(), size);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(binary_nbest_round_trip)
+{
+  TempFile file;
+  {
+    std::ofstream out(file.path().c_str(), std::ios::out | std::ios::binary);
+    BinaryNBestWriter writer(out, Labels());
+    std::vector<std::pair<std::string, float> > sparse;
+    sparse.push_back(std::make_pair("sp_x", 3));
+    writer.Write(out, 0, "the house ", Dense(-1.5, -2, 0.25), sparse, -4.5, " 0-0 1-1");
+    writer.Write(out, 0, "a house ", Dense(-3, -1, 0.5), kNoSparse, -5, "");
+    writer.Write(out, 1, "house", Dense(1, 2, 3), kNoSparse, 6, "0-0");
+  }
+  BOOST_REQUIRE(BinaryNBestReader::IsBinaryNBest(file.path()));
+  BinaryNBestReader in(file.path());
+  BOOST_REQUIRE_EQUAL(3, in.size());
+
+  BOOST_REQUIRE_EQUAL(2, in.GetLabels().size());
+  BOOST_CHECK_EQUAL("LM0", in.GetLabels()[0].first);
+  BOOST_CHECK_EQUAL(2, in.GetLabels()[0].second);
+  BOOST_CHECK_EQUAL("TM0", in.GetLabels()[1].first);
+  BOOST_CHECK_EQUAL(1, in.GetLabels()[1].second);
+
+  BinaryNBestEntry entry;
+  in.Get(0, entry);
+  BOOST_CHECK_EQUAL(0, entry.sentenceId);
+  BOOST_CHECK_EQUAL(-4.5, entry.totalScore);
+  BOOST_REQUIRE_EQUAL(2, entry.tokenCount);
+  BOOST_CHECK_EQUAL("the", in.GetWord(entry.tokens[0]));
+  BOOST_CHECK_EQUAL("house", in.GetWord(entry.tokens[1]));
+  BOOST_REQUIRE_EQUAL(3, entry.denseCount);
+  BOOST_CHECK_EQUAL(-1.5, entry.dense[0]);
+  BOOST_CHECK_EQUAL(-2, entry.dense[1]);
+  BOOST_CHECK_EQUAL(0.25, entry.dense[2]);
+  BOOST_REQUIRE_EQUAL(1, entry.sparseCount);
+  BOOST_CHECK_EQUAL("sp_x=", in.GetWord(entry.sparse[0].name));
+  BOOST_CHECK_EQUAL(3, entry.sparse[0].value);
+  BOOST_CHECK_EQUAL(" 0-0 1-1", entry.alignment);
+
+  // words are shared between hypotheses
+  const uint32_t house = entry.tokens[1];
+  in.Get(1, entry);
+  BOOST_CHECK_EQUAL(house, entry.tokens[1]);
+  BOOST_CHECK_EQUAL(0, entry.sparseCount);
+  BOOST_CHECK(entry.alignment.empty());
+
+  in.Get(2, entry);
+  BOOST_CHECK_EQUAL(1, entry.sentenceId);
+  BOOST_CHECK_EQUAL(6, entry.totalScore);
+  BOOST_REQUIRE_EQUAL(1, entry.tokenCount);
+  BOOST_CHECK_EQUAL(house, entry.tokens[0]);
+  BOOST_CHECK_EQUAL("0-0", entry.alignment);
+}
+
+// decoding threads encode sentences in any order, and the collector writes
+// them in order of the sentences
+BOOST_AUTO_TEST_CASE(binary_nbest_out_of_order)
+{
+  TempFile file;
+  {
+    std::ofstream out(file.path().c_str(), std::ios::out | std::ios::binary);
+    BinaryNBestWriter writer(out, Labels());
+    std::ostringstream first, second;
+    writer.Write(second, 1, "a house", Dense(1, 2, 3), kNoSparse, 6, "");
+    writer.Write(first, 0, "the house", Dense(4, 5, 6), kNoSparse, 15, "");
+    out << first.str() << second.str();
+  }
+  BinaryNBestReader in(file.path());
+  BOOST_REQUIRE_EQUAL(2, in.size());
+  BinaryNBestEntry entry;
+  in.Get(0, entry);
+  BOOST_CHECK_EQUAL(0, entry.sentenceId);
+  BOOST_REQUIRE_EQUAL(2, entry.tokenCount);
+  BOOST_CHECK_EQUAL("the", in.GetWord(entry.tokens[0]));
+  BOOST_CHECK_EQUAL("house", in.GetWord(entry.tokens[1]));
+  BOOST_CHECK_EQUAL(4, entry.dense[0]);
+  in.Get(1, entry);
+  BOOST_CHECK_EQUAL(1, entry.sentenceId);
+  BOOST_CHECK_EQUAL("a", in.GetWord(entry.tokens[0]));
+}
+
+BOOST_AUTO_TEST_CASE(binary_nbest_dense_count)
+{
+  std::ostringstream out;
+  BinaryNBestWriter writer(out, Labels());
+  std::vector<float> dense(2, 0);
+  BOOST_CHECK_THROW(writer.Write(out, 0, "house", dense, kNoSparse, 0, ""), util::Exception);
+}
+
+BOOST_AUTO_TEST_CASE(binary_nbest_detect_text)
+{
+  TempFile file;
+  {
+    std::ofstream out(file.path().c_str());
+    out << "0 ||| the house ||| LM0= -1 ||| -1\n";
+  }
+  BOOST_CHECK(!BinaryNBestReader::IsBinaryNBest(file.path()));
+}
+
+BOOST_AUTO_TEST_CASE(binary_nbest_truncated)
+{
+  std::ostringstream header, body;
+  BinaryNBestWriter writer(header, Labels());
+  std::vector<std::pair<std::string, float> > sparse;
+  sparse.push_back(std::make_pair("sp_x", 3));
+  writer.Write(body, 0, "the house", Dense(-1.5, -2, 0.25), sparse, -4.5, " 0-0 1-1");
+  const std::string data = header.str() + body.str();
+
+  // a cut between blocks leaves the hypotheses before it, any other throws
+  TempFile file;
+  for (std::size_t size = 9; size < data.size(); ++size) {
+    WriteFile(file.path(), data, size);
+    try {
+      BinaryNBestReader in(file.path());
+      BOOST_CHECK_EQUAL(0, in.size());
+    } catch (const util::Exception &) {
+    }
+  }
+
+  // the hypothesis is the last block: type, record, two tokens, three dense
+  // values, a sparse one and the alignment
+  const std::size_t hypothesis = sizeof(uint32_t) + sizeof(BinaryNBestRecord)
+                                 + 2 * sizeof(uint32_t) + 3 * sizeof(float)
+                                 + sizeof(BinaryNBestSparse) + 8;
+  BOOST_REQUIRE(body.str().size() > hypothesis);
+
+  // without the blocks declaring its words
+  const std::string cut = header.str() + body.str().substr(body.str().size() - hypothesis);
+  WriteFile(file.path(), cut, cut.size());
+  BOOST_CHECK_THROW(BinaryNBestReader in(file.path()), util::Exception);
+
+  WriteFile(file.path(), data, data.size());
+  BinaryNBestReader in(file.path());
+  BOOST_CHECK_EQUAL(1, in.size());
+}
@@ -21,6 +21,7 @@
 #include "util/tokenize_piece.hh"
 #include "util/string_piece.hh"
 #include "FeatureDataIterator.h"
+#include "moses/BinaryNBest.h"
 
 using namespace std;
 
@@ -138,6 +139,11 @@ void Data::load(const std::string &featfile, const std::string &scorefile)
 
 void Data::loadNBest(const string &file, bool oneBest)
 {
+  if (Moses::BinaryNBestReader::IsBinaryNBest(file)) {
+    loadBinaryNBest(file, oneBest);
+    return;
+  }
+
   TRACE_ERR("loading nbest from " << file << endl);
   util::FilePiece in(file.c_str());
 
@@ -195,6 +201,60 @@ void Data::loadNBest(const string &file, bool oneBest)
   }
 }
 
+void Data::loadBinaryNBest(const string &file, bool oneBest)
+{
+  TRACE_ERR("loading binary nbest from " << file << endl);
+  Moses::BinaryNBestReader in(file);
+
+  // same names as InitFeatureMap() gives the labels of a text n-best list
+  if (!existsFeatureNames()) {
+    stringstream features;
+    const vector<pair<StringPiece, uint32_t> > &labels = in.GetLabels();
+    for (size_t i = 0; i < labels.size(); ++i) {
+      for (uint32_t j = 0; j < labels[i].second; ++j) {
+        features << labels[i].first << "_" << j << " ";
+      }
+    }
+    m_feature_data->setFeatureMap(features.str());
+  }
+
+  ScoreStats scoreentry;
+  FeatureStats feature_entry;
+  Moses::BinaryNBestEntry entry;
+  string sentence;
+
+  for (size_t i = 0; i < in.size(); ++i) {
+    in.Get(i, entry);
+    int sentence_index = entry.sentenceId;
+    if (oneBest && m_score_data->exists(sentence_index)) continue;
+
+    // the scorers still take the translation as text
+    sentence.clear();
+    for (uint32_t t = 0; t < entry.tokenCount; ++t) {
+      if (t) sentence += ' ';
+      StringPiece word = in.GetWord(entry.tokens[t]);
+      sentence.append(word.data(), word.size());
+    }
+    if (m_scorer->useAlignment()) {
+      sentence += "|||";
+      sentence.append(entry.alignment.data(), entry.alignment.size());
+    }
+    scoreentry.clear();
+    m_scorer->prepareStats(sentence_index, sentence, scoreentry);
+    m_score_data->add(scoreentry, sentence_index);
+
+    feature_entry.reset();
+    for (uint32_t f = 0; f < entry.denseCount; ++f) {
+      feature_entry.add(entry.dense[f]);
+    }
+    for (uint32_t f = 0; f < entry.sparseCount; ++f) {
+      feature_entry.addSparse(in.GetWord(entry.sparse[f].name).as_string(), entry.sparse[f].value);
+    }
+    m_feature_data->add(feature_entry, sentence_index);
+  }
+  PrintUserTime("Loaded N-best lists");
+}
+
 void Data::save(const std::string &featfile, const std::string &scorefile, bool bin)
 {
   if (bin)
@@ -69,6 +69,9 @@ public:
 
   void loadNBest(const std::string &file, bool oneBest=false);
 
+  // n-best list written by the decoder with -n-best-binary
+  void loadBinaryNBest(const std::string &file, bool oneBest=false);
+
   void load(const std::string &featfile, const std::string &scorefile);
 
   void save(const std::string &featfile, const std::string &scorefile, bool bin=false);
@@ -1,10 +1,13 @@
 #include "Data.h"
+#include "FeatureDataIterator.h"
+#include "ScoreDataIterator.h"
 #include "Scorer.h"
 #include "ScorerFactory.h"
 
 #define BOOST_TEST_MODULE MertData
 #include <boost/test/unit_test.hpp>
 
+#include <boost/filesystem.hpp>
 #include <boost/scoped_ptr.hpp>
 
 using namespace MosesTuning;
@@ -75,3 +78,57 @@ BOOST_AUTO_TEST_CASE(add_features_test)
   BOOST_CHECK(IsAlmostEqual(-14.7486f, stats.get(7)));
   BOOST_CHECK(IsAlmostEqual(7.99917f,  stats.get(8)));
 }
+
+// the iterators of pro and kbmira read the files of extractor --binary in
+// place, and give the same values as from the text files
+BOOST_AUTO_TEST_CASE(binary_iterator_test)
+{
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  Data data(scorer.get());
+  data.InitFeatureMap("d= 0 lm= -64.5 -65.25 w= -8 ");
+  data.AddFeatures("d= 0 lm= -64.5 -65.25 w= -8 ", 0);
+  data.AddFeatures("d= 1 lm= -2.5 -3 w= -7 ", 0);
+  data.AddFeatures("d= 0.5 lm= -1 -2 w= -3 ", 1);
+  for (int sentence = 0; sentence < 2; ++sentence) {
+    for (size_t hypothesis = 0; hypothesis < 2 - sentence; ++hypothesis) {
+      ScoreStats stats;
+      for (size_t i = 0; i < scorer->NumberOfScores(); ++i) {
+        stats.add(sentence + hypothesis + i);
+      }
+      data.getScoreData()->add(stats, sentence);
+    }
+  }
+
+  const boost::filesystem::path dir = boost::filesystem::temp_directory_path() /
+                                      boost::filesystem::unique_path("data_test_%%%%%%");
+  boost::filesystem::create_directory(dir);
+  const std::string text = (dir / "text").string();
+  const std::string bin = (dir / "bin").string();
+  data.save(text + ".features", text + ".scores", false);
+  data.save(bin + ".features", bin + ".scores", true);
+
+  FeatureDataIterator textFeatures(text + ".features");
+  FeatureDataIterator binFeatures(bin + ".features");
+  size_t blocks = 0;
+  for (; textFeatures != FeatureDataIterator::end(); ++textFeatures, ++binFeatures, ++blocks) {
+    BOOST_REQUIRE(binFeatures != FeatureDataIterator::end());
+    BOOST_REQUIRE_EQUAL(textFeatures->size(), binFeatures->size());
+    for (size_t i = 0; i < textFeatures->size(); ++i) {
+      BOOST_CHECK((*textFeatures)[i].dense == (*binFeatures)[i].dense);
+    }
+  }
+  BOOST_CHECK(binFeatures == FeatureDataIterator::end());
+  BOOST_CHECK_EQUAL(2, blocks);
+
+  ScoreDataIterator textScores(text + ".scores");
+  ScoreDataIterator binScores(bin + ".scores");
+  blocks = 0;
+  for (; textScores != ScoreDataIterator::end(); ++textScores, ++binScores, ++blocks) {
+    BOOST_REQUIRE(binScores != ScoreDataIterator::end());
+    BOOST_CHECK(*textScores == *binScores);
+  }
+  BOOST_CHECK(binScores == ScoreDataIterator::end());
+  BOOST_CHECK_EQUAL(2, blocks);
+
+  boost::filesystem::remove_all(dir);
+}
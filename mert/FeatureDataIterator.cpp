@@ -16,10 +16,12 @@ You should have received a copy of the GNU Lesser General Public
 License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <boost/functional/hash.hpp>
 
+#include "util/file.hh"
 #include "util/file_piece.hh"
 #include "util/tokenize_piece.hh"
 
@@ -55,6 +57,61 @@ float ParseFloat(const StringPiece& str)
   return value;
 }
 
+BinaryDataFile::BinaryDataFile(const string& filename, const char* begin, const char* end)
+  : m_filename(filename), m_beginMarker(begin), m_endMarker(end),
+    m_begin(NULL), m_at(NULL), m_end(NULL)
+{
+  scoped_fd file(OpenReadOrThrow(filename.c_str()));
+  uint64_t size = SizeFile(file.get());
+  // pipes and compressed files stay with FilePiece
+  if (size == kBadSize || size <= m_beginMarker.size()) return;
+  string marker(m_beginMarker.size() + 1, ' ');
+  ErsatzPRead(file.get(), &marker[0], marker.size(), 0);
+  if (marker != m_beginMarker + " ") return;
+
+  MapRead(POPULATE_OR_LAZY, file.get(), 0, size, m_mem);
+  m_begin = m_at = static_cast<const char*>(m_mem.get());
+  m_end = m_begin + size;
+}
+
+StringPiece BinaryDataFile::ReadLine()
+{
+  const char* newline = static_cast<const char*>(memchr(m_at, '\n', m_end - m_at));
+  if (!newline) throw FileFormatException(m_filename, string(m_at, m_end));
+  StringPiece line(m_at, newline - m_at);
+  m_at = newline + 1;
+  return line;
+}
+
+bool BinaryDataFile::Next(size_t& count, size_t& length, const char*& values)
+{
+  if (m_at == m_end) return false;
+  StringPiece line = ReadLine();
+  TokenIter<SingleCharacter, true> field(line, ' ');
+  if (!field || *field != StringPiece(m_beginMarker)) {
+    throw FileFormatException(m_filename, line.as_string());
+  }
+  // sentence id, count and length, the rest of the line is ignored
+  size_t header[3];
+  for (size_t i = 0; i < 3; ++i) {
+    if (!++field) throw FileFormatException(m_filename, line.as_string());
+    header[i] = ParseInt(*field);
+  }
+  count = header[1];
+  length = header[2];
+  const size_t bytes = count * length * sizeof(float);
+  if (bytes > static_cast<size_t>(m_end - m_at)) {
+    throw FileFormatException(m_filename, line.as_string());
+  }
+  values = m_at;
+  m_at += bytes;
+  line = ReadLine();
+  if (line != StringPiece(m_endMarker)) {
+    throw FileFormatException(m_filename, line.as_string());
+  }
+  return true;
+}
+
 bool operator==(FeatureDataItem const& item1, FeatureDataItem const& item2)
 {
   return item1.dense==item1.dense && item1.sparse==item1.sparse;
@@ -73,7 +130,11 @@ FeatureDataIterator::FeatureDataIterator() {}
 
 FeatureDataIterator::FeatureDataIterator(const string& filename)
 {
-  m_in.reset(new FilePiece(filename.c_str()));
+  m_binary.reset(new BinaryDataFile(filename, FEATURES_BIN_BEGIN, FEATURES_BIN_END));
+  if (!m_binary->IsBinary()) {
+    m_binary.reset();
+    m_in.reset(new FilePiece(filename.c_str()));
+  }
   readNext();
 }
 
@@ -82,6 +143,10 @@ FeatureDataIterator::~FeatureDataIterator() {}
 void FeatureDataIterator::readNext()
 {
   m_next.clear();
+  if (m_binary) {
+    readNextBinary();
+    return;
+  }
   try {
     StringPiece marker = m_in->ReadDelimited();
     if (marker != StringPiece(FEATURES_TXT_BEGIN)) {
@@ -124,6 +189,22 @@ void FeatureDataIterator::readNext()
   }
 }
 
+void FeatureDataIterator::readNextBinary()
+{
+  size_t count, length;
+  const char* values;
+  if (!m_binary->Next(count, length, values)) {
+    m_binary.reset();
+    return;
+  }
+  // binary blocks only hold the dense features
+  m_next.resize(count);
+  for (size_t i = 0; i < count && length; ++i) {
+    m_next[i].dense.resize(length);
+    memcpy(&m_next[i].dense[0], values + i * length * sizeof(float), length * sizeof(float));
+  }
+}
+
 void FeatureDataIterator::increment()
 {
   readNext();
@@ -131,6 +212,11 @@ void FeatureDataIterator::increment()
 
 bool FeatureDataIterator::equal(const FeatureDataIterator& rhs) const
 {
+  if (m_binary || rhs.m_binary) {
+    return m_binary && rhs.m_binary &&
+           m_binary->FileName() == rhs.m_binary->FileName() &&
+           m_binary->Offset() == rhs.m_binary->Offset();
+  }
   if (!m_in && !rhs.m_in) {
     return true;
   } else if (!m_in) {
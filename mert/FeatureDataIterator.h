@@ -33,6 +33,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <boost/shared_ptr.hpp>
 
 #include "util/exception.hh"
+#include "util/mmap.hh"
 #include "util/string_piece.hh"
 
 #include "FeatureStats.h"
@@ -61,6 +62,44 @@ int ParseInt(const StringPiece& str );
 /** Assumes a delimiter, so only apply to tokens */
 float ParseFloat(const StringPiece& str);
 
+/**
+  * Maps a features or scores file written with --binary, so that its blocks
+  * are read in place rather than through FilePiece. A block is a header line
+  * (marker, sentence id, count, length, ...), count * length floats and an
+  * end line.
+**/
+class BinaryDataFile
+{
+public:
+  BinaryDataFile(const std::string& filename, const char* begin, const char* end);
+
+  /** False for text files, and for files that cannot be mapped */
+  bool IsBinary() const {
+    return m_at != NULL;
+  }
+
+  /** The next block, values are not aligned. False at the end of the file */
+  bool Next(std::size_t& count, std::size_t& length, const char*& values);
+
+  const std::string& FileName() const {
+    return m_filename;
+  }
+  std::size_t Offset() const {
+    return m_at - m_begin;
+  }
+
+private:
+  std::string m_filename;
+  std::string m_beginMarker;
+  std::string m_endMarker;
+  util::scoped_memory m_mem;
+  const char* m_begin;
+  const char* m_at;
+  const char* m_end;
+
+  StringPiece ReadLine();
+};
+
 
 class FeatureDataItem
 {
@@ -95,8 +134,10 @@ private:
   const std::vector<FeatureDataItem>& dereference() const;
 
   void readNext();
+  void readNextBinary();
 
   boost::shared_ptr<util::FilePiece> m_in;
+  boost::shared_ptr<BinaryDataFile> m_binary;
   std::vector<FeatureDataItem> m_next;
 };
 
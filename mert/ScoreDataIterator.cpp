@@ -16,6 +16,7 @@ You should have received a copy of the GNU Lesser General Public
 License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
+#include <cstring>
 #include <iostream>
 
 #include "util/file_piece.hh"
@@ -35,7 +36,11 @@ ScoreDataIterator::ScoreDataIterator() {}
 
 ScoreDataIterator::ScoreDataIterator(const string& filename)
 {
-  m_in.reset(new FilePiece(filename.c_str()));
+  m_binary.reset(new BinaryDataFile(filename, SCORES_BIN_BEGIN, SCORES_BIN_END));
+  if (!m_binary->IsBinary()) {
+    m_binary.reset();
+    m_in.reset(new FilePiece(filename.c_str()));
+  }
   readNext();
 }
 
@@ -44,6 +49,10 @@ ScoreDataIterator::~ScoreDataIterator() {}
 void ScoreDataIterator::readNext()
 {
   m_next.clear();
+  if (m_binary) {
+    readNextBinary();
+    return;
+  }
   try {
     StringPiece marker = m_in->ReadDelimited();
     if (marker != StringPiece(SCORES_TXT_BEGIN)) {
@@ -74,6 +83,20 @@ void ScoreDataIterator::readNext()
   }
 }
 
+void ScoreDataIterator::readNextBinary()
+{
+  size_t count, length;
+  const char* values;
+  if (!m_binary->Next(count, length, values)) {
+    m_binary.reset();
+    return;
+  }
+  m_next.resize(count, ScoreDataItem(length));
+  for (size_t i = 0; i < count && length; ++i) {
+    memcpy(&m_next[i][0], values + i * length * sizeof(float), length * sizeof(float));
+  }
+}
+
 void ScoreDataIterator::increment()
 {
   readNext();
@@ -82,6 +105,11 @@ void ScoreDataIterator::increment()
 
 bool ScoreDataIterator::equal(const ScoreDataIterator& rhs) const
 {
+  if (m_binary || rhs.m_binary) {
+    return m_binary && rhs.m_binary &&
+           m_binary->FileName() == rhs.m_binary->FileName() &&
+           m_binary->Offset() == rhs.m_binary->Offset();
+  }
   if (!m_in && !rhs.m_in) {
     return true;
   } else if (!m_in) {
@@ -0,0 +1,200 @@
+// Micro-benchmark for Moses::FactorCollection::AddFactor() under many threads.
+// Compares the sharded, lock-free-lookup collection with a set guarded by one
+// reader-writer lock, which is how FactorCollection used to work.
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "moses/FactorCollection.h"
+#include "util/murmur_hash.hh"
+#include "util/pool.hh"
+#include "util/usage.hh"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+// the previous implementation: one boost::unordered_set, one shared_mutex
+class LockedFactorSet
+{
+public:
+  typedef std::pair<StringPiece, size_t> Entry;
+
+  LockedFactorSet() : m_factorId(0) {}
+
+  const Entry *AddFactor(const StringPiece &factorString) {
+    Entry to_ins(factorString, m_factorId);
+    {
+      boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
+      Set::const_iterator i = m_set.find(to_ins);
+      if (i != m_set.end()) return &*i;
+    }
+    boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
+    std::pair<Set::iterator, bool> ret(m_set.insert(to_ins));
+    if (ret.second) {
+      const_cast<Entry&>(*ret.first).first = StringPiece(
+          (const char*) memcpy(m_string_backing.Allocate(factorString.size()), factorString.data(), factorString.size()),
+          factorString.size());
+      ++m_factorId;
+    }
+    return &*ret.first;
+  }
+
+private:
+  struct HashEntry {
+    size_t operator()(const Entry &entry) const {
+      return util::MurmurHashNative(entry.first.data(), entry.first.size());
+    }
+  };
+  struct EqualsEntry {
+    bool operator()(const Entry &left, const Entry &right) const {
+      return left.first == right.first;
+    }
+  };
+  typedef boost::unordered_set<Entry, HashEntry, EqualsEntry> Set;
+
+  Set m_set;
+  util::Pool m_string_backing;
+  boost::shared_mutex m_accessLock;
+  size_t m_factorId;
+};
+
+// each thread looks up a skewed sample of the vocabulary. A fraction of the
+// lookups are words nobody has seen before, like OOVs or XML markup
+struct Workload {
+  const vector<string> *vocab;
+  size_t numLookups;
+  float oovRate;
+  size_t run;
+};
+
+void Words(const Workload &work, size_t threadInd, vector<string> &out)
+{
+  out.resize(work.numLookups);
+  unsigned int seed = threadInd * 7919 + work.run;
+  for (size_t i = 0; i < work.numLookups; ++i) {
+    float r = (float) rand_r(&seed) / RAND_MAX;
+    if (r < work.oovRate) {
+      stringstream strme;
+      strme << "__oov_" << work.run << "_" << threadInd << "_" << i;
+      out[i] = strme.str();
+    } else {
+      // squaring biases towards the head of the vocab, a crude zipf
+      float u = (float) rand_r(&seed) / RAND_MAX;
+      size_t ind = (size_t) (u * u * (work.vocab->size() - 1));
+      out[i] = (*work.vocab)[ind];
+    }
+  }
+}
+
+void RunCollection(const vector<string> *words)
+{
+  FactorCollection &collection = FactorCollection::Instance();
+  for (size_t i = 0; i < words->size(); ++i) {
+    collection.AddFactor((*words)[i]);
+  }
+}
+
+void RunLocked(LockedFactorSet *set, const vector<string> *words)
+{
+  for (size_t i = 0; i < words->size(); ++i) {
+    set->AddFactor((*words)[i]);
+  }
+}
+
+template <class Fn>
+double Time(size_t numThreads, Fn fn)
+{
+  boost::thread_group threads;
+  double start = util::WallTime();
+  for (size_t i = 0; i < numThreads; ++i) {
+    threads.create_thread(boost::bind<void>(fn, i));
+  }
+  threads.join_all();
+  return util::WallTime() - start;
+}
+
+struct CollectionFn {
+  const vector<vector<string> > *words;
+  void operator()(size_t i) const {
+    RunCollection(&(*words)[i]);
+  }
+};
+
+struct LockedFn {
+  const vector<vector<string> > *words;
+  LockedFactorSet *set;
+  void operator()(size_t i) const {
+    RunLocked(set, &(*words)[i]);
+  }
+};
+
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 1 && string(argv[1]) == "--help") {
+    cerr << "Usage: " << argv[0] << " [max-threads=32] [vocab-size=100000] [lookups-per-thread=1000000] [oov-rate=0.01]" << endl;
+    return 1;
+  }
+  size_t maxThreads = argc > 1 ? atoi(argv[1]) : 32;
+  size_t vocabSize = argc > 2 ? atoi(argv[2]) : 100000;
+  size_t numLookups = argc > 3 ? atoi(argv[3]) : 1000000;
+  float oovRate = argc > 4 ? atof(argv[4]) : 0.01;
+
+  vector<string> vocab(vocabSize);
+  for (size_t i = 0; i < vocabSize; ++i) {
+    stringstream strme;
+    strme << "word" << i;
+    vocab[i] = strme.str();
+    FactorCollection::Instance().AddFactor(vocab[i]);
+  }
+
+  cout << "threads\tlocked (Mlookups/s)\tsharded (Mlookups/s)\tspeedup" << endl;
+  size_t run = 0;
+  for (size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+    Workload work;
+    work.vocab = &vocab;
+    work.numLookups = numLookups;
+    work.oovRate = oovRate;
+    work.run = ++run;
+
+    vector<vector<string> > words(numThreads);
+    for (size_t i = 0; i < numThreads; ++i) {
+      Words(work, i, words[i]);
+    }
+
+    LockedFactorSet locked;
+    for (size_t i = 0; i < vocabSize; ++i) {
+      locked.AddFactor(vocab[i]);
+    }
+
+    LockedFn lockedFn;
+    lockedFn.words = &words;
+    lockedFn.set = &locked;
+    double lockedTime = Time(numThreads, lockedFn);
+
+    CollectionFn collectionFn;
+    collectionFn.words = &words;
+    double collectionTime = Time(numThreads, collectionFn);
+
+    double total = (double) numThreads * numLookups / 1000000;
+    cout << numThreads
+         << "\t" << total / lockedTime
+         << "\t" << total / collectionTime
+         << "\t" << lockedTime / collectionTime
+         << endl;
+  }
+
+  return 0;
+}
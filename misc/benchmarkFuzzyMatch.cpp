@@ -0,0 +1,167 @@
+// Benchmark for the edit distances used by fuzzy matching (PhraseDictionaryFuzzyMatch).
+// Compares the dynamic program FuzzyMatchWrapper used to run with the
+// bit-parallel tmmt::WordEditDistancePattern and tmmt::LetterEditDistance(), on a
+// translation memory and input sentences, and checks that they agree.
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "moses/TranslationModel/fuzzy-match/EditDistance.h"
+#include "moses/TranslationModel/fuzzy-match/Vocabulary.h"
+#include "util/usage.hh"
+
+using namespace std;
+using namespace tmmt;
+
+namespace
+{
+
+// the previous implementation, one full cost matrix per call
+template <class Sequence>
+unsigned int DynamicProgram(const Sequence &a, const Sequence &b)
+{
+  vector<vector<unsigned int> > cost(a.size() + 1, vector<unsigned int>(b.size() + 1));
+  for (size_t i = 0; i <= a.size(); ++i) {
+    cost[i][0] = i;
+  }
+  for (size_t j = 0; j <= b.size(); ++j) {
+    cost[0][j] = j;
+  }
+  for (size_t i = 1; i <= a.size(); ++i) {
+    for (size_t j = 1; j <= b.size(); ++j) {
+      unsigned int ins = cost[i-1][j] + 1;
+      unsigned int del = cost[i][j-1] + 1;
+      unsigned int diag = cost[i-1][j-1] + (a[i-1] == b[j-1] ? 0 : 1);
+      cost[i][j] = min(diag, min(ins, del));
+    }
+  }
+  return cost[a.size()][b.size()];
+}
+
+void Load(const char *path, Vocabulary &vocab, vector<vector<WORD_ID> > &corpus, size_t maxLines)
+{
+  ifstream in(path);
+  if (!in) {
+    cerr << "file not found: " << path << endl;
+    exit(1);
+  }
+  string line;
+  while (corpus.size() < maxLines && getline(in, line)) {
+    corpus.push_back(vocab.Tokenize(line.c_str()));
+  }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3) {
+    cerr << "Usage: " << argv[0] << " tm-source input [max-tm-sentences=10000] [max-input-sentences=100] [min-match=70]" << endl;
+    return 1;
+  }
+  size_t maxTM = argc > 3 ? atoi(argv[3]) : 10000;
+  size_t maxInput = argc > 4 ? atoi(argv[4]) : 100;
+  int minMatch = argc > 5 ? atoi(argv[5]) : 70;
+
+  Vocabulary vocab;
+  vector<vector<WORD_ID> > tm, input;
+  Load(argv[1], vocab, tm, maxTM);
+  Load(argv[2], vocab, input, maxInput);
+  cerr << tm.size() << " tm sentences, " << input.size() << " input sentences" << endl;
+
+  // word level, every input sentence against every tm sentence
+  size_t numPairs = 0, numWithin = 0, numWrong = 0;
+  unsigned long long checksum = 0;
+
+  double start = util::WallTime();
+  for (size_t i = 0; i < input.size(); ++i) {
+    for (size_t s = 0; s < tm.size(); ++s) {
+      checksum += DynamicProgram(input[i], tm[s]);
+    }
+  }
+  double dpTime = util::WallTime() - start;
+
+  start = util::WallTime();
+  unsigned long long checksumBits = 0;
+  for (size_t i = 0; i < input.size(); ++i) {
+    WordEditDistancePattern pattern(input[i]);
+    for (size_t s = 0; s < tm.size(); ++s) {
+      checksumBits += pattern.Distance(tm[s]);
+    }
+  }
+  double bitsTime = util::WallTime() - start;
+
+  // with the cutoff fuzzy matching starts with
+  start = util::WallTime();
+  for (size_t i = 0; i < input.size(); ++i) {
+    WordEditDistancePattern pattern(input[i]);
+    unsigned int maxCost = input[i].size() * (100 - minMatch) / 100 + 1;
+    for (size_t s = 0; s < tm.size(); ++s) {
+      ++numPairs;
+      if (pattern.Distance(tm[s], maxCost) <= maxCost) {
+        ++numWithin;
+      }
+    }
+  }
+  double cutoffTime = util::WallTime() - start;
+
+  for (size_t i = 0; i < input.size(); ++i) {
+    unsigned int maxCost = input[i].size() * (100 - minMatch) / 100 + 1;
+    for (size_t s = 0; s < tm.size(); ++s) {
+      unsigned int expected = DynamicProgram(input[i], tm[s]);
+      unsigned int cost = WordEditDistance(input[i], tm[s], maxCost);
+      if (expected <= maxCost ? cost != expected : cost <= maxCost) {
+        ++numWrong;
+      }
+    }
+  }
+  if (checksum != checksumBits) {
+    ++numWrong;
+  }
+
+  // letter level, every input word against every word of the vocabulary
+  vector<string> words(vocab.vocab.begin(), vocab.vocab.end());
+  vector<string> inputWords;
+  for (size_t i = 0; i < input.size() && inputWords.size() < 100; ++i) {
+    for (size_t j = 0; j < input[i].size(); ++j) {
+      inputWords.push_back(vocab.GetWord(input[i][j]));
+    }
+  }
+  inputWords.resize(min<size_t>(inputWords.size(), 100));
+
+  start = util::WallTime();
+  unsigned long long letterChecksum = 0;
+  for (size_t i = 0; i < inputWords.size(); ++i) {
+    for (size_t w = 0; w < words.size(); ++w) {
+      letterChecksum += DynamicProgram(inputWords[i], words[w]);
+    }
+  }
+  double letterDPTime = util::WallTime() - start;
+
+  start = util::WallTime();
+  unsigned long long letterChecksumBits = 0;
+  for (size_t i = 0; i < inputWords.size(); ++i) {
+    for (size_t w = 0; w < words.size(); ++w) {
+      letterChecksumBits += LetterEditDistance(inputWords[i], words[w]);
+    }
+  }
+  double letterBitsTime = util::WallTime() - start;
+  if (letterChecksum != letterChecksumBits) {
+    ++numWrong;
+  }
+
+  cout << "word level: " << numPairs << " pairs, " << numWithin << " within the cutoff" << endl;
+  cout << "  dynamic program\t" << dpTime << " s" << endl;
+  cout << "  bit-parallel\t" << bitsTime << " s\t" << dpTime / bitsTime << "x" << endl;
+  cout << "  with cutoff\t" << cutoffTime << " s\t" << dpTime / cutoffTime << "x" << endl;
+  cout << "letter level: " << inputWords.size() * words.size() << " pairs" << endl;
+  cout << "  dynamic program\t" << letterDPTime << " s" << endl;
+  cout << "  bit-parallel\t" << letterBitsTime << " s\t" << letterDPTime / letterBitsTime << "x" << endl;
+  cout << (numWrong ? "MISMATCHES: " : "results agree, mismatches: ") << numWrong << endl;
+
+  return numWrong ? 1 : 0;
+}
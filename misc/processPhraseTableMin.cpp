@@ -32,6 +32,8 @@ void printHelp(char **argv)
             "\t-join-scores      -- single set of Huffman codes for score components\n"
             "\t-quantize int     -- maximum number of scores per score component\n"
             "\t-no-warnings      -- suppress warnings about missing alignment data\n"
+            "\t-stream           -- read the text table twice instead of keeping the\n"
+            "\t                     encoded target phrases, needs input sorted by source\n"
             "\n"
             "  For more information see: http://www.statmt.org/moses/?n=Moses.AdvancedFeatures#ntoc6\n\n"
             "  If you use this please cite:\n\n"
@@ -67,6 +69,7 @@ int main(int argc, char **argv)
   bool sortScoreIndexSet = false;
   size_t sortScoreIndex = 2;
   bool warnMe = true;
+  bool streaming = false;
   size_t threads =
 #ifdef WITH_THREADS
     boost::thread::hardware_concurrency() ? boost::thread::hardware_concurrency() :
@@ -124,6 +127,8 @@ int main(int argc, char **argv)
       quantize = atoi(argv[i]);
     } else if("-no-warnings" == arg) {
       warnMe = false;
+    } else if("-stream" == arg) {
+      streaming = true;
     } else if("-threads" == arg && i+1 < argc) {
 #ifdef WITH_THREADS
       ++i;
@@ -166,7 +171,7 @@ int main(int argc, char **argv)
                      numScoreComponent, sortScoreIndex,
                      coding, orderBits, fingerprintBits,
                      useAlignmentInfo, multipleScoreTrees,
-                     quantize, maxRank, warnMe
+                     quantize, maxRank, warnMe, streaming
 #ifdef WITH_THREADS
                      , threads
 #endif
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "Arena.h"
+#include "util/scoped.hh"
+
+namespace Moses
+{
+
+namespace
+{
+// in front of objects from AllocateTagged(), keeps the object aligned
+struct ArenaTag {
+  std::size_t size;
+  std::size_t padding;
+};
+}
+
+Arena::Arena()
+  : m_current(NULL)
+  , m_currentEnd(NULL)
+  , m_freeLists(MAX_FREE_LIST_SIZE / GRANULARITY + 1, NULL)
+{
+}
+
+Arena::~Arena()
+{
+  for (size_t i = 0; i < m_blocks.size(); ++i) {
+    free(m_blocks[i].begin);
+  }
+}
+
+void *Arena::Allocate(std::size_t size)
+{
+  size = (size + GRANULARITY - 1) & ~(GRANULARITY - 1);
+  if (size <= MAX_FREE_LIST_SIZE) {
+    void *&head = m_freeLists[size / GRANULARITY];
+    if (head) {
+      void *ret = head;
+      head = *static_cast<void**>(ret);
+      return ret;
+    }
+  }
+  if (m_currentEnd - m_current < (std::ptrdiff_t) size) {
+    return More(size);
+  }
+  void *ret = m_current;
+  m_current += size;
+  return ret;
+}
+
+void Arena::Free(void *p, std::size_t size)
+{
+  size = (size + GRANULARITY - 1) & ~(GRANULARITY - 1);
+  if (size <= MAX_FREE_LIST_SIZE) {
+    void *&head = m_freeLists[size / GRANULARITY];
+    *static_cast<void**>(p) = head;
+    head = p;
+  }
+}
+
+void *Arena::AllocateTagged(std::size_t size)
+{
+  size += sizeof(ArenaTag);
+  ArenaTag *tag = static_cast<ArenaTag*>(Allocate(size));
+  tag->size = size;
+  return tag + 1;
+}
+
+void Arena::FreeTagged(void *p)
+{
+  ArenaTag *tag = static_cast<ArenaTag*>(p) - 1;
+  Free(tag, tag->size);
+}
+
+bool Arena::Owns(const void *p) const
+{
+  const char *c = static_cast<const char*>(p);
+  Block key;
+  key.begin = const_cast<char*>(c);
+  std::vector<Block>::const_iterator upper = std::upper_bound(m_blocks.begin(), m_blocks.end(), key);
+  return upper != m_blocks.begin() && c < (upper - 1)->end;
+}
+
+void *Arena::More(std::size_t size)
+{
+  // blocks double, up to 64 times the first one
+  std::size_t amount = MIN_BLOCK_SIZE << std::min<std::size_t>(m_blocks.size(), 6);
+  amount = std::max(amount, size);
+  Block block;
+  block.begin = static_cast<char*>(util::MallocOrThrow(amount));
+  block.end = block.begin + amount;
+  m_blocks.insert(std::upper_bound(m_blocks.begin(), m_blocks.end(), block), block);
+
+  m_current = block.begin + size;
+  m_currentEnd = block.end;
+  return block.begin;
+}
+
+}
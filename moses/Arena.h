@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <valarray>
+#include <vector>
+
+#include "FeatureVector.h"
+
+namespace Moses
+{
+class FFState;
+
+/** Memory for the hypotheses and feature function states of one Manager,
+ * if search-arena is set, so that decoding threads do not contend in
+ * malloc. Objects are placed in it explicitly by the search; freed memory
+ * goes to a free list per size and is reused, and everything is returned
+ * to the system in one step when the arena is destroyed. Not thread-safe:
+ * an arena belongs to the Manager decoding on one thread.
+ */
+class Arena
+{
+public:
+  Arena();
+  ~Arena();
+
+  //! memory for an object of the given size, freed with Free(p, size)
+  void *Allocate(std::size_t size);
+  void Free(void *p, std::size_t size);
+
+  /** for objects whose size isn't known when they are freed, such as
+   * feature function states: the size is kept in front of the object
+   */
+  void *AllocateTagged(std::size_t size);
+  void FreeTagged(void *p);
+
+  //! whether p points into memory of this arena
+  bool Owns(const void *p) const;
+
+  /** storage of the score vectors and state lists of freed hypotheses,
+   * zeroed, to be taken over by new ones
+   */
+  std::vector<std::valarray<FValue> > &GetRecycledScores() {
+    return m_recycledScores;
+  }
+  std::vector<std::vector<const FFState*> > &GetRecycledStates() {
+    return m_recycledStates;
+  }
+
+private:
+  // sizes are rounded up to multiples of this, which keeps objects aligned
+  static const std::size_t GRANULARITY = 16;
+  // larger blocks are not reused until the arena is destroyed
+  static const std::size_t MAX_FREE_LIST_SIZE = 1024;
+  static const std::size_t MIN_BLOCK_SIZE = 1 << 16;
+
+  struct Block {
+    char *begin, *end;
+    bool operator<(const Block &other) const {
+      return begin < other.begin;
+    }
+  };
+
+  // sorted by address, for Owns()
+  std::vector<Block> m_blocks;
+  char *m_current, *m_currentEnd;
+  std::vector<void*> m_freeLists;
+
+  std::vector<std::valarray<FValue> > m_recycledScores;
+  std::vector<std::vector<const FFState*> > m_recycledStates;
+
+  void *More(std::size_t size);
+
+  // no copying
+  Arena(const Arena &);
+  Arena &operator=(const Arena &);
+};
+
+}
@@ -0,0 +1,159 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "Arena.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+bool Aligned(const void *p)
+{
+  return reinterpret_cast<size_t>(p) % 16 == 0;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(arena)
+
+BOOST_AUTO_TEST_CASE(allocate)
+{
+  Arena arena;
+  char *a = static_cast<char*>(arena.Allocate(1));
+  char *b = static_cast<char*>(arena.Allocate(24));
+  char *c = static_cast<char*>(arena.Allocate(100));
+  BOOST_CHECK(Aligned(a));
+  BOOST_CHECK(Aligned(b));
+  BOOST_CHECK(Aligned(c));
+  BOOST_CHECK(a + 16 <= b);
+  BOOST_CHECK(b + 32 <= c);
+  BOOST_CHECK(arena.Owns(a));
+  BOOST_CHECK(arena.Owns(b));
+  BOOST_CHECK(arena.Owns(c + 99));
+}
+
+BOOST_AUTO_TEST_CASE(reuse_size_class)
+{
+  Arena arena;
+  void *a = arena.Allocate(17);
+  void *b = arena.Allocate(20);
+  // 17 and 32 round to the same size, the last freed is reused first
+  arena.Free(a, 17);
+  arena.Free(b, 20);
+  BOOST_CHECK_EQUAL(arena.Allocate(32), b);
+  BOOST_CHECK_EQUAL(arena.Allocate(25), a);
+  // the free list is empty again
+  void *c = arena.Allocate(32);
+  BOOST_CHECK(c != a && c != b);
+}
+
+BOOST_AUTO_TEST_CASE(no_reuse_across_size_classes)
+{
+  Arena arena;
+  void *a = arena.Allocate(16);
+  arena.Free(a, 16);
+  void *b = arena.Allocate(48);
+  BOOST_CHECK(b != a);
+  BOOST_CHECK_EQUAL(arena.Allocate(16), a);
+}
+
+BOOST_AUTO_TEST_CASE(large)
+{
+  Arena arena;
+  // larger than a free list size, and larger than a block
+  char *a = static_cast<char*>(arena.Allocate(4000));
+  char *b = static_cast<char*>(arena.Allocate(1 << 20));
+  memset(b, 1, 1 << 20);
+  BOOST_CHECK(Aligned(a));
+  BOOST_CHECK(arena.Owns(a + 3999));
+  BOOST_CHECK(arena.Owns(b));
+  BOOST_CHECK(arena.Owns(b + (1 << 20) - 1));
+  arena.Free(a, 4000);
+  BOOST_CHECK(arena.Allocate(4000) != a);
+}
+
+BOOST_AUTO_TEST_CASE(tagged)
+{
+  Arena arena;
+  void *a = arena.AllocateTagged(40);
+  void *b = arena.AllocateTagged(8);
+  BOOST_CHECK(Aligned(a));
+  BOOST_CHECK(Aligned(b));
+  BOOST_CHECK(arena.Owns(a));
+  memset(a, 0xff, 40);
+  memset(b, 0xff, 8);
+
+  arena.FreeTagged(a);
+  arena.FreeTagged(b);
+  BOOST_CHECK_EQUAL(arena.AllocateTagged(1), b);
+  BOOST_CHECK_EQUAL(arena.AllocateTagged(33), a);
+}
+
+BOOST_AUTO_TEST_CASE(foreign_pointers)
+{
+  Arena arena;
+  int onStack = 0;
+  BOOST_CHECK(!arena.Owns(&onStack));
+  BOOST_CHECK(!arena.Owns(NULL));
+
+  arena.Allocate(64);
+  BOOST_CHECK(!arena.Owns(&onStack));
+  BOOST_CHECK(!arena.Owns(NULL));
+  void *fromMalloc = malloc(64);
+  BOOST_CHECK(!arena.Owns(fromMalloc));
+  free(fromMalloc);
+}
+
+BOOST_AUTO_TEST_CASE(many_blocks)
+{
+  Arena arena;
+  // objects filled with their index, over many blocks, must not overlap
+  vector<pair<unsigned char*, size_t> > objects;
+  for (size_t i = 0; i < 20000; ++i) {
+    size_t size = 1 + (i * 37) % 700;
+    unsigned char *p = static_cast<unsigned char*>(arena.Allocate(size));
+    BOOST_REQUIRE(Aligned(p));
+    memset(p, i & 0xff, size);
+    objects.push_back(make_pair(p, size));
+  }
+
+  map<unsigned char*, size_t> byAddress;
+  for (size_t i = 0; i < objects.size(); ++i) {
+    BOOST_REQUIRE(arena.Owns(objects[i].first));
+    BOOST_REQUIRE(arena.Owns(objects[i].first + objects[i].second - 1));
+    for (size_t j = 0; j < objects[i].second; ++j) {
+      BOOST_REQUIRE_EQUAL(objects[i].first[j], i & 0xff);
+    }
+    byAddress[objects[i].first] = objects[i].second;
+  }
+  BOOST_CHECK_EQUAL(byAddress.size(), objects.size());
+  map<unsigned char*, size_t>::const_iterator prev = byAddress.begin(), iter = prev;
+  for (++iter; iter != byAddress.end(); prev = iter++) {
+    BOOST_REQUIRE(prev->first + prev->second <= iter->first);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 #include "moses/FF/StatelessFeatureFunction.h"
 #include "moses/FF/StatefulFeatureFunction.h"
 #include "moses/TranslationTask.h"
+#include "moses/BinaryNBest.h"
 
 #include <vector>
 #include <boost/algorithm/string/predicate.hpp>
@@ -147,6 +148,27 @@ void BaseManager::WriteApplicationContext(std::ostream &out,
   }
 }
 
+BinaryNBestWriter*
+BaseManager::
+GetBinaryNBestWriter() const
+{
+  ttasksptr ttask = GetTtask();
+  return ttask && ttask->GetIOWrapper() ? ttask->GetIOWrapper()->GetBinaryNBestWriter() : NULL;
+}
+
+void
+BaseManager::
+OutputBinaryNBestEntry(std::ostream &out, BinaryNBestWriter &writer,
+                       const std::string &surface,
+                       const ScoreComponentCollection &features,
+                       float score, const std::string &alignment) const
+{
+  std::vector<float> dense;
+  std::vector<std::pair<std::string, float> > sparse;
+  features.GetAllFeatureScores(dense, sparse);
+  writer.Write(out, m_source.GetTranslationId(), surface, dense, sparse, score, alignment);
+}
+
 AllOptions::ptr const&
 BaseManager::
 options() const
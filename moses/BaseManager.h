@@ -11,6 +11,7 @@ namespace Moses
 class ScoreComponentCollection;
 class FeatureFunction;
 class OutputCollector;
+class BinaryNBestWriter;
 
 class BaseManager
 {
@@ -30,6 +31,16 @@ protected:
   void WriteApplicationContext(std::ostream &out,
                                const ApplicationContext &context) const;
 
+  //! with -n-best-binary, the writer of the n-best list, NULL otherwise
+  BinaryNBestWriter *GetBinaryNBestWriter() const;
+
+  //! writes one n-best hypothesis to out in the binary format, rather than
+  //! as a line of text
+  void OutputBinaryNBestEntry(std::ostream &out, BinaryNBestWriter &writer,
+                              const std::string &surface,
+                              const ScoreComponentCollection &features,
+                              float score, const std::string &alignment) const;
+
   template <class T>
   void ShiftOffsets(std::vector<T> &offsets, T shift) const {
     T currPos = shift;
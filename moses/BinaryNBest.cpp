@@ -0,0 +1,230 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "BinaryNBest.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/tokenize_piece.hh"
+
+namespace Moses
+{
+
+namespace
+{
+const char kMagic[8] = {'m', 'o', 's', 'e', 's', 'n', 'b', '1'};
+
+std::size_t Padding(std::size_t size)
+{
+  return (4 - size % 4) % 4;
+}
+
+void Append(std::ostream &out, const void *data, std::size_t size)
+{
+  out.write(static_cast<const char*>(data), size);
+}
+
+void Pad(std::ostream &out, std::size_t size)
+{
+  static const char zeros[4] = {0, 0, 0, 0};
+  Append(out, zeros, Padding(size));
+}
+}
+
+BinaryNBestWriter::BinaryNBestWriter(std::ostream &out,
+                                     const std::vector<std::pair<std::string, std::size_t> > &labels)
+  : m_denseCount(0)
+{
+  Append(out, kMagic, sizeof(kMagic));
+  std::vector<uint32_t> block;
+  block.push_back(BinaryNBestLabels);
+  block.push_back(labels.size());
+  for (std::size_t i = 0; i < labels.size(); ++i) {
+    block.push_back(GetId(out, labels[i].first));
+    block.push_back(labels[i].second);
+    m_denseCount += labels[i].second;
+  }
+  Append(out, &block[0], block.size() * sizeof(uint32_t));
+}
+
+uint32_t BinaryNBestWriter::GetId(std::ostream &out, const StringPiece &word)
+{
+  std::pair<boost::unordered_map<std::string, uint32_t>::iterator, bool> ret
+    = m_vocab.insert(std::make_pair(word.as_string(), (uint32_t) m_vocab.size()));
+  if (ret.second) {
+    uint32_t header[3] = { BinaryNBestWord, ret.first->second, (uint32_t) word.size() };
+    Append(out, header, sizeof(header));
+    Append(out, word.data(), word.size());
+    Pad(out, word.size());
+  }
+  return ret.first->second;
+}
+
+void BinaryNBestWriter::Write(std::ostream &out, uint32_t sentenceId, const StringPiece &surface,
+                              const std::vector<float> &dense,
+                              const std::vector<std::pair<std::string, float> > &sparse,
+                              float totalScore, const StringPiece &alignment)
+{
+  UTIL_THROW_IF2(dense.size() != m_denseCount, "Hypothesis with " << dense.size()
+                 << " dense feature values, the labels name " << m_denseCount);
+
+  std::vector<uint32_t> tokens;
+  std::vector<BinaryNBestSparse> sparseIds(sparse.size());
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    for (util::TokenIter<util::SingleCharacter, true> token(surface, ' '); token; ++token) {
+      tokens.push_back(GetId(out, *token));
+    }
+    for (std::size_t i = 0; i < sparse.size(); ++i) {
+      sparseIds[i].name = GetId(out, sparse[i].first + "=");
+      sparseIds[i].value = sparse[i].second;
+    }
+  }
+
+  BinaryNBestRecord record;
+  record.sentenceId = sentenceId;
+  record.totalScore = totalScore;
+  record.tokenCount = tokens.size();
+  record.denseCount = dense.size();
+  record.sparseCount = sparseIds.size();
+  record.alignmentLength = alignment.size();
+
+  uint32_t type = BinaryNBestHypothesis;
+  Append(out, &type, sizeof(type));
+  Append(out, &record, sizeof(record));
+  if (!tokens.empty()) Append(out, &tokens[0], tokens.size() * sizeof(uint32_t));
+  if (!dense.empty()) Append(out, &dense[0], dense.size() * sizeof(float));
+  if (!sparseIds.empty()) Append(out, &sparseIds[0], sparseIds.size() * sizeof(BinaryNBestSparse));
+  Append(out, alignment.data(), alignment.size());
+  Pad(out, alignment.size());
+}
+
+bool BinaryNBestReader::IsBinaryNBest(const std::string &path)
+{
+  std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+  char magic[sizeof(kMagic)];
+  return in.read(magic, sizeof(magic)) && !memcmp(magic, kMagic, sizeof(kMagic));
+}
+
+BinaryNBestReader::BinaryNBestReader(const std::string &path)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(path.c_str()));
+  uint64_t size = util::SizeOrThrow(file.get());
+  UTIL_THROW_IF2(size < sizeof(kMagic), "Not a binary n-best file: " << path);
+  util::MapRead(util::POPULATE_OR_LAZY, file.get(), 0, size, m_mem);
+
+  const char *begin = static_cast<const char*>(m_mem.get());
+  const char *end = begin + size;
+  UTIL_THROW_IF2(memcmp(begin, kMagic, sizeof(kMagic)), "Not a binary n-best file: " << path);
+
+  // every block is padded, so each size is checked against what is left of
+  // the file before anything it covers is read
+  const uint32_t *labels = NULL;
+  const char *at = begin + sizeof(kMagic);
+  while (at != end) {
+    UTIL_THROW_IF2(end - at < 2 * (std::ptrdiff_t) sizeof(uint32_t), "Truncated binary n-best file " << path);
+    uint32_t type = *reinterpret_cast<const uint32_t*>(at);
+    at += sizeof(uint32_t);
+    const std::size_t left = end - at;
+    const uint32_t *values = reinterpret_cast<const uint32_t*>(at);
+    std::size_t length;
+    switch (type) {
+    case BinaryNBestWord:
+      length = 2 * sizeof(uint32_t);
+      UTIL_THROW_IF2(length > left, "Truncated binary n-best file " << path);
+      length += values[1];
+      UTIL_THROW_IF2(length + Padding(length) > left, "Truncated binary n-best file " << path);
+      if (values[0] >= m_words.size()) {
+        m_words.resize(values[0] + 1);
+      }
+      m_words[values[0]] = StringPiece(at + 2 * sizeof(uint32_t), values[1]);
+      break;
+    case BinaryNBestLabels:
+      length = sizeof(uint32_t) * (1 + 2 * (std::size_t) values[0]);
+      UTIL_THROW_IF2(length > left, "Truncated binary n-best file " << path);
+      labels = values;
+      break;
+    case BinaryNBestHypothesis: {
+      const BinaryNBestRecord *record = reinterpret_cast<const BinaryNBestRecord*>(at);
+      length = sizeof(BinaryNBestRecord);
+      UTIL_THROW_IF2(length > left, "Truncated binary n-best file " << path);
+      length += sizeof(uint32_t) * (std::size_t) record->tokenCount
+                + sizeof(float) * (std::size_t) record->denseCount
+                + sizeof(BinaryNBestSparse) * (std::size_t) record->sparseCount
+                + record->alignmentLength;
+      UTIL_THROW_IF2(length + Padding(length) > left, "Truncated binary n-best file " << path);
+      m_hypotheses.push_back(record);
+      break;
+    }
+    default:
+      UTIL_THROW2("Unknown block " << type << " in binary n-best file " << path);
+    }
+    at += length + Padding(length);
+  }
+
+  // words may be declared after the hypotheses using them, so the ids are
+  // only checked now. A word missing means the file was cut
+  for (uint32_t i = 0; labels && i < labels[0]; ++i) {
+    m_labels.push_back(std::make_pair(Declared(labels[1 + 2 * i], path), labels[2 + 2 * i]));
+  }
+  BinaryNBestEntry entry;
+  for (std::size_t i = 0; i < m_hypotheses.size(); ++i) {
+    Get(i, entry);
+    for (uint32_t t = 0; t < entry.tokenCount; ++t) {
+      Declared(entry.tokens[t], path);
+    }
+    for (uint32_t f = 0; f < entry.sparseCount; ++f) {
+      Declared(entry.sparse[f].name, path);
+    }
+  }
+}
+
+StringPiece BinaryNBestReader::Declared(uint32_t id, const std::string &path) const
+{
+  UTIL_THROW_IF2(id >= m_words.size() || !m_words[id].data(),
+                 "Truncated binary n-best file " << path << ": word " << id << " is not declared");
+  return m_words[id];
+}
+
+void BinaryNBestReader::Get(std::size_t i, BinaryNBestEntry &entry) const
+{
+  const BinaryNBestRecord &record = *m_hypotheses[i];
+  entry.sentenceId = record.sentenceId;
+  entry.totalScore = record.totalScore;
+  entry.tokenCount = record.tokenCount;
+  entry.denseCount = record.denseCount;
+  entry.sparseCount = record.sparseCount;
+
+  const char *at = reinterpret_cast<const char*>(&record + 1);
+  entry.tokens = reinterpret_cast<const uint32_t*>(at);
+  at += sizeof(uint32_t) * record.tokenCount;
+  entry.dense = reinterpret_cast<const float*>(at);
+  at += sizeof(float) * record.denseCount;
+  entry.sparse = reinterpret_cast<const BinaryNBestSparse*>(at);
+  at += sizeof(BinaryNBestSparse) * record.sparseCount;
+  entry.alignment = StringPiece(at, record.alignmentLength);
+}
+
+}
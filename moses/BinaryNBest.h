@@ -0,0 +1,153 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_BinaryNBest_h
+#define moses_BinaryNBest_h
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/unordered_map.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
+#include "util/mmap.hh"
+#include "util/string_piece.hh"
+
+namespace Moses
+{
+
+/** Binary n-best list, so that tuning does not have to parse the text one.
+ *
+ * The file is a magic string followed by 4-byte aligned blocks, each
+ * starting with a uint32_t BinaryNBestBlock type:
+ *  - word: uint32_t id, uint32_t length, the bytes
+ *  - labels: uint32_t count, then (word id of name, number of values) pairs
+ *    naming the dense feature values of every hypothesis
+ *  - hypothesis: BinaryNBestRecord, then the token word ids, the dense
+ *    feature values, BinaryNBestSparse pairs and the alignment text
+ * The labels come first. Words are declared once, by the first hypothesis
+ * encoded with them; as decoding threads encode their sentences in any
+ * order, that may be after hypotheses of earlier sentences using them.
+ */
+enum BinaryNBestBlock {
+  BinaryNBestWord = 1,
+  BinaryNBestLabels = 2,
+  BinaryNBestHypothesis = 3
+};
+
+struct BinaryNBestRecord {
+  uint32_t sentenceId;
+  float totalScore;
+  uint32_t tokenCount;
+  uint32_t denseCount;
+  uint32_t sparseCount;
+  uint32_t alignmentLength;
+};
+
+struct BinaryNBestSparse {
+  uint32_t name;
+  float value;
+};
+
+/** Encodes the hypotheses of the decoders. Sparse feature names are stored
+ * with a trailing '=', as mert's extractor reads them from a text list.
+ */
+class BinaryNBestWriter
+{
+public:
+  //! writes the magic string and the labels, (name, number of values)
+  BinaryNBestWriter(std::ostream &out,
+                    const std::vector<std::pair<std::string, std::size_t> > &labels);
+
+  /** Appends one hypothesis to out: the words it is the first to use, then
+   * its record. Called by every decoding thread, for the stream of the
+   * n-best OutputCollector.
+   */
+  void Write(std::ostream &out, uint32_t sentenceId, const StringPiece &surface,
+             const std::vector<float> &dense,
+             const std::vector<std::pair<std::string, float> > &sparse,
+             float totalScore, const StringPiece &alignment);
+
+private:
+  boost::unordered_map<std::string, uint32_t> m_vocab;
+  std::size_t m_denseCount;
+#ifdef WITH_THREADS
+  boost::mutex m_mutex;
+#endif
+
+  uint32_t GetId(std::ostream &out, const StringPiece &word);
+};
+
+/** A hypothesis of a mapped binary n-best list. Arrays point into the map */
+struct BinaryNBestEntry {
+  uint32_t sentenceId;
+  float totalScore;
+  const uint32_t *tokens;
+  uint32_t tokenCount;
+  const float *dense;
+  uint32_t denseCount;
+  const BinaryNBestSparse *sparse;
+  uint32_t sparseCount;
+  StringPiece alignment;
+};
+
+/** Memory maps a binary n-best list. Opening indexes the blocks once, and
+ * checks that every word used is declared; words, labels and hypotheses
+ * are then read in place.
+ */
+class BinaryNBestReader
+{
+public:
+  explicit BinaryNBestReader(const std::string &path);
+
+  //! whether path starts with the binary n-best magic string
+  static bool IsBinaryNBest(const std::string &path);
+
+  std::size_t size() const {
+    return m_hypotheses.size();
+  }
+  void Get(std::size_t i, BinaryNBestEntry &entry) const;
+
+  StringPiece GetWord(uint32_t id) const {
+    return m_words[id];
+  }
+
+  //! (name, number of values) of the dense features, in order
+  const std::vector<std::pair<StringPiece, uint32_t> > &GetLabels() const {
+    return m_labels;
+  }
+
+private:
+  util::scoped_memory m_mem;
+  std::vector<StringPiece> m_words;
+  std::vector<std::pair<StringPiece, uint32_t> > m_labels;
+  std::vector<const BinaryNBestRecord*> m_hypotheses;
+
+  StringPiece Declared(uint32_t id, const std::string &path) const;
+};
+
+}
+
+#endif
@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/FF/DistortionScoreProducer.h"
 #include "TranslationOptionList.h"
 #include "Manager.h"
+#include "Arena.h"
 
 namespace Moses
 {
@@ -225,7 +226,7 @@ Hypothesis *BackwardsEdge::CreateHypothesis(const Hypothesis &hypothesis, const
     hypothesis.GetManager().GetSentenceStats().StartTimeBuildHyp();
   }
   const Bitmap &bitmap = m_parent.GetWordsBitmap();
-  Hypothesis *newHypo = new Hypothesis(hypothesis, transOpt, bitmap, hypothesis.GetManager().GetNextHypoId());
+  Hypothesis *newHypo = Hypothesis::Create(hypothesis, transOpt, bitmap, hypothesis.GetManager().GetNextHypoId());
   IFVERBOSE(2) {
     hypothesis.GetManager().GetSentenceStats().StopTimeBuildHyp();
   }
@@ -297,6 +298,7 @@ BitmapContainer::BitmapContainer(const Bitmap &bitmap
   , m_stack(stack)
   , m_numStackInsertions(0)
   , m_deterministic(deterministic)
+  , m_arena(stack.GetManager().GetArena())
 {
   m_hypotheses = HypothesisSet();
   m_edges = BackwardsEdgeSet();
@@ -311,8 +313,8 @@ BitmapContainer::~BitmapContainer()
     HypothesisQueueItem *item = m_queue.top();
     m_queue.pop();
 
-    delete item->GetHypothesis();
-    delete item;
+    Hypothesis::Destroy(item->GetHypothesis());
+    DeleteItem(item);
   }
 
   // Delete all edges.
@@ -331,7 +333,10 @@ BitmapContainer::Enqueue(int hypothesis_pos
 {
   // Only supply target phrase if running deterministic search mode
   const TargetPhrase *target_phrase = m_deterministic ? &(hypothesis->GetCurrTargetPhrase()) : NULL;
-  HypothesisQueueItem *item = new HypothesisQueueItem(hypothesis_pos
+  void *memory = m_arena
+                 ? m_arena->Allocate(sizeof(HypothesisQueueItem))
+                 : ::operator new(sizeof(HypothesisQueueItem));
+  HypothesisQueueItem *item = new (memory) HypothesisQueueItem(hypothesis_pos
       , translation_pos
       , hypothesis
       , edge
@@ -485,7 +490,18 @@ BitmapContainer::ProcessBestHypothesis()
   item->GetBackwardsEdge()->PushSuccessors(item->GetHypothesisPos(), item->GetTranslationPos());
 
   // We are done with the queue item, we delete it.
-  delete item;
+  DeleteItem(item);
+}
+
+void
+BitmapContainer::DeleteItem(HypothesisQueueItem *item)
+{
+  item->~HypothesisQueueItem();
+  if (m_arena) {
+    m_arena->Free(item, sizeof(HypothesisQueueItem));
+  } else {
+    ::operator delete(item);
+  }
 }
 
 void
@@ -235,10 +235,13 @@ private:
   HypothesisQueue m_queue;
   size_t m_numStackInsertions;
   bool m_deterministic;
+  Arena *m_arena; // of the queue items, if search-arena is set
 
   // We always require a corresponding bitmap to be supplied.
   BitmapContainer();
   BitmapContainer(const BitmapContainer &);
+
+  void DeleteItem(HypothesisQueueItem *item);
 public:
   BitmapContainer(const Bitmap &bitmap
                   , HypothesisStackCubePruning &stack
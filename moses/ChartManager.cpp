@@ -20,6 +20,7 @@
  ***********************************************************************/
 
 #include <cstdio>
+#include <boost/ptr_container/ptr_vector.hpp>
 #include "ChartManager.h"
 #include "ChartCell.h"
 #include "ChartHypothesis.h"
@@ -36,11 +37,106 @@
 #include "moses/HypergraphOutput.h"
 #include "moses/TranslationTask.h"
 
+#ifdef WITH_THREADS
+#include <boost/exception_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include "moses/ThreadPool.h"
+#endif
+
 using namespace std;
 
 namespace Moses
 {
 
+#ifdef WITH_THREADS
+namespace
+{
+
+//! waits for the cells of one span width to be decoded
+class ChartCellLatch
+{
+public:
+  explicit ChartCellLatch(size_t count) : m_count(count) {}
+
+  //! error is empty, or what the cell threw
+  void CountDown(const boost::exception_ptr &error) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (!m_error) {
+      m_error = error;
+    }
+    --m_count;
+    m_done.notify_all();
+  }
+
+  //! rethrows the first exception of a cell in the waiting thread
+  void Wait() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_count) {
+      m_done.wait(lock);
+    }
+    if (m_error) {
+      boost::rethrow_exception(m_error);
+    }
+  }
+
+private:
+  size_t m_count;
+  boost::exception_ptr m_error;
+  boost::mutex m_mutex;
+  boost::condition_variable m_done;
+};
+
+//! decode one chart cell, given the translation options of its range
+class ChartCellDecodeTask : public Task
+{
+public:
+  ChartCellDecodeTask(ChartCell &cell,
+                      const ChartTranslationOptionList &transOptList,
+                      const ChartCellCollection &allChartCells,
+                      ChartCellLatch &latch)
+    : m_cell(cell)
+    , m_transOptList(transOptList)
+    , m_allChartCells(allChartCells)
+    , m_latch(latch) {
+  }
+
+  //! counts down whatever the cell throws, or the waiting thread would hang
+  void Run() {
+    boost::exception_ptr error;
+    try {
+      m_cell.Decode(m_transOptList, m_allChartCells);
+      m_cell.PruneToSize();
+      m_cell.CleanupArcList();
+      m_cell.SortHypotheses();
+    } catch (...) {
+      error = boost::current_exception();
+    }
+    m_latch.CountDown(error);
+  }
+
+private:
+  ChartCell &m_cell;
+  const ChartTranslationOptionList &m_transOptList;
+  const ChartCellCollection &m_allChartCells;
+  ChartCellLatch &m_latch;
+};
+
+//! One pool shared by all sentences. Never deleted: its threads wait for work until exit
+ThreadPool &GetChartThreadPool(size_t numThreads)
+{
+  static boost::mutex mutex;
+  static ThreadPool *pool = NULL;
+  boost::mutex::scoped_lock lock(mutex);
+  if (pool == NULL) {
+    pool = new ThreadPool(numThreads);
+  }
+  return *pool;
+}
+
+}
+#endif
+
 /* constructor. Initialize everything prior to decoding a particular sentence.
  * \param source the sentence to be decoded
  * \param system which particular set of models to use.
@@ -78,27 +174,40 @@ void ChartManager::Decode()
 
   // MAIN LOOP
   size_t size = m_source.GetSize();
-  for (int startPos = size-1; startPos >= 0; --startPos) {
-    for (size_t width = 1; width <= size-startPos; ++width) {
-      size_t endPos = startPos + width - 1;
-      Range range(startPos, endPos);
-
-      // create trans opt
-      m_translationOptionList.Clear();
-      m_parser.Create(range, m_translationOptionList);
-      m_translationOptionList.ApplyThreshold(options()->search.trans_opt_threshold);
-
-      const InputPath &inputPath = m_parser.GetInputPath(range);
-      m_translationOptionList.EvaluateWithSourceContext(m_source, inputPath);
-
-      // decode
-      ChartCell &cell = m_hypoStackColl.Get(range);
-      cell.Decode(m_translationOptionList, m_hypoStackColl);
-
-      m_translationOptionList.Clear();
-      cell.PruneToSize();
-      cell.CleanupArcList();
-      cell.SortHypotheses();
+#ifdef WITH_THREADS
+  size_t numThreads = options()->syntax.chart_threads;
+  if (numThreads > 1) {
+    if (m_parser.SetLookupByWidth(true)) {
+      DecodeByWidth(numThreads);
+    } else {
+      VERBOSE(2, "Rule lookup does not support decoding by span width, decoding serially" << endl);
+    }
+  }
+#endif
+
+  if (!m_parser.IsLookupByWidth()) {
+    for (int startPos = size-1; startPos >= 0; --startPos) {
+      for (size_t width = 1; width <= size-startPos; ++width) {
+        size_t endPos = startPos + width - 1;
+        Range range(startPos, endPos);
+
+        // create trans opt
+        m_translationOptionList.Clear();
+        m_parser.Create(range, m_translationOptionList);
+        m_translationOptionList.ApplyThreshold(options()->search.trans_opt_threshold);
+
+        const InputPath &inputPath = m_parser.GetInputPath(range);
+        m_translationOptionList.EvaluateWithSourceContext(m_source, inputPath);
+
+        // decode
+        ChartCell &cell = m_hypoStackColl.Get(range);
+        cell.Decode(m_translationOptionList, m_hypoStackColl);
+
+        m_translationOptionList.Clear();
+        cell.PruneToSize();
+        cell.CleanupArcList();
+        cell.SortHypotheses();
+      }
     }
   }
 
@@ -123,6 +232,52 @@ void ChartManager::Decode()
   }
 }
 
+#ifdef WITH_THREADS
+/** decode the chart one span width at a time. The cells of one width only
+ *  depend on cells of shorter spans, so they are decoded in parallel.
+ *  Rule lookup stays in this thread, as lookup managers and phrase tables keep
+ *  per-sentence state, and results do not depend on the number of threads.
+ */
+void ChartManager::DecodeByWidth(size_t numThreads)
+{
+  ThreadPool &pool = GetChartThreadPool(numThreads);
+  size_t size = m_source.GetSize();
+
+  // translation options for each cell of the current width
+  boost::ptr_vector<ChartTranslationOptionList> transOptLists;
+  for (size_t i = 0; i < size; ++i) {
+    transOptLists.push_back(new ChartTranslationOptionList(options()->syntax.rule_limit, m_source));
+  }
+
+  for (size_t width = 1; width <= size; ++width) {
+    size_t numCells = size - width + 1;
+
+    // create trans opts, right to left as in the serial loop
+    for (int startPos = numCells-1; startPos >= 0; --startPos) {
+      Range range(startPos, startPos + width - 1);
+      ChartTranslationOptionList &transOptList = transOptLists[startPos];
+
+      transOptList.Clear();
+      m_parser.Create(range, transOptList);
+      transOptList.ApplyThreshold(options()->search.trans_opt_threshold);
+
+      const InputPath &inputPath = m_parser.GetInputPath(range);
+      transOptList.EvaluateWithSourceContext(m_source, inputPath);
+    }
+
+    // decode
+    ChartCellLatch latch(numCells);
+    for (size_t startPos = 0; startPos < numCells; ++startPos) {
+      Range range(startPos, startPos + width - 1);
+      boost::shared_ptr<Task> task(new ChartCellDecodeTask(m_hypoStackColl.Get(range),
+                                   transOptLists[startPos], m_hypoStackColl, latch));
+      pool.Submit(task);
+    }
+    latch.Wait();
+  }
+}
+#endif
+
 /** add specific translation options and hypotheses according to the XML override translation scheme.
  *  Doesn't seem to do anything about walls and zones.
  *  @todo check walls & zones. Check that the implementation doesn't leak, xml options sometimes does if you're not careful
@@ -346,6 +501,7 @@ void ChartManager::OutputNBestList(OutputCollector *collector,
   NBestOptions const& nbo = options()->nbest;
   bool includeWordAlignment = nbo.include_alignment_info;
   bool PrintNBestTrees = nbo.print_trees;
+  BinaryNBestWriter *binary = GetBinaryNBestWriter();
 
   for (ChartKBestExtractor::KBestVec::const_iterator p = nBestList.begin();
        p != nBestList.end(); ++p) {
@@ -360,24 +516,37 @@ void ChartManager::OutputNBestList(OutputCollector *collector,
     outputPhrase.RemoveWord(0);
     outputPhrase.RemoveWord(outputPhrase.GetSize() - 1);
 
+    boost::shared_ptr<ScoreComponentCollection> scoreBreakdown = ChartKBestExtractor::GetOutputScoreBreakdown(derivation);
+
+    // optionally, word alignments
+    std::ostringstream alignment;
+    if (includeWordAlignment) {
+      Alignments align;
+      OutputAlignmentNBest(align, derivation, 0);
+      for (Alignments::const_iterator q = align.begin(); q != align.end();
+           ++q) {
+        alignment << q->first << "-" << q->second << " ";
+      }
+    }
+
+    if (binary) {
+      std::ostringstream surface;
+      OutputSurface(surface, outputPhrase);
+      OutputBinaryNBestEntry(out, *binary, surface.str(), *scoreBreakdown,
+                             derivation.score, alignment.str());
+      continue;
+    }
+
     // print the translation ID, surface factors, and scores
     out << translationId << " ||| ";
     OutputSurface(out, outputPhrase); // , outputFactorOrder, false);
     out << " ||| ";
-    boost::shared_ptr<ScoreComponentCollection> scoreBreakdown = ChartKBestExtractor::GetOutputScoreBreakdown(derivation);
     bool with_labels = options()->nbest.include_feature_labels;
     scoreBreakdown->OutputAllFeatureScores(out, with_labels);
     out << " ||| " << derivation.score;
 
-    // optionally, print word alignments
     if (includeWordAlignment) {
-      out << " ||| ";
-      Alignments align;
-      OutputAlignmentNBest(align, derivation, 0);
-      for (Alignments::const_iterator q = align.begin(); q != align.end();
-           ++q) {
-        out << q->first << "-" << q->second << " ";
-      }
+      out << " ||| " << alignment.str();
     }
 
     // optionally, print tree
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <vector>
+#include <boost/atomic.hpp>
 #include <boost/unordered_map.hpp>
 #include "ChartCell.h"
 #include "ChartCellCollection.h"
@@ -47,12 +48,16 @@ private:
   ChartCellCollection m_hypoStackColl;
   std::auto_ptr<SentenceStats> m_sentenceStats;
   clock_t m_start; /**< starting time, used for logging */
-  unsigned m_hypothesisId; /* For handing out hypothesis ids to ChartHypothesis */
+  boost::atomic<unsigned> m_hypothesisId; /* For handing out hypothesis ids to ChartHypothesis */
 
   ChartParser m_parser;
 
   ChartTranslationOptionList m_translationOptionList; /**< pre-computed list of translation options for the phrases in this sentence */
 
+#ifdef WITH_THREADS
+  void DecodeByWidth(size_t numThreads);
+#endif
+
   /* auxilliary functions for SearchGraphs */
   void FindReachableHypotheses(
     const ChartHypothesis *hypo, std::map<unsigned,bool> &reachable , size_t* winners, size_t* losers) const;
@@ -131,7 +136,8 @@ public:
     m_sentenceStats = std::auto_ptr<SentenceStats>(new SentenceStats(source));
   }
 
-  //! contigious hypo id for each input sentence. For debugging purposes
+  //! contigious hypo id for each input sentence. For debugging purposes.
+  //! Not in creation order if cells are decoded in parallel
   unsigned GetNextHypoId() {
     return m_hypothesisId++;
   }
@@ -162,6 +162,7 @@ ChartParser
   , m_unknown(ttask)
   , m_decodeGraphList(StaticData::Instance().GetDecodeGraphs())
   , m_source(*(ttask->GetSource().get()))
+  , m_lookupByWidth(false)
 {
   const StaticData &staticData = StaticData::Instance();
 
@@ -231,6 +232,15 @@ void ChartParser::Create(const Range &range, ChartParserCallback &to)
   }
 }
 
+bool ChartParser::SetLookupByWidth(bool lookupByWidth)
+{
+  m_lookupByWidth = lookupByWidth;
+  for (size_t i = 0; i < m_ruleLookupManagers.size(); ++i) {
+    m_lookupByWidth = m_lookupByWidth && m_ruleLookupManagers[i]->SupportsLookupByWidth();
+  }
+  return m_lookupByWidth;
+}
+
 void ChartParser::CreateInputPaths(const InputType &input)
 {
   size_t size = input.GetSize();
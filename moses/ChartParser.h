@@ -69,6 +69,15 @@ public:
 
   void Create(const Range &range, ChartParserCallback &to);
 
+  /** Look up ranges span width by span width rather than in the serial
+   *  CKY+ order, if all rule lookup managers support it.
+   *  Returns whether lookup by width is on. Create() is not thread-safe either way.
+   */
+  bool SetLookupByWidth(bool lookupByWidth);
+  bool IsLookupByWidth() const {
+    return m_lookupByWidth;
+  }
+
   //! the sentence being decoded
   //const Sentence &GetSentence() const;
   long GetTranslationId() const;
@@ -89,6 +98,7 @@ private:
 
   typedef std::vector< std::vector<InputPath*> > InputPathMatrix;
   InputPathMatrix	m_inputPathMatrix;
+  bool m_lookupByWidth;
 
   void CreateInputPaths(const InputType &input);
   InputPath &GetInputPath(size_t startPos, size_t endPos);
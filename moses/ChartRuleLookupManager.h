@@ -69,6 +69,15 @@ public:
     size_t lastPos,  // last position to consider if using lookahead
     ChartParserCallback &outColl) = 0;
 
+  /** Whether GetChartRuleCollection() can be called span width by span
+   *  width, each range needing only the chart cells of shorter spans.
+   *  Otherwise ranges must be visited in the order of the serial CKY+ loop:
+   *  start positions right to left, then increasing width.
+   */
+  virtual bool SupportsLookupByWidth() const {
+    return false;
+  }
+
 private:
   //! Non-copyable: copy constructor and assignment operator not implemented.
   ChartRuleLookupManager(const ChartRuleLookupManager &);
@@ -123,6 +123,7 @@ string SimpleTranslationInterface::translate(const string &inputString)
   boost::shared_ptr<TranslationTask> task
   = TranslationTask::create(source, ioWrapper);
   task->Run();
+  ioWrapper->GetSingleBestOutputCollector()->Flush();
 
   string output = outputStream.str();
   //now trim the end whitespace
@@ -303,6 +304,9 @@ batch_run()
   IFVERBOSE(0) util::PrintUsage(std::cerr);
 
 #ifndef EXIT_RETURN
+  // the collectors write from threads of their own, so wait for them here
+  // rather than in ~IOWrapper
+  ioWrapper->Flush();
   //This avoids that destructors are called (it can take a long time)
   exit(EXIT_SUCCESS);
 #else
@@ -303,7 +303,7 @@ FFState* DistortionScoreProducer::EvaluateWhenApplied(
                                   prev->first_gap);
   out->PlusEquals(this, distortionScore);
 
-  DistortionState* state = new DistortionState(
+  DistortionState* state = new (hypo.GetArena()) DistortionState(
     hypo.GetCurrSourceWordsRange(),
     hypo.GetWordsBitmap().GetFirstGapPos(),
     subordinateConjunction);
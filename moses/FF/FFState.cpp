@@ -1,9 +1,38 @@
 #include "moses/FF/FFState.h"
+#include "moses/Arena.h"
 
 namespace Moses
 {
 
 FFState::~FFState() {}
 
+void *FFState::operator new(size_t size, Arena *arena)
+{
+  return arena ? arena->AllocateTagged(size) : ::operator new(size);
+}
+
+void FFState::operator delete(void *p, Arena *arena)
+{
+  // only called if a constructor throws
+  if (arena) {
+    arena->FreeTagged(p);
+  } else {
+    ::operator delete(p);
+  }
 }
 
+void FFState::Delete(const FFState *state, Arena *arena)
+{
+  if (arena && state) {
+    // states of feature functions that don't use the arena are on the heap
+    const void *p = dynamic_cast<const void*>(state);
+    if (arena->Owns(p)) {
+      state->~FFState();
+      arena->FreeTagged(const_cast<void*>(p));
+      return;
+    }
+  }
+  delete state;
+}
+
+}
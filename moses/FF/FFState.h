@@ -7,11 +7,29 @@
 
 namespace Moses
 {
+class Arena;
 
 class FFState
 {
 public:
   virtual ~FFState();
+
+  /** new (arena) State(...) places a state in the arena of a phrase-based
+   * search with search-arena set, see Hypothesis::GetArena(). With a NULL
+   * arena, it is allocated as usual. Free either kind with Delete()
+   */
+  static void *operator new(size_t size, Arena *arena);
+  static void operator delete(void *p, Arena *arena);
+  static void *operator new(size_t size) {
+    return ::operator new(size);
+  }
+  static void operator delete(void *p) {
+    ::operator delete(p);
+  }
+
+  //! deletes state, which may be in arena
+  static void Delete(const FFState *state, Arena *arena);
+
   virtual size_t hash() const = 0;
   virtual bool operator==(const FFState& other) const = 0;
 
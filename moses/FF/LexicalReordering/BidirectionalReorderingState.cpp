@@ -27,11 +27,12 @@ bool BidirectionalReorderingState::operator==(const FFState& o) const
 LRState*
 BidirectionalReorderingState::
 Expand(const TranslationOption& topt, const InputType& input,
-       ScoreComponentCollection* scores) const
+       ScoreComponentCollection* scores, Arena *arena) const
 {
-  LRState *newbwd = m_backward->Expand(topt,input, scores);
-  LRState *newfwd = m_forward->Expand(topt, input, scores);
-  return new BidirectionalReorderingState(m_configuration, newbwd, newfwd, m_offset);
+  LRState *newbwd = m_backward->Expand(topt, input, scores, arena);
+  LRState *newfwd = m_forward->Expand(topt, input, scores, arena);
+  return new (arena) BidirectionalReorderingState(m_configuration, newbwd, newfwd,
+         m_offset, arena);
 }
 
 }
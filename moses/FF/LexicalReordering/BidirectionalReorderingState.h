@@ -10,20 +10,23 @@ class BidirectionalReorderingState
 private:
   const LRState *m_backward;
   const LRState *m_forward;
+  Arena *m_arena; // of the two states, if any
 public:
   BidirectionalReorderingState(const LRModel &config,
                                const LRState *bw,
-                               const LRState *fw, size_t offset)
+                               const LRState *fw, size_t offset,
+                               Arena *arena = NULL)
     : LRState(config,
               LRModel::Bidirectional,
               offset)
     , m_backward(bw)
     , m_forward(fw)
+    , m_arena(arena)
   { }
 
   ~BidirectionalReorderingState() {
-    delete m_backward;
-    delete m_forward;
+    FFState::Delete(m_backward, m_arena);
+    FFState::Delete(m_forward, m_arena);
   }
 
   virtual size_t hash() const;
@@ -31,7 +34,7 @@ public:
 
   LRState*
   Expand(const TranslationOption& topt, const InputType& input,
-         ScoreComponentCollection*  scores) const;
+         ScoreComponentCollection*  scores, Arena *arena) const;
 };
 
 }
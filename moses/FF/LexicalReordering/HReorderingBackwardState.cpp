@@ -35,10 +35,10 @@ bool HReorderingBackwardState::operator==(const FFState& o) const
 LRState*
 HReorderingBackwardState::
 Expand(const TranslationOption& topt, const InputType& input,
-       ScoreComponentCollection*  scores) const
+       ScoreComponentCollection*  scores, Arena *arena) const
 {
   HReorderingBackwardState* nextState;
-  nextState = new HReorderingBackwardState(this, topt, m_reoStack);
+  nextState = new (arena) HReorderingBackwardState(this, topt, m_reoStack);
   Range swrange = topt.GetSourceWordsRange();
   int reoDistance = nextState->m_reoStack.ShiftReduce(swrange);
   ReorderingType reoType = m_configuration.GetOrientation(reoDistance);
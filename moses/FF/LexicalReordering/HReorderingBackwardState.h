@@ -21,7 +21,7 @@ public:
   virtual bool operator==(const FFState& other) const;
 
   virtual LRState* Expand(const TranslationOption& hypo, const InputType& input,
-                          ScoreComponentCollection*  scores) const;
+                          ScoreComponentCollection*  scores, Arena *arena) const;
 
 private:
   ReorderingType GetOrientationTypeMSD(int reoDistance) const;
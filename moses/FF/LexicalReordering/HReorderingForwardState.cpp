@@ -62,7 +62,7 @@ bool HReorderingForwardState::operator==(const FFState& o) const
 LRState*
 HReorderingForwardState::
 Expand(TranslationOption const& topt, InputType const& input,
-       ScoreComponentCollection* scores) const
+       ScoreComponentCollection* scores, Arena *arena) const
 {
   const Range cur = topt.GetSourceWordsRange();
   // keep track of the current coverage ourselves so we don't need the hypothesis
@@ -72,7 +72,7 @@ Expand(TranslationOption const& topt, InputType const& input,
     reoType = m_configuration.GetOrientation(m_prevRange,cur,cov);
     CopyScores(scores, topt, input, reoType);
   }
-  return new HReorderingForwardState(this, topt);
+  return new (arena) HReorderingForwardState(this, topt);
 }
 
 }
@@ -26,7 +26,8 @@ public:
 
   virtual LRState* Expand(const TranslationOption& hypo,
                           const InputType& input,
-                          ScoreComponentCollection* scores) const;
+                          ScoreComponentCollection* scores,
+                          Arena *arena) const;
 };
 
 }
@@ -32,8 +32,6 @@ CopyScores(ScoreComponentCollection*  accum,
   LexicalReordering* producer = m_configuration.GetScoreProducer();
   Scores const* cached = relevantOpt->GetLexReorderingScores(producer);
 
-  // The approach here is bizarre! Why create a whole vector and do
-  // vector addition (acumm->PlusEquals) to update a single value? - UG
   size_t off_remote = m_offset + reoType;
   size_t off_local  = m_configuration.CollapseScores() ? m_offset : off_remote;
 
@@ -43,16 +41,13 @@ CopyScores(ScoreComponentCollection*  accum,
   // look up applicable score from vectore of scores
   if(cached) {
     UTIL_THROW_IF2(off_remote >= cached->size(), "offset out of vector bounds!");
-    Scores scores(producer->GetNumScoreComponents(),0);
-    scores[off_local ] = (*cached)[off_remote];
-    accum->PlusEquals(producer, scores);
+    accum->PlusEquals(producer->GetIndex() + off_local, (*cached)[off_remote]);
   }
 
   // else: use default scores (if specified)
   else if (producer->GetHaveDefaultScores()) {
-    Scores scores(producer->GetNumScoreComponents(),0);
-    scores[off_local] = producer->GetDefaultScore(off_remote);
-    accum->PlusEquals(m_configuration.GetScoreProducer(), scores);
+    accum->PlusEquals(producer->GetIndex() + off_local,
+                      producer->GetDefaultScore(off_remote));
   }
   // note: if no default score, no cost
 
@@ -24,7 +24,7 @@ public:
   virtual
   LRState*
   Expand(const TranslationOption& hypo, const InputType& input,
-         ScoreComponentCollection* scores) const = 0;
+         ScoreComponentCollection* scores, Arena *arena) const = 0;
 
   static
   LRState*
@@ -108,7 +108,8 @@ EvaluateWhenApplied(const Hypothesis& hypo,
 {
   VERBOSE(3,"LexicalReordering::Evaluate(const Hypothesis& hypo,...) START" << std::endl);
   const LRState *prev = static_cast<const LRState *>(prev_state);
-  LRState *next_state = prev->Expand(hypo.GetTranslationOption(), hypo.GetInput(), out);
+  LRState *next_state = prev->Expand(hypo.GetTranslationOption(), hypo.GetInput(), out,
+                                         hypo.GetArena());
 
   VERBOSE(3,"LexicalReordering::Evaluate(const Hypothesis& hypo,...) END" << std::endl);
 
@@ -54,7 +54,7 @@ bool PhraseBasedReorderingState::operator==(const FFState& o) const
 LRState*
 PhraseBasedReorderingState::
 Expand(const TranslationOption& topt, const InputType& input,
-       ScoreComponentCollection* scores) const
+       ScoreComponentCollection* scores, Arena *arena) const
 {
   // const LRModel::ModelType modelType = m_configuration.GetModelType();
 
@@ -65,7 +65,7 @@ Expand(const TranslationOption& topt, const InputType& input,
                                        : lrmodel.GetOrientation(m_prevRange,cur));
     CopyScores(scores, topt, input, reoType);
   }
-  return new PhraseBasedReorderingState(this, topt);
+  return new (arena) PhraseBasedReorderingState(this, topt);
 }
 
 }
@@ -26,7 +26,7 @@ public:
   virtual
   LRState*
   Expand(const TranslationOption& topt,const InputType& input,
-         ScoreComponentCollection*  scores) const;
+         ScoreComponentCollection*  scores, Arena *arena) const;
 };
 
 }
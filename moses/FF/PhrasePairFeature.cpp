@@ -1,4 +1,5 @@
 #include <boost/algorithm/string.hpp>
+#include <boost/functional/hash.hpp>
 
 #include "PhrasePairFeature.h"
 #include "moses/AlignmentInfo.h"
@@ -15,6 +16,81 @@ using namespace std;
 namespace Moses
 {
 
+namespace
+{
+// The key of a simple feature, read from the phrase pair instead of copied
+// into a vector: the source factors, NULL, then the target factors.
+class PhrasePairKey
+{
+public:
+  PhrasePairKey(const Phrase &source, FactorType sourceFactorId,
+                const Phrase &target, FactorType targetFactorId)
+    : m_source(source)
+    , m_target(target)
+    , m_sourceFactorId(sourceFactorId)
+    , m_targetFactorId(targetFactorId) {
+  }
+
+  size_t size() const {
+    return m_source.GetSize() + 1 + m_target.GetSize();
+  }
+
+  const Factor *operator[](size_t i) const {
+    if (i < m_source.GetSize()) {
+      return m_source.GetWord(i).GetFactor(m_sourceFactorId);
+    }
+    if (i == m_source.GetSize()) {
+      return NULL;
+    }
+    return m_target.GetWord(i - m_source.GetSize() - 1).GetFactor(m_targetFactorId);
+  }
+
+private:
+  const Phrase &m_source;
+  const Phrase &m_target;
+  FactorType m_sourceFactorId;
+  FactorType m_targetFactorId;
+};
+
+template <class Key>
+size_t HashFactors(const Key &key)
+{
+  size_t seed = 0;
+  for (size_t i = 0; i < key.size(); ++i) {
+    boost::hash_combine(seed, key[i]);
+  }
+  return seed;
+}
+
+struct PhrasePairKeyHash {
+  size_t operator()(const PhrasePairKey &key) const {
+    return HashFactors(key);
+  }
+};
+
+struct PhrasePairKeyEquals {
+  bool operator()(const PhrasePairKey &lhs, const std::vector<const Factor*> &rhs) const {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < rhs.size(); ++i) {
+      if (lhs[i] != rhs[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool operator()(const std::vector<const Factor*> &lhs, const PhrasePairKey &rhs) const {
+    return (*this)(rhs, lhs);
+  }
+};
+}
+
+size_t PhrasePairFeature::SimpleKeyHash::operator()(const SimpleKey &key) const
+{
+  return HashFactors(key);
+}
+
 PhrasePairFeature::PhrasePairFeature(const std::string &line)
   :StatelessFeatureFunction(0, line)
   ,m_unrestricted(false)
@@ -241,6 +317,13 @@ void PhrasePairFeature::EvaluateInIsolation(const Phrase &source
     , ScoreComponentCollection &estimatedScores) const
 {
   if (m_simple) {
+    const PhrasePairKey pairKey(source, m_sourceFactorId, targetPhrase, m_targetFactorId);
+    const FName *name = m_simpleNames.find(pairKey, PhrasePairKeyHash(), PhrasePairKeyEquals());
+    if (name) {
+      scoreBreakdown.SparsePlusEquals(*name, 1);
+      return;
+    }
+
     util::StringStream namestr;
     namestr << m_description << "_";
     namestr << ReplaceTilde( source.GetWord(0).GetFactor(m_sourceFactorId)->GetString() );
@@ -256,7 +339,11 @@ void PhrasePairFeature::EvaluateInIsolation(const Phrase &source
       namestr << "~";
       namestr << ReplaceTilde( targetFactor->GetString() );
     }
-    scoreBreakdown.SparsePlusEquals(namestr.str(),1);
+    SimpleKey key(pairKey.size());
+    for (size_t i = 0; i < key.size(); ++i) {
+      key[i] = pairKey[i];
+    }
+    scoreBreakdown.SparsePlusEquals(m_simpleNames.add(key, namestr.str()), 1);
   }
 }
 
@@ -5,6 +5,7 @@
 
 #include "StatelessFeatureFunction.h"
 #include "moses/Factor.h"
+#include "moses/FeatureVector.h"
 #include "moses/Sentence.h"
 
 namespace Moses
@@ -30,6 +31,12 @@ class PhrasePairFeature: public StatelessFeatureFunction
   bool m_ignorePunctuation;
   CharHash m_punctuationHash;
   std::string m_filePathSource;
+  // key of a simple feature: the source factors, NULL and the target factors
+  typedef std::vector<const Factor*> SimpleKey;
+  struct SimpleKeyHash {
+    size_t operator()(const SimpleKey &key) const;
+  };
+  FNameCache<SimpleKey, SimpleKeyHash> m_simpleNames;
 
   inline std::string ReplaceTilde(const StringPiece &str) const {
     std::string out = str.as_string();
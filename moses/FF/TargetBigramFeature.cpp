@@ -94,35 +94,41 @@ FFState* TargetBigramFeature::EvaluateWhenApplied(const Hypothesis& cur_hypo,
       f1 = targetPhrase.GetWord(i-1).GetFactor(m_factorType);
     }
     const Factor* f2 = targetPhrase.GetWord(i).GetFactor(m_factorType);
-    const StringPiece w1 = f1->GetString();
-    const StringPiece w2 = f2->GetString();
 
     // skip bigrams if they don't belong to a given restricted vocabulary
     if (m_vocab.size() &&
-        (FindStringPiece(m_vocab, w1) == m_vocab.end() || FindStringPiece(m_vocab, w2) == m_vocab.end())) {
+        (FindStringPiece(m_vocab, f1->GetString()) == m_vocab.end() ||
+         FindStringPiece(m_vocab, f2->GetString()) == m_vocab.end())) {
       continue;
     }
 
-    string name(w1.data(), w1.size());
-    name += ":";
-    name.append(w2.data(), w2.size());
-    accumulator->PlusEquals(this,name,1);
+    accumulator->SparsePlusEquals(GetName(f1, f2), 1);
   }
 
   if (cur_hypo.GetWordsBitmap().IsComplete()) {
-    const StringPiece w1 = targetPhrase.GetWord(targetPhrase.GetSize()-1).GetFactor(m_factorType)->GetString();
-    const string& w2 = EOS_;
-    if (m_vocab.empty() || (FindStringPiece(m_vocab, w1) != m_vocab.end())) {
-      string name(w1.data(), w1.size());
-      name += ":";
-      name += w2;
-      accumulator->PlusEquals(this,name,1);
+    const Factor *f1 = targetPhrase.GetWord(targetPhrase.GetSize()-1).GetFactor(m_factorType);
+    if (m_vocab.empty() || (FindStringPiece(m_vocab, f1->GetString()) != m_vocab.end())) {
+      accumulator->SparsePlusEquals(GetName(f1, NULL), 1);
     }
     return NULL;
   }
   return new TargetBigramState(targetPhrase.GetWord(targetPhrase.GetSize()-1));
 }
 
+const FName &TargetBigramFeature::GetName(const Factor *f1, const Factor *f2) const
+{
+  const std::pair<const Factor*, const Factor*> key(f1, f2);
+  const FName *name = m_names.find(key);
+  if (name) {
+    return *name;
+  }
+  string str = GetScoreProducerDescription() + FName::SEP;
+  str += f1->GetString().as_string();
+  str += ":";
+  str += f2 ? f2->GetString().as_string() : string(EOS_);
+  return m_names.add(key, str);
+}
+
 bool TargetBigramFeature::IsUseable(const FactorMask &mask) const
 {
   bool ret = mask[m_factorType];
@@ -8,6 +8,7 @@
 #include "moses/FF/FFState.h"
 #include "StatefulFeatureFunction.h"
 #include "moses/FactorCollection.h"
+#include "moses/FeatureVector.h"
 #include "moses/Word.h"
 
 namespace Moses
@@ -56,6 +57,10 @@ private:
   Word m_bos;
   std::string m_filePath;
   boost::unordered_set<std::string> m_vocab;
+  // names of seen bigrams, the second factor is NULL for </s>
+  FNameCache<std::pair<const Factor*, const Factor*> > m_names;
+
+  const FName &GetName(const Factor *f1, const Factor *f2) const;
 };
 
 }
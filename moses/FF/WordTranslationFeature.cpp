@@ -156,8 +156,10 @@ void WordTranslationFeature::EvaluateWithSourceContext(const InputType &input
     if (m_factorTypeSource == 0 && ws.IsNonTerminal()) continue;
     Word wt = targetPhrase.GetWord(targetIndex);
     if (m_factorTypeSource == 0 && wt.IsNonTerminal()) continue;
-    StringPiece sourceWord = ws.GetFactor(m_factorTypeSource)->GetString();
-    StringPiece targetWord = wt.GetFactor(m_factorTypeTarget)->GetString();
+    const Factor *sourceFactor = ws.GetFactor(m_factorTypeSource);
+    const Factor *targetFactor = wt.GetFactor(m_factorTypeTarget);
+    StringPiece sourceWord = sourceFactor->GetString();
+    StringPiece targetWord = targetFactor->GetString();
     if (m_ignorePunctuation) {
       // check if source or target are punctuation
       char firstChar = sourceWord[0];
@@ -171,20 +173,29 @@ void WordTranslationFeature::EvaluateWithSourceContext(const InputType &input
     }
 
     if (!m_unrestricted) {
-      if (FindStringPiece(m_vocabSource, sourceWord) == m_vocabSource.end())
+      if (FindStringPiece(m_vocabSource, sourceWord) == m_vocabSource.end()) {
         sourceWord = "OTHER";
-      if (FindStringPiece(m_vocabTarget, targetWord) == m_vocabTarget.end())
+        sourceFactor = NULL;
+      }
+      if (FindStringPiece(m_vocabTarget, targetWord) == m_vocabTarget.end()) {
+        targetFactor = NULL;
         targetWord = "OTHER";
+      }
     }
 
     if (m_simple) {
-      // construct feature name
-      util::StringStream featureName;
-      featureName << m_description << "_";
-      featureName << sourceWord;
-      featureName << "~";
-      featureName << targetWord;
-      scoreBreakdown.SparsePlusEquals(featureName.str(), 1);
+      const WordPair key(sourceFactor, targetFactor);
+      const FName *name = m_simpleNames.find(key);
+      if (!name) {
+        // construct feature name
+        util::StringStream featureName;
+        featureName << m_description << "_";
+        featureName << sourceWord;
+        featureName << "~";
+        featureName << targetWord;
+        name = &m_simpleNames.add(key, featureName.str());
+      }
+      scoreBreakdown.SparsePlusEquals(*name, 1);
     }
     if (m_domainTrigger && !m_sourceContext) {
       const bool use_topicid = sentence.GetUseTopicId();
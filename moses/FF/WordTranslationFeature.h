@@ -4,6 +4,7 @@
 #include <boost/unordered_set.hpp>
 
 #include "moses/FactorCollection.h"
+#include "moses/FeatureVector.h"
 #include "moses/Sentence.h"
 #include "StatelessFeatureFunction.h"
 
@@ -17,6 +18,8 @@ class WordTranslationFeature : public StatelessFeatureFunction
 
   typedef std::map< char, short > CharHash;
   typedef std::vector< boost::unordered_set<std::string> > DocumentVector;
+  // source and target factor of a simple feature, NULL for OTHER
+  typedef std::pair<const Factor*, const Factor*> WordPair;
 
 private:
   boost::unordered_set<std::string> m_vocabSource;
@@ -33,6 +36,7 @@ private:
   CharHash m_punctuationHash;
   std::string m_filePathSource;
   std::string m_filePathTarget;
+  FNameCache<WordPair> m_simpleNames;
 
 public:
   WordTranslationFeature(const std::string &line);
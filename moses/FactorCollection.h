@@ -28,14 +28,16 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 #ifdef WITH_THREADS
-#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
 #endif
+#include <boost/atomic.hpp>
 
 #include "util/murmur_hash.hh"
 #include <boost/unordered_set.hpp>
 
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "util/string_piece.hh"
 #include "util/pool.hh"
@@ -70,30 +72,47 @@ class FactorCollection
   friend std::ostream& operator<<(std::ostream&, const FactorCollection&);
   friend class ::System;
 
-  struct HashFactor : public std::unary_function<const FactorFriend &, std::size_t> {
-    std::size_t operator()(const FactorFriend &factor) const {
-      return util::MurmurHashNative(factor.in.m_string.data(), factor.in.m_string.size());
-    }
+  /** Open-addressing hash table of factors, linear probing.
+   * A slot is written exactly once, after the factor it points to is fully
+   * constructed, so readers can probe it without taking any lock.
+   */
+  struct Table {
+    explicit Table(size_t size);
+    ~Table();
+
+    size_t mask;
+    boost::atomic<const FactorFriend*> *slots;
   };
-  struct EqualsFactor : public std::binary_function<const FactorFriend &, const FactorFriend &, bool> {
-    bool operator()(const FactorFriend &left, const FactorFriend &right) const {
-      return left.in.GetString() == right.in.GetString();
-    }
+
+  /** Factors are spread over NumShards independent tables by the high bits of
+   * their hash. Only insertion of a new factor locks, and only its own shard.
+   * Tables replaced by a resize are kept until destruction since a reader may
+   * still be probing them.
+   */
+  struct Shard {
+    Shard();
+    ~Shard();
+
+    boost::atomic<Table*> table;
+    std::vector<Table*> retired;
+    size_t size;
+    util::Pool factorBacking; //! only ever holds FactorFriend, so stays aligned
+    util::Pool stringBacking;
+#ifdef WITH_THREADS
+    boost::mutex writeLock;
+#endif
   };
-  typedef boost::unordered_set<FactorFriend, HashFactor, EqualsFactor> Set;
-  Set m_set;
-  Set m_setNonTerminal;
 
-  util::Pool m_string_backing;
+  static const size_t NumShardBits = 6;
+  static const size_t NumShards = 1 << NumShardBits;
+
+  Shard m_shards[NumShards];
+  Shard m_shardsNonTerminal[NumShards];
 
   static FactorCollection s_instance;
-#ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::shared_mutex m_accessLock;
-#endif
 
-  size_t m_factorIdNonTerminal; /**< unique, contiguous ids, starting from 0, for each non-terminal factor */
-  size_t m_factorId; /**< unique, contiguous ids, starting from moses_MaxNumNonterminals, for each terminal factor */
+  boost::atomic<size_t> m_factorIdNonTerminal; /**< unique, contiguous ids, starting from 0, for each non-terminal factor */
+  boost::atomic<size_t> m_factorId; /**< unique, contiguous ids, starting from moses_MaxNumNonterminals, for each terminal factor */
 
   //! constructor. only the 1 static variable can be created
   FactorCollection()
@@ -101,6 +120,15 @@ class FactorCollection
     , m_factorId(moses_MaxNumNonterminals) {
   }
 
+  Shard &GetShard(uint64_t hash, bool isNonTerminal) {
+    size_t ind = hash >> (64 - NumShardBits);
+    return isNonTerminal ? m_shardsNonTerminal[ind] : m_shards[ind];
+  }
+
+  static const FactorFriend *Find(const Table &table, uint64_t hash, const StringPiece &factorString);
+  static void Insert(Table &table, uint64_t hash, const FactorFriend *factor);
+  static Table *Grow(Shard &shard);
+
 public:
   static FactorCollection& Instance() {
     return s_instance;
@@ -114,7 +142,7 @@ public:
   const Factor *AddFactor(const StringPiece &factorString, bool isNonTerminal = false);
 
   size_t GetNumNonTerminals() {
-    return m_factorIdNonTerminal;
+    return m_factorIdNonTerminal.load();
   }
 
   const Factor *GetFactor(const StringPiece &factorString, bool isNonTerminal = false);
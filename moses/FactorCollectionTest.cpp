@@ -0,0 +1,94 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+#include "FactorCollection.h"
+
+using namespace Moses;
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(factor_collection)
+
+BOOST_AUTO_TEST_CASE(add_and_get)
+{
+  FactorCollection &collection = FactorCollection::Instance();
+  const Factor *a = collection.AddFactor("fc_test_a");
+  const Factor *b = collection.AddFactor("fc_test_b");
+  BOOST_CHECK(a != b);
+  BOOST_CHECK_NE(a->GetId(), b->GetId());
+  BOOST_CHECK_EQUAL(a, collection.AddFactor("fc_test_a"));
+  BOOST_CHECK_EQUAL(a, collection.GetFactor("fc_test_a"));
+  BOOST_CHECK_EQUAL(a->GetString(), StringPiece("fc_test_a"));
+  BOOST_CHECK(collection.GetFactor("fc_test_never_added") == NULL);
+
+  // terminals and non-terminals are kept apart
+  const Factor *nt = collection.AddFactor("fc_test_a", true);
+  BOOST_CHECK(nt != a);
+  BOOST_CHECK_LT(nt->GetId(), (size_t) moses_MaxNumNonterminals);
+  BOOST_CHECK_EQUAL(nt, collection.GetFactor("fc_test_a", true));
+}
+
+static void AddMany(size_t threadInd, size_t num, vector<const Factor*> *out)
+{
+  FactorCollection &collection = FactorCollection::Instance();
+  out->resize(num);
+  // every thread adds the same words, in a different order, so that inserts
+  // race with each other and with the tables growing
+  for (size_t i = 0; i < num; ++i) {
+    size_t ind = (i * 7 + threadInd * 131) % num;
+    stringstream strme;
+    strme << "fc_test_concurrent_" << ind;
+    (*out)[ind] = collection.AddFactor(strme.str());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_add)
+{
+  const size_t numThreads = 8;
+  const size_t num = 20000;
+  vector<vector<const Factor*> > factors(numThreads);
+
+  boost::thread_group threads;
+  for (size_t i = 0; i < numThreads; ++i) {
+    threads.create_thread(boost::bind(&AddMany, i, num, &factors[i]));
+  }
+  threads.join_all();
+
+  set<size_t> ids;
+  for (size_t i = 0; i < num; ++i) {
+    for (size_t j = 1; j < numThreads; ++j) {
+      BOOST_REQUIRE_EQUAL(factors[0][i], factors[j][i]);
+    }
+    ids.insert(factors[0][i]->GetId());
+
+    stringstream strme;
+    strme << "fc_test_concurrent_" << i;
+    BOOST_REQUIRE_EQUAL(factors[0][i]->GetString(), StringPiece(strme.str()));
+  }
+  BOOST_CHECK_EQUAL(ids.size(), num);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -23,9 +23,16 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <sstream>
 #include <stdexcept>
 
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
 #if defined __MINGW32__ && defined WITH_THREADS
 #include <boost/thread/locks.hpp>
 #endif // WITH_THREADS
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
 
 #include "FeatureVector.h"
 #include "util/string_piece_hash.hh"
@@ -38,53 +45,147 @@ namespace Moses
 {
 
 const string FName::SEP = "_";
-FName::Name2Id FName::name2id;
-vector<string> FName::id2name;
 FName::Id2Count FName::id2hopeCount;
 FName::Id2Count FName::id2fearCount;
 #ifdef WITH_THREADS
 boost::shared_mutex FName::m_idLock;
 #endif
 
-void FName::init(const StringPiece &name)
+/** Ids of all feature names. The name to id maps are split in shards with
+ * a lock each, so that threads looking up different names rarely meet.
+ * Names are stored by id in chunks that never move, so that FName::name()
+ * reads them without a lock.
+ */
+class FNameRegistry
 {
+public:
+  FNameRegistry() : m_size(0) {
+    std::fill(m_chunks, m_chunks + MAX_CHUNKS, (std::string*) NULL);
+  }
+
+  ~FNameRegistry() {
+    for (size_t i = 0; i < MAX_CHUNKS && m_chunks[i]; ++i) {
+      delete [] m_chunks[i];
+    }
+  }
+
+  // returns the id of name, registering it if it is new
+  size_t GetId(const StringPiece &name) {
+    Shard &shard = GetShard(name);
+    {
 #ifdef WITH_THREADS
-  //reader lock
-  boost::shared_lock<boost::shared_mutex> lock(m_idLock);
+      boost::shared_lock<boost::shared_mutex> lock(shard.lock);
 #endif
-  Name2Id::iterator i = FindStringPiece(name2id, name);
-  if (i != name2id.end()) {
-    m_id = i->second;
-  } else {
+      FName::Name2Id::const_iterator i = FindStringPiece(shard.ids, name);
+      if (i != shard.ids.end()) {
+        return i->second;
+      }
+    }
+#ifdef WITH_THREADS
+    boost::unique_lock<boost::shared_mutex> lock(shard.lock);
+#endif
+    // someone else may have added it in between
+    FName::Name2Id::const_iterator i = FindStringPiece(shard.ids, name);
+    if (i != shard.ids.end()) {
+      return i->second;
+    }
+    size_t id = Append(name);
+    shard.ids[std::string(name.data(), name.size())] = id;
+    return id;
+  }
+
+  bool Find(const StringPiece &name, size_t &id) {
+    Shard &shard = GetShard(name);
+#ifdef WITH_THREADS
+    boost::shared_lock<boost::shared_mutex> lock(shard.lock);
+#endif
+    FName::Name2Id::const_iterator i = FindStringPiece(shard.ids, name);
+    if (i == shard.ids.end()) {
+      return false;
+    }
+    id = i->second;
+    return true;
+  }
+
+  const std::string &GetName(size_t id) const {
+    return m_chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)];
+  }
+
+  // dense-only mode, if no name has been registered yet
+  void SelectDenseOnly() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_appendLock);
+#endif
+    FVector::s_denseOnly = (m_size == 0);
+  }
+
+private:
+  static const size_t SHARDS = 64;
+  static const size_t CHUNK_BITS = 14;
+  static const size_t CHUNK_SIZE = 1 << CHUNK_BITS;
+  static const size_t MAX_CHUNKS = 1 << 14;
+
+  struct Shard {
+    FName::Name2Id ids;
+#ifdef WITH_THREADS
+    boost::shared_mutex lock;
+#endif
+  };
+
+  Shard m_shards[SHARDS];
+  std::string *m_chunks[MAX_CHUNKS];
+  size_t m_size;
+#ifdef WITH_THREADS
+  boost::mutex m_appendLock;
+#endif
+
+  Shard &GetShard(const StringPiece &name) {
+    return m_shards[hash_value(name) % SHARDS];
+  }
+
+  size_t Append(const StringPiece &name) {
 #ifdef WITH_THREADS
-    //release the reader lock, and upgrade to writer lock
-    lock.unlock();
-    boost::unique_lock<boost::shared_mutex> write_lock(m_idLock);
+    boost::mutex::scoped_lock lock(m_appendLock);
 #endif
-    std::pair<std::string, size_t> to_ins;
-    to_ins.first.assign(name.data(), name.size());
-    to_ins.second = name2id.size();
-    std::pair<Name2Id::iterator, bool> res(name2id.insert(to_ins));
-    if (res.second) {
-      // TODO this should be string pointers backed by the hash table.
-      id2name.push_back(to_ins.first);
+    size_t id = m_size;
+    UTIL_THROW_IF2((id >> CHUNK_BITS) >= MAX_CHUNKS, "Too many feature names");
+    std::string *&chunk = m_chunks[id >> CHUNK_BITS];
+    if (!chunk) {
+      chunk = new std::string[CHUNK_SIZE];
     }
-    m_id = res.first->second;
+    chunk[id & (CHUNK_SIZE - 1)].assign(name.data(), name.size());
+    ++m_size;
+    // before any thread can find the name and put it in a vector
+    FVector::s_denseOnly = false;
+    return id;
   }
+};
+
+namespace
+{
+FNameRegistry &Registry()
+{
+  static FNameRegistry registry;
+  return registry;
+}
+}
+
+void FName::init(const StringPiece &name)
+{
+  m_id = Registry().GetId(name);
 }
 
 size_t FName::getId(const string& name)
 {
-  Name2Id::iterator i = name2id.find(name);
-  assert (i != name2id.end());
-  return i->second;
+  size_t id = 0;
+  UTIL_THROW_IF2(!Registry().Find(name, id), "Unknown feature name " << name);
+  return id;
 }
 
 size_t FName::getHopeIdCount(const string& name)
 {
-  Name2Id::iterator i = name2id.find(name);
-  if (i != name2id.end()) {
-    float id = i->second;
+  size_t id = 0;
+  if (Registry().Find(name, id)) {
     return id2hopeCount[id];
   }
   return 0;
@@ -92,9 +193,8 @@ size_t FName::getHopeIdCount(const string& name)
 
 size_t FName::getFearIdCount(const string& name)
 {
-  Name2Id::iterator i = name2id.find(name);
-  if (i != name2id.end()) {
-    float id = i->second;
+  size_t id = 0;
+  if (Registry().Find(name, id)) {
     return id2fearCount[id];
   }
   return 0;
@@ -102,26 +202,24 @@ size_t FName::getFearIdCount(const string& name)
 
 void FName::incrementHopeId(const string& name)
 {
-  Name2Id::iterator i = name2id.find(name);
-  assert(i != name2id.end());
+  size_t id = getId(name);
 #ifdef WITH_THREADS
   // get upgradable lock and upgrade to writer lock
   boost::upgrade_lock<boost::shared_mutex> upgradeLock(m_idLock);
   boost::upgrade_to_unique_lock<boost::shared_mutex> uniqueLock(upgradeLock);
 #endif
-  id2hopeCount[i->second] += 1;
+  id2hopeCount[id] += 1;
 }
 
 void FName::incrementFearId(const string& name)
 {
-  Name2Id::iterator i = name2id.find(name);
-  assert(i != name2id.end());
+  size_t id = getId(name);
 #ifdef WITH_THREADS
   // get upgradable lock and upgrade to writer lock
   boost::upgrade_lock<boost::shared_mutex> upgradeLock(m_idLock);
   boost::upgrade_to_unique_lock<boost::shared_mutex> uniqueLock(upgradeLock);
 #endif
-  id2fearCount[i->second] += 1;
+  id2fearCount[id] += 1;
 }
 
 void FName::eraseId(size_t id)
@@ -148,7 +246,7 @@ size_t FName::hash() const
 
 const std::string& FName::name() const
 {
-  return id2name[m_id];
+  return Registry().GetName(m_id);
 }
 
 
@@ -162,7 +260,70 @@ bool FName::operator!=(const FName& rhs) const
   return ! (*this == rhs);
 }
 
-FVector::FVector(size_t coreFeatures) : m_coreFeatures(coreFeatures) {}
+namespace
+{
+// kernels of the dense-only mode. valarray storage comes from operator new,
+// which is 16-byte aligned, but unaligned loads cost the same when aligned
+void DenseAdd(FValue *lhs, const FValue *rhs, size_t n)
+{
+  size_t i = 0;
+#ifdef __SSE__
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(lhs + i, _mm_add_ps(_mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i)));
+  }
+#endif
+  for (; i < n; ++i) {
+    lhs[i] += rhs[i];
+  }
+}
+
+void DenseSubtract(FValue *lhs, const FValue *rhs, size_t n)
+{
+  size_t i = 0;
+#ifdef __SSE__
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(lhs + i, _mm_sub_ps(_mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i)));
+  }
+#endif
+  for (; i < n; ++i) {
+    lhs[i] -= rhs[i];
+  }
+}
+
+FValue DenseInnerProduct(const FValue *lhs, const FValue *rhs, size_t n)
+{
+  FValue product = 0.0;
+  size_t i = 0;
+#ifdef __SSE__
+  __m128 sum = _mm_setzero_ps();
+  for (; i + 4 <= n; i += 4) {
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i)));
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, sum);
+  product = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+  for (; i < n; ++i) {
+    product += lhs[i] * rhs[i];
+  }
+  return product;
+}
+}
+
+boost::atomic<bool> FVector::s_denseOnly(false);
+
+void FVector::selectDenseOnly()
+{
+  Registry().SelectDenseOnly();
+}
+
+FVector::FVector(size_t coreFeatures)
+{
+  // no allocation for an empty vector
+  if (coreFeatures) {
+    m_coreFeatures.resize(coreFeatures);
+  }
+}
 
 void FVector::resize(size_t newsize)
 {
@@ -370,6 +531,11 @@ FVector& FVector::operator+= (const FVector& rhs)
 {
   if (rhs.m_coreFeatures.size() > m_coreFeatures.size())
     resize(rhs.m_coreFeatures.size());
+  if (s_denseOnly) {
+    if (rhs.m_coreFeatures.size())
+      DenseAdd(&m_coreFeatures[0], &rhs.m_coreFeatures[0], rhs.m_coreFeatures.size());
+    return *this;
+  }
   for (const_iterator i = rhs.cbegin(); i != rhs.cend(); ++i)
     set(i->first, get(i->first) + i->second);
   for (size_t i = 0; i < rhs.m_coreFeatures.size(); ++i)
@@ -389,6 +555,11 @@ void FVector::corePlusEquals(const FVector& rhs)
 {
   if (rhs.m_coreFeatures.size() > m_coreFeatures.size())
     resize(rhs.m_coreFeatures.size());
+  if (s_denseOnly) {
+    if (rhs.m_coreFeatures.size())
+      DenseAdd(&m_coreFeatures[0], &rhs.m_coreFeatures[0], rhs.m_coreFeatures.size());
+    return;
+  }
   for (size_t i = 0; i < rhs.m_coreFeatures.size(); ++i)
     m_coreFeatures[i] += rhs.m_coreFeatures[i];
 }
@@ -548,6 +719,11 @@ FVector& FVector::operator-= (const FVector& rhs)
 {
   if (rhs.m_coreFeatures.size() > m_coreFeatures.size())
     resize(rhs.m_coreFeatures.size());
+  if (s_denseOnly) {
+    if (rhs.m_coreFeatures.size())
+      DenseSubtract(&m_coreFeatures[0], &rhs.m_coreFeatures[0], rhs.m_coreFeatures.size());
+    return *this;
+  }
   for (const_iterator i = rhs.cbegin(); i != rhs.cend(); ++i)
     set(i->first, get(i->first) -(i->second));
   for (size_t i = 0; i < m_coreFeatures.size(); ++i) {
@@ -805,6 +981,11 @@ FValue FVector::sum() const
 FValue FVector::inner_product(const FVector& rhs) const
 {
   assert(m_coreFeatures.size() == rhs.m_coreFeatures.size());
+  if (s_denseOnly) {
+    return m_coreFeatures.size()
+           ? DenseInnerProduct(&m_coreFeatures[0], &rhs.m_coreFeatures[0], m_coreFeatures.size())
+           : 0;
+  }
   FValue product = 0.0;
   for (const_iterator i = cbegin(); i != cend(); ++i) {
     product += ((i->second)*(rhs.get(i->first)));
@@ -29,6 +29,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <valarray>
 #include <vector>
 
+#include <boost/atomic.hpp>
 #include <boost/functional/hash.hpp>
 #include <boost/unordered_map.hpp>
 
@@ -42,6 +43,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #ifdef WITH_THREADS
 #include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/tss.hpp>
 #endif
 
 #include "util/exception.hh"
@@ -61,9 +63,6 @@ struct FName {
 
   typedef boost::unordered_map<std::string,size_t> Name2Id;
   typedef boost::unordered_map<size_t,size_t> Id2Count;
-  //typedef std::map<std::string, size_t> Name2Id;
-  static Name2Id name2id;
-  static std::vector<std::string> id2name;
   static Id2Count id2hopeCount;
   static Id2Count id2fearCount;
 
@@ -99,7 +98,8 @@ private:
   void init(const StringPiece& name);
   size_t m_id;
 #ifdef WITH_THREADS
-  //reader-writer lock
+  //reader-writer lock of the hope and fear counts. The names themselves
+  //are in a sharded registry, see FeatureVector.cpp
   static boost::shared_mutex m_idLock;
 #endif
 };
@@ -119,7 +119,64 @@ struct FNameHash
   }
 };
 
+/**
+ * Names of the sparse features of one feature function, keyed by what the
+ * feature builds them from, e.g. Factor pointers. The name string is only
+ * assembled and registered the first time a thread meets a key; after
+ * that, lookups go to a map of the thread and take no lock.
+ **/
+template <class Key, class Hash = boost::hash<Key> >
+class FNameCache
+{
+public:
+  typedef boost::unordered_map<Key, FName, Hash> Map;
+
+  //! the name cached for key on this thread, or NULL
+  const FName *find(const Key &key) const {
+    const Map &names = getMap();
+    typename Map::const_iterator i = names.find(key);
+    return i == names.end() ? NULL : &i->second;
+  }
+
+  /** as find(key), for a key that is not a Key but equals one, so that
+   * callers need not build a Key to look it up. hash has to give equal
+   * keys the same value as Hash.
+   **/
+  template <class CompatibleKey, class CompatibleHash, class CompatibleEquals>
+  const FName *find(const CompatibleKey &key, const CompatibleHash &hash,
+                    const CompatibleEquals &equals) const {
+    const Map &names = getMap();
+    typename Map::const_iterator i = names.find(key, hash, equals);
+    return i == names.end() ? NULL : &i->second;
+  }
+
+  //! registers name, caches it for key and returns it
+  const FName &add(const Key &key, const StringPiece &name) const {
+    return getMap().insert(std::make_pair(key, FName(name))).first->second;
+  }
+
+private:
+#ifdef WITH_THREADS
+  mutable boost::thread_specific_ptr<Map> m_names;
+
+  Map &getMap() const {
+    if (!m_names.get()) {
+      m_names.reset(new Map);
+    }
+    return *m_names;
+  }
+#else
+  mutable Map m_names;
+
+  Map &getMap() const {
+    return m_names;
+  }
+#endif
+};
+
 class ProxyFVector;
+class FNameRegistry;
+class FVectorTest;
 
 /**
  * A sparse feature (or weight) vector.
@@ -175,6 +232,16 @@ public:
   FValue operator[](const FName& name) const;
   FValue operator[](size_t index) const;
 
+  /** Dense-only mode: sparse features are skipped and the core features
+   * are combined with vectorised kernels. Selected once the features and
+   * weights are loaded, if no sparse feature name has been registered;
+   * registering one later turns it off again.
+   **/
+  static void selectDenseOnly();
+  static bool isDenseOnly() {
+    return s_denseOnly;
+  }
+
   /** Size */
   size_t size() const {
     return m_features.size() + m_coreFeatures.size();
@@ -188,6 +255,13 @@ public:
     return m_coreFeatures;
   }
 
+  /** Exchange the core features with coreFeatures, so that their storage
+   * can be recycled rather than freed, see Arena
+   */
+  void swapCoreFeatures(std::valarray<FValue> &coreFeatures) {
+    m_coreFeatures.swap(coreFeatures);
+  }
+
   /** Equality */
   bool operator== (const FVector& rhs) const;
   bool operator!= (const FVector& rhs) const;
@@ -195,6 +269,8 @@ public:
   FValue inner_product(const FVector& rhs) const;
 
   friend class ProxyFVector;
+  friend class FNameRegistry;
+  friend class FVectorTest;
 
   /**arithmetic */
   //Element-wise
@@ -275,6 +351,10 @@ private:
   FNVmap m_features;
   std::valarray<FValue> m_coreFeatures;
 
+  // read on every += and inner_product while another thread may register
+  // a name. Only changed by the name registry, under its lock
+  static boost::atomic<bool> s_denseOnly;
+
 #ifdef MPI_ENABLE
   //serialization
   template<class Archive>
@@ -17,15 +17,80 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <set>
+#include <sstream>
+
+#include <boost/bind.hpp>
 #include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
 
 #include "FeatureVector.h"
+#include "util/string_piece_hash.hh"
 
 using namespace Moses;
 using namespace std;
 
 static const float TOL = 0.00001;
 
+namespace Moses
+{
+/** Runs the core feature arithmetic with and without the dense-only
+ * kernels. Dense-only mode can't be selected through selectDenseOnly()
+ * here, because the other tests register sparse feature names.
+ */
+class FVectorTest
+{
+public:
+  FVectorTest() : m_denseOnly(FVector::s_denseOnly) {}
+  ~FVectorTest() {
+    FVector::s_denseOnly = m_denseOnly;
+  }
+
+  // core features only. Values are multiples of 1/4, so that sums and
+  // products are exact in any order
+  static FVector Make(size_t size, float offset) {
+    FVector ret(size);
+    for (size_t i = 0; i < size; ++i) {
+      ret[i] = offset + 0.25 * (i % 7) - 0.5 * (i % 3);
+    }
+    return ret;
+  }
+
+  void Compare(size_t lhsSize, size_t rhsSize) {
+    FVector lhs = Make(lhsSize, 1.5), rhs = Make(rhsSize, -0.75);
+    std::vector<FVector> generic, dense;
+    FValue genericProduct = Run(false, lhs, rhs, generic);
+    FValue denseProduct = Run(true, lhs, rhs, dense);
+
+    for (size_t op = 0; op < dense.size(); ++op) {
+      BOOST_REQUIRE_EQUAL(dense[op].coreSize(), max(lhsSize, rhsSize));
+      BOOST_REQUIRE_EQUAL(generic[op].coreSize(), dense[op].coreSize());
+      for (size_t i = 0; i < dense[op].coreSize(); ++i) {
+        BOOST_CHECK_EQUAL(dense[op][i], generic[op][i]);
+      }
+    }
+    BOOST_CHECK_EQUAL(denseProduct, genericProduct);
+  }
+
+private:
+  bool m_denseOnly;
+
+  // lhs += rhs, lhs -= rhs and lhs.corePlusEquals(rhs) into out. Returns
+  // the inner product, if the sizes match
+  FValue Run(bool denseOnly, const FVector &lhs, const FVector &rhs,
+             std::vector<FVector> &out) {
+    FVector::s_denseOnly = denseOnly;
+    out.assign(3, lhs);
+    out[0] += rhs;
+    out[1] -= rhs;
+    out[2].corePlusEquals(rhs);
+    FValue product = lhs.coreSize() == rhs.coreSize() ? lhs.inner_product(rhs) : 0;
+    FVector::s_denseOnly = m_denseOnly;
+    return product;
+  }
+};
+}
+
 BOOST_AUTO_TEST_SUITE(fv)
 
 BOOST_AUTO_TEST_CASE(vector_sum_diff)
@@ -306,6 +371,107 @@ BOOST_AUTO_TEST_CASE(ip)
   BOOST_CHECK_CLOSE((FValue)p1, 1.1*0.5 + -0.1*0.25 + 2.2*2.4, TOL);
 }
 
+BOOST_AUTO_TEST_CASE(dense_only_equal_sizes)
+{
+  FVectorTest test;
+  // the kernels work in blocks of 4 and finish the rest one at a time
+  size_t sizes[] = { 1, 3, 4, 5, 8, 13, 16, 31 };
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    test.Compare(sizes[i], sizes[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(dense_only_unequal_sizes)
+{
+  FVectorTest test;
+  // the shorter side is padded with 0
+  test.Compare(3, 9);
+  test.Compare(9, 3);
+  test.Compare(4, 13);
+  test.Compare(13, 5);
+}
+
+BOOST_AUTO_TEST_CASE(name_registry)
+{
+  FName joined("fv_test_root", "leaf");
+  FName whole("fv_test_root_leaf");
+  BOOST_CHECK(joined == whole);
+  BOOST_CHECK(joined != FName("fv_test_root_other"));
+  BOOST_CHECK_EQUAL(whole.name(), "fv_test_root_leaf");
+  BOOST_CHECK_EQUAL(FName::getId("fv_test_root_leaf"), FName::getId(joined.name()));
+  BOOST_CHECK_THROW(FName::getId("fv_test_never_registered"), util::Exception);
+}
+
+static void RegisterMany(size_t threadInd, size_t num, vector<size_t> *ids)
+{
+  ids->resize(num);
+  // every thread registers the same names, in a different order, so that
+  // registrations race with each other and with lookups of the same shard
+  for (size_t i = 0; i < num; ++i) {
+    size_t ind = (i * 7 + threadInd * 131) % num;
+    stringstream strme;
+    strme << "fv_test_concurrent_" << ind;
+    FName name(strme.str());
+    BOOST_CHECK_EQUAL(name.name(), strme.str());
+    (*ids)[ind] = FName::getId(strme.str());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(name_registry_concurrent)
+{
+  const size_t numThreads = 8;
+  const size_t num = 20000;
+  vector<vector<size_t> > ids(numThreads);
+
+  boost::thread_group threads;
+  for (size_t i = 0; i < numThreads; ++i) {
+    threads.create_thread(boost::bind(&RegisterMany, i, num, &ids[i]));
+  }
+  threads.join_all();
+
+  // one id per name, the same in every thread
+  BOOST_CHECK_EQUAL(set<size_t>(ids[0].begin(), ids[0].end()).size(), num);
+  for (size_t i = 1; i < numThreads; ++i) {
+    BOOST_CHECK(ids[i] == ids[0]);
+  }
+  for (size_t ind = 0; ind < num; ++ind) {
+    stringstream strme;
+    strme << "fv_test_concurrent_" << ind;
+    BOOST_CHECK_EQUAL(FName::getId(strme.str()), ids[0][ind]);
+  }
+}
+
+typedef FNameCache<std::string, StringPieceCompatibleHash> StringNameCache;
+
+static void FindInOtherThread(const StringNameCache *cache, const FName **found)
+{
+  *found = cache->find("fv_test_cache_key");
+}
+
+BOOST_AUTO_TEST_CASE(name_cache)
+{
+  StringNameCache cache;
+  BOOST_CHECK(cache.find("fv_test_cache_key") == NULL);
+
+  const FName &added = cache.add("fv_test_cache_key", "fv_test_cache_name");
+  BOOST_CHECK_EQUAL(added.name(), "fv_test_cache_name");
+  BOOST_CHECK(added == FName("fv_test_cache_name"));
+
+  const FName *found = cache.find("fv_test_cache_key");
+  BOOST_REQUIRE(found != NULL);
+  BOOST_CHECK(found == &added);
+  // without building a std::string key
+  BOOST_CHECK(cache.find(StringPiece("fv_test_cache_key"), StringPieceCompatibleHash(),
+                         StringPieceCompatibleEquals()) == &added);
+  BOOST_CHECK(cache.find(StringPiece("fv_test_cache_other"), StringPieceCompatibleHash(),
+                         StringPieceCompatibleEquals()) == NULL);
+
+  // names are cached per thread
+  const FName *other = &added;
+  boost::thread thread(boost::bind(&FindInOtherThread, &cache, &other));
+  thread.join();
+  BOOST_CHECK(other == NULL);
+}
 
 BOOST_AUTO_TEST_SUITE_END()
 
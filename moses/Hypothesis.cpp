@@ -33,6 +33,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "InputType.h"
 #include "Manager.h"
 #include "IOWrapper.h"
+#include "Arena.h"
 #include "moses/FF/FFState.h"
 #include "moses/FF/StatefulFeatureFunction.h"
 #include "moses/FF/StatelessFeatureFunction.h"
@@ -45,6 +46,26 @@ namespace Moses
 {
 //size_t g_numHypos = 0;
 
+namespace
+{
+// score vectors and state lists left by freed hypotheses, if search-arena is set
+std::vector<std::valarray<FValue> > *RecycledScores(const Manager &manager)
+{
+  Arena *arena = manager.GetArena();
+  return arena ? &arena->GetRecycledScores() : NULL;
+}
+
+void InitStates(std::vector<const FFState*> &states, size_t size, Arena *arena)
+{
+  if (arena && !arena->GetRecycledStates().empty()) {
+    states.swap(arena->GetRecycledStates().back());
+    arena->GetRecycledStates().pop_back();
+  } else {
+    states.resize(size);
+  }
+}
+}
+
 Hypothesis::
 Hypothesis(Manager& manager, InputType const& source, const TranslationOption &initialTransOpt, const Bitmap &bitmap, int id)
   : m_prevHypo(NULL)
@@ -57,7 +78,7 @@ Hypothesis(Manager& manager, InputType const& source, const TranslationOption &i
   , m_wordDeleted(false)
   , m_futureScore(0.0f)
   , m_estimatedScore(0.0f)
-  , m_ffStates(StatefulFeatureFunction::GetStatefulFeatureFunctions().size())
+  , m_currScoreBreakdown(RecycledScores(manager))
   , m_arcList(NULL)
   , m_transOpt(initialTransOpt)
   , m_manager(manager)
@@ -69,6 +90,7 @@ Hypothesis(Manager& manager, InputType const& source, const TranslationOption &i
   //_hash_computed = false;
   //s_HypothesesCreated = 1;
   const vector<const StatefulFeatureFunction*>& ffs = StatefulFeatureFunction::GetStatefulFeatureFunctions();
+  InitStates(m_ffStates, ffs.size(), manager.GetArena());
   for (unsigned i = 0; i < ffs.size(); ++i)
     m_ffStates[i] = ffs[i]->EmptyHypothesisState(source);
 }
@@ -88,13 +110,14 @@ Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt, const
   , m_wordDeleted(false)
   , m_futureScore(0.0f)
   , m_estimatedScore(0.0f)
-  , m_ffStates(prevHypo.m_ffStates.size())
+  , m_currScoreBreakdown(RecycledScores(prevHypo.GetManager()))
   , m_arcList(NULL)
   , m_transOpt(transOpt)
   , m_manager(prevHypo.GetManager())
   , m_id(id)
 {
 //	++g_numHypos;
+  InitStates(m_ffStates, prevHypo.m_ffStates.size(), prevHypo.GetArena());
 
   m_currScoreBreakdown.PlusEquals(transOpt.GetScoreBreakdown());
   m_wordDeleted = transOpt.IsDeletionOption();
@@ -103,19 +126,71 @@ Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt, const
 Hypothesis::
 ~Hypothesis()
 {
+  Arena *arena = GetArena();
   for (unsigned i = 0; i < m_ffStates.size(); ++i)
-    delete m_ffStates[i];
+    FFState::Delete(m_ffStates[i], arena);
 
   if (m_arcList) {
     ArcList::iterator iter;
     for (iter = m_arcList->begin() ; iter != m_arcList->end() ; ++iter) {
-      delete *iter;
+      Destroy(*iter);
     }
     m_arcList->clear();
 
     delete m_arcList;
     m_arcList = NULL;
   }
+
+  if (arena) {
+    // keep the storage for the next hypothesis
+    std::fill(m_ffStates.begin(), m_ffStates.end(), (const FFState*) NULL);
+    arena->GetRecycledStates().push_back(std::vector<const FFState*>());
+    arena->GetRecycledStates().back().swap(m_ffStates);
+    m_currScoreBreakdown.RecycleDenseScores(arena->GetRecycledScores());
+  }
+}
+
+Hypothesis *
+Hypothesis::
+Create(Manager& manager, InputType const& source, const TranslationOption &initialTransOpt, const Bitmap &bitmap, int id)
+{
+  Arena *arena = manager.GetArena();
+  if (!arena) {
+    return new Hypothesis(manager, source, initialTransOpt, bitmap, id);
+  }
+  return new (arena->Allocate(sizeof(Hypothesis))) Hypothesis(manager, source, initialTransOpt, bitmap, id);
+}
+
+Hypothesis *
+Hypothesis::
+Create(const Hypothesis &prevHypo, const TranslationOption &transOpt, const Bitmap &bitmap, int id)
+{
+  Arena *arena = prevHypo.GetArena();
+  if (!arena) {
+    return new Hypothesis(prevHypo, transOpt, bitmap, id);
+  }
+  return new (arena->Allocate(sizeof(Hypothesis))) Hypothesis(prevHypo, transOpt, bitmap, id);
+}
+
+void
+Hypothesis::
+Destroy(Hypothesis *hypo)
+{
+  if (!hypo) return;
+  Arena *arena = hypo->GetArena();
+  if (!arena) {
+    delete hypo;
+    return;
+  }
+  hypo->~Hypothesis();
+  arena->Free(hypo, sizeof(Hypothesis));
+}
+
+Arena *
+Hypothesis::
+GetArena() const
+{
+  return m_manager.GetArena();
 }
 
 void
@@ -253,7 +328,7 @@ CleanupArcList(size_t nBestSize, bool distinctNBest)
 
     // delete bad ones
     ArcList::iterator i = m_arcList->begin() + nBestSize;
-    while (i != m_arcList->end()) delete *i++;
+    while (i != m_arcList->end()) Destroy(*i++);
     m_arcList->erase(m_arcList->begin() + nBestSize, m_arcList->end());
   }
 
@@ -50,6 +50,7 @@ class FFState;
 class StatelessFeatureFunction;
 class StatefulFeatureFunction;
 class Manager;
+class Arena;
 struct ReportingOptions;
 
 typedef std::vector<Hypothesis*> ArcList;
@@ -92,6 +93,16 @@ public:
   Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt, const Bitmap &bitmap, int id);
   ~Hypothesis();
 
+  /** The search makes and frees hypotheses with these, so that they come
+   * from the arena of the Manager if search-arena is set
+   */
+  static Hypothesis *Create(Manager& manager, InputType const& source, const TranslationOption &initialTransOpt, const Bitmap &bitmap, int id);
+  static Hypothesis *Create(const Hypothesis &prevHypo, const TranslationOption &transOpt, const Bitmap &bitmap, int id);
+  static void Destroy(Hypothesis *hypo);
+
+  //! where feature functions place the states of this hypothesis. NULL unless search-arena is set
+  Arena *GetArena() const;
+
   void PrintHypothesis() const;
 
   const InputType& GetInput() const {
@@ -25,6 +25,9 @@ protected:
 
 public:
   HypothesisStack(Manager& manager): m_manager(manager) {}
+  Manager &GetManager() const {
+    return m_manager;
+  }
   typedef _HCType::iterator iterator;
   typedef _HCType::const_iterator const_iterator;
   //! iterators
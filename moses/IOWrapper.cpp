@@ -49,6 +49,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "moses/ConfusionNet.h"
 #include "moses/WordLattice.h"
 #include "moses/ChartManager.h"
+#include "moses/BinaryNBest.h"
 
 #include "IOWrapper.h"
 
@@ -101,7 +102,16 @@ IOWrapper::IOWrapper(AllOptions const& opts)
     m_inputStream = m_inputFile;
   }
 
-  if (nBestSize > 0) {
+  if (nBestSize > 0 && m_options->nbest.binary) {
+    UTIL_THROW_IF2(m_options->lmbr.enabled,
+                   "The lattice MBR n-best list cannot be written with -n-best-binary");
+    m_nBestStream = new std::ofstream(nBestFilePath.c_str(), std::ios::out | std::ios::binary);
+    UTIL_THROW_IF2(!m_nBestStream->good(), "Failed to open binary n-best file " << nBestFilePath);
+    std::vector<std::pair<std::string, size_t> > labels;
+    ScoreComponentCollection::GetAllFeatureLabels(labels);
+    m_binaryNBestWriter.reset(new BinaryNBestWriter(*m_nBestStream, labels));
+    m_nBestOutputCollector.reset(new Moses::OutputCollector(m_nBestStream));
+  } else if (nBestSize > 0) {
     m_nBestOutputCollector.reset(new Moses::OutputCollector(nBestFilePath));
     if (m_nBestOutputCollector->OutputIsCout()) {
       m_surpressSingleBestOutput = true;
@@ -141,6 +151,12 @@ IOWrapper::IOWrapper(AllOptions const& opts)
     m_singleBestOutputCollector.reset(new Moses::OutputCollector(&std::cout));
   }
 
+  // outputs are written in the order of the translation ids
+  std::vector<OutputCollector*> collectors = GetCollectors();
+  for (size_t i = 0; i < collectors.size(); ++i) {
+    collectors[i]->SetFirstId(m_currentLine);
+  }
+
   // setup file pattern for hypergraph output
   char const* key = "output-search-graph-hypergraph";
   PARAM_VEC const* p = staticData.GetParameter().GetParam(key);
@@ -169,8 +185,13 @@ IOWrapper::IOWrapper(AllOptions const& opts)
 
 IOWrapper::~IOWrapper()
 {
+  Flush();
+
   if (m_inputFile != NULL)
     delete m_inputFile;
+  // binary n-best stream, only set with -n-best-binary
+  m_nBestOutputCollector.reset();
+  delete m_nBestStream;
   // if (m_nBestStream != NULL && !m_surpressSingleBestOutput) {
   // outputting n-best to file, rather than stdout. need to close file and delete obj
   // delete m_nBestStream;
@@ -184,6 +205,51 @@ IOWrapper::~IOWrapper()
   // delete m_latticeSamplesStream;
 }
 
+std::vector<OutputCollector*>
+IOWrapper::
+GetCollectors() const
+{
+  OutputCollector *collectors[] = {
+    m_singleBestOutputCollector.get(), m_nBestOutputCollector.get(),
+    m_unknownsCollector.get(), m_alignmentInfoCollector.get(),
+    m_searchGraphOutputCollector.get(), m_detailedTranslationCollector.get(),
+    m_wordGraphCollector.get(), m_latticeSamplesCollector.get(),
+    m_detailTreeFragmentsOutputCollector.get()
+  };
+  std::vector<OutputCollector*> ret;
+  for (size_t i = 0; i < sizeof(collectors) / sizeof(collectors[0]); ++i) {
+    if (collectors[i]) ret.push_back(collectors[i]);
+  }
+  return ret;
+}
+
+void
+IOWrapper::
+Flush()
+{
+  std::vector<OutputCollector*> collectors = GetCollectors();
+  for (size_t i = 0; i < collectors.size(); ++i) {
+    collectors[i]->Flush();
+  }
+
+  IFVERBOSE(1) {
+    PrintCollectorStats("single-best", m_singleBestOutputCollector.get());
+    PrintCollectorStats("n-best", m_nBestOutputCollector.get());
+  }
+}
+
+void
+IOWrapper::
+PrintCollectorStats(const std::string &name, OutputCollector *collector)
+{
+  if (collector == NULL) return;
+  TRACE_ERR("Output collector " << name
+            << ": max reorder depth " << collector->GetMaxReorderDepth()
+            << ", writer stalled " << collector->GetWriterStallTime() << "s"
+            << ", producers waited " << collector->GetProducerWaitTime() << "s"
+            << endl);
+}
+
 // InputType*
 // IOWrapper::
 // GetInput(InputType* inputType)
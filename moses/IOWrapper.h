@@ -73,6 +73,7 @@ class Hypothesis;
 class ChartHypothesis;
 class Factor;
 class TranslationTask;
+class BinaryNBestWriter;
 namespace Syntax
 {
 struct SHyperedge;
@@ -89,6 +90,7 @@ protected:
   Moses::InputFileStream *m_inputFile;
   std::istream *m_inputStream;
   std::ostream *m_nBestStream;
+  std::auto_ptr<BinaryNBestWriter> m_binaryNBestWriter; // with -n-best-binary
   // std::ostream *m_outputWordGraphStream;
   // std::auto_ptr<std::ostream> m_outputSearchGraphStream;
   // std::ostream *m_detailedTranslationReportingStream;
@@ -126,10 +128,16 @@ protected:
 
   std::string m_hypergraph_output_filepattern;
 
+  std::vector<OutputCollector*> GetCollectors() const;
+  static void PrintCollectorStats(const std::string &name, OutputCollector *collector);
+
 public:
   IOWrapper(AllOptions const& opts);
   ~IOWrapper();
 
+  //! wait until the collectors have written all outputs, and report their stats
+  void Flush();
+
   // Moses::InputType* GetInput(Moses::InputType *inputType);
 
   boost::shared_ptr<InputType>
@@ -142,14 +150,22 @@ public:
   void SetOutputStream2SingleBestOutputCollector(std::ostream* outStream) {
     if (m_singleBestOutputCollector.get())
       m_singleBestOutputCollector->SetOutputStream(outStream);
-    else
+    else {
       m_singleBestOutputCollector.reset(new Moses::OutputCollector(outStream));
+      m_singleBestOutputCollector->SetFirstId(m_currentLine);
+    }
   }
 
   Moses::OutputCollector *GetNBestOutputCollector() {
     return m_nBestOutputCollector.get();
   }
 
+  //! encodes the n-best lists with -n-best-binary, NULL otherwise.
+  //! Used by every decoding thread
+  BinaryNBestWriter *GetBinaryNBestWriter() const {
+    return m_binaryNBestWriter.get();
+  }
+
   Moses::OutputCollector *GetUnknownsCollector() {
     return m_unknownsCollector.get();
   }
@@ -335,6 +335,7 @@ OutputNBestList(OutputCollector *collector,
   if (collector->OutputIsCout()) {
     FixPrecision(out);
   }
+  BinaryNBestWriter *binary = GetBinaryNBestWriter();
   Phrase outputPhrase;
   ScoreComponentCollection features;
   for (std::vector<search::Applied>::const_iterator i = nbest.begin();
@@ -347,6 +348,12 @@ OutputNBestList(OutputCollector *collector,
 
     outputPhrase.RemoveWord(0);
     outputPhrase.RemoveWord(outputPhrase.GetSize() - 1);
+    if (binary) {
+      std::ostringstream surface;
+      OutputSurface(surface, outputPhrase);
+      OutputBinaryNBestEntry(out, *binary, surface.str(), features, i->GetScore(), "");
+      continue;
+    }
     out << translationId << " ||| ";
     OutputSurface(out, outputPhrase); // , outputFactorOrder, false);
     out << " ||| ";
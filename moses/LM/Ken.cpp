@@ -198,11 +198,12 @@ template <class Model> FFState *LanguageModelKen<Model>::EvaluateWhenApplied(con
 {
   const lm::ngram::State &in_state = static_cast<const KenLMState&>(*ps).state;
 
-  std::auto_ptr<KenLMState> ret(new KenLMState());
+  // copied into the search arena, if any, once scoring is done
+  KenLMState ret;
 
   if (!hypo.GetCurrTargetLength()) {
-    ret->state = in_state;
-    return ret.release();
+    ret.state = in_state;
+    return new (hypo.GetArena()) KenLMState(ret);
   }
 
   const std::size_t begin = hypo.GetCurrTargetWordsRange().GetStartPos();
@@ -212,7 +213,7 @@ template <class Model> FFState *LanguageModelKen<Model>::EvaluateWhenApplied(con
 
   std::size_t position = begin;
   typename Model::State aux_state;
-  typename Model::State *state0 = &ret->state, *state1 = &aux_state;
+  typename Model::State *state0 = &ret.state, *state1 = &aux_state;
 
   float score = m_ngram->Score(in_state, TranslateID(hypo.GetWord(position)), *state0);
   ++position;
@@ -225,15 +226,15 @@ template <class Model> FFState *LanguageModelKen<Model>::EvaluateWhenApplied(con
     // Score end of sentence.
     std::vector<lm::WordIndex> indices(m_ngram->Order() - 1);
     const lm::WordIndex *last = LastIDs(hypo, &indices.front());
-    score += m_ngram->FullScoreForgotState(&indices.front(), last, m_ngram->GetVocabulary().EndSentence(), ret->state).prob;
+    score += m_ngram->FullScoreForgotState(&indices.front(), last, m_ngram->GetVocabulary().EndSentence(), ret.state).prob;
   } else if (adjust_end < end) {
     // Get state after adding a long phrase.
     std::vector<lm::WordIndex> indices(m_ngram->Order() - 1);
     const lm::WordIndex *last = LastIDs(hypo, &indices.front());
-    m_ngram->GetState(&indices.front(), last, ret->state);
-  } else if (state0 != &ret->state) {
+    m_ngram->GetState(&indices.front(), last, ret.state);
+  } else if (state0 != &ret.state) {
     // Short enough phrase that we can just reuse the state.
-    ret->state = *state0;
+    ret.state = *state0;
   }
 
   score = TransformLMScore(score);
@@ -247,7 +248,7 @@ template <class Model> FFState *LanguageModelKen<Model>::EvaluateWhenApplied(con
     out->PlusEquals(this, score);
   }
 
-  return ret.release();
+  return new (hypo.GetArena()) KenLMState(ret);
 }
 
 class LanguageModelChartStateKenLM : public FFState
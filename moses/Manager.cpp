@@ -49,6 +49,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/LatticeMBR.h"
 #include "moses/SearchNormal.h"
 #include "moses/SearchCubePruning.h"
+#include "moses/Arena.h"
 #include <boost/foreach.hpp>
 
 #ifdef HAVE_PROTOBUF
@@ -70,6 +71,10 @@ Manager::Manager(ttasksptr const& ttask)
   , interrupted_flag(0)
   , m_hypoId(0)
 {
+  if (options()->search.arena) {
+    m_arena.reset(new Arena);
+  }
+
   boost::shared_ptr<InputType> source = ttask->GetSource();
   m_transOptColl = source->CreateTranslationOptionCollection(ttask);
 
@@ -1595,7 +1600,11 @@ void Manager::OutputNBest(OutputCollector *collector) const
     ostringstream out;
     NBestOptions const& nbo = options()->nbest;
     CalcNBest(nbo.nbest_size, nBestList, nbo.only_distinct);
-    OutputNBest(out, nBestList);
+    if (BinaryNBestWriter *writer = GetBinaryNBestWriter()) {
+      OutputBinaryNBest(out, nBestList, *writer);
+    } else {
+      OutputNBest(out, nBestList);
+    }
     collector->Write(m_source.GetTranslationId(), out.str());
   }
 
@@ -1633,34 +1642,12 @@ OutputNBest(std::ostream& out, Moses::TrellisPathList const& nBestList) const
     //phrase-to-phrase segmentation
     if (includeSegmentation) {
       out << " |||";
-      for (int currEdge = (int)edges.size() - 2 ; currEdge >= 0 ; currEdge--) {
-        const Hypothesis &edge = *edges[currEdge];
-        const Range &sourceRange = edge.GetCurrSourceWordsRange();
-        Range targetRange = path.GetTargetWordsRange(edge);
-        out << " " << sourceRange.GetStartPos();
-        if (sourceRange.GetStartPos() < sourceRange.GetEndPos()) {
-          out << "-" << sourceRange.GetEndPos();
-        }
-        out<< "=" << targetRange.GetStartPos();
-        if (targetRange.GetStartPos() < targetRange.GetEndPos()) {
-          out<< "-" << targetRange.GetEndPos();
-        }
-      }
+      OutputNBestSegmentation(out, path);
     }
 
     if (includeWordAlignment) {
       out << " ||| ";
-      for (int currEdge = (int)edges.size() - 2 ; currEdge >= 0 ; currEdge--) {
-        const Hypothesis &edge = *edges[currEdge];
-        const Range &sourceRange = edge.GetCurrSourceWordsRange();
-        Range targetRange = path.GetTargetWordsRange(edge);
-        const int sourceOffset = sourceRange.GetStartPos();
-        const int targetOffset = targetRange.GetStartPos();
-        const AlignmentInfo &ai = edge.GetCurrTargetPhrase().GetAlignTerm();
-
-        OutputAlignment(out, ai, sourceOffset, targetOffset);
-
-      }
+      OutputNBestAlignment(out, path);
     }
 
     if (options()->output.RecoverPath) {
@@ -1758,6 +1745,74 @@ OutputSurface(std::ostream &out, Hypothesis const& edge, bool const recursive) c
   }
 }
 
+void
+Manager::
+OutputBinaryNBest(std::ostream& out, Moses::TrellisPathList const& nBestList,
+                  BinaryNBestWriter &writer) const
+{
+  NBestOptions const& nbo = options()->nbest;
+
+  TrellisPathList::const_iterator iter;
+  for (iter = nBestList.begin() ; iter != nBestList.end() ; ++iter) {
+    const TrellisPath &path = **iter;
+    const std::vector<const Hypothesis *> &edges = path.GetEdges();
+
+    ostringstream surface;
+    for (int currEdge = (int)edges.size() - 1 ; currEdge >= 0 ; currEdge--) {
+      OutputSurface(surface, *edges[currEdge]);
+    }
+
+    // as extractor reads the text list, the word alignment wins over the
+    // segmentation
+    ostringstream alignment;
+    if (nbo.include_alignment_info) {
+      OutputNBestAlignment(alignment, path);
+    } else if (nbo.include_segmentation) {
+      OutputNBestSegmentation(alignment, path);
+    }
+
+    OutputBinaryNBestEntry(out, writer, surface.str(), *path.GetScoreBreakdown(),
+                           path.GetFutureScore(), alignment.str());
+  }
+}
+
+void
+Manager::
+OutputNBestSegmentation(std::ostream& out, const TrellisPath &path) const
+{
+  const std::vector<const Hypothesis *> &edges = path.GetEdges();
+  for (int currEdge = (int)edges.size() - 2 ; currEdge >= 0 ; currEdge--) {
+    const Hypothesis &edge = *edges[currEdge];
+    const Range &sourceRange = edge.GetCurrSourceWordsRange();
+    Range targetRange = path.GetTargetWordsRange(edge);
+    out << " " << sourceRange.GetStartPos();
+    if (sourceRange.GetStartPos() < sourceRange.GetEndPos()) {
+      out << "-" << sourceRange.GetEndPos();
+    }
+    out<< "=" << targetRange.GetStartPos();
+    if (targetRange.GetStartPos() < targetRange.GetEndPos()) {
+      out<< "-" << targetRange.GetEndPos();
+    }
+  }
+}
+
+void
+Manager::
+OutputNBestAlignment(std::ostream& out, const TrellisPath &path) const
+{
+  const std::vector<const Hypothesis *> &edges = path.GetEdges();
+  for (int currEdge = (int)edges.size() - 2 ; currEdge >= 0 ; currEdge--) {
+    const Hypothesis &edge = *edges[currEdge];
+    const Range &sourceRange = edge.GetCurrSourceWordsRange();
+    Range targetRange = path.GetTargetWordsRange(edge);
+    const int sourceOffset = sourceRange.GetStartPos();
+    const int targetOffset = targetRange.GetStartPos();
+    const AlignmentInfo &ai = edge.GetCurrTargetPhrase().GetAlignTerm();
+
+    OutputAlignment(out, ai, sourceOffset, targetOffset);
+  }
+}
+
 void
 Manager::
 OutputAlignment(ostream &out, const AlignmentInfo &ai,
@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include <vector>
 #include <list>
+#include <boost/scoped_ptr.hpp>
 #include "InputType.h"
 #include "Hypothesis.h"
 #include "StaticData.h"
@@ -112,6 +113,7 @@ private:
 
 protected:
   // data
+  boost::scoped_ptr<Arena> m_arena; /**< memory of the hypotheses, if search-arena is set. Destroyed last */
   TranslationOptionCollection *m_transOptColl; /**< pre-computed list of translation options for the phrases in this sentence */
   Search *m_search;
 
@@ -133,6 +135,10 @@ protected:
   mutable std::ostringstream m_alignmentOut;
 public:
   void OutputNBest(std::ostream& out, const Moses::TrellisPathList &nBestList) const;
+  void OutputBinaryNBest(std::ostream& out, const Moses::TrellisPathList &nBestList,
+                         BinaryNBestWriter &writer) const;
+  void OutputNBestSegmentation(std::ostream& out, const TrellisPath &path) const;
+  void OutputNBestAlignment(std::ostream& out, const TrellisPath &path) const;
   void OutputSurface(std::ostream &out,
                      Hypothesis const& edge,
                      bool const recursive=false) const;
@@ -166,6 +172,10 @@ public:
   void GetOutputLanguageModelOrder( std::ostream &out, const Hypothesis *hypo ) const;
   void GetWordGraph(long translationId, std::ostream &outputWordGraphStream) const;
   int GetNextHypoId();
+  //! NULL unless search-arena is set
+  Arena *GetArena() const {
+    return m_arena.get();
+  }
 
   void OutputLatticeMBRNBest(std::ostream& out, const std::vector<LatticeMBRSolution>& solutions,long translationId) const;
   void OutputBestHypo(const std::vector<Moses::Word>&  mbrBestHypo, std::ostream& out) const;
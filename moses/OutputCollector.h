@@ -22,7 +22,11 @@
 #define moses_OutputCollector_h
 
 #ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #endif
 
 #ifdef BOOST_HAS_PTHREADS
@@ -34,26 +38,41 @@
 #include <ostream>
 #include <fstream>
 #include <string>
+#include <vector>
 #include "Util.h"
 #include "util/exception.hh"
+#include "util/usage.hh"
 namespace Moses
 {
 /**
-* Makes sure output goes in the correct order when multi-threading
+* Makes sure output goes in the correct order when multi-threading.
+*
+* Outputs that arrive early wait in a ring buffer of WINDOW_SIZE slots.
+* Writing is done by a thread of the collector, started with the first
+* output, which writes all consecutive outputs that are ready in one batch.
+* A thread whose output is more than WINDOW_SIZE ahead of the next one to be
+* written blocks until there is room, so ids have to be consecutive,
+* starting at 0 or the id given to SetFirstId().
 **/
 class OutputCollector
 {
 public:
+  static const size_t WINDOW_SIZE = 1024;
+
   OutputCollector(std::ostream* outStream= &std::cout,
                   std::ostream* debugStream=&std::cerr)
-    : m_nextOutput(0)
+    : m_window(WINDOW_SIZE)
+    , m_nextOutput(0)
     , m_outStream(outStream)
     , m_debugStream(debugStream)
     , m_isHoldingOutputStream(false)
-    , m_isHoldingDebugStream(false) {}
+    , m_isHoldingDebugStream(false) {
+    Init();
+  }
 
   OutputCollector(std::string xout, std::string xerr = "")
-    : m_nextOutput(0) {
+    : m_window(WINDOW_SIZE)
+    , m_nextOutput(0) {
     // TO DO open magic streams instead of regular ofstreams! [UG]
 
     if (xout == "/dev/stderr") {
@@ -81,9 +100,20 @@ public:
       m_debugStream = &std::cerr;
       m_isHoldingDebugStream = false;
     }
+    Init();
   }
 
   ~OutputCollector() {
+#ifdef WITH_THREADS
+    if (m_writer) {
+      {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_stop = true;
+        m_ready.notify_one();
+      }
+      m_writer->join();
+    }
+#endif
     if (m_isHoldingOutputStream)
       delete m_outStream;
     if (m_isHoldingDebugStream)
@@ -102,52 +132,172 @@ public:
     return (m_outStream == &std::cout);
   }
 
+  //! id of the first output, if not 0. Call before the first Write()
+  void SetFirstId(int sourceId) {
+    m_nextOutput = sourceId;
+  }
+
   /**
     * Write or cache the output, as appropriate.
     **/
   void Write(int sourceId,const std::string& output,const std::string& debug="") {
 #ifdef WITH_THREADS
     boost::mutex::scoped_lock lock(m_mutex);
+    if (sourceId >= m_nextOutput + (int) WINDOW_SIZE) {
+      double start = util::WallTime();
+      while (sourceId >= m_nextOutput + (int) WINDOW_SIZE)
+        m_space.wait(lock);
+      m_producerWaitTime += util::WallTime() - start;
+    }
+#else
+    UTIL_THROW_IF2(sourceId >= m_nextOutput + (int) WINDOW_SIZE,
+                   "Output " << sourceId << " is too far ahead of " << m_nextOutput);
 #endif
+    // already written, or never will be
+    if (sourceId < m_nextOutput)
+      return;
+
+    Slot &slot = m_window[sourceId % WINDOW_SIZE];
+    slot.output = output;
+    slot.debug = debug;
+    slot.ready = true;
+    ++m_numReady;
+    m_maxReorderDepth = std::max(m_maxReorderDepth, (size_t) (sourceId - m_nextOutput + 1));
+
+#ifdef WITH_THREADS
     if (sourceId == m_nextOutput) {
-      //This is the one we were expecting
-      *m_outStream << output << std::flush;
-      *m_debugStream << debug << std::flush;
-      ++m_nextOutput;
-      //see if there's any more
-      std::map<int,std::string>::iterator iter;
-      while ((iter = m_outputs.find(m_nextOutput)) != m_outputs.end()) {
-        *m_outStream << iter->second << std::flush;
-        ++m_nextOutput;
-        std::map<int,std::string>::iterator debugIter = m_debugs.find(iter->first);
-        m_outputs.erase(iter);
-        if (debugIter != m_debugs.end()) {
-          *m_debugStream << debugIter->second << std::flush;
-          m_debugs.erase(debugIter);
-        }
-      }
-    } else {
-      //save for later
-      m_outputs[sourceId] = output;
-      m_debugs[sourceId] = debug;
+      if (!m_writer)
+        m_writer.reset(new boost::thread(boost::bind(&OutputCollector::WriteLoop, this)));
+      m_ready.notify_one();
     }
+#else
+    std::string out, dbg;
+    TakeReady(out, dbg);
+    WriteBatch(out, dbg);
+#endif
+  }
+
+  //! wait until all outputs that can be written have been written
+  void Flush() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_writing || m_window[m_nextOutput % WINDOW_SIZE].ready)
+      m_space.wait(lock);
+#endif
+  }
+
+  //! largest distance of an output to the next one to be written, plus 1
+  size_t GetMaxReorderDepth() const {
+    return m_maxReorderDepth;
   }
 
+  //! seconds the writer waited for the next output while later ones were ready
+  double GetWriterStallTime() const {
+    return m_writerStallTime;
+  }
+
+  //! seconds threads waited in Write() for room in the window
+  double GetProducerWaitTime() const {
+    return m_producerWaitTime;
+  }
 
 private:
-  std::map<int,std::string> m_outputs;
-  std::map<int,std::string> m_debugs;
+  struct Slot {
+    bool ready;
+    std::string output;
+    std::string debug;
+    Slot() : ready(false) {}
+  };
+
+  std::vector<Slot> m_window;
   int m_nextOutput;
   std::ostream* m_outStream;
   std::ostream* m_debugStream;
   bool m_isHoldingOutputStream;
   bool m_isHoldingDebugStream;
+
+  size_t m_maxReorderDepth;
+  size_t m_numReady;
+  double m_writerStallTime;
+  double m_producerWaitTime;
+
 #ifdef WITH_THREADS
   boost::mutex m_mutex;
+  boost::condition_variable m_ready;
+  boost::condition_variable m_space;
+  boost::scoped_ptr<boost::thread> m_writer;
+  bool m_writing;
+  bool m_stop;
+#endif
+
+  void Init() {
+    m_maxReorderDepth = 0;
+    m_numReady = 0;
+    m_writerStallTime = 0;
+    m_producerWaitTime = 0;
+#ifdef WITH_THREADS
+    m_writing = false;
+    m_stop = false;
+#endif
+  }
+
+  //! moves the consecutive ready outputs into out and debug
+  void TakeReady(std::string &out, std::string &debug) {
+    Slot *slot;
+    while ((slot = &m_window[m_nextOutput % WINDOW_SIZE])->ready) {
+      out += slot->output;
+      debug += slot->debug;
+      std::string().swap(slot->output);
+      std::string().swap(slot->debug);
+      slot->ready = false;
+      --m_numReady;
+      ++m_nextOutput;
+    }
+  }
+
+  void WriteBatch(const std::string &out, const std::string &debug) {
+    m_outStream->write(out.data(), out.size());
+    *m_outStream << std::flush;
+    m_debugStream->write(debug.data(), debug.size());
+    *m_debugStream << std::flush;
+  }
+
+#ifdef WITH_THREADS
+  void WriteLoop() {
+    std::string out, debug;
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (true) {
+      if (!m_window[m_nextOutput % WINDOW_SIZE].ready) {
+        if (m_stop)
+          break;
+        // head-of-line blocking: later outputs wait behind a slow one
+        bool stalled = m_numReady > 0;
+        double start = util::WallTime();
+        m_ready.wait(lock);
+        if (stalled)
+          m_writerStallTime += util::WallTime() - start;
+        continue;
+      }
+
+      out.clear();
+      debug.clear();
+      TakeReady(out, debug);
+      m_writing = true;
+      m_space.notify_all();
+
+      lock.unlock();
+      WriteBatch(out, debug);
+      lock.lock();
+
+      m_writing = false;
+      m_space.notify_all();
+    }
+  }
 #endif
 
 public:
   void SetOutputStream(std::ostream* outStream) {
+    Flush();
     m_outStream = outStream;
   }
 
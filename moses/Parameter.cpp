@@ -107,6 +107,7 @@ Parameter::Parameter()
 
   // miscellaneous search options
   AddParam(search_opts,"disable-discarding", "dd", "disable hypothesis discarding"); // ??? memory management? UG
+  AddParam(search_opts,"search-arena", "allocate hypotheses and feature function states of each sentence from an arena (phrase-based search only)");
   AddParam(search_opts,"phrase-drop-allowed", "da", "if present, allow dropping of source words"); //da = drop any (word); see -du for comparison
   AddParam(search_opts,"threads","th", "number of threads to use in decoding (defaults to single-threaded)");
 
@@ -208,6 +209,7 @@ Parameter::Parameter()
   // AddParam(nbest_opts,"n-best-list-size", "size of n-best-list to be generated; specify - as the file in order to write to STDOUT");
   AddParam(nbest_opts,"labeled-n-best-list", "print out labels for each weight type in n-best list. default is true");
   AddParam(nbest_opts,"n-best-trees", "Write n-best target-side trees to n-best-list");
+  AddParam(nbest_opts,"n-best-binary", "Write the n-best-list in the binary format read by mert's extractor. Default is false");
   AddParam(nbest_opts,"n-best-factor", "factor to compute the maximum number of contenders (=factor*nbest-size). value 0 means infinity, i.e. no threshold. default is 0");
   AddParam(nbest_opts,"report-all-factors-in-n-best", "Report all factors in n-best-lists. Default is false");
   AddParam(nbest_opts,"lattice-samples", "generate samples from lattice, in same format as nbest list. Uses the file and size arguments, as in n-best-list");
@@ -251,6 +253,7 @@ Parameter::Parameter()
   AddParam(chart_opts,"rule-limit", "a little like table limit. But for chart decoding rules. Default is DEFAULT_MAX_TRANS_OPT_SIZE");
   AddParam(chart_opts,"source-label-overlap", "What happens if a span already has a label. 0=add more. 1=replace. 2=discard. Default is 0");
   AddParam(chart_opts,"unknown-lhs", "file containing target lhs of unknown words. 1 per line: LHS prob");
+  AddParam(chart_opts,"chart-threads", "number of threads decoding the cells of one span width of a sentence in parallel. Feature functions must be thread-safe (default 1)");
 
   po::options_description misc_opts("Miscellaneous Options");
   AddParam(misc_opts,"mira", "do mira training");
@@ -276,6 +279,7 @@ Parameter::Parameter()
   // Compact phrase table and reordering table.
   po::options_description cpt_opts("Options when using compact phrase and reordering tables.");
   AddParam(cpt_opts,"minphr-memory", "Load phrase table in minphr format into memory");
+  AddParam(cpt_opts,"minphr-cache-size", "Size in MB of the decoding cache shared by all threads of a minphr phrase table (default 256)");
   AddParam(cpt_opts,"minlexr-memory", "Load lexical reordering table in minlexr format into memory");
 
   po::options_description spe_opts("Simulated Post-editing Options");
@@ -58,6 +58,27 @@ ScoreComponentCollection()
   : m_scores(s_denseVectorSize)
 {}
 
+ScoreComponentCollection::
+ScoreComponentCollection(std::vector<std::valarray<FValue> > *recycled)
+{
+  if (recycled && !recycled->empty()) {
+    m_scores.swapCoreFeatures(recycled->back());
+    recycled->pop_back();
+  } else {
+    std::valarray<FValue> scores(s_denseVectorSize);
+    m_scores.swapCoreFeatures(scores);
+  }
+}
+
+void
+ScoreComponentCollection::
+RecycleDenseScores(std::vector<std::valarray<FValue> > &recycled)
+{
+  recycled.push_back(std::valarray<FValue>());
+  m_scores.swapCoreFeatures(recycled.back());
+  recycled.back() = 0.0f;
+}
+
 
 void
 ScoreComponentCollection::
@@ -307,25 +328,80 @@ void ScoreComponentCollection::PlusEquals(const FeatureFunction* sp, const Score
   }
 }
 
-void
-ScoreComponentCollection::
-OutputAllFeatureScores(std::ostream &out, bool with_labels) const
+namespace
 {
-  std::string lastName = "";
+// the features of the n-best lists, in the order they are written
+std::vector<const FeatureFunction*> NBestFeatureFunctions()
+{
+  std::vector<const FeatureFunction*> ret;
   const vector<const StatefulFeatureFunction*>& sff
   = StatefulFeatureFunction::GetStatefulFeatureFunctions();
   for( size_t i=0; i<sff.size(); i++ ) {
-    const StatefulFeatureFunction *ff = sff[i];
-    if (ff->IsTuneable()) {
-      OutputFeatureScores(out, ff, lastName, with_labels);
+    if (sff[i]->IsTuneable()) {
+      ret.push_back(sff[i]);
     }
   }
   const vector<const StatelessFeatureFunction*>& slf
   = StatelessFeatureFunction::GetStatelessFeatureFunctions();
   for( size_t i=0; i<slf.size(); i++ ) {
-    const StatelessFeatureFunction *ff = slf[i];
-    if (ff->IsTuneable()) {
-      OutputFeatureScores(out, ff, lastName, with_labels);
+    if (slf[i]->IsTuneable()) {
+      ret.push_back(slf[i]);
+    }
+  }
+  return ret;
+}
+}
+
+void
+ScoreComponentCollection::
+OutputAllFeatureScores(std::ostream &out, bool with_labels) const
+{
+  std::string lastName = "";
+  const std::vector<const FeatureFunction*> ffs = NBestFeatureFunctions();
+  for( size_t i=0; i<ffs.size(); i++ ) {
+    OutputFeatureScores(out, ffs[i], lastName, with_labels);
+  }
+}
+
+void
+ScoreComponentCollection::
+GetAllFeatureScores(std::vector<float> &dense,
+                    std::vector<std::pair<std::string, float> > &sparse) const
+{
+  dense.clear();
+  sparse.clear();
+  const std::vector<const FeatureFunction*> ffs = NBestFeatureFunctions();
+  for( size_t i=0; i<ffs.size(); i++ ) {
+    const FeatureFunction *ff = ffs[i];
+    if (ff->HasTuneableComponents()) {
+      vector<float> scores = GetScoresForProducer( ff );
+      for (size_t j = 0; j<scores.size(); ++j) {
+        if (ff->IsTuneableComponent(j)) {
+          dense.push_back(scores[j]);
+        }
+      }
+    }
+    const FVector scores = GetVectorForProducer( ff );
+    for(FVector::FNVmap::const_iterator j = scores.cbegin(); j != scores.cend(); j++) {
+      sparse.push_back(std::make_pair(j->first.name(), j->second));
+    }
+  }
+}
+
+void
+ScoreComponentCollection::
+GetAllFeatureLabels(std::vector<std::pair<std::string, std::size_t> > &labels)
+{
+  labels.clear();
+  const std::vector<const FeatureFunction*> ffs = NBestFeatureFunctions();
+  for( size_t i=0; i<ffs.size(); i++ ) {
+    const FeatureFunction *ff = ffs[i];
+    if (ff->HasTuneableComponents()) {
+      size_t count = 0;
+      for (size_t j = 0; j < ff->GetNumScoreComponents(); ++j) {
+        count += ff->IsTuneableComponent(j);
+      }
+      labels.push_back(std::make_pair(ff->GetScoreProducerDescription(), count));
     }
   }
 }
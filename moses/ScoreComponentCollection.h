@@ -120,6 +120,14 @@ public:
   //! Create a new score collection with all values set to 0.0
   ScoreComponentCollection();
 
+  /** As above, but if recycled isn't NULL, the dense scores take over the
+   * storage of one of its vectors, see RecycleDenseScores()
+   */
+  explicit ScoreComponentCollection(std::vector<std::valarray<FValue> > *recycled);
+
+  //! Move the storage of the dense scores, zeroed, to recycled. Leaves no dense scores
+  void RecycleDenseScores(std::vector<std::valarray<FValue> > &recycled);
+
   //! Clone a score collection
   ScoreComponentCollection(const ScoreComponentCollection& rhs)
     : m_scores(rhs.m_scores) {
@@ -443,6 +451,13 @@ public:
   void OutputFeatureScores(std::ostream& out, Moses::FeatureFunction const* ff,
                            std::string &lastName, bool with_labels) const;
 
+  //! the values OutputAllFeatureScores() prints, dense ones in order and
+  //! sparse ones with their names
+  void GetAllFeatureScores(std::vector<float> &dense,
+                           std::vector<std::pair<std::string, float> > &sparse) const;
+  //! (name, number of values) of the dense values of GetAllFeatureScores()
+  static void GetAllFeatureLabels(std::vector<std::pair<std::string, std::size_t> > &labels);
+
 #ifdef MPI_ENABLE
 public:
   friend class boost::serialization::access;
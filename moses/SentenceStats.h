@@ -26,6 +26,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <string>
 #include <vector>
 #include <ctime>
+#include <boost/atomic.hpp>
 #include "Timer.h"
 #include "Phrase.h"
 #include "Hypothesis.h"
@@ -233,8 +234,9 @@ protected:
   std::vector<RecombinationInfo> m_recombinationInfos;
   unsigned int m_numHyposCreated;
   unsigned int m_numHyposPopped;
-  unsigned int m_numHyposPruned;
-  unsigned int m_numHyposDiscarded;
+  // counted by the cells of a chart decoded in parallel
+  boost::atomic<unsigned int> m_numHyposPruned;
+  boost::atomic<unsigned int> m_numHyposDiscarded;
   unsigned int m_numHyposEarlyDiscarded;
   unsigned int m_numHyposNotBuilt;
   Timer m_timeCollectOpts;
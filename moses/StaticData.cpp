@@ -246,6 +246,11 @@ bool StaticData::LoadData(Parameter *parameter)
   if (params && params->size() && !LoadAlternateWeightSettings())
     return false;
 
+  // all features and weights are known; without sparse features, score
+  // vectors are combined with the dense kernels
+  FVector::selectDenseOnly();
+  VERBOSE(2, "Dense-only feature vectors: " << (FVector::isDenseOnly() ? "yes" : "no") << endl);
+
   return true;
 }
 
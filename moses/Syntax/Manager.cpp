@@ -85,6 +85,7 @@ void Manager::OutputNBestList(OutputCollector *collector,
 
   bool includeWordAlignment = options()->nbest.include_alignment_info;
   bool PrintNBestTrees = options()->nbest.print_trees; // PrintNBestTrees();
+  BinaryNBestWriter *binary = GetBinaryNBestWriter();
 
   for (KBestExtractor::KBestVec::const_iterator p = nBestList.begin();
        p != nBestList.end(); ++p) {
@@ -99,6 +100,25 @@ void Manager::OutputNBestList(OutputCollector *collector,
     outputPhrase.RemoveWord(0);
     outputPhrase.RemoveWord(outputPhrase.GetSize() - 1);
 
+    // optionally, word alignments
+    std::ostringstream alignment;
+    if (includeWordAlignment) {
+      Alignments align;
+      OutputAlignmentNBest(align, derivation, 0);
+      for (Alignments::const_iterator q = align.begin(); q != align.end();
+           ++q) {
+        alignment << q->first << "-" << q->second << " ";
+      }
+    }
+
+    if (binary) {
+      std::ostringstream surface;
+      OutputSurface(surface, outputPhrase);
+      OutputBinaryNBestEntry(out, *binary, surface.str(), derivation.scoreBreakdown,
+                             derivation.score, alignment.str());
+      continue;
+    }
+
     // print the translation ID, surface factors, and scores
     out << translationId << " ||| ";
     OutputSurface(out, outputPhrase); // , outputFactorOrder, false);
@@ -107,15 +127,8 @@ void Manager::OutputNBestList(OutputCollector *collector,
     derivation.scoreBreakdown.OutputAllFeatureScores(out, with_labels);
     out << " ||| " << derivation.score;
 
-    // optionally, print word alignments
     if (includeWordAlignment) {
-      out << " ||| ";
-      Alignments align;
-      OutputAlignmentNBest(align, derivation, 0);
-      for (Alignments::const_iterator q = align.begin(); q != align.end();
-           ++q) {
-        out << q->first << "-" << q->second << " ";
-      }
+      out << " ||| " << alignment.str();
     }
 
     // optionally, print tree
@@ -0,0 +1,127 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+// CompactPT, and so the cache, is only built with cmph
+#ifdef HAVE_CMPH
+
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+#include "FactorCollection.h"
+#include "TranslationModel/CompactPT/TargetPhraseCollectionCache.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+Phrase MakePhrase(size_t i)
+{
+  stringstream strme;
+  strme << "tpcc_test_" << i;
+  Word word;
+  word.SetFactor(0, FactorCollection::Instance().AddFactor(strme.str()));
+  Phrase phrase;
+  phrase.AddWord(word);
+  return phrase;
+}
+
+TargetPhraseVectorPtr MakeTargets(size_t n)
+{
+  return TargetPhraseVectorPtr(new TargetPhraseVector(n));
+}
+
+void CacheAndRetrieve(TargetPhraseCollectionCache *cache, size_t threadInd)
+{
+  for (size_t i = 0; i < 2000; ++i) {
+    Phrase phrase = MakePhrase((i * 7 + threadInd) % 300);
+    std::pair<TargetPhraseVectorPtr, size_t> ret = cache->Retrieve(phrase);
+    if (ret.first) {
+      BOOST_CHECK_EQUAL(ret.first->size(), (size_t) 3);
+    } else {
+      cache->Cache(phrase, MakeTargets(3));
+    }
+  }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(target_phrase_collection_cache)
+
+BOOST_AUTO_TEST_CASE(cache_and_retrieve)
+{
+  TargetPhraseCollectionCache cache;
+  Phrase a = MakePhrase(0), b = MakePhrase(1);
+
+  BOOST_CHECK(!cache.Retrieve(a).first);
+  cache.Cache(a, MakeTargets(5), 42, 2);
+
+  std::pair<TargetPhraseVectorPtr, size_t> ret = cache.Retrieve(a);
+  BOOST_REQUIRE(ret.first);
+  BOOST_CHECK_EQUAL(ret.first->size(), (size_t) 2); // cut to maxRank
+  BOOST_CHECK_EQUAL(ret.second, (size_t) 42);
+  BOOST_CHECK(!cache.Retrieve(b).first);
+
+  TargetPhraseCollectionCache::Stats stats = cache.GetStats();
+  BOOST_CHECK_EQUAL(stats.hits, (size_t) 1);
+  BOOST_CHECK_EQUAL(stats.misses, (size_t) 2);
+  BOOST_CHECK_EQUAL(stats.entries, (size_t) 1);
+  BOOST_CHECK_EQUAL(stats.evictions, (size_t) 0);
+
+  cache.CleanUp();
+  BOOST_CHECK(!cache.Retrieve(a).first);
+}
+
+BOOST_AUTO_TEST_CASE(bounded_bytes)
+{
+  // small enough that each shard only holds a few entries
+  TargetPhraseCollectionCache cache(64 * 4096);
+  for (size_t i = 0; i < 5000; ++i) {
+    cache.Cache(MakePhrase(i), MakeTargets(4));
+  }
+  TargetPhraseCollectionCache::Stats stats = cache.GetStats();
+  BOOST_CHECK_LE(stats.bytes, cache.GetMaxBytes());
+  BOOST_CHECK_GT(stats.evictions, (size_t) 0);
+  BOOST_CHECK_EQUAL(stats.entries + stats.evictions, (size_t) 5000);
+
+  // the most recently added phrase survives
+  BOOST_CHECK(cache.Retrieve(MakePhrase(4999)).first);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_access)
+{
+  TargetPhraseCollectionCache cache;
+  boost::thread_group threads;
+  for (size_t i = 0; i < 8; ++i) {
+    threads.create_thread(boost::bind(&CacheAndRetrieve, &cache, i));
+  }
+  threads.join_all();
+
+  TargetPhraseCollectionCache::Stats stats = cache.GetStats();
+  BOOST_CHECK_EQUAL(stats.hits + stats.misses, (size_t) 8 * 2000);
+  BOOST_CHECK_EQUAL(stats.entries, (size_t) 300);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
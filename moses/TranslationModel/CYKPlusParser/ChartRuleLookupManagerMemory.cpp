@@ -49,6 +49,8 @@ ChartRuleLookupManagerMemory::ChartRuleLookupManagerMemory(
   m_completedRules.resize(sourceSize, CompletedRuleCollection(ruleLimit));
 
   m_isSoftMatching = !m_softMatchingMap.empty();
+  m_lookupByWidth = false;
+  m_widthInMatrix = 0;
 }
 
 void ChartRuleLookupManagerMemory::GetChartRuleCollection(
@@ -60,24 +62,39 @@ void ChartRuleLookupManagerMemory::GetChartRuleCollection(
   size_t startPos = range.GetStartPos();
   size_t absEndPos = range.GetEndPos();
 
-  m_lastPos = lastPos;
   m_stackVec.clear();
   m_stackScores.clear();
   m_outColl = &outColl;
-  m_unaryPos = absEndPos-1; // rules ending in this position are unary and should not be added to collection
-
-  // create/update data structure to quickly look up all chart cells that match start position and label.
-  UpdateCompressedMatrix(startPos, absEndPos, lastPos);
+  m_lookupByWidth = GetParser().IsLookupByWidth();
 
   const PhraseDictionaryNodeMemory &rootNode = m_ruleTable.GetRootNode();
 
-  // all rules starting with terminal
-  if (startPos == absEndPos) {
+  if (m_lookupByWidth) {
+    // only the cells of shorter spans are decoded. Collect the rules covering
+    // exactly this range, all from here rather than over several calls
+    m_lastPos = absEndPos;
+    m_unaryPos = NOT_FOUND; // this range is not a cell yet, so no rule can be unary
+    UpdateCompressedMatrixByWidth(range.GetNumWordsCovered());
+
     GetTerminalExtension(&rootNode, startPos);
-  }
-  // all rules starting with nonterminal
-  else if (absEndPos > startPos) {
-    GetNonTerminalExtension(&rootNode, startPos);
+    if (absEndPos > startPos) {
+      GetNonTerminalExtension(&rootNode, startPos);
+    }
+  } else {
+    m_lastPos = lastPos;
+    m_unaryPos = absEndPos-1; // rules ending in this position are unary and should not be added to collection
+
+    // create/update data structure to quickly look up all chart cells that match start position and label.
+    UpdateCompressedMatrix(startPos, absEndPos, lastPos);
+
+    // all rules starting with terminal
+    if (startPos == absEndPos) {
+      GetTerminalExtension(&rootNode, startPos);
+    }
+    // all rules starting with nonterminal
+    else if (absEndPos > startPos) {
+      GetNonTerminalExtension(&rootNode, startPos);
+    }
   }
 
   // copy temporarily stored rules to out collection
@@ -90,6 +107,44 @@ void ChartRuleLookupManagerMemory::GetChartRuleCollection(
 
 }
 
+// In lookup by width, add the cells of all spans shorter than width to the compressed matrix.
+// Cells are added in order of width, so each column stays sorted by end position.
+void ChartRuleLookupManagerMemory::UpdateCompressedMatrixByWidth(size_t width)
+{
+  size_t numNonTerms = FactorCollection::Instance().GetNumNonTerminals();
+  size_t size = GetParser().GetSize();
+  m_compressedMatrixVec.resize(size);
+
+  for (; m_widthInMatrix + 1 < width; ++m_widthInMatrix) {
+    size_t cellWidth = m_widthInMatrix + 1;
+    for (size_t startPos = 0; startPos + cellWidth <= size; ++startPos) {
+      size_t endPos = startPos + cellWidth - 1;
+      CompressedMatrix & cellMatrix = m_compressedMatrixVec[startPos];
+      cellMatrix.resize(numNonTerms);
+
+      const ChartCellLabelSet &targetNonTerms = GetTargetLabelSet(startPos, endPos);
+      if (targetNonTerms.GetSize() == 0) {
+        continue;
+      }
+
+#if !defined(UNLABELLED_SOURCE)
+      const InputPath &inputPath = GetParser().GetInputPath(startPos, endPos);
+      if (inputPath.GetNonTerminalSet().size() == 0) {
+        continue;
+      }
+#endif
+
+      for (size_t i = 0; i < numNonTerms; i++) {
+        const ChartCellLabel *cellLabel = targetNonTerms.Find(i);
+        if (cellLabel != NULL) {
+          float score = cellLabel->GetBestScore(m_outColl);
+          cellMatrix[i].push_back(ChartCellCache(endPos, cellLabel, score));
+        }
+      }
+    }
+  }
+}
+
 // Create/update compressed matrix that stores all valid ChartCellLabels for a given start position and label.
 void ChartRuleLookupManagerMemory::UpdateCompressedMatrix(size_t startPos,
     size_t origEndPos,
@@ -169,7 +224,9 @@ void ChartRuleLookupManagerMemory::AddAndExtend(
 
   TargetPhraseCollection::shared_ptr tpc = node->GetTargetPhraseCollection();
   // add target phrase collection (except if rule is empty or a unary non-terminal rule)
-  if (!tpc->IsEmpty() && (m_stackVec.empty() || endPos != m_unaryPos)) {
+  // (in lookup by width, only rules covering the whole range)
+  if (!tpc->IsEmpty() && (m_stackVec.empty() || endPos != m_unaryPos)
+      && (!m_lookupByWidth || endPos == m_lastPos)) {
     m_completedRules[endPos].Add(*tpc, m_stackVec, m_stackScores, *m_outColl);
   }
 
@@ -248,6 +305,9 @@ void ChartRuleLookupManagerMemory::GetNonTerminalExtension(
       for (std::vector<Word>::const_iterator softMatch = softMatches.begin(); softMatch != softMatches.end(); ++softMatch) {
         const CompressedColumn &matches = compressedMatrix[(*softMatch)[0]->GetId()];
         for (CompressedColumn::const_iterator match = matches.begin(); match != matches.end(); ++match) {
+          if (match->endPos > m_lastPos) {
+            break;
+          }
           m_stackVec.back() = match->cellLabel;
           m_stackScores.back() = match->score;
           AddAndExtend(child, match->endPos);
@@ -256,7 +316,11 @@ void ChartRuleLookupManagerMemory::GetNonTerminalExtension(
     } // end of soft matches lookup
 
     const CompressedColumn &matches = compressedMatrix[targetNonTerm[0]->GetId()];
+    // columns are sorted by end position
     for (CompressedColumn::const_iterator match = matches.begin(); match != matches.end(); ++match) {
+      if (match->endPos > m_lastPos) {
+        break;
+      }
       m_stackVec.back() = match->cellLabel;
       m_stackScores.back() = match->score;
       AddAndExtend(child, match->endPos);
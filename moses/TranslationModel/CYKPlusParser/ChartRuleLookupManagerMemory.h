@@ -53,6 +53,10 @@ public:
     size_t lastPos, // last position to consider if using lookahead
     ChartParserCallback &outColl);
 
+  virtual bool SupportsLookupByWidth() const {
+    return true;
+  }
+
 private:
 
   void GetTerminalExtension(
@@ -67,6 +71,8 @@ private:
     const PhraseDictionaryNodeMemory *node,
     size_t endPos);
 
+  void UpdateCompressedMatrixByWidth(size_t width);
+
   void UpdateCompressedMatrix(size_t startPos,
                               size_t endPos,
                               size_t lastPos);
@@ -82,6 +88,8 @@ private:
 
   size_t m_lastPos;
   size_t m_unaryPos;
+  bool m_lookupByWidth;
+  size_t m_widthInMatrix; // in lookup by width, the cells up to this width are in the matrix
 
   StackVec m_stackVec;
   std::vector<float> m_stackScores;
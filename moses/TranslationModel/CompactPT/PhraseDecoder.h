@@ -136,7 +136,9 @@ public:
                                          bool topLevel,
                                          bool eval);
 
-  void PruneCache();
+  TargetPhraseCollectionCache::Stats GetCacheStats() const {
+    return m_decodingCache.GetStats();
+  }
 };
 
 }
@@ -49,6 +49,7 @@ PhraseDictionaryCompact::SentenceCache PhraseDictionaryCompact::m_sentenceCache;
 PhraseDictionaryCompact::PhraseDictionaryCompact(const std::string &line)
   :PhraseDictionary(line, true)
   ,m_inMemory(s_inMemoryByDefault)
+  ,m_cacheSize(s_cacheSizeByDefault)
   ,m_useAlignmentInfo(true)
   ,m_hash(10, 16)
   ,m_phraseDecoder(0)
@@ -152,8 +153,14 @@ GetTargetPhraseCollectionRaw(const Phrase &sourcePhrase) const
 PhraseDictionaryCompact::
 ~PhraseDictionaryCompact()
 {
-  if(m_phraseDecoder)
+  if(m_phraseDecoder) {
+    TargetPhraseCollectionCache::Stats stats = m_phraseDecoder->GetCacheStats();
+    VERBOSE(1, GetScoreProducerDescription() << " decoding cache:"
+            << " hits=" << stats.hits << " misses=" << stats.misses
+            << " evictions=" << stats.evictions << " entries=" << stats.entries
+            << " bytes=" << stats.bytes << std::endl);
     delete m_phraseDecoder;
+  }
 }
 
 void
@@ -177,18 +184,22 @@ CleanUpAfterSentenceProcessing(const InputType &source)
   if(!m_sentenceCache.get())
     m_sentenceCache.reset(new PhraseCache());
 
-  m_phraseDecoder->PruneCache();
   m_sentenceCache->clear();
 
   ReduceCache();
 }
 
 bool PhraseDictionaryCompact::s_inMemoryByDefault = false;
+size_t PhraseDictionaryCompact::s_cacheSizeByDefault = 256 * 1024 * 1024;
 void
 PhraseDictionaryCompact::
 SetStaticDefaultParameters(Parameter const& param)
 {
   param.SetParameter(s_inMemoryByDefault, "minphr-memory", false);
+
+  size_t cacheSizeMB;
+  param.SetParameter<size_t>(cacheSizeMB, "minphr-cache-size", 256);
+  s_cacheSizeByDefault = cacheSizeMB * 1024 * 1024;
 }
 }
 
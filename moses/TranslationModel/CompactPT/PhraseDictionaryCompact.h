@@ -49,7 +49,9 @@ protected:
   friend class PhraseDecoder;
 
   static bool s_inMemoryByDefault;
+  static size_t s_cacheSizeByDefault;
   bool m_inMemory;
+  size_t m_cacheSize; // bytes, shared by all threads
   bool m_useAlignmentInfo;
 
   typedef std::vector<TargetPhraseCollection::shared_ptr > PhraseCache;
@@ -21,6 +21,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include <cstdio>
 
+#include <boost/bind.hpp>
+
 #include "PhraseTableCreator.h"
 #include "ConsistentPhrases.h"
 #include "ThrowingFwrite.h"
@@ -52,7 +54,8 @@ PhraseTableCreator::PhraseTableCreator(std::string inPath,
                                        bool multipleScoreTrees,
                                        size_t quantize,
                                        size_t maxRank,
-                                       bool warnMe
+                                       bool warnMe,
+                                       bool streaming
 #ifdef WITH_THREADS
                                        , size_t threads
 #endif
@@ -63,7 +66,7 @@ PhraseTableCreator::PhraseTableCreator(std::string inPath,
     m_coding(coding), m_orderBits(orderBits), m_fingerPrintBits(fingerPrintBits),
     m_useAlignmentInfo(useAlignmentInfo),
     m_multipleScoreTrees(multipleScoreTrees),
-    m_quantize(quantize), m_maxRank(maxRank),
+    m_quantize(quantize), m_maxRank(maxRank), m_streaming(streaming),
 #ifdef WITH_THREADS
     m_threads(threads),
     m_srcHash(m_orderBits, m_fingerPrintBits, 1),
@@ -72,9 +75,9 @@ PhraseTableCreator::PhraseTableCreator(std::string inPath,
     m_srcHash(m_orderBits, m_fingerPrintBits),
     m_rnkHash(m_orderBits, m_fingerPrintBits),
 #endif
-    m_maxPhraseLength(0),
+    m_maxPhraseLength(0), m_encodedTargetPhrases(NULL),
     m_lastFlushedLine(-1), m_lastFlushedSourceNum(0),
-    m_lastFlushedSourcePhrase("")
+    m_lastFlushedSourcePhrase(""), m_nextStreamedChunk(0)
 {
   PrintInfo();
 
@@ -106,33 +109,57 @@ PhraseTableCreator::PhraseTableCreator(std::string inPath,
     CreateRankHash();
   }
 
-  // 1st pass
-  std::cerr << "Pass " << cur_pass << "/" << all_passes << ": Creating source phrase index + Encoding target phrases" << std::endl;
-  m_srcHash.BeginSave(m_outFile);
+  if(m_streaming) {
+    // Streaming mode: the 1st pass only counts symbols, the 2nd pass encodes
+    // the text again and compresses it right away, so that no encoded
+    // intermediate of the whole table is kept.
+    std::cerr << "Pass " << cur_pass << "/" << all_passes << ": Counting target phrase symbols" << std::endl;
+    CountTargetPhrases();
+
+    cur_pass++;
+
+    std::cerr << "Intermezzo: Calculating Huffman code sets" << std::endl;
+    CalcHuffmanCodes();
 
-  if(tempfilePath.size()) {
-    MmapAllocator<unsigned char> allocEncoded(util::FMakeTemp(tempfilePath));
-    m_encodedTargetPhrases = new StringVectorTemp<unsigned char, unsigned long, MmapAllocator>(allocEncoded);
+    std::cerr << "Pass " << cur_pass << "/" << all_passes << ": Creating source phrase index + Encoding and compressing target phrases" << std::endl;
+    m_srcHash.BeginSave(m_outFile);
+
+    if(tempfilePath.size()) {
+      MmapAllocator<unsigned char> allocCompressed(util::FMakeTemp(tempfilePath));
+      m_compressedTargetPhrases = new StringVector<unsigned char, unsigned long, MmapAllocator>(allocCompressed);
+    } else {
+      m_compressedTargetPhrases = new StringVector<unsigned char, unsigned long, MmapAllocator>(true);
+    }
+    StreamTargetPhrases();
   } else {
-    m_encodedTargetPhrases = new StringVectorTemp<unsigned char, unsigned long, MmapAllocator>();
-  }
-  EncodeTargetPhrases();
+    // 1st pass
+    std::cerr << "Pass " << cur_pass << "/" << all_passes << ": Creating source phrase index + Encoding target phrases" << std::endl;
+    m_srcHash.BeginSave(m_outFile);
+
+    if(tempfilePath.size()) {
+      MmapAllocator<unsigned char> allocEncoded(util::FMakeTemp(tempfilePath));
+      m_encodedTargetPhrases = new StringVectorTemp<unsigned char, unsigned long, MmapAllocator>(allocEncoded);
+    } else {
+      m_encodedTargetPhrases = new StringVectorTemp<unsigned char, unsigned long, MmapAllocator>();
+    }
+    EncodeTargetPhrases();
 
-  cur_pass++;
+    cur_pass++;
 
-  std::cerr << "Intermezzo: Calculating Huffman code sets" << std::endl;
-  CalcHuffmanCodes();
+    std::cerr << "Intermezzo: Calculating Huffman code sets" << std::endl;
+    CalcHuffmanCodes();
 
-  // 2nd pass
-  std::cerr << "Pass " << cur_pass << "/" << all_passes << ": Compressing target phrases" << std::endl;
+    // 2nd pass
+    std::cerr << "Pass " << cur_pass << "/" << all_passes << ": Compressing target phrases" << std::endl;
 
-  if(tempfilePath.size()) {
-    MmapAllocator<unsigned char> allocCompressed(util::FMakeTemp(tempfilePath));
-    m_compressedTargetPhrases = new StringVector<unsigned char, unsigned long, MmapAllocator>(allocCompressed);
-  } else {
-    m_compressedTargetPhrases = new StringVector<unsigned char, unsigned long, MmapAllocator>(true);
+    if(tempfilePath.size()) {
+      MmapAllocator<unsigned char> allocCompressed(util::FMakeTemp(tempfilePath));
+      m_compressedTargetPhrases = new StringVector<unsigned char, unsigned long, MmapAllocator>(allocCompressed);
+    } else {
+      m_compressedTargetPhrases = new StringVector<unsigned char, unsigned long, MmapAllocator>(true);
+    }
+    CompressTargetPhrases();
   }
-  CompressTargetPhrases();
 
   std::cerr << "Saving to " << m_outPath << std::endl;
   Save();
@@ -179,6 +206,7 @@ void PhraseTableCreator::PrintInfo()
   else
     std::cerr << "no" << std::endl;
   std::cerr << "\tExplicitly included alignment information: " << (m_useAlignmentInfo ? "yes" : "no") << std::endl;
+  std::cerr << "\tStreaming from sorted text: " << (m_streaming ? "yes" : "no") << std::endl;
 
 #ifdef WITH_THREADS
   std::cerr << "\tRunning with " << m_threads << " threads" << std::endl;
@@ -377,35 +405,91 @@ void PhraseTableCreator::CompressTargetPhrases()
   FlushCompressedQueue(true);
 }
 
+void PhraseTableCreator::CountTargetPhrases()
+{
+  InputFileStream inFile(m_inPath);
+  ChunkReader reader(inFile);
+
+#ifdef WITH_THREADS
+  boost::thread_group threads;
+  for (size_t i = 0; i < m_threads; ++i)
+    threads.create_thread(StreamingTask(reader, *this, false));
+  threads.join_all();
+#else
+  StreamingTask st(reader, *this, false);
+  st();
+#endif
+}
+
+void PhraseTableCreator::StreamTargetPhrases()
+{
+  InputFileStream inFile(m_inPath);
+  // Compressed chunks are kept until all earlier ones are saved
+  ChunkReader reader(inFile, 1000, 4 * m_threads);
+
+#ifdef WITH_THREADS
+  boost::thread_group threads;
+  for (size_t i = 0; i < m_threads; ++i)
+    threads.create_thread(StreamingTask(reader, *this, true));
+  threads.join_all();
+#else
+  StreamingTask st(reader, *this, true);
+  st();
+#endif
+  FlushStreamedChunks(true);
+}
+
 void PhraseTableCreator::CalcHuffmanCodes()
 {
   std::cerr << "\tCreating Huffman codes for " << m_symbolCounter.Size()
             << " target phrase symbols" << std::endl;
 
-  m_symbolTree = new SymbolTree(m_symbolCounter.Begin(),
-                                m_symbolCounter.End());
-
-  std::vector<ScoreTree*>::iterator treeIt = m_scoreTrees.begin();
-  for(std::vector<ScoreCounter*>::iterator it = m_scoreCounters.begin();
-      it != m_scoreCounters.end(); it++) {
-    if(m_quantize)
-      (*it)->Quantize(m_quantize);
+  // The code sets do not depend on each other
+#ifdef WITH_THREADS
+  boost::thread_group threads;
+  threads.create_thread(boost::bind(&PhraseTableCreator::CalcSymbolCodes, this));
+  for(size_t i = 0; i < m_scoreCounters.size(); i++)
+    threads.create_thread(boost::bind(&PhraseTableCreator::CalcScoreCodes, this, i));
+  if(m_useAlignmentInfo)
+    threads.create_thread(boost::bind(&PhraseTableCreator::CalcAlignCodes, this));
+  threads.join_all();
+#else
+  CalcSymbolCodes();
+  for(size_t i = 0; i < m_scoreCounters.size(); i++)
+    CalcScoreCodes(i);
+  if(m_useAlignmentInfo)
+    CalcAlignCodes();
+#endif
 
-    std::cerr << "\tCreating Huffman codes for " << (*it)->Size()
+  for(size_t i = 0; i < m_scoreCounters.size(); i++)
+    std::cerr << "\tCreated Huffman codes for " << m_scoreCounters[i]->Size()
               << " scores" << std::endl;
 
-    *treeIt = new ScoreTree((*it)->Begin(), (*it)->End());
-    treeIt++;
-  }
-
-  if(m_useAlignmentInfo) {
-    std::cerr << "\tCreating Huffman codes for " << m_alignCounter.Size()
+  if(m_useAlignmentInfo)
+    std::cerr << "\tCreated Huffman codes for " << m_alignCounter.Size()
               << " alignment points" << std::endl;
-    m_alignTree = new AlignTree(m_alignCounter.Begin(), m_alignCounter.End());
-  }
   std::cerr << std::endl;
 }
 
+void PhraseTableCreator::CalcSymbolCodes()
+{
+  m_symbolTree = new SymbolTree(m_symbolCounter.Begin(),
+                                m_symbolCounter.End());
+}
+
+void PhraseTableCreator::CalcScoreCodes(size_t i)
+{
+  if(m_quantize)
+    m_scoreCounters[i]->Quantize(m_quantize);
+  m_scoreTrees[i] = new ScoreTree(m_scoreCounters[i]->Begin(),
+                                  m_scoreCounters[i]->End());
+}
+
+void PhraseTableCreator::CalcAlignCodes()
+{
+  m_alignTree = new AlignTree(m_alignCounter.Begin(), m_alignCounter.End());
+}
+
 
 void PhraseTableCreator::AddSourceSymbolId(std::string& symbol)
 {
@@ -473,6 +557,21 @@ unsigned PhraseTableCreator::GetOrAddTargetSymbolId(std::string& symbol)
   }
 }
 
+unsigned PhraseTableCreator::GetOrAddTargetSymbolId(std::string& symbol,
+    EncodingContext& context)
+{
+  boost::unordered_map<std::string, unsigned>::iterator it
+  = context.targetSymbols.find(symbol);
+  if(it != context.targetSymbols.end())
+    return it->second;
+
+  unsigned value = GetOrAddTargetSymbolId(symbol);
+  // keep the cache of every thread bounded
+  if(context.targetSymbols.size() < (1ul << 20))
+    context.targetSymbols[symbol] = value;
+  return value;
+}
+
 unsigned PhraseTableCreator::GetRank(unsigned srcIdx, unsigned trgIdx)
 {
   size_t srcTrgIdx = m_lexicalTableIndex[srcIdx];
@@ -535,26 +634,30 @@ unsigned PhraseTableCreator::EncodePREncSymbol2(int left, int right, unsigned ra
 }
 
 void PhraseTableCreator::EncodeTargetPhraseNone(std::vector<std::string>& t,
+    EncodingContext& context,
     std::ostream& os)
 {
   std::stringstream encodedTargetPhrase;
   size_t j = 0;
   while(j < t.size()) {
-    unsigned targetSymbolId = GetOrAddTargetSymbolId(t[j]);
+    unsigned targetSymbolId = GetOrAddTargetSymbolId(t[j], context);
 
-    m_symbolCounter.Increase(targetSymbolId);
+    if(context.count)
+      context.symbols[targetSymbolId]++;
     os.write((char*)&targetSymbolId, sizeof(targetSymbolId));
     j++;
   }
 
-  unsigned stopSymbolId = GetTargetSymbolId(m_phraseStopSymbol);
+  unsigned stopSymbolId = GetOrAddTargetSymbolId(m_phraseStopSymbol, context);
   os.write((char*)&stopSymbolId, sizeof(stopSymbolId));
-  m_symbolCounter.Increase(stopSymbolId);
+  if(context.count)
+    context.symbols[stopSymbolId]++;
 }
 
 void PhraseTableCreator::EncodeTargetPhraseREnc(std::vector<std::string>& s,
     std::vector<std::string>& t,
     std::set<AlignPoint>& a,
+    EncodingContext& context,
     std::ostream& os)
 {
   std::stringstream encodedTargetPhrase;
@@ -564,7 +667,7 @@ void PhraseTableCreator::EncodeTargetPhraseREnc(std::vector<std::string>& s,
     a2[it->second].push_back(it->first);
 
   for(size_t i = 0; i < t.size(); i++) {
-    unsigned idxTarget = GetOrAddTargetSymbolId(t[i]);
+    unsigned idxTarget = GetOrAddTargetSymbolId(t[i], context);
     unsigned encodedSymbol = -1;
 
     unsigned bestSrcPos = s.size();
@@ -579,10 +682,10 @@ void PhraseTableCreator::EncodeTargetPhraseREnc(std::vector<std::string>& s,
         if(r < bestRank) {
           bestRank = r;
           bestSrcPos = *it;
-          bestDiff = abs(*it-i);
-        } else if(r == bestRank && unsigned(abs(*it-i)) < bestDiff) {
+          bestDiff = abs(int(*it) - int(i));
+        } else if(r == bestRank && unsigned(abs(int(*it) - int(i))) < bestDiff) {
           bestSrcPos = *it;
-          bestDiff = abs(*it-i);
+          bestDiff = abs(int(*it) - int(i));
         }
       }
     }
@@ -598,19 +701,22 @@ void PhraseTableCreator::EncodeTargetPhraseREnc(std::vector<std::string>& s,
     }
 
     os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
-    m_symbolCounter.Increase(encodedSymbol);
+    if(context.count)
+      context.symbols[encodedSymbol]++;
   }
 
-  unsigned stopSymbolId = GetTargetSymbolId(m_phraseStopSymbol);
+  unsigned stopSymbolId = GetOrAddTargetSymbolId(m_phraseStopSymbol, context);
   unsigned encodedSymbol = EncodeREncSymbol1(stopSymbolId);
   os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
-  m_symbolCounter.Increase(encodedSymbol);
+  if(context.count)
+    context.symbols[encodedSymbol]++;
 }
 
 void PhraseTableCreator::EncodeTargetPhrasePREnc(std::vector<std::string>& s,
     std::vector<std::string>& t,
     std::set<AlignPoint>& a,
     size_t ownRank,
+    EncodingContext& context,
     std::ostream& os)
 {
   std::vector<unsigned> encodedSymbols(t.size());
@@ -660,25 +766,30 @@ void PhraseTableCreator::EncodeTargetPhrasePREnc(std::vector<std::string>& s,
   while(j < t.size()) {
     if(encodedSymbolsLengths[j] > 0) {
       unsigned encodedSymbol = encodedSymbols[j];
-      m_symbolCounter.Increase(encodedSymbol);
+      if(context.count)
+        context.symbols[encodedSymbol]++;
       os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
       j += encodedSymbolsLengths[j];
     } else {
-      unsigned targetSymbolId = GetOrAddTargetSymbolId(t[j]);
+      unsigned targetSymbolId = GetOrAddTargetSymbolId(t[j], context);
       unsigned encodedSymbol = EncodePREncSymbol1(targetSymbolId);
-      m_symbolCounter.Increase(encodedSymbol);
+      if(context.count)
+        context.symbols[encodedSymbol]++;
       os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
       j++;
     }
   }
 
-  unsigned stopSymbolId = GetTargetSymbolId(m_phraseStopSymbol);
+  unsigned stopSymbolId = GetOrAddTargetSymbolId(m_phraseStopSymbol, context);
   unsigned encodedSymbol = EncodePREncSymbol1(stopSymbolId);
   os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
-  m_symbolCounter.Increase(encodedSymbol);
+  if(context.count)
+    context.symbols[encodedSymbol]++;
 }
 
-void PhraseTableCreator::EncodeScores(std::vector<float>& scores, std::ostream& os)
+void PhraseTableCreator::EncodeScores(std::vector<float>& scores,
+                                      EncodingContext& context,
+                                      std::ostream& os)
 {
   size_t c = 0;
   float score;
@@ -687,25 +798,57 @@ void PhraseTableCreator::EncodeScores(std::vector<float>& scores, std::ostream&
     score = scores[c];
     score = FloorScore(TransformScore(score));
     os.write((char*)&score, sizeof(score));
-    m_scoreCounters[m_multipleScoreTrees ? c : 0]->Increase(score);
+    if(context.count)
+      context.scores[m_multipleScoreTrees ? c : 0][score]++;
     c++;
   }
 }
 
 void PhraseTableCreator::EncodeAlignment(std::set<AlignPoint>& alignment,
+    EncodingContext& context,
     std::ostream& os)
 {
   for(std::set<AlignPoint>::iterator it = alignment.begin();
       it != alignment.end(); it++) {
     os.write((char*)&(*it), sizeof(AlignPoint));
-    m_alignCounter.Increase(*it);
+    if(context.count)
+      context.alignPoints[*it]++;
   }
   AlignPoint stop(-1, -1);
   os.write((char*) &stop, sizeof(AlignPoint));
-  m_alignCounter.Increase(stop);
+  if(context.count)
+    context.alignPoints[stop]++;
 }
 
-std::string PhraseTableCreator::EncodeLine(std::vector<std::string>& tokens, size_t ownRank)
+void PhraseTableCreator::SplitLine(std::string& line, std::vector<std::string>& tokens)
+{
+  tokens.clear();
+  Moses::TokenizeMultiCharSeparator(tokens, line, m_separator);
+
+  for(std::vector<std::string>::iterator it = tokens.begin(); it != tokens.end(); it++)
+    *it = Moses::Trim(*it);
+
+  if(tokens.size() < 3) {
+    std::stringstream strme;
+    strme << "Error: It seems the following line has a wrong format:" << std::endl;
+    strme << "Line: " << line << std::endl;
+    UTIL_THROW2(strme.str());
+  }
+
+  if(tokens.size() > 3 && tokens[3].size() <= 1 && m_coding != None) {
+    std::stringstream strme;
+    strme << "Error: It seems the following line contains no alignment information, " << std::endl;
+    strme << "but you are using ";
+    strme << (m_coding == PREnc ? "PREnc" : "REnc");
+    strme << " encoding which makes use of alignment data. " << std::endl;
+    strme << "Use -encoding None" << std::endl;
+    strme << "Line: " << line << std::endl;
+    UTIL_THROW2(strme.str());
+  }
+}
+
+std::string PhraseTableCreator::EncodeLine(std::vector<std::string>& tokens, size_t ownRank,
+    EncodingContext& context)
 {
   std::string sourcePhraseStr = tokens[0];
   std::string targetPhraseStr = tokens[1];
@@ -718,8 +861,8 @@ std::string PhraseTableCreator::EncodeLine(std::vector<std::string>& tokens, siz
   std::vector<std::string> s = Tokenize(sourcePhraseStr);
 
   size_t phraseLength = s.size();
-  if(m_maxPhraseLength < phraseLength)
-    m_maxPhraseLength = phraseLength;
+  if(context.maxPhraseLength < phraseLength)
+    context.maxPhraseLength = phraseLength;
 
   std::vector<std::string> t = Tokenize(targetPhraseStr);
   std::vector<float> scores = Tokenize<float>(scoresStr);
@@ -743,21 +886,35 @@ std::string PhraseTableCreator::EncodeLine(std::vector<std::string>& tokens, siz
   std::stringstream encodedTargetPhrase;
 
   if(m_coding == PREnc) {
-    EncodeTargetPhrasePREnc(s, t, a, ownRank, encodedTargetPhrase);
+    EncodeTargetPhrasePREnc(s, t, a, ownRank, context, encodedTargetPhrase);
   } else if(m_coding == REnc) {
-    EncodeTargetPhraseREnc(s, t, a, encodedTargetPhrase);
+    EncodeTargetPhraseREnc(s, t, a, context, encodedTargetPhrase);
   } else {
-    EncodeTargetPhraseNone(t, encodedTargetPhrase);
+    EncodeTargetPhraseNone(t, context, encodedTargetPhrase);
   }
 
-  EncodeScores(scores, encodedTargetPhrase);
+  EncodeScores(scores, context, encodedTargetPhrase);
 
   if(m_useAlignmentInfo)
-    EncodeAlignment(a, encodedTargetPhrase);
+    EncodeAlignment(a, context, encodedTargetPhrase);
 
   return encodedTargetPhrase.str();
 }
 
+void PhraseTableCreator::MergeCounts(EncodingContext& context)
+{
+  m_symbolCounter.Merge(context.symbols);
+  for(size_t i = 0; i < m_scoreCounters.size(); i++)
+    m_scoreCounters[i]->Merge(context.scores[i]);
+  m_alignCounter.Merge(context.alignPoints);
+
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
+  if(m_maxPhraseLength < context.maxPhraseLength)
+    m_maxPhraseLength = context.maxPhraseLength;
+}
+
 std::string PhraseTableCreator::CompressEncodedCollection(std::string encodedCollection)
 {
   enum EncodeState {
@@ -1013,6 +1170,60 @@ void PhraseTableCreator::FlushCompressedQueue(bool force)
   }
 }
 
+void PhraseTableCreator::AddStreamedChunk(size_t chunkNum,
+    std::vector<SrcTrgString>& collections)
+{
+  m_streamedChunks[chunkNum].swap(collections);
+}
+
+void PhraseTableCreator::FlushStreamedChunks(bool force)
+{
+  // Same source phrase ranges as FlushEncodedQueue, but a range is only
+  // saved once the next source phrase arrives, so the last one is never empty
+  std::map<size_t, std::vector<SrcTrgString> >::iterator chunk;
+  while((chunk = m_streamedChunks.find(m_nextStreamedChunk)) != m_streamedChunks.end()) {
+    std::vector<SrcTrgString>& collections = chunk->second;
+    for(size_t i = 0; i < collections.size(); i++) {
+      if(m_lastSourceRange.size() == (1ul << m_orderBits)) {
+        m_srcHash.AddRange(m_lastSourceRange);
+        m_srcHash.SaveLastRange();
+        m_srcHash.DropLastRange();
+        m_lastSourceRange.clear();
+      }
+
+      m_lastSourceRange.push_back(MakeSourceKey(collections[i].first));
+      m_compressedTargetPhrases->push_back(collections[i].second);
+
+      m_lastFlushedSourceNum++;
+      if(m_lastFlushedSourceNum % 100000 == 0)
+        std::cerr << ".";
+      if(m_lastFlushedSourceNum % 5000000 == 0)
+        std::cerr << "[" << m_lastFlushedSourceNum << "]" << std::endl;
+    }
+    m_streamedChunks.erase(chunk);
+    m_nextStreamedChunk++;
+  }
+
+  if(force) {
+    if(!m_lastSourceRange.empty()) {
+      m_srcHash.AddRange(m_lastSourceRange);
+      m_lastSourceRange.clear();
+    }
+
+#ifdef WITH_THREADS
+    m_srcHash.WaitAll();
+#endif
+
+    m_srcHash.SaveLastRange();
+    m_srcHash.DropLastRange();
+    m_srcHash.FinalizeSave();
+
+    m_lastFlushedSourceNum = 0;
+
+    std::cerr << std::endl << std::endl;
+  }
+}
+
 //****************************************************************************//
 
 size_t RankingTask::m_lineNum = 0;
@@ -1146,42 +1357,24 @@ void EncodingTask::operator()()
   std::vector<PackedItem> result;
   result.reserve(max_lines);
 
+  PhraseTableCreator::EncodingContext context(true, m_creator.m_scoreCounters.size());
+  std::vector<std::string> tokens;
+
   while(lines.size()) {
     for(size_t i = 0; i < lines.size(); i++) {
-      std::vector<std::string> tokens;
-      Moses::TokenizeMultiCharSeparator(tokens, lines[i], m_creator.m_separator);
-
-      for(std::vector<std::string>::iterator it = tokens.begin(); it != tokens.end(); it++)
-        *it = Moses::Trim(*it);
-
-      if(tokens.size() < 3) {
-        std::stringstream strme;
-        strme << "Error: It seems the following line has a wrong format:" << std::endl;
-        strme << "Line " << i << ": " << lines[i] << std::endl;
-        UTIL_THROW2(strme.str());
-      }
-
-      if(tokens.size() > 3 && tokens[3].size() <= 1 && m_creator.m_coding != PhraseTableCreator::None) {
-        std::stringstream strme;
-        strme << "Error: It seems the following line contains no alignment information, " << std::endl;
-        strme << "but you are using ";
-        strme << (m_creator.m_coding == PhraseTableCreator::PREnc ? "PREnc" : "REnc");
-        strme << " encoding which makes use of alignment data. " << std::endl;
-        strme << "Use -encoding None" << std::endl;
-        strme << "Line " << i << ": " << lines[i] << std::endl;
-        UTIL_THROW2(strme.str());
-      }
+      m_creator.SplitLine(lines[i], tokens);
 
       size_t ownRank = 0;
       if(m_creator.m_coding == PhraseTableCreator::PREnc)
         ownRank = m_creator.m_ranks[lineNum + i];
 
-      std::string encodedLine = m_creator.EncodeLine(tokens, ownRank);
+      std::string encodedLine = m_creator.EncodeLine(tokens, ownRank, context);
 
       PackedItem packedItem(lineNum + i, tokens[0], encodedLine, ownRank);
       result.push_back(packedItem);
     }
     lines.clear();
+    m_creator.MergeCounts(context);
 
     {
 #ifdef WITH_THREADS
@@ -1209,6 +1402,137 @@ void EncodingTask::operator()()
 
 //****************************************************************************//
 
+ChunkReader::ChunkReader(InputFileStream& inFile, size_t maxLines,
+                         size_t maxAhead)
+  : m_inFile(inFile), m_maxLines(maxLines), m_maxAhead(maxAhead),
+    m_chunkNum(0), m_nextUnreleased(0), m_lineNum(0), m_haveNextLine(false) {}
+
+bool ChunkReader::Next(std::vector<std::string>& lines, size_t& chunkNum,
+                       size_t& lineNum)
+{
+  lines.clear();
+
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+  while(m_maxAhead && m_chunkNum >= m_nextUnreleased + m_maxAhead)
+    m_released.wait(lock);
+#endif
+  // The first line of this chunk may have been read with the last one
+  if(m_haveNextLine) {
+    lines.push_back(m_nextLine);
+    m_haveNextLine = false;
+  }
+
+  std::string line, source;
+  while(std::getline(m_inFile, line)) {
+    source = Moses::Trim(line.substr(0, line.find(PhraseTableCreator::m_separator)));
+    if(lines.size() >= m_maxLines && source != m_lastSource) {
+      m_nextLine.swap(line);
+      m_haveNextLine = true;
+      m_lastSource.swap(source);
+      break;
+    }
+    lines.push_back(line);
+    m_lastSource.swap(source);
+  }
+
+  chunkNum = m_chunkNum;
+  lineNum = m_lineNum;
+  if(lines.empty())
+    return false;
+
+  m_chunkNum++;
+  m_lineNum += lines.size();
+  return true;
+}
+
+void ChunkReader::Release(size_t nextUnreleased)
+{
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+  m_nextUnreleased = nextUnreleased;
+  m_released.notify_all();
+#else
+  m_nextUnreleased = nextUnreleased;
+#endif
+}
+
+#ifdef WITH_THREADS
+boost::mutex StreamingTask::m_mutex;
+#endif
+
+StreamingTask::StreamingTask(ChunkReader& reader, PhraseTableCreator& creator,
+                             bool compress)
+  : m_reader(reader), m_creator(creator), m_compress(compress) {}
+
+void StreamingTask::operator()()
+{
+  PhraseTableCreator::EncodingContext context(!m_compress, m_creator.m_scoreCounters.size());
+
+  std::vector<std::string> lines;
+  std::vector<std::string> tokens;
+  std::vector<std::string> collection;
+  std::vector<PhraseTableCreator::SrcTrgString> result;
+  std::string source;
+
+  size_t chunkNum, lineNum;
+  while(m_reader.Next(lines, chunkNum, lineNum)) {
+    for(size_t i = 0; i < lines.size(); i++) {
+      m_creator.SplitLine(lines[i], tokens);
+
+      size_t ownRank = 0;
+      if(m_creator.m_coding == PhraseTableCreator::PREnc)
+        ownRank = m_creator.m_ranks[lineNum + i];
+
+      std::string encodedLine = m_creator.EncodeLine(tokens, ownRank, context);
+      if(!m_compress)
+        continue;
+
+      if(tokens[0] != source && collection.size())
+        AddCollection(source, collection, result);
+      source = tokens[0];
+
+      if(m_creator.m_coding == PhraseTableCreator::PREnc) {
+        if(collection.size() <= ownRank)
+          collection.resize(ownRank + 1);
+        collection[ownRank].swap(encodedLine);
+      } else {
+        collection.push_back(encodedLine);
+      }
+    }
+
+    if(!m_compress) {
+      m_creator.MergeCounts(context);
+      continue;
+    }
+
+    // Chunks end with a complete collection
+    AddCollection(source, collection, result);
+
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    m_creator.AddStreamedChunk(chunkNum, result);
+    m_creator.FlushStreamedChunks();
+    m_reader.Release(m_creator.m_nextStreamedChunk);
+    result.clear();
+  }
+}
+
+void StreamingTask::AddCollection(const std::string& source,
+                                  std::vector<std::string>& collection,
+                                  std::vector<PhraseTableCreator::SrcTrgString>& result)
+{
+  std::string encodedCollection;
+  for(std::vector<std::string>::iterator it = collection.begin();
+      it != collection.end(); it++)
+    encodedCollection += *it;
+  collection.clear();
+
+  result.push_back(PhraseTableCreator::SrcTrgString(source,
+                   m_creator.CompressEncodedCollection(encodedCollection)));
+}
+
 size_t CompressionTask::m_collectionNum = 0;
 #ifdef WITH_THREADS
 boost::mutex CompressionTask::m_mutex;
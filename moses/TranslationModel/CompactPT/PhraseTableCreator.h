@@ -27,6 +27,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <queue>
 #include <vector>
 #include <set>
+#include <map>
 #include <boost/unordered_map.hpp>
 
 #include "moses/InputFileStream.h"
@@ -96,6 +97,16 @@ public:
     m_freqMap[data] += num;
   }
 
+  //! add the counts of freqMap, e.g. collected by a single thread, and clear it
+  void Merge(FreqMap& freqMap) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    for(iterator it = freqMap.begin(); it != freqMap.end(); it++)
+      m_freqMap[it->first] += it->second;
+    freqMap.clear();
+  }
+
   mapped_type& operator[](DataType data) {
     return m_freqMap[data];
   }
@@ -198,6 +209,7 @@ private:
   bool m_multipleScoreTrees;
   size_t m_quantize;
   size_t m_maxRank;
+  bool m_streaming;
 
   static std::string m_phraseStopSymbol;
   static std::string m_separator;
@@ -272,6 +284,25 @@ private:
   std::priority_queue<std::pair<float, size_t> > m_rankQueue;
   std::vector<std::string> m_lastCollection;
 
+  // compressed collections of the streaming pass, by chunk number
+  std::map<size_t, std::vector<SrcTrgString> > m_streamedChunks;
+  size_t m_nextStreamedChunk;
+
+  /** State of one encoding thread. Symbols, scores and alignment points are
+   * counted here and merged into the counters above once per chunk, and
+   * target symbol ids are cached, so that threads rarely lock. */
+  struct EncodingContext {
+    bool count;
+    size_t maxPhraseLength;
+    SymbolCounter::FreqMap symbols;
+    std::vector<ScoreCounter::FreqMap> scores;
+    AlignCounter::FreqMap alignPoints;
+    boost::unordered_map<std::string, unsigned> targetSymbols;
+
+    EncodingContext(bool count_, size_t numScoreCounters)
+      : count(count_), maxPhraseLength(0), scores(numScoreCounters) {}
+  };
+
   void Save();
   void PrintInfo();
 
@@ -281,6 +312,7 @@ private:
   void AddTargetSymbolId(std::string& symbol);
   unsigned GetTargetSymbolId(std::string& symbol);
   unsigned GetOrAddTargetSymbolId(std::string& symbol);
+  unsigned GetOrAddTargetSymbolId(std::string& symbol, EncodingContext& context);
 
   unsigned GetRank(unsigned srcIdx, unsigned trgIdx);
 
@@ -292,20 +324,25 @@ private:
   unsigned EncodePREncSymbol2(int lOff, int rOff, unsigned rank);
 
   void EncodeTargetPhraseNone(std::vector<std::string>& t,
+                              EncodingContext& context,
                               std::ostream& os);
 
   void EncodeTargetPhraseREnc(std::vector<std::string>& s,
                               std::vector<std::string>& t,
                               std::set<AlignPoint>& a,
+                              EncodingContext& context,
                               std::ostream& os);
 
   void EncodeTargetPhrasePREnc(std::vector<std::string>& s,
                                std::vector<std::string>& t,
                                std::set<AlignPoint>& a, size_t ownRank,
+                               EncodingContext& context,
                                std::ostream& os);
 
-  void EncodeScores(std::vector<float>& scores, std::ostream& os);
-  void EncodeAlignment(std::set<AlignPoint>& alignment, std::ostream& os);
+  void EncodeScores(std::vector<float>& scores, EncodingContext& context,
+                    std::ostream& os);
+  void EncodeAlignment(std::set<AlignPoint>& alignment,
+                       EncodingContext& context, std::ostream& os);
 
   std::string MakeSourceKey(std::string&);
   std::string MakeSourceTargetKey(std::string&, std::string&);
@@ -315,12 +352,21 @@ private:
   void CreateRankHash();
   void EncodeTargetPhrases();
   void CalcHuffmanCodes();
+  void CalcSymbolCodes();
+  void CalcScoreCodes(size_t i);
+  void CalcAlignCodes();
   void CompressTargetPhrases();
 
+  void CountTargetPhrases();
+  void StreamTargetPhrases();
+
   void AddRankedLine(PackedItem& pi);
   void FlushRankedQueue(bool force = false);
 
-  std::string EncodeLine(std::vector<std::string>& tokens, size_t ownRank);
+  void SplitLine(std::string& line, std::vector<std::string>& tokens);
+  std::string EncodeLine(std::vector<std::string>& tokens, size_t ownRank,
+                         EncodingContext& context);
+  void MergeCounts(EncodingContext& context);
   void AddEncodedLine(PackedItem& pi);
   void FlushEncodedQueue(bool force = false);
 
@@ -328,6 +374,9 @@ private:
   void AddCompressedCollection(PackedItem& pi);
   void FlushCompressedQueue(bool force = false);
 
+  void AddStreamedChunk(size_t chunkNum, std::vector<SrcTrgString>& collections);
+  void FlushStreamedChunks(bool force = false);
+
 public:
 
   PhraseTableCreator(std::string inPath,
@@ -342,7 +391,8 @@ public:
                      bool multipleScoreTrees = true,
                      size_t quantize = 0,
                      size_t maxRank = 100,
-                     bool warnMe = true
+                     bool warnMe = true,
+                     bool streaming = false
 #ifdef WITH_THREADS
                                    , size_t threads = 2
 #endif
@@ -353,6 +403,8 @@ public:
   friend class RankingTask;
   friend class EncodingTask;
   friend class CompressionTask;
+  friend class ChunkReader;
+  friend class StreamingTask;
 };
 
 class RankingTask
@@ -390,6 +442,60 @@ public:
   void operator()();
 };
 
+/** Hands out the lines of the text phrase table in numbered chunks of at
+ * least maxLines lines that end with a complete target phrase collection,
+ * so that a chunk can be encoded and compressed on its own. With maxAhead,
+ * no chunk is handed out more than maxAhead chunks after the first one not
+ * yet released, which bounds the finished chunks waiting to be saved. */
+class ChunkReader
+{
+private:
+#ifdef WITH_THREADS
+  boost::mutex m_mutex;
+  boost::condition_variable m_released;
+#endif
+  InputFileStream& m_inFile;
+  size_t m_maxLines;
+  size_t m_maxAhead;
+  size_t m_chunkNum;
+  size_t m_nextUnreleased;
+  size_t m_lineNum;
+  std::string m_nextLine;
+  bool m_haveNextLine;
+  std::string m_lastSource;
+
+public:
+  ChunkReader(InputFileStream& inFile, size_t maxLines = 1000,
+              size_t maxAhead = 0);
+
+  //! false at the end of the file
+  bool Next(std::vector<std::string>& lines, size_t& chunkNum, size_t& lineNum);
+
+  //! all chunks before nextUnreleased are saved
+  void Release(size_t nextUnreleased);
+};
+
+/** Both passes of the streaming mode: counts the symbols of a chunk or
+ * encodes and compresses its target phrase collections. */
+class StreamingTask
+{
+private:
+#ifdef WITH_THREADS
+  static boost::mutex m_mutex;
+#endif
+  ChunkReader& m_reader;
+  PhraseTableCreator& m_creator;
+  bool m_compress;
+
+  void AddCollection(const std::string& source,
+                     std::vector<std::string>& collection,
+                     std::vector<PhraseTableCreator::SrcTrgString>& result);
+
+public:
+  StreamingTask(ChunkReader& reader, PhraseTableCreator& creator, bool compress);
+  void operator()();
+};
+
 class CompressionTask
 {
 private:
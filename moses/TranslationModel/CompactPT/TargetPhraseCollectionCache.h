@@ -22,12 +22,15 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_TargetPhraseCollectionCache_h
 #define moses_TargetPhraseCollectionCache_h
 
-#include <map>
-#include <set>
+#include <list>
 #include <vector>
 
-#include <boost/thread/tss.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
 
 #include "moses/Phrase.h"
 #include "moses/TargetPhraseCollection.h"
@@ -39,123 +42,77 @@ namespace Moses
 typedef std::vector<TargetPhrase> TargetPhraseVector;
 typedef boost::shared_ptr<TargetPhraseVector> TargetPhraseVectorPtr;
 
-/** Implementation of Persistent Cache **/
+/** Implementation of Persistent Cache.
+ *  One cache is shared by all decoding threads. It is split into shards by
+ *  the hash of the source phrase, each with its own lock and its own LRU
+ *  list, so eviction is LRU per shard and approximately LRU overall.
+ *  Memory is bounded by an estimate of the bytes held by the cached
+ *  target phrases rather than by the number of source phrases.
+ *  Cached vectors are never modified, only replaced or dropped, so callers
+ *  may keep reading a vector after it has been evicted.
+ **/
 class TargetPhraseCollectionCache
 {
-private:
-  size_t m_max;
-  float m_tolerance;
-
-  struct LastUsed {
-    clock_t m_clock;
-    TargetPhraseVectorPtr m_tpv;
-    size_t m_bitsLeft;
+public:
+  struct Stats {
+    size_t hits, misses, evictions;
+    size_t entries, bytes;
+  };
 
-    LastUsed() : m_clock(0), m_bitsLeft(0) {}
+  TargetPhraseCollectionCache(size_t maxBytes = 256 * 1024 * 1024);
 
-    LastUsed(clock_t clock, TargetPhraseVectorPtr tpv, size_t bitsLeft = 0)
-      : m_clock(clock), m_tpv(tpv), m_bitsLeft(bitsLeft) {}
-  };
+  /** store translations for source phrase in persistent cache **/
+  void Cache(const Phrase &sourcePhrase, TargetPhraseVectorPtr tpv,
+             size_t bitsLeft = 0, size_t maxRank = 0);
 
-  typedef std::map<Phrase, LastUsed> CacheMap;
-  static boost::thread_specific_ptr<CacheMap> m_phraseCache;
+  /** retrieve translations for source phrase from persistent cache **/
+  std::pair<TargetPhraseVectorPtr, size_t> Retrieve(const Phrase &sourcePhrase);
 
-public:
+  void CleanUp();
 
-  typedef CacheMap::iterator iterator;
-  typedef CacheMap::const_iterator const_iterator;
+  Stats GetStats() const;
 
-  TargetPhraseCollectionCache(size_t max = 5000, float tolerance = 0.2)
-    : m_max(max), m_tolerance(tolerance) {
+  size_t GetMaxBytes() const {
+    return m_maxBytes;
   }
 
-  iterator Begin() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->begin();
-  }
+private:
+  static const size_t NumShards = 64;
 
-  const_iterator Begin() const {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->begin();
-  }
+  struct Entry;
+  typedef std::list<Entry> LRUList;
+  typedef boost::unordered_map<Phrase, LRUList::iterator> EntryMap;
 
-  iterator End() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->end();
-  }
+  struct Entry {
+    const Phrase *m_source; // key in Shard::m_map
+    TargetPhraseVectorPtr m_tpv;
+    size_t m_bitsLeft;
+    size_t m_bytes;
+  };
 
-  const_iterator End() const {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->end();
-  }
+  struct Shard {
+#ifdef WITH_THREADS
+    mutable boost::mutex m_mutex;
+#endif
+    EntryMap m_map;
+    LRUList m_lru; // most recently used first
+    size_t m_bytes;
+    size_t m_hits, m_misses, m_evictions;
 
-  /** retrieve translations for source phrase from persistent cache **/
-  void Cache(const Phrase &sourcePhrase, TargetPhraseVectorPtr tpv,
-             size_t bitsLeft = 0, size_t maxRank = 0) {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    // check if source phrase is already in cache
-    iterator it = m_phraseCache->find(sourcePhrase);
-    if(it != m_phraseCache->end())
-      // if found, just update clock
-      it->second.m_clock = clock();
-    else {
-      // else, add to cache
-      if(maxRank && tpv->size() > maxRank) {
-        TargetPhraseVectorPtr tpv_temp(new TargetPhraseVector());
-        tpv_temp->resize(maxRank);
-        std::copy(tpv->begin(), tpv->begin() + maxRank, tpv_temp->begin());
-        (*m_phraseCache)[sourcePhrase] = LastUsed(clock(), tpv_temp, bitsLeft);
-      } else
-        (*m_phraseCache)[sourcePhrase] = LastUsed(clock(), tpv, bitsLeft);
-    }
-  }
+    Shard() : m_bytes(0), m_hits(0), m_misses(0), m_evictions(0) {}
+  };
 
-  std::pair<TargetPhraseVectorPtr, size_t> Retrieve(const Phrase &sourcePhrase) {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    iterator it = m_phraseCache->find(sourcePhrase);
-    if(it != m_phraseCache->end()) {
-      LastUsed &lu = it->second;
-      lu.m_clock = clock();
-      return std::make_pair(lu.m_tpv, lu.m_bitsLeft);
-    } else
-      return std::make_pair(TargetPhraseVectorPtr(), 0);
-  }
+  size_t m_maxBytes;
+  Shard m_shards[NumShards];
 
-  // if cache full, reduce
-  void Prune() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    if(m_phraseCache->size() > m_max * (1 + m_tolerance)) {
-      typedef std::set<std::pair<clock_t, Phrase> > Cands;
-      Cands cands;
-      for(CacheMap::iterator it = m_phraseCache->begin();
-          it != m_phraseCache->end(); it++) {
-        LastUsed &lu = it->second;
-        cands.insert(std::make_pair(lu.m_clock, it->first));
-      }
-
-      for(Cands::iterator it = cands.begin(); it != cands.end(); it++) {
-        const Phrase& p = it->second;
-        m_phraseCache->erase(p);
-
-        if(m_phraseCache->size() < (m_max * (1 - m_tolerance)))
-          break;
-      }
-    }
+  Shard &GetShard(const Phrase &sourcePhrase) {
+    return m_shards[hash_value(sourcePhrase) % NumShards];
   }
 
-  void CleanUp() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    m_phraseCache->clear();
-  }
+  // evict least recently used entries until shard is within its budget
+  void Reduce(Shard &shard);
 
+  static size_t EstimateBytes(const Phrase &sourcePhrase, const TargetPhraseVector &tpv);
 };
 
 }
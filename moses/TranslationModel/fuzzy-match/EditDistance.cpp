@@ -0,0 +1,203 @@
+//
+//  EditDistance.cpp
+//  fuzzy-match
+//
+
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+#include "EditDistance.h"
+
+using namespace std;
+
+namespace tmmt
+{
+
+namespace
+{
+
+typedef uint64_t Bits;
+const size_t BLOCK_SIZE = 64;
+
+/* one column of one block of 64 rows. hin is the difference between the
+ cells of this column and the previous one in the row above the block,
+ returns the same for the row given by outBit */
+inline int UpdateBlock( Bits &pv, Bits &mv, Bits eq, int hin, Bits outBit )
+{
+  Bits xv = eq | mv;
+  if (hin < 0)
+    eq |= 1;
+  Bits xh = (((eq & pv) + pv) ^ pv) | eq;
+  Bits ph = mv | ~(xh | pv);
+  Bits mh = pv & xh;
+
+  int hout = 0;
+  if (ph & outBit)
+    hout = 1;
+  else if (mh & outBit)
+    hout = -1;
+
+  ph <<= 1;
+  mh <<= 1;
+  if (hin < 0)
+    mh |= 1;
+  else if (hin > 0)
+    ph |= 1;
+
+  pv = mh | ~(xv | ph);
+  mv = ph & xv;
+  return hout;
+}
+
+/* a has length m, b length n. peq(j) returns the match masks of all blocks of
+ a for b[j], or NULL if b[j] does not occur in a */
+template <class Peq>
+unsigned int Distance( size_t m, size_t n, const Peq &peq, unsigned int maxCost )
+{
+  size_t diff = (m > n) ? m - n : n - m;
+  if (diff > maxCost)
+    return maxCost + 1;
+  if (m == 0 || n == 0)
+    return diff;
+
+  // the first row of the cost matrix counts up from 0, each column starts at the bottom row m
+  const size_t numBlocks = (m + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  const Bits lastBit = (Bits) 1 << ((m - 1) % BLOCK_SIZE);
+  const Bits highBit = (Bits) 1 << (BLOCK_SIZE - 1);
+  size_t score = m;
+
+  if (numBlocks == 1) {
+    Bits pv = ~(Bits) 0, mv = 0;
+    for (size_t j = 0; j < n; ++j) {
+      const Bits *eq = peq(j);
+      score += UpdateBlock(pv, mv, eq ? *eq : 0, 1, lastBit);
+
+      // each remaining column lowers the final distance by at most 1
+      if (score > (size_t) maxCost + (n - j - 1))
+        return maxCost + 1;
+    }
+    return score;
+  }
+
+  vector< Bits > pv(numBlocks, ~(Bits) 0), mv(numBlocks, 0);
+  for (size_t j = 0; j < n; ++j) {
+    const Bits *eq = peq(j);
+    int h = 1;
+    for (size_t block = 0; block < numBlocks; ++block) {
+      Bits outBit = (block + 1 == numBlocks) ? lastBit : highBit;
+      h = UpdateBlock(pv[block], mv[block], eq ? eq[block] : 0, h, outBit);
+    }
+    score += h;
+
+    if (score > (size_t) maxCost + (n - j - 1))
+      return maxCost + 1;
+  }
+  return score;
+}
+
+class WordPeq
+{
+public:
+  WordPeq( const WordEditDistancePattern &pattern, const vector< WORD_ID > &b )
+    : m_pattern(pattern)
+    , m_b(b) {
+  }
+
+  const Bits *operator()( size_t j ) const {
+    return m_pattern.GetMasks(m_b[j]);
+  }
+
+private:
+  const WordEditDistancePattern &m_pattern;
+  const vector< WORD_ID > &m_b;
+};
+
+class LetterPeq
+{
+public:
+  LetterPeq( const string &a, const string &b, Bits *masks )
+    : m_b(b)
+    , m_numBlocks((a.size() + BLOCK_SIZE - 1) / BLOCK_SIZE)
+    , m_masks(masks) {
+    memset(m_masks, 0, sizeof(Bits) * 256 * m_numBlocks);
+    for (size_t i = 0; i < a.size(); ++i) {
+      m_masks[(unsigned char) a[i] * m_numBlocks + i / BLOCK_SIZE] |= (Bits) 1 << (i % BLOCK_SIZE);
+    }
+  }
+
+  const Bits *operator()( size_t j ) const {
+    return m_masks + (unsigned char) m_b[j] * m_numBlocks;
+  }
+
+private:
+  const string &m_b;
+  size_t m_numBlocks;
+  Bits *m_masks;
+};
+
+}
+
+WordEditDistancePattern::WordEditDistancePattern( const vector< WORD_ID > &a )
+  : m_length(a.size())
+  , m_numBlocks((a.size() + BLOCK_SIZE - 1) / BLOCK_SIZE)
+{
+  // at most half full
+  size_t tableSize = 4;
+  while (tableSize < 2 * a.size())
+    tableSize *= 2;
+  m_table.resize(tableSize, make_pair((WORD_ID) 0, (size_t) 0));
+  m_tableMask = tableSize - 1;
+
+  size_t numWords = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    size_t slot = Slot(a[i]);
+    if (m_table[slot].second == 0) {
+      m_table[slot] = make_pair(a[i], ++numWords);
+      m_masks.resize(numWords * m_numBlocks, 0);
+    }
+    m_masks[(m_table[slot].second - 1) * m_numBlocks + i / BLOCK_SIZE] |= (Bits) 1 << (i % BLOCK_SIZE);
+  }
+}
+
+size_t WordEditDistancePattern::Slot( WORD_ID word ) const
+{
+  size_t slot = ((uint64_t) word * 0x9E3779B97F4A7C15ULL >> 32) & m_tableMask;
+  while (m_table[slot].second != 0 && m_table[slot].first != word)
+    slot = (slot + 1) & m_tableMask;
+  return slot;
+}
+
+const uint64_t *WordEditDistancePattern::GetMasks( WORD_ID word ) const
+{
+  const pair< WORD_ID, size_t > &entry = m_table[Slot(word)];
+  if (entry.second == 0)
+    return NULL;
+  return &m_masks[(entry.second - 1) * m_numBlocks];
+}
+
+unsigned int WordEditDistancePattern::Distance( const vector< WORD_ID > &b, unsigned int maxCost ) const
+{
+  WordPeq peq(*this, b);
+  return tmmt::Distance(m_length, b.size(), peq, maxCost);
+}
+
+unsigned int WordEditDistance( const vector< WORD_ID > &a, const vector< WORD_ID > &b, unsigned int maxCost )
+{
+  return WordEditDistancePattern(a).Distance(b, maxCost);
+}
+
+unsigned int LetterEditDistance( const string &a, const string &b, unsigned int maxCost )
+{
+  // nearly all words fit into one block, keep their masks on the stack
+  if (a.size() <= BLOCK_SIZE) {
+    Bits masks[256];
+    LetterPeq peq(a, b, masks);
+    return Distance(a.size(), b.size(), peq, maxCost);
+  }
+
+  vector< Bits > masks(256 * ((a.size() + BLOCK_SIZE - 1) / BLOCK_SIZE));
+  LetterPeq peq(a, b, &masks[0]);
+  return Distance(a.size(), b.size(), peq, maxCost);
+}
+
+}
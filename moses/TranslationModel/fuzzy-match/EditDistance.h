@@ -0,0 +1,57 @@
+//
+//  EditDistance.h
+//  fuzzy-match
+//
+
+#ifndef fuzzy_match_EditDistance_h
+#define fuzzy_match_EditDistance_h
+
+#include <climits>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Vocabulary.h"
+
+namespace tmmt
+{
+
+/* Levenshtein distance with the bit-parallel algorithm of Myers (1999), in
+ Hyyro's (2003) formulation: 64 positions of a are updated at once for each
+ position of b, so the cost is O(n * m/64) instead of O(n * m).
+ Once the distance is known to be larger than maxCost, the computation stops
+ and a value > maxCost is returned. Otherwise the exact distance is returned. */
+
+unsigned int WordEditDistance( const std::vector< WORD_ID > &a, const std::vector< WORD_ID > &b, unsigned int maxCost = UINT_MAX );
+
+/* the same, with the bit masks of a computed once, for comparing one input
+ sentence with many translation memory sentences */
+
+class WordEditDistancePattern
+{
+public:
+  explicit WordEditDistancePattern( const std::vector< WORD_ID > &a );
+
+  unsigned int Distance( const std::vector< WORD_ID > &b, unsigned int maxCost = UINT_MAX ) const;
+
+  //! match masks of word in all blocks of a, NULL if a does not contain it
+  const uint64_t *GetMasks( WORD_ID word ) const;
+
+private:
+  size_t m_length, m_numBlocks;
+  // open addressing table of the distinct words of a, mapping to the
+  // position of their masks + 1, so that 0 marks an empty slot
+  std::vector< std::pair< WORD_ID, size_t > > m_table;
+  size_t m_tableMask;
+  std::vector< uint64_t > m_masks;
+
+  size_t Slot( WORD_ID word ) const;
+};
+
+/* same, for the letters (bytes) of two words */
+
+unsigned int LetterEditDistance( const std::string &a, const std::string &b, unsigned int maxCost = UINT_MAX );
+
+}
+
+#endif
@@ -0,0 +1,137 @@
+//
+//  EditDistanceTest.cpp
+//  fuzzy-match
+//
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "EditDistance.h"
+
+using namespace tmmt;
+using namespace std;
+
+namespace
+{
+
+//! the textbook dynamic program, for comparison
+template <class Seq>
+unsigned int ReferenceDistance(const Seq &a, const Seq &b)
+{
+  vector<unsigned int> row(b.size() + 1);
+  for (size_t j = 0; j <= b.size(); ++j) {
+    row[j] = j;
+  }
+  for (size_t i = 1; i <= a.size(); ++i) {
+    unsigned int diagonal = row[0];
+    row[0] = i;
+    for (size_t j = 1; j <= b.size(); ++j) {
+      unsigned int above = row[j];
+      row[j] = min(min(row[j] + 1, row[j - 1] + 1),
+                   diagonal + (a[i - 1] == b[j - 1] ? 0 : 1));
+      diagonal = above;
+    }
+  }
+  return row[b.size()];
+}
+
+//! a deterministic sequence of words from a small vocabulary
+vector<WORD_ID> Sentence(size_t length, unsigned int seed, WORD_ID vocabSize)
+{
+  vector<WORD_ID> ret;
+  for (size_t i = 0; i < length; ++i) {
+    seed = seed * 1103515245 + 12345;
+    ret.push_back((seed >> 16) % vocabSize);
+  }
+  return ret;
+}
+
+string Letters(const vector<WORD_ID> &words)
+{
+  string ret;
+  for (size_t i = 0; i < words.size(); ++i) {
+    ret += (char) ('a' + words[i]);
+  }
+  return ret;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(fuzzy_match_edit_distance)
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+  vector<WORD_ID> empty, three = Sentence(3, 1, 10);
+  BOOST_CHECK_EQUAL(WordEditDistance(empty, empty), 0);
+  BOOST_CHECK_EQUAL(WordEditDistance(empty, three), 3);
+  BOOST_CHECK_EQUAL(WordEditDistance(three, empty), 3);
+  BOOST_CHECK_EQUAL(WordEditDistancePattern(empty).Distance(three), 3);
+
+  BOOST_CHECK_EQUAL(LetterEditDistance("", ""), 0);
+  BOOST_CHECK_EQUAL(LetterEditDistance("", "abc"), 3);
+  BOOST_CHECK_EQUAL(LetterEditDistance("abc", ""), 3);
+}
+
+BOOST_AUTO_TEST_CASE(equal)
+{
+  for (size_t length = 1; length <= 200; length += 33) {
+    vector<WORD_ID> a = Sentence(length, length, 50);
+    BOOST_CHECK_EQUAL(WordEditDistance(a, a), 0);
+    BOOST_CHECK_EQUAL(WordEditDistance(a, a, 0), 0);
+    BOOST_CHECK_EQUAL(LetterEditDistance(Letters(a), Letters(a), 0), 0);
+  }
+  BOOST_CHECK_EQUAL(LetterEditDistance("kitten", "sitting"), 3);
+}
+
+BOOST_AUTO_TEST_CASE(cutoff)
+{
+  vector<WORD_ID> a = Sentence(20, 1, 5), b = Sentence(25, 2, 5);
+  unsigned int distance = ReferenceDistance(a, b);
+  BOOST_REQUIRE(distance >= 5);
+
+  // exact up to maxCost, and some value above it beyond
+  BOOST_CHECK_EQUAL(WordEditDistance(a, b, distance), distance);
+  BOOST_CHECK_EQUAL(WordEditDistance(a, b, distance + 1), distance);
+  BOOST_CHECK_GT(WordEditDistance(a, b, distance - 1), distance - 1);
+  BOOST_CHECK_GT(WordEditDistance(a, b, 0), 0);
+
+  // the difference in length is enough to stop
+  BOOST_CHECK_GT(WordEditDistance(a, b, 4), 4);
+  BOOST_CHECK_GT(LetterEditDistance("ab", "abcdef", 3), 3);
+  BOOST_CHECK_EQUAL(LetterEditDistance("ab", "abcdef", 4), 4);
+}
+
+BOOST_AUTO_TEST_CASE(long_sentences)
+{
+  // lengths around the 64 positions of a block, and several blocks
+  const size_t lengths[] = { 1, 63, 64, 65, 127, 128, 129, 300 };
+  const size_t numLengths = sizeof(lengths) / sizeof(lengths[0]);
+  for (size_t i = 0; i < numLengths; ++i) {
+    for (size_t j = 0; j < numLengths; ++j) {
+      vector<WORD_ID> a = Sentence(lengths[i], i, 8), b = Sentence(lengths[j], 100 + j, 8);
+      unsigned int distance = ReferenceDistance(a, b);
+      BOOST_CHECK_EQUAL(WordEditDistance(a, b), distance);
+      BOOST_CHECK_EQUAL(WordEditDistancePattern(a).Distance(b), distance);
+      BOOST_CHECK_EQUAL(LetterEditDistance(Letters(a), Letters(b)), distance);
+      BOOST_CHECK_EQUAL(WordEditDistance(a, b, distance), distance);
+      if (distance > 0) {
+        BOOST_CHECK_GT(WordEditDistance(a, b, distance - 1), distance - 1);
+        BOOST_CHECK_GT(LetterEditDistance(Letters(a), Letters(b), distance - 1), distance - 1);
+      }
+    }
+  }
+
+  // a few edits in a long sentence
+  vector<WORD_ID> a = Sentence(150, 7, 1000), b = a;
+  b.erase(b.begin() + 10);
+  b[70] = 1000;
+  b.insert(b.begin() + 140, 1001);
+  BOOST_CHECK_EQUAL(WordEditDistance(a, b), 3);
+  BOOST_CHECK_EQUAL(WordEditDistance(a, b, 3), 3);
+  BOOST_CHECK_GT(WordEditDistance(a, b, 2), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
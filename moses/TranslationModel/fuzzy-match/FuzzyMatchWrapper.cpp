@@ -11,8 +11,8 @@
 #include "SentenceAlignment.h"
 #include "Match.h"
 #include "create_xml.h"
+#include "EditDistance.h"
 #include "moses/Util.h"
-#include "moses/StaticData.h"
 #include "util/file.hh"
 
 using namespace std;
@@ -49,64 +49,59 @@ FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::s
   cerr << "loading completed" << endl;
 }
 
-string FuzzyMatchWrapper::Extract(long translationId, const string &dirNameStr)
+void FuzzyMatchWrapper::Extract(long translationId, const string &inputStr, vector<FuzzyMatchRule> &rules)
 {
-  const Moses::StaticData &staticData = Moses::StaticData::Instance();
-
   WordIndex wordIndex;
 
-  string fuzzyMatchFile = ExtractTM(wordIndex, translationId, dirNameStr);
-
-  // create extrac files
-  create_xml(fuzzyMatchFile);
-
-  // create phrase table with usual Moses scoring and consolidate programs
-  string cmd;
-  cmd = "LC_ALL=C sort " + fuzzyMatchFile + ".extract | gzip -c > "
-        + fuzzyMatchFile + ".extract.sorted.gz";
-  system(cmd.c_str());
-  cmd = "LC_ALL=C sort " + fuzzyMatchFile + ".extract.inv | gzip -c > "
-        + fuzzyMatchFile + ".extract.inv.sorted.gz";
-  system(cmd.c_str());
+  vector<WORD_ID> input = GetVocabulary().Tokenize(inputStr.c_str());
 
-#ifdef IS_XCODE
-  cmd = "/Users/hieuhoang/unison/workspace/github/moses-smt/bin";
-#elif IS_ECLIPSE
-  cmd = "/home/hieu/workspace/github/moses-smt/bin";
-#else
-  cmd = staticData.GetBinDirectory();
-#endif
+  vector<ExtractedRule> extracted;
+  ExtractTM(wordIndex, translationId, input, extracted);
 
-  cmd += string("/../scripts/training/train-model.perl -dont-zip -first-step 6 -last-step 6 -f en -e fr -hierarchical ")
-         + " -extract-file " + fuzzyMatchFile + ".extract -lexical-file - -score-options \"--NoLex\" "
-         + " -phrase-translation-table " + fuzzyMatchFile + ".pt";
-  system(cmd.c_str());
+  // score as train-model.perl -hierarchical -score-options --NoLex would
+  map<string, float> countF, countE;
+  map<pair<string, string>, map<string, float> > countEF;
+  for (size_t i = 0; i < extracted.size(); ++i) {
+    const ExtractedRule &rule = extracted[i];
+    countF[rule.source] += rule.count;
+    countE[rule.target] += rule.count;
+    countEF[make_pair(rule.source, rule.target)][rule.alignment] += rule.count;
+  }
 
+  typedef map<pair<string, string>, map<string, float> >::const_iterator PairIter;
+  for (PairIter iter = countEF.begin(); iter != countEF.end(); ++iter) {
+    FuzzyMatchRule rule;
+    rule.source = iter->first.first;
+    rule.target = iter->first.second;
+
+    // most frequent alignment
+    float pairCount = 0, bestAlignmentCount = -1;
+    map<string, float>::const_iterator align;
+    for (align = iter->second.begin(); align != iter->second.end(); ++align) {
+      pairCount += align->second;
+      if (align->second > bestAlignmentCount) {
+        bestAlignmentCount = align->second;
+        rule.alignment = align->first;
+      }
+    }
 
-  return fuzzyMatchFile + ".pt.gz";
+    rule.scores.push_back(pairCount / countE[rule.target]);
+    rule.scores.push_back(pairCount / countF[rule.source]);
+    rules.push_back(rule);
+  }
 }
 
-string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, const string &dirNameStr)
+void FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, const vector<WORD_ID> &input, vector<ExtractedRule> &rules)
 {
   const std::vector< std::vector< WORD_ID > > &source = suffixArray->GetCorpus();
 
-  string inputPath = dirNameStr + "/in";
-  string fuzzyMatchFile = dirNameStr + "/fuzzyMatchFile";
-  ofstream fuzzyMatchStream(fuzzyMatchFile.c_str());
-
-  vector< vector< WORD_ID > > input;
-  load_corpus(inputPath, input);
-
-  assert(input.size() == 1);
-  size_t sentenceInd = 0;
-
   clock_t start_clock = clock();
   // if (i % 10 == 0) cerr << ".";
 
   // establish some basic statistics
 
   // int input_length = compute_length( input[i] );
-  int input_length = input[sentenceInd].size();
+  int input_length = input.size();
   int best_cost = input_length * (100-min_match) / 100 + 1;
 
   int match_count = 0; // how many substring matches to be considered
@@ -114,15 +109,15 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
 
   // find match ranges in suffix array
   vector< vector< pair< SuffixArray::INDEX, SuffixArray::INDEX > > > match_range;
-  for(int start=0; start<input[sentenceInd].size(); start++) {
+  for(int start=0; start<input.size(); start++) {
     SuffixArray::INDEX prior_first_match = 0;
     SuffixArray::INDEX prior_last_match = suffixArray->GetSize()-1;
     vector< string > substring;
     bool stillMatched = true;
     vector< pair< SuffixArray::INDEX, SuffixArray::INDEX > > matchedAtThisStart;
     //cerr << "start: " << start;
-    for(size_t word=start; stillMatched && word<input[sentenceInd].size(); word++) {
-      substring.push_back( GetVocabulary().GetWord( input[sentenceInd][word] ) );
+    for(size_t word=start; stillMatched && word<input.size(); word++) {
+      substring.push_back( GetVocabulary().GetWord( input[word] ) );
 
       // only look up, if needed (i.e. no unnecessary short gram lookups)
       //				if (! word-start+1 <= short_match_max_length( input_length ) )
@@ -149,14 +144,14 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
   map< int, int > sentence_match_word_count;
 
   // go through all matches, longest first
-  for(int length = input[sentenceInd].size(); length >= 1; length--) {
+  for(int length = input.size(); length >= 1; length--) {
     // do not create matches, if these are handled by the short match function
     if (length <= short_match_max_length( input_length ) ) {
       continue;
     }
 
     unsigned int count = 0;
-    for(int start = 0; start <= input[sentenceInd].size() - length; start++) {
+    for(int start = 0; start <= input.size() - length; start++) {
       if (match_range[start].size() >= length) {
         pair< SuffixArray::INDEX, SuffixArray::INDEX > &range = match_range[start][length-1];
         // cerr << " (" << range.first << "," << range.second << ")";
@@ -244,11 +239,13 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
   int tm_count_word_match2 = 0;
   int pruned_match_count = 0;
   if (short_match_max_length( input_length )) {
-    init_short_matches(wordIndex, translationId, input[sentenceInd] );
+    init_short_matches(wordIndex, translationId, input );
   }
   vector< int > best_tm;
   typedef map< int, vector< Match > >::iterator I;
 
+  WordEditDistancePattern inputPattern( input );
+
   clock_t clock_validation_sum = 0;
 
   for(I tm=sentence_match.begin(); tm!=sentence_match.end(); tm++) {
@@ -289,8 +286,8 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     clock_t clock_validation_start = clock();
     if (! parse_flag ||
         pruned.size()>=10) { // to prevent worst cases
-      string path;
-      cost = sed( input[sentenceInd], source[tmID], path, false );
+      // only the cost is needed here, and only if it is not worse than the best
+      cost = inputPattern.Distance( source[tmID], best_cost );
       if (cost <  best_cost) {
         best_cost = cost;
       }
@@ -318,7 +315,7 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
   // create xml and extract files
   string inputStr, sourceStr;
   for (size_t pos = 0; pos < input_length; ++pos) {
-    inputStr += GetVocabulary().GetWord(input[sentenceInd][pos]) + " ";
+    inputStr += GetVocabulary().GetWord(input[pos]) + " ";
   }
 
   // do not try to find the best ... report multiple matches
@@ -326,10 +323,10 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     for(size_t si=0; si<best_tm.size(); si++) {
       int s = best_tm[si];
       string path;
-      sed( input[sentenceInd], source[s], path, true );
+      sed( input, source[s], path, true );
       const vector<WORD_ID> &sourceSentence = source[s];
       vector<SentenceAlignment> &targets = targetAndAlignment[s];
-      create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, path, fuzzyMatchStream);
+      create_extract(best_cost, sourceSentence, targets, inputStr, path, rules);
 
     }
   } // if (multiple_flag)
@@ -340,11 +337,11 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     int best_match = -1;
     unsigned int best_letter_cost;
     if (lsed_flag) {
-      best_letter_cost = compute_length( input[sentenceInd] ) * min_match / 100 + 1;
+      best_letter_cost = compute_length( input ) * min_match / 100 + 1;
       for(size_t si=0; si<best_tm.size(); si++) {
         int s = best_tm[si];
         string path;
-        unsigned int letter_cost = sed( input[sentenceInd], source[s], path, true );
+        unsigned int letter_cost = sed( input, source[s], path, true );
         if (letter_cost < best_letter_cost) {
           best_letter_cost = letter_cost;
           best_path = path;
@@ -356,7 +353,7 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     else {
       if (best_tm.size() > 0) {
         string path;
-        sed( input[sentenceInd], source[best_tm[0]], path, false );
+        sed( input, source[best_tm[0]], path, false );
         best_path = path;
         best_match = best_tm[0];
       }
@@ -368,7 +365,7 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
          << " (validation: " << (1000 * (clock_validation_sum) / CLOCKS_PER_SEC) << ")"
          << " )" << endl;
     if (lsed_flag) {
-      //cout << best_letter_cost << "/" << compute_length( input[sentenceInd] ) << " (";
+      //cout << best_letter_cost << "/" << compute_length( input ) << " (";
     }
     //cout << best_cost <<"/" << input_length;
     if (lsed_flag) {
@@ -384,32 +381,9 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     // creat xml & extracts
     const vector<WORD_ID> &sourceSentence = source[best_match];
     vector<SentenceAlignment> &targets = targetAndAlignment[best_match];
-    create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, best_path, fuzzyMatchStream);
+    create_extract(best_cost, sourceSentence, targets, inputStr, best_path, rules);
 
   } // else if (multiple_flag)
-
-  fuzzyMatchStream.close();
-
-  return fuzzyMatchFile;
-}
-
-void FuzzyMatchWrapper::load_corpus( const std::string &fileName, vector< vector< WORD_ID > > &corpus )
-{
-  // source
-  ifstream fileStream;
-  fileStream.open(fileName.c_str());
-  if (!fileStream) {
-    cerr << "file not found: " << fileName << endl;
-    exit(1);
-  }
-  cerr << "loading " << fileName << endl;
-
-  istream *fileStreamP = &fileStream;
-
-  string line;
-  while(getline(*fileStreamP, line)) {
-    corpus.push_back( GetVocabulary().Tokenize( line.c_str() ) );
-  }
 }
 
 void FuzzyMatchWrapper::load_target(const std::string &fileName, vector< vector< SentenceAlignment > > &corpus)
@@ -511,80 +485,11 @@ void FuzzyMatchWrapper::load_alignment(const std::string &fileName, vector< vect
   }
 }
 
-bool FuzzyMatchWrapper::GetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, unsigned int &value) const
-{
-#ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-#endif
-  map< pair< WORD_ID, WORD_ID >, unsigned int >::const_iterator lookup = m_lsed.find( key );
-  if (lookup != m_lsed.end()) {
-    value = lookup->second;
-    return true;
-  }
-
-  return false;
-}
-
-void FuzzyMatchWrapper::SetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, const unsigned int &value)
-{
-#ifdef WITH_THREADS
-  boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
-#endif
-  m_lsed[ key ] = value;
-}
-
 /* Letter string edit distance, e.g. sub 'their' to 'there' costs 2 */
 
 unsigned int FuzzyMatchWrapper::letter_sed( WORD_ID aIdx, WORD_ID bIdx )
 {
-  // check if already computed -> lookup in cache
-  pair< WORD_ID, WORD_ID > pIdx = make_pair( aIdx, bIdx );
-  unsigned int value;
-  bool ret = GetLSEDCache(pIdx, value);
-  if (ret) {
-    return value;
-  }
-
-  // get surface strings for word indices
-  const string &a = GetVocabulary().GetWord( aIdx );
-  const string &b = GetVocabulary().GetWord( bIdx );
-
-  // initialize cost matrix
-  unsigned int **cost  = (unsigned int**) calloc( sizeof( unsigned int*  ), a.size()+1 );
-  for( unsigned int i=0; i<=a.size(); i++ ) {
-    cost[i] = (unsigned int*) calloc( sizeof(unsigned int), b.size()+1 );
-    cost[i][0] = i;
-  }
-  for( unsigned int j=0; j<=b.size(); j++ ) {
-    cost[0][j] = j;
-  }
-
-  // core string edit distance loop
-  for( unsigned int i=1; i<=a.size(); i++ ) {
-    for( unsigned int j=1; j<=b.size(); j++ ) {
-
-      unsigned int ins = cost[i-1][j] + 1;
-      unsigned int del = cost[i][j-1] + 1;
-      bool match = (a.substr(i-1,1).compare( b.substr(j-1,1) ) == 0);
-      unsigned int diag = cost[i-1][j-1] + (match ? 0 : 1);
-
-      unsigned int min = (ins < del) ? ins : del;
-      min = (diag < min) ? diag : min;
-
-      cost[i][j] = min;
-    }
-  }
-
-  // clear out memory
-  unsigned int final = cost[a.size()][b.size()];
-  for( unsigned int i=0; i<=a.size(); i++ ) {
-    free( cost[i] );
-  }
-  free( cost );
-
-  // cache and return result
-  SetLSEDCache(pIdx, final);
-  return final;
+  return LetterEditDistance( GetVocabulary().GetWord( aIdx ), GetVocabulary().GetWord( bIdx ) );
 }
 
 /* string edit distance implementation */
@@ -1000,7 +905,7 @@ int FuzzyMatchWrapper::parse_matches( vector< Match > &match, int input_length,
 }
 
 
-void FuzzyMatchWrapper::create_extract(int sentenceInd, int cost, const vector< WORD_ID > &sourceSentence, const vector<SentenceAlignment> &targets, const string &inputStr, const string  &path, ofstream &outputFile)
+void FuzzyMatchWrapper::create_extract(int cost, const vector< WORD_ID > &sourceSentence, const vector<SentenceAlignment> &targets, const string &inputStr, const string  &path, vector<ExtractedRule> &rules)
 {
   string sourceStr;
   for (size_t pos = 0; pos < sourceSentence.size(); ++pos) {
@@ -1013,16 +918,14 @@ void FuzzyMatchWrapper::create_extract(int sentenceInd, int cost, const vector<
     string targetStr = sentenceAlignment.getTargetString(GetVocabulary());
     string alignStr = sentenceAlignment.getAlignmentString();
 
-    outputFile
-        << sentenceInd << endl
-        << cost << endl
-        << sourceStr << endl
-        << inputStr << endl
-        << targetStr << endl
-        << alignStr << endl
-        << path << endl
-        << sentenceAlignment.count << endl;
+    CreateXMLRetValues ret = createXML(rules.size() + 1, sourceStr, inputStr, targetStr, alignStr, path + "X");
 
+    ExtractedRule rule;
+    rule.source = ret.ruleS + " [X]";
+    rule.target = ret.ruleT + " [X]";
+    rule.alignment = ret.ruleAlignment;
+    rule.count = sentenceAlignment.count;
+    rules.push_back(rule);
   }
 }
 
@@ -9,10 +9,6 @@
 #ifndef moses_FuzzyMatchWrapper_h
 #define moses_FuzzyMatchWrapper_h
 
-#ifdef WITH_THREADS
-#include <boost/thread/shared_mutex.hpp>
-#endif
-
 #include <fstream>
 #include <string>
 #include "SuffixArray.h"
@@ -25,14 +21,28 @@ namespace tmmt
 class Match;
 struct SentenceAlignment;
 
+/** hierarchical rule extracted from the best fuzzy matches of an input sentence,
+ * with the scores train-model.perl -hierarchical -score-options --NoLex gives it */
+struct FuzzyMatchRule {
+  std::string source, target; // including the [X] left hand side
+  std::string alignment;
+  std::vector<float> scores; // p(f|e), p(e|f)
+};
+
 class FuzzyMatchWrapper
 {
 public:
   FuzzyMatchWrapper(const std::string &source, const std::string &target, const std::string &alignment);
 
-  std::string Extract(long translationId, const std::string &dirNameStr);
+  //! match the input against the translation memory, and extract and score rules, in memory
+  void Extract(long translationId, const std::string &input, std::vector<FuzzyMatchRule> &rules);
 
 protected:
+  struct ExtractedRule {
+    std::string source, target, alignment;
+    int count;
+  };
+
   // tm-mt
   std::vector< std::vector< tmmt::SentenceAlignment > > targetAndAlignment;
   tmmt::SuffixArray *suffixArray;
@@ -48,14 +58,6 @@ protected:
 
   typedef std::map< WORD_ID,std::vector< int > > WordIndex;
 
-  // global cache for word pairs
-  std::map< std::pair< WORD_ID, WORD_ID >, unsigned int > m_lsed;
-#ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::shared_mutex m_accessLock;
-#endif
-
-  void load_corpus( const std::string &fileName, std::vector< std::vector< tmmt::WORD_ID > > &corpus );
   void load_target( const std::string &fileName, std::vector< std::vector< tmmt::SentenceAlignment > > &corpus);
   void load_alignment( const std::string &fileName, std::vector< std::vector< tmmt::SentenceAlignment > > &corpus );
 
@@ -74,16 +76,12 @@ protected:
   std::vector< Match > prune_matches( const std::vector< Match > &match, int best_cost );
   int parse_matches( std::vector< Match > &match, int input_length, int tm_length, int &best_cost );
 
-  void create_extract(int sentenceInd, int cost, const std::vector< WORD_ID > &sourceSentence, const std::vector<SentenceAlignment> &targets, const std::string &inputStr, const std::string  &path, std::ofstream &outputFile);
+  void create_extract(int cost, const std::vector< WORD_ID > &sourceSentence, const std::vector<SentenceAlignment> &targets, const std::string &inputStr, const std::string  &path, std::vector<ExtractedRule> &rules);
 
-  std::string ExtractTM(WordIndex &wordIndex, long translationId, const std::string &inputPath);
+  void ExtractTM(WordIndex &wordIndex, long translationId, const std::vector< WORD_ID > &input, std::vector<ExtractedRule> &rules);
   Vocabulary &GetVocabulary() {
     return suffixArray->GetVocabulary();
   }
-
-  bool GetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, unsigned int &value) const;
-  void SetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, const unsigned int &value);
-
 };
 
 }
@@ -18,6 +18,7 @@ namespace Moses
     size_t stack_diversity;  // minHypoStackDiversity;
     bool disable_discarding; 
     // Disable discarding of bad hypotheses from HypothesisStackNormal
+    bool arena; // allocate hypotheses from a per-sentence arena
     size_t max_phrase_length;
     size_t max_trans_opt_per_cov; 
     size_t max_partial_trans_opt;
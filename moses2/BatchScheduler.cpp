@@ -0,0 +1,329 @@
+/*
+ * BatchScheduler.cpp
+ *
+ */
+#ifdef __linux
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <sstream>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include "BatchScheduler.h"
+#include "TranslationTask.h"
+#include "System.h"
+#include "legacy/Util2.h"
+#include "util/usage.hh"
+
+using namespace std;
+
+namespace Moses2
+{
+
+namespace
+{
+size_t CountTokens(const std::string &line)
+{
+  size_t ret = 0;
+  bool inToken = false;
+  for (size_t i = 0; i < line.size(); ++i) {
+    bool isSpace = (line[i] == ' ' || line[i] == '\t');
+    if (!isSpace && !inToken) {
+      ++ret;
+    }
+    inToken = !isSpace;
+  }
+  return ret;
+}
+
+struct LongerFirst {
+  template<typename T>
+  bool operator()(const T &a, const T &b) const {
+    return a.length > b.length;
+  }
+};
+
+void OutputPercentiles(std::ostream &out, const char *name, std::vector<float> vec)
+{
+  std::sort(vec.begin(), vec.end());
+  out << "  " << name << " (s):"
+      << " p50=" << Percentile(vec, 0.5f)
+      << " p90=" << Percentile(vec, 0.9f)
+      << " p99=" << Percentile(vec, 0.99f)
+      << " max=" << (vec.empty() ? 0 : vec.back())
+      << endl;
+}
+}
+
+BatchScheduler::BatchScheduler(System &system, size_t numThreads, size_t window,
+                               int cpuAffinityOffset, int cpuAffinityIncr)
+  :m_system(system)
+  ,m_window(std::max<size_t>(window, 2))
+  ,m_cpuAffinityOffset(cpuAffinityOffset)
+  ,m_cpuAffinityIncr(cpuAffinityIncr)
+  ,m_stats(std::max<size_t>(numThreads, 1))
+  ,m_queued(0)
+  ,m_eof(false)
+  ,m_startTime(0)
+  ,m_endTime(0)
+{
+  m_queues.resize(m_stats.size());
+  for (size_t i = 0; i < m_queues.size(); ++i) {
+    m_queues[i] = new WorkQueue();
+    m_queues[i]->load = 0;
+  }
+}
+
+BatchScheduler::~BatchScheduler()
+{
+  BOOST_FOREACH(WorkQueue *queue, m_queues) {
+    delete queue;
+  }
+}
+
+void BatchScheduler::Run(std::istream &inStream)
+{
+  m_eof = false;
+  m_queued = 0;
+  BOOST_FOREACH(WorkerStats &stats, m_stats) {
+    stats.busyTime = 0;
+    stats.numTasks = stats.numSteals = 0;
+    stats.decodeTimes.clear();
+    stats.latencies.clear();
+  }
+
+  m_startTime = util::WallTime();
+  for (size_t i = 0; i < m_queues.size(); ++i) {
+    boost::thread *thread = m_threads.create_thread(
+                              boost::bind(&BatchScheduler::Execute, this, i));
+    SetAffinity(thread, i);
+  }
+
+  // fill the whole window, then top it up half a window at a time so that
+  // there are always enough sentences to sort and spread across the workers
+  const size_t chunk = m_window / 2;
+  long translationId = 0;
+  size_t numRead = ReadChunk(inStream, translationId, m_window);
+  while (numRead) {
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (m_queued + chunk > m_window) {
+        m_drained.wait(lock);
+      }
+    }
+    numRead = ReadChunk(inStream, translationId, chunk);
+  }
+
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_eof = true;
+  }
+  m_workAvailable.notify_all();
+  m_threads.join_all();
+
+  m_endTime = util::WallTime();
+}
+
+size_t BatchScheduler::ReadChunk(std::istream &inStream, long &translationId, size_t maxLines)
+{
+  std::vector<Item> items;
+  items.reserve(maxLines);
+
+  double now = util::WallTime();
+  string line;
+  while (items.size() < maxLines && getline(inStream, line)) {
+    Item item;
+    item.length = CountTokens(line);
+    item.submitTime = now;
+    item.task.reset(new TranslationTask(m_system, line, translationId));
+    items.push_back(item);
+    ++translationId;
+  }
+
+  size_t ret = items.size();
+  if (ret) {
+    Dispatch(items);
+  }
+  return (ret == maxLines) ? ret : 0;
+}
+
+void BatchScheduler::Dispatch(std::vector<Item> &items)
+{
+  // longest processing time first: each sentence goes to the currently
+  // least loaded queue, and each queue stays sorted longest-first
+  std::stable_sort(items.begin(), items.end(), LongerFirst());
+
+  std::vector<size_t> loads(m_queues.size());
+  for (size_t i = 0; i < m_queues.size(); ++i) {
+    boost::mutex::scoped_lock lock(m_queues[i]->mutex);
+    loads[i] = m_queues[i]->load;
+  }
+
+  BOOST_FOREACH(const Item &item, items) {
+    size_t ind = std::min_element(loads.begin(), loads.end()) - loads.begin();
+    loads[ind] += item.length + 1;
+
+    WorkQueue &queue = *m_queues[ind];
+    boost::mutex::scoped_lock lock(queue.mutex);
+    std::deque<Item>::iterator iter = std::upper_bound(queue.items.begin(),
+                                      queue.items.end(), item, LongerFirst());
+    queue.items.insert(iter, item);
+    queue.load += item.length + 1;
+    Counted(+1);
+  }
+
+  m_workAvailable.notify_all();
+}
+
+void BatchScheduler::Execute(size_t threadInd)
+{
+  WorkerStats &stats = m_stats[threadInd];
+  size_t node = Numa::GetThreadNode(threadInd);
+  if (m_system.numa && !Numa::RunOnNode(node)) {
+    cerr << "Couldn't run thread " << threadInd << " on NUMA node " << node << endl;
+  }
+
+  while (true) {
+    Item item;
+    if (Pop(threadInd, item) || Steal(threadInd, item)) {
+      m_drained.notify_one();
+
+      double start = util::WallTime();
+      item.task->Run();
+      double end = util::WallTime();
+
+      stats.busyTime += end - start;
+      ++stats.numTasks;
+      stats.decodeTimes.push_back(end - start);
+      stats.latencies.push_back(end - item.submitTime);
+      if (m_system.numa) {
+        m_system.numaStats.Add(node, end - start);
+      }
+      continue;
+    }
+
+    // m_queued > 0 means that some queue holds a sentence, so sleep
+    // until there is one, or until the input is done
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_queued == 0 && !m_eof) {
+      m_workAvailable.wait(lock);
+    }
+    if (m_queued == 0) {
+      break;
+    }
+  }
+}
+
+void BatchScheduler::Counted(int diff)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  m_queued += diff;
+}
+
+bool BatchScheduler::Pop(size_t threadInd, Item &item)
+{
+  WorkQueue &queue = *m_queues[threadInd];
+  boost::mutex::scoped_lock lock(queue.mutex);
+  if (queue.items.empty()) {
+    return false;
+  }
+  item = queue.items.front();
+  queue.items.pop_front();
+  queue.load -= item.length + 1;
+  Counted(-1);
+  return true;
+}
+
+bool BatchScheduler::Steal(size_t threadInd, Item &item)
+{
+  // take the longest waiting sentence of the busiest worker.
+  // This, not the shortest, is what shortens the tail of the batch
+  size_t victim = threadInd;
+  size_t maxLoad = 0;
+  for (size_t i = 0; i < m_queues.size(); ++i) {
+    if (i == threadInd) {
+      continue;
+    }
+    boost::mutex::scoped_lock lock(m_queues[i]->mutex);
+    if (m_queues[i]->load > maxLoad) {
+      maxLoad = m_queues[i]->load;
+      victim = i;
+    }
+  }
+
+  if (victim == threadInd) {
+    return false;
+  }
+
+  WorkQueue &queue = *m_queues[victim];
+  boost::mutex::scoped_lock lock(queue.mutex);
+  if (queue.items.empty()) {
+    return false;
+  }
+  item = queue.items.front();
+  queue.items.pop_front();
+  queue.load -= item.length + 1;
+  Counted(-1);
+
+  ++m_stats[threadInd].numSteals;
+  return true;
+}
+
+void BatchScheduler::SetAffinity(boost::thread *thread, size_t threadInd) const
+{
+#ifdef __linux
+  if (m_cpuAffinityOffset < 0 || m_system.numa) {
+    return;
+  }
+
+  size_t numCPU = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t cpuInd = (m_cpuAffinityOffset + threadInd * m_cpuAffinityIncr) % numCPU;
+
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpuInd, &cpuset);
+
+  int s = pthread_setaffinity_np(thread->native_handle(), sizeof(cpu_set_t), &cpuset);
+  if (s != 0) {
+    cerr << "pthread_setaffinity_np failed for thread " << threadInd << endl;
+  }
+#endif
+}
+
+void BatchScheduler::OutputStats(std::ostream &out) const
+{
+  double wallTime = m_endTime - m_startTime;
+
+  std::vector<float> decodeTimes, latencies;
+  double busyTime = 0;
+  size_t numTasks = 0, numSteals = 0;
+  BOOST_FOREACH(const WorkerStats &stats, m_stats) {
+    decodeTimes.insert(decodeTimes.end(), stats.decodeTimes.begin(), stats.decodeTimes.end());
+    latencies.insert(latencies.end(), stats.latencies.begin(), stats.latencies.end());
+    busyTime += stats.busyTime;
+    numTasks += stats.numTasks;
+    numSteals += stats.numSteals;
+  }
+
+  out << "Batch scheduler: " << numTasks << " sentences on "
+      << m_stats.size() << " threads, window=" << m_window
+      << ", wall time=" << wallTime << "s, steals=" << numSteals << endl;
+  OutputPercentiles(out, "decode time", decodeTimes);
+  OutputPercentiles(out, "latency", latencies);
+
+  out << "  utilisation: "
+      << (wallTime > 0 ? 100.0 * busyTime / (wallTime * m_stats.size()) : 0)
+      << "% (per thread:";
+  BOOST_FOREACH(const WorkerStats &stats, m_stats) {
+    out << " " << (wallTime > 0 ? (int) (100.0 * stats.busyTime / wallTime) : 0) << "%";
+  }
+  out << ")" << endl;
+
+  if (m_system.numa) {
+    m_system.numaStats.Output(out, wallTime);
+  }
+}
+
+}
+
@@ -0,0 +1,86 @@
+/*
+ * BatchScheduler.h
+ *
+ * Batch-mode scheduler which reads ahead a window of input sentences and
+ * dispatches them longest-first onto per-thread work-stealing queues.
+ * Output order is still guaranteed by System::bestCollector etc.
+ */
+#pragma once
+#include <iostream>
+#include <deque>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+namespace Moses2
+{
+class System;
+class Task;
+
+class BatchScheduler
+{
+public:
+  BatchScheduler(System &system, size_t numThreads, size_t window,
+                 int cpuAffinityOffset = -1, int cpuAffinityIncr = 1);
+  virtual ~BatchScheduler();
+
+  //! read and translate every line of inStream. Returns when all are done
+  void Run(std::istream &inStream);
+
+  //! tail-latency and utilisation summary of the last Run()
+  void OutputStats(std::ostream &out) const;
+
+protected:
+  struct Item {
+    boost::shared_ptr<Task> task;
+    size_t length;
+    double submitTime;
+  };
+
+  // one per worker. The owner pops from the front, which is kept sorted
+  // longest-first. Idle workers steal from the front of the most loaded queue
+  struct WorkQueue {
+    boost::mutex mutex;
+    std::deque<Item> items;
+    size_t load; // sum of Item::length
+  };
+
+  struct WorkerStats {
+    double busyTime;
+    size_t numTasks;
+    size_t numSteals;
+    std::vector<float> decodeTimes, latencies;
+  };
+
+  System &m_system;
+  size_t m_window;
+  int m_cpuAffinityOffset, m_cpuAffinityIncr;
+
+  std::vector<WorkQueue*> m_queues;
+  std::vector<WorkerStats> m_stats;
+  boost::thread_group m_threads;
+
+  // guards m_queued & m_eof. Used only to sleep/wake, not on the fast path.
+  // m_queued is the number of sentences in the queues. It changes together
+  // with them, under the mutex of the queue, which is locked first
+  boost::mutex m_mutex;
+  boost::condition_variable m_workAvailable;
+  boost::condition_variable m_drained;
+  size_t m_queued;
+  bool m_eof;
+
+  double m_startTime, m_endTime;
+
+  size_t ReadChunk(std::istream &inStream, long &translationId, size_t maxLines);
+  void Dispatch(std::vector<Item> &items);
+
+  void Execute(size_t threadInd);
+  bool Pop(size_t threadInd, Item &item);
+  bool Steal(size_t threadInd, Item &item);
+  void Counted(int diff);
+
+  void SetAffinity(boost::thread *thread, size_t threadInd) const;
+};
+
+}
+
@@ -46,6 +46,11 @@ public:
                                    const SCFG::Hypothesis &hypo, int featureID, Scores &scores,
                                    FFState &state) const;
 
+  //! scores are minus the jump distance
+  virtual SCORE GetWhenAppliedUpperBound(const System &system) const {
+    return NonPositiveScoresBound(system);
+  }
+
 protected:
   SCORE CalculateDistortionScore(const Range &prev, const Range &curr,
                                  const int FirstGap) const;
@@ -4,6 +4,9 @@
 #include "../TranslationModel/ProbingPT.h"
 #include "../TranslationModel/UnknownWordPenalty.h"
 #include "../TranslationModel/Transliteration.h"
+#ifdef HAVE_CMPH
+#include "../TranslationModel/CompactPT/PhraseTableCompact.h"
+#endif
 
 #include "../LM/KENLM.h"
 #include "../LM/KENLMBatch.h"
@@ -56,6 +59,9 @@ FeatureRegistry::FeatureRegistry()
   MOSES_FNAME(ProbingPT);
   MOSES_FNAME2("PhraseDictionaryTransliteration", Transliteration);
   MOSES_FNAME(UnknownWordPenalty);
+#ifdef HAVE_CMPH
+  MOSES_FNAME2("PhraseDictionaryCompact", PhraseTableCompact);
+#endif
 
   Add("KENLM", new KenFactory());
 
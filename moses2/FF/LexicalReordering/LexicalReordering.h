@@ -60,6 +60,11 @@ public:
                                    const SCFG::Hypothesis &hypo, int featureID, Scores &scores,
                                    FFState &state) const;
 
+  //! scores are log probs
+  virtual SCORE GetWhenAppliedUpperBound(const System &system) const {
+    return NonPositiveScoresBound(system);
+  }
+
 protected:
   std::string m_path;
   FactorList m_FactorsF;
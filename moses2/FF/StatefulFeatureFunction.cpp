@@ -10,10 +10,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <limits>
 
 #include <boost/foreach.hpp>
 #include "StatefulFeatureFunction.h"
 #include "../PhraseBased/Hypothesis.h"
+#include "../System.h"
 
 using namespace std;
 
@@ -65,5 +67,21 @@ void StatefulFeatureFunction::EvaluateWhenAppliedBatch(
 #endif
 }
 
+SCORE StatefulFeatureFunction::GetWhenAppliedUpperBound(const System &system) const
+{
+  return std::numeric_limits<SCORE>::infinity();
+}
+
+SCORE StatefulFeatureFunction::NonPositiveScoresBound(const System &system) const
+{
+  std::vector<SCORE> weights = system.weights.GetWeights(*this);
+  BOOST_FOREACH(SCORE weight, weights) {
+    if (weight < 0) {
+      return std::numeric_limits<SCORE>::infinity();
+    }
+  }
+  return 0;
+}
+
 }
 
@@ -56,9 +56,18 @@ public:
     const System &system,
     const Batch &batch) const;
 
+  /** upper bound of the weighted score EvaluateWhenApplied() adds to a
+   * phrase-based hypo. Lets the search discard hypos without scoring them.
+   * Infinity if there is no bound
+   */
+  virtual SCORE GetWhenAppliedUpperBound(const System &system) const;
+
 protected:
   size_t m_statefulInd;
 
+  //! bound for features whose scores are never positive, eg. log probs
+  SCORE NonPositiveScoresBound(const System &system) const;
+
 };
 
 }
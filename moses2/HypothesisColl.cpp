@@ -7,19 +7,31 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
-#include <boost/foreach.hpp>
+#include <cstring>
 #include "HypothesisColl.h"
 #include "ManagerBase.h"
 #include "System.h"
-#include "MemPoolAllocator.h"
 
 using namespace std;
 
 namespace Moses2
 {
 
+namespace
+{
+struct EntryFutureScoreOrderer {
+  template<typename Entry>
+  bool operator()(const Entry &a, const Entry &b) const {
+    return HypothesisFutureScoreOrderer()(a.hypo, b.hypo);
+  }
+};
+}
+
 HypothesisColl::HypothesisColl(const ManagerBase &mgr)
-  :m_coll(MemPoolAllocator<const HypothesisBase*>(mgr.GetPool()))
+  :m_pool(mgr.GetPool())
+  ,m_entries(NULL)
+  ,m_capacity(0)
+  ,m_size(0)
   ,m_sortedHypos(NULL)
 {
   m_bestScore = -std::numeric_limits<float>::infinity();
@@ -36,9 +48,10 @@ const HypothesisBase *HypothesisColl::GetBestHypo() const
   }
 
   SCORE bestScore = -std::numeric_limits<SCORE>::infinity();
-  const HypothesisBase *bestHypo;
-  BOOST_FOREACH(const HypothesisBase *hypo, m_coll) {
-    if (hypo->GetFutureScore() > bestScore) {
+  const HypothesisBase *bestHypo = NULL;
+  for (size_t i = 0; i < m_capacity; ++i) {
+    const HypothesisBase *hypo = m_entries[i].hypo;
+    if (hypo && hypo->GetFutureScore() > bestScore) {
       bestScore = hypo->GetFutureScore();
       bestHypo = hypo;
     }
@@ -53,12 +66,6 @@ void HypothesisColl::Add(
   ArcLists &arcLists)
 {
   size_t maxStackSize = mgr.system.options.search.stack_size;
-
-  if (GetSize() > maxStackSize * 2) {
-    //cerr << "maxStackSize=" << maxStackSize << " " << GetSize() << endl;
-    PruneHypos(mgr, mgr.arcLists);
-  }
-
   SCORE futureScore = hypo->GetFutureScore();
 
   /*
@@ -68,9 +75,7 @@ void HypothesisColl::Add(
       << GetSize() << " "
       << endl;
   */
-  if (GetSize() >= maxStackSize && futureScore < m_worstScore) {
-    // beam threshold or really bad hypo that won't make the pruning cut
-    // as more hypos are added, the m_worstScore stat gets out of date and isn't the optimum cut-off point
+  if (IsBelowThreshold(mgr, futureScore)) {
     //cerr << "Discard, really bad score:" << hypo->Debug(mgr.system) << endl;
     hypoRecycle.Recycle(hypo);
     return;
@@ -105,28 +110,45 @@ void HypothesisColl::Add(
   }
 }
 
+bool HypothesisColl::IsBelowThreshold(const ManagerBase &mgr, SCORE futureScore)
+{
+  size_t maxStackSize = mgr.system.options.search.stack_size;
+
+  if (GetSize() > maxStackSize * 2) {
+    //cerr << "maxStackSize=" << maxStackSize << " " << GetSize() << endl;
+    PruneHypos(mgr, mgr.arcLists);
+  }
+
+  // beam threshold or really bad hypo that won't make the pruning cut
+  // as more hypos are added, the m_worstScore stat gets out of date and isn't the optimum cut-off point
+  return GetSize() >= maxStackSize && futureScore < m_worstScore;
+}
+
 StackAdd HypothesisColl::Add(const HypothesisBase *hypo)
 {
-  std::pair<_HCType::iterator, bool> addRet = m_coll.insert(hypo);
+  Reserve(m_size + 1);
+
+  size_t hash = hypo->hash();
+  Entry &entry = Find(hash, *hypo);
   //cerr << endl << "new=" << hypo->Debug(hypo->GetManager().system) << endl;
 
   // CHECK RECOMBINATION
-  if (addRet.second) {
+  if (entry.hypo == NULL) {
     // equiv hypo doesn't exists
     //cerr << "Added " << hypo << endl;
+    entry.hash = hash;
+    entry.hypo = hypo;
+    ++m_size;
     return StackAdd(true, NULL);
   } else {
-    HypothesisBase *hypoExisting = const_cast<HypothesisBase*>(*addRet.first);
+    HypothesisBase *hypoExisting = const_cast<HypothesisBase*>(entry.hypo);
     //cerr << "hypoExisting=" << hypoExisting->Debug(hypo->GetManager().system) << endl;
 
     if (hypo->GetFutureScore() > hypoExisting->GetFutureScore()) {
-      // incoming hypo is better than the one we have
-      const HypothesisBase * const &hypoExisting1 = *addRet.first;
-      const HypothesisBase *&hypoExisting2 =
-        const_cast<const HypothesisBase *&>(hypoExisting1);
-      hypoExisting2 = hypo;
+      // incoming hypo is better than the one we have. Same states, same hash
+      entry.hypo = hypo;
 
-      //cerr << "Added " << hypo << " dicard existing " << hypoExisting2 << endl;
+      //cerr << "Added " << hypo << " dicard existing " << hypoExisting << endl;
       return StackAdd(true, hypoExisting);
     } else {
       // already storing the best hypo. discard incoming hypo
@@ -134,8 +156,6 @@ StackAdd HypothesisColl::Add(const HypothesisBase *hypo)
       return StackAdd(false, hypoExisting);
     }
   }
-
-  //assert(false);
 }
 
 const Hypotheses &HypothesisColl::GetSortedAndPrunedHypos(
@@ -144,19 +164,17 @@ const Hypotheses &HypothesisColl::GetSortedAndPrunedHypos(
 {
   if (m_sortedHypos == NULL) {
     // create sortedHypos first
-    MemPool &pool = mgr.GetPool();
-    m_sortedHypos = new (pool.Allocate<Hypotheses>()) Hypotheses(pool,
-        m_coll.size());
-
-    SortHypos(mgr, m_sortedHypos->GetArray());
+    Entry *sortedEntries = (Entry *) alloca(GetSize() * sizeof(Entry));
+    SortHypos(mgr, sortedEntries);
 
     // prune
     Recycler<HypothesisBase*> &recycler = mgr.GetHypoRecycle();
 
+    size_t size = GetSize();
     size_t maxStackSize = mgr.system.options.search.stack_size;
-    if (maxStackSize && m_sortedHypos->size() > maxStackSize) {
-      for (size_t i = maxStackSize; i < m_sortedHypos->size(); ++i) {
-        HypothesisBase *hypo = const_cast<HypothesisBase*>((*m_sortedHypos)[i]);
+    if (maxStackSize && size > maxStackSize) {
+      for (size_t i = maxStackSize; i < size; ++i) {
+        HypothesisBase *hypo = const_cast<HypothesisBase*>(sortedEntries[i].hypo);
         recycler.Recycle(hypo);
 
         // delete from arclist
@@ -164,9 +182,16 @@ const Hypotheses &HypothesisColl::GetSortedAndPrunedHypos(
           arcLists.Delete(hypo);
         }
       }
-      m_sortedHypos->resize(maxStackSize);
+      size = maxStackSize;
+    }
+
+    m_sortedHypos = new (m_pool.Allocate<Hypotheses>()) Hypotheses(m_pool, size);
+    for (size_t i = 0; i < size; ++i) {
+      (*m_sortedHypos)[i] = sortedEntries[i].hypo;
     }
 
+    // compact. Only the surviving hypos stay in the table
+    Rebuild(sortedEntries, size);
   }
 
   return *m_sortedHypos;
@@ -178,47 +203,41 @@ void HypothesisColl::PruneHypos(const ManagerBase &mgr, ArcLists &arcLists)
 
   Recycler<HypothesisBase*> &recycler = mgr.GetHypoRecycle();
 
-  const HypothesisBase **sortedHypos = (const HypothesisBase **) alloca(GetSize() * sizeof(const HypothesisBase *));
-  SortHypos(mgr, sortedHypos);
+  size_t size = GetSize();
+  Entry *sortedEntries = (Entry *) alloca(size * sizeof(Entry));
+  SortHypos(mgr, sortedEntries);
 
   // update worse score
-  m_worstScore = sortedHypos[maxStackSize - 1]->GetFutureScore();
+  m_worstScore = sortedEntries[maxStackSize - 1].hypo->GetFutureScore();
 
   // prune
-  for (size_t i = maxStackSize; i < GetSize(); ++i) {
-    HypothesisBase *hypo = const_cast<HypothesisBase*>(sortedHypos[i]);
+  for (size_t i = maxStackSize; i < size; ++i) {
+    HypothesisBase *hypo = const_cast<HypothesisBase*>(sortedEntries[i].hypo);
 
     // delete from arclist
     if (mgr.system.options.nbest.nbest_size) {
       arcLists.Delete(hypo);
     }
 
-    // delete from collection
-    Delete(hypo);
-
     recycler.Recycle(hypo);
   }
 
+  // delete from collection
+  Rebuild(sortedEntries, maxStackSize);
 }
 
-void HypothesisColl::SortHypos(const ManagerBase &mgr, const HypothesisBase **sortedHypos) const
+void HypothesisColl::SortHypos(const ManagerBase &mgr, Entry *sortedEntries) const
 {
   size_t maxStackSize = mgr.system.options.search.stack_size;
   //assert(maxStackSize); // can't do stack=0 - unlimited stack size. No-one ever uses that
   //assert(GetSize() > maxStackSize);
-  //assert(sortedHypos.size() == GetSize());
 
-  /*
-   cerr << "UNSORTED hypos: ";
-   BOOST_FOREACH(const HypothesisBase *hypo, m_coll) {
-     cerr << hypo << "(" << hypo->GetFutureScore() << ")" << " ";
-   }
-   cerr << endl;
-   */
   size_t ind = 0;
-  BOOST_FOREACH(const HypothesisBase *hypo, m_coll) {
-    sortedHypos[ind] = hypo;
-    ++ind;
+  for (size_t i = 0; i < m_capacity; ++i) {
+    if (m_entries[i].hypo) {
+      sortedEntries[ind] = m_entries[i];
+      ++ind;
+    }
   }
 
   size_t indMiddle;
@@ -231,18 +250,16 @@ void HypothesisColl::SortHypos(const ManagerBase &mgr, const HypothesisBase **so
     indMiddle = GetSize();
   }
 
-  const HypothesisBase **iterMiddle = sortedHypos + indMiddle;
-
   std::partial_sort(
-    sortedHypos,
-    iterMiddle,
-    sortedHypos + GetSize(),
-    HypothesisFutureScoreOrderer());
+    sortedEntries,
+    sortedEntries + indMiddle,
+    sortedEntries + GetSize(),
+    EntryFutureScoreOrderer());
 
   /*
    cerr << "sorted hypos: ";
-   for (size_t i = 0; i < sortedHypos.size(); ++i) {
-     const HypothesisBase *hypo = sortedHypos[i];
+   for (size_t i = 0; i < GetSize(); ++i) {
+     const HypothesisBase *hypo = sortedEntries[i].hypo;
      cerr << hypo << " ";
    }
    cerr << endl;
@@ -251,27 +268,112 @@ void HypothesisColl::SortHypos(const ManagerBase &mgr, const HypothesisBase **so
 
 void HypothesisColl::Delete(const HypothesisBase *hypo)
 {
-  //cerr << "hypo=" << hypo << " " << m_coll.size() << endl;
+  //cerr << "hypo=" << hypo << " " << GetSize() << endl;
 
-  size_t erased = m_coll.erase(hypo);
-  UTIL_THROW_IF2(erased != 1, "couldn't erase hypo " << hypo);
+  Entry *entry = m_capacity ? &Find(hypo->hash(), *hypo) : NULL;
+  UTIL_THROW_IF2(entry == NULL || entry->hypo != hypo, "couldn't erase hypo " << hypo);
+  Erase(*entry);
 }
 
 void HypothesisColl::Clear()
 {
   m_sortedHypos = NULL;
-  m_coll.clear();
+  if (m_size) {
+    memset(m_entries, 0, m_capacity * sizeof(Entry));
+    m_size = 0;
+  }
 
   m_bestScore = -std::numeric_limits<float>::infinity();
   m_worstScore = std::numeric_limits<float>::infinity();
 }
 
+HypothesisColl::Entry &HypothesisColl::Find(size_t hash, const HypothesisBase &hypo) const
+{
+  // the table is never more than half full, so there is always an empty slot
+  size_t mask = m_capacity - 1;
+  for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+    Entry &entry = m_entries[i];
+    if (entry.hypo == NULL
+        || (entry.hash == hash && (entry.hypo == &hypo || *entry.hypo == hypo))) {
+      return entry;
+    }
+  }
+}
+
+void HypothesisColl::Insert(const Entry &entry) const
+{
+  // entries come from the table, so there is no equal hypo to look for
+  size_t mask = m_capacity - 1;
+  size_t i = entry.hash & mask;
+  while (m_entries[i].hypo) {
+    i = (i + 1) & mask;
+  }
+  m_entries[i] = entry;
+  ++m_size;
+}
+
+void HypothesisColl::Erase(Entry &entry)
+{
+  // move later entries of the probe sequence back so that no tombstones are needed
+  size_t mask = m_capacity - 1;
+  size_t hole = &entry - m_entries;
+  for (size_t i = (hole + 1) & mask; m_entries[i].hypo; i = (i + 1) & mask) {
+    size_t home = m_entries[i].hash & mask;
+    // can move unless home is cyclically in (hole, i]
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      m_entries[hole] = m_entries[i];
+      hole = i;
+    }
+  }
+  m_entries[hole].hypo = NULL;
+  --m_size;
+}
+
+void HypothesisColl::Rebuild(const Entry *entries, size_t size) const
+{
+  if (m_capacity) {
+    memset(m_entries, 0, m_capacity * sizeof(Entry));
+  }
+  m_size = 0;
+  for (size_t i = 0; i < size; ++i) {
+    Insert(entries[i]);
+  }
+}
+
+void HypothesisColl::Reserve(size_t size) const
+{
+  if (2 * size <= m_capacity) {
+    return;
+  }
+
+  size_t capacity = m_capacity ? m_capacity : 16;
+  while (capacity < 2 * size) {
+    capacity *= 2;
+  }
+
+  // the old table stays in the pool until the manager resets it
+  Entry *oldEntries = m_entries;
+  size_t oldCapacity = m_capacity;
+  m_entries = m_pool.Allocate<Entry>(capacity);
+  m_capacity = capacity;
+  memset(m_entries, 0, capacity * sizeof(Entry));
+
+  m_size = 0;
+  for (size_t i = 0; i < oldCapacity; ++i) {
+    if (oldEntries[i].hypo) {
+      Insert(oldEntries[i]);
+    }
+  }
+}
+
 std::string HypothesisColl::Debug(const System &system) const
 {
   stringstream out;
-  BOOST_FOREACH (const HypothesisBase *hypo, m_coll) {
-    out << hypo->Debug(system);
-    out << std::endl << std::endl;
+  for (size_t i = 0; i < m_capacity; ++i) {
+    if (m_entries[i].hypo) {
+      out << m_entries[i].hypo->Debug(system);
+      out << std::endl << std::endl;
+    }
   }
 
   return out.str();
@@ -5,9 +5,8 @@
  *      Author: hieu
  */
 #pragma once
-#include <boost/unordered_set.hpp>
 #include "HypothesisBase.h"
-#include "MemPoolAllocator.h"
+#include "MemPool.h"
 #include "Recycler.h"
 #include "Array.h"
 #include "legacy/Util2.h"
@@ -30,8 +29,13 @@ public:
            Recycler<HypothesisBase*> &hypoRecycle,
            ArcLists &arcLists);
 
+  /** whether Add() would discard a hypo with this future score. Prunes the
+   * collection first if it has grown too big, as Add() does
+   */
+  bool IsBelowThreshold(const ManagerBase &mgr, SCORE futureScore);
+
   size_t GetSize() const {
-    return m_coll.size();
+    return m_size;
   }
 
   void Clear();
@@ -53,11 +57,20 @@ public:
   std::string Debug(const System &system) const;
 
 protected:
-  typedef boost::unordered_set<const HypothesisBase*,
-          UnorderedComparer<HypothesisBase>, UnorderedComparer<HypothesisBase>,
-          MemPoolAllocator<const HypothesisBase*> > _HCType;
+  // recombination table. Open addressing with linear probing, in memory
+  // from the manager's pool. Each entry keeps the hash of its hypo's states
+  // so that probing compares hashes before calling the virtual operator==,
+  // and growing or compacting the table never rehashes a hypo
+  struct Entry {
+    size_t hash;
+    const HypothesisBase *hypo; // NULL if the slot is empty
+  };
+
+  MemPool &m_pool;
+  mutable Entry *m_entries;
+  mutable size_t m_capacity; // power of 2
+  mutable size_t m_size;
 
-  _HCType m_coll;
   mutable Hypotheses *m_sortedHypos;
 
   SCORE m_bestScore;
@@ -66,7 +79,13 @@ protected:
   StackAdd Add(const HypothesisBase *hypo);
 
   void PruneHypos(const ManagerBase &mgr, ArcLists &arcLists);
-  void SortHypos(const ManagerBase &mgr, const HypothesisBase **sortedHypos) const;
+  void SortHypos(const ManagerBase &mgr, Entry *sortedEntries) const;
+
+  Entry &Find(size_t hash, const HypothesisBase &hypo) const;
+  void Insert(const Entry &entry) const;
+  void Erase(Entry &entry);
+  void Rebuild(const Entry *entries, size_t size) const;
+  void Reserve(size_t size) const;
 
 };
 
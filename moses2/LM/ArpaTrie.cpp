@@ -0,0 +1,492 @@
+/*
+ * ArpaTrie.cpp
+ *
+ *  Flattened n-gram trie for the in-memory LanguageModel.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "ArpaTrie.h"
+#include "../legacy/ThreadPool.h"
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/file_piece.hh"
+#include "util/string_piece_hash.hh"
+#include "util/tokenize_piece.hh"
+
+using namespace std;
+
+namespace Moses2
+{
+
+namespace
+{
+const char kMagic[8] = {'m', 'o', 's', 'e', 's', 'l', 'm', '1'};
+
+struct BinaryHeader {
+  char magic[8];
+  uint64_t order, numWords, numNodes, vocabBytes;
+};
+
+// lines per parse task
+const size_t CHUNK_LINES = 1 << 16;
+
+// more interpolation steps rarely pay off over binary search
+const size_t MAX_INTERPOLATION_STEPS = 4;
+const ptrdiff_t MIN_INTERPOLATION_SIZE = 16;
+
+typedef boost::unordered_map<StringPiece, uint32_t> VocabMap;
+
+float ParseFloat(const StringPiece &str)
+{
+  char buffer[64];
+  size_t length = std::min(str.size(), sizeof(buffer) - 1);
+  memcpy(buffer, str.data(), length);
+  buffer[length] = 0;
+  return strtof(buffer, NULL);
+}
+
+// prob <tab> words [<tab> backoff]. Returns the words
+StringPiece SplitLine(const StringPiece &line, float &prob, float &backoff)
+{
+  size_t tab = line.find('\t');
+  UTIL_THROW_IF2(tab == StringPiece::npos, "Bad ARPA line: " << line);
+  prob = ParseFloat(line.substr(0, tab));
+
+  StringPiece words = line.substr(tab + 1);
+  tab = words.find('\t');
+  if (tab == StringPiece::npos) {
+    backoff = 0;
+    return words;
+  }
+  backoff = ParseFloat(words.substr(tab + 1));
+  return words.substr(0, tab);
+}
+
+struct KeyLess {
+  const uint32_t *keys;
+  size_t order;
+
+  KeyLess(const uint32_t *keys, size_t order) : keys(keys), order(order) {}
+
+  bool operator()(size_t a, size_t b) const {
+    const uint32_t *ka = keys + a * order, *kb = keys + b * order;
+    return std::lexicographical_compare(ka, ka + order, kb, kb + order);
+  }
+};
+
+struct WordLess {
+  bool operator()(const ArpaTrie::Node &node, uint32_t word) const {
+    return node.word < word;
+  }
+};
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+//! parses a chunk of lines of one n-gram section
+class ArpaTrie::ParseTask: public Task
+{
+public:
+  ParseTask(const VocabMap &vocab, size_t order)
+    : m_vocab(vocab) {
+    level.order = order;
+  }
+
+  void Run() {
+    try {
+      Parse();
+    } catch (const std::exception &e) {
+      error = e.what();
+    }
+  }
+
+  std::string chunk;
+  Level level;
+  std::string error;
+
+private:
+  const VocabMap &m_vocab;
+
+  void Parse() {
+    const size_t order = level.order;
+    std::vector<uint32_t> key(order);
+    StringPiece rest(chunk);
+    while (!rest.empty()) {
+      size_t newline = rest.find('\n');
+      StringPiece line = rest.substr(0, newline);
+      rest = newline == StringPiece::npos ? StringPiece() : rest.substr(newline + 1);
+
+      float prob, backoff;
+      StringPiece words = SplitLine(line, prob, backoff);
+
+      // stored backwards
+      size_t pos = order;
+      for (util::TokenIter<util::SingleCharacter, true> word(words, ' '); word; ++word) {
+        UTIL_THROW_IF2(pos == 0, "Too many words in " << order << "-gram: " << line);
+        VocabMap::const_iterator iter = m_vocab.find(*word);
+        UTIL_THROW_IF2(iter == m_vocab.end(), "Word " << *word << " is not a unigram");
+        key[--pos] = iter->second;
+      }
+      UTIL_THROW_IF2(pos != 0, "Too few words in " << order << "-gram: " << line);
+
+      level.keys.insert(level.keys.end(), key.begin(), key.end());
+      level.probs.push_back(prob);
+      level.backoffs.push_back(backoff);
+    }
+  }
+};
+
+//! sorts the n-grams of one order
+class ArpaTrie::SortTask: public Task
+{
+public:
+  explicit SortTask(Level &level) : m_level(level) {}
+  void Run() {
+    m_level.Sort();
+  }
+private:
+  Level &m_level;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+void ArpaTrie::Level::Sort()
+{
+  std::vector<size_t> perm(size());
+  for (size_t i = 0; i < perm.size(); ++i) {
+    perm[i] = i;
+  }
+  std::stable_sort(perm.begin(), perm.end(), KeyLess(&keys[0], order));
+
+  // duplicates: the last one counts
+  Level sorted;
+  sorted.order = order;
+  sorted.keys.reserve(keys.size());
+  sorted.probs.reserve(size());
+  sorted.backoffs.reserve(size());
+  for (size_t i = 0; i < perm.size(); ++i) {
+    const uint32_t *key = &keys[perm[i] * order];
+    if (sorted.size() && std::equal(key, key + order, sorted.keys.end() - order)) {
+      sorted.probs.back() = probs[perm[i]];
+      sorted.backoffs.back() = backoffs[perm[i]];
+      continue;
+    }
+    sorted.keys.insert(sorted.keys.end(), key, key + order);
+    sorted.probs.push_back(probs[perm[i]]);
+    sorted.backoffs.push_back(backoffs[perm[i]]);
+  }
+
+  keys.swap(sorted.keys);
+  probs.swap(sorted.probs);
+  backoffs.swap(sorted.backoffs);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+const uint32_t ArpaTrie::NO_WORD;
+
+ArpaTrie::ArpaTrie()
+  : m_order(0), m_nodes(NULL), m_numNodes(0)
+{
+}
+
+bool ArpaTrie::IsBinary(const std::string &path)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(path.c_str()));
+  char magic[sizeof(kMagic)];
+  return util::ReadOrEOF(file.get(), magic, sizeof(magic)) == sizeof(magic)
+         && !memcmp(magic, kMagic, sizeof(kMagic));
+}
+
+void ArpaTrie::LoadArpa(const std::string &path, size_t threads)
+{
+  util::FilePiece in(path.c_str());
+
+  StringPiece line;
+  while ((line = in.ReadLine()) != "\\data\\") {
+  }
+
+  std::vector<size_t> counts;
+  while (!(line = in.ReadLine()).empty()) {
+    size_t equals = line.find('=');
+    UTIL_THROW_IF2(!line.starts_with("ngram ") || equals == StringPiece::npos,
+                   "Bad ARPA header line: " << line);
+    counts.push_back(boost::lexical_cast<size_t>(line.substr(equals + 1).as_string()));
+  }
+  m_order = counts.size();
+  UTIL_THROW_IF2(m_order == 0, "No n-grams in " << path);
+
+  std::vector<Level> levels(m_order);
+  VocabMap vocab;
+  for (size_t order = 1; order <= m_order; ++order) {
+    while ((line = in.ReadLine()).empty()) {
+    }
+    const std::string header = "\\" + boost::lexical_cast<std::string>(order) + "-grams:";
+    UTIL_THROW_IF2(line != header, "Expected " << header << " but got " << line);
+
+    Level &level = levels[order - 1];
+    level.order = order;
+
+    if (order == 1) {
+      // unigrams number the words, so they are read here
+      level.keys.reserve(counts[0]);
+      for (size_t i = 0; i < counts[0]; ++i) {
+        float prob, backoff;
+        StringPiece word = SplitLine(in.ReadLine(), prob, backoff);
+        VocabMap::const_iterator iter = vocab.find(word);
+        uint32_t id;
+        if (iter == vocab.end()) {
+          id = m_vocab.size();
+          m_vocab.push_back(word.as_string());
+          vocab[StringPiece(m_vocab.back())] = id;
+        } else {
+          id = iter->second;
+        }
+        level.keys.push_back(id);
+        level.probs.push_back(prob);
+        level.backoffs.push_back(backoff);
+      }
+      continue;
+    }
+
+    ThreadPool pool(std::max<size_t>(threads, 1));
+    pool.SetQueueLimit(2 * std::max<size_t>(threads, 1));
+    std::vector<boost::shared_ptr<ParseTask> > tasks;
+    for (size_t remaining = counts[order - 1]; remaining; ) {
+      boost::shared_ptr<ParseTask> task(new ParseTask(vocab, order));
+      for (size_t i = 0; i < CHUNK_LINES && remaining; ++i, --remaining) {
+        line = in.ReadLine();
+        task->chunk.append(line.data(), line.size());
+        task->chunk += '\n';
+      }
+      tasks.push_back(task);
+      pool.Submit(task);
+    }
+    pool.Stop(true);
+
+    size_t total = 0;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      UTIL_THROW_IF2(!tasks[i]->error.empty(), tasks[i]->error << " in " << path);
+      total += tasks[i]->level.size();
+    }
+    level.keys.reserve(total * order);
+    level.probs.reserve(total);
+    level.backoffs.reserve(total);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      Level &part = tasks[i]->level;
+      level.keys.insert(level.keys.end(), part.keys.begin(), part.keys.end());
+      level.probs.insert(level.probs.end(), part.probs.begin(), part.probs.end());
+      level.backoffs.insert(level.backoffs.end(), part.backoffs.begin(), part.backoffs.end());
+      tasks[i].reset();
+    }
+  }
+
+  // the levels are sorted independently
+  {
+    ThreadPool pool(std::max<size_t>(std::min(threads, m_order), 1));
+    for (size_t i = 0; i < m_order; ++i) {
+      pool.Submit(boost::shared_ptr<Task>(new SortTask(levels[i])));
+    }
+    pool.Stop(true);
+  }
+
+  Build(levels);
+}
+
+void ArpaTrie::Build(std::vector<Level> &levels)
+{
+  // every prefix of a stored key must be a node. ARPA files need not contain
+  // all of them, the missing ones are added without probability
+  for (size_t i = levels.size() - 1; i > 0; --i) {
+    const Level &upper = levels[i];
+    Level &lower = levels[i - 1];
+    const size_t order = lower.order;
+
+    std::vector<uint32_t> missing;
+    size_t j = 0;
+    for (size_t k = 0; k < upper.size(); ++k) {
+      const uint32_t *prefix = &upper.keys[k * upper.order];
+      if (k && std::equal(prefix, prefix + order, prefix - upper.order)) {
+        continue;
+      }
+      while (j < lower.size() && std::lexicographical_compare(
+               &lower.keys[j * order], &lower.keys[j * order] + order, prefix, prefix + order)) {
+        ++j;
+      }
+      if (j == lower.size() || !std::equal(prefix, prefix + order, &lower.keys[j * order])) {
+        missing.insert(missing.end(), prefix, prefix + order);
+      }
+    }
+
+    if (!missing.empty()) {
+      lower.keys.insert(lower.keys.end(), missing.begin(), missing.end());
+      lower.probs.resize(lower.keys.size() / order, std::numeric_limits<float>::infinity());
+      lower.backoffs.resize(lower.keys.size() / order, 0);
+      lower.Sort();
+    }
+  }
+
+  // node 0 is the root, the levels follow in order
+  std::vector<size_t> levelStart(levels.size() + 1);
+  levelStart[0] = 1;
+  for (size_t i = 0; i < levels.size(); ++i) {
+    levelStart[i + 1] = levelStart[i] + levels[i].size();
+  }
+  m_numNodes = levelStart.back();
+  UTIL_THROW_IF2(m_numNodes >= NO_WORD, "Too many n-grams: " << m_numNodes);
+  UTIL_THROW_IF2(levels[0].size() != m_vocab.size(), "Unigrams are not unique");
+
+  m_built.resize(m_numNodes);
+  Node &root = m_built[0];
+  root.word = NO_WORD;
+  root.firstChild = levelStart[0];
+  root.endChild = levelStart[1];
+  root.prob = std::numeric_limits<float>::infinity();
+  root.backoff = 0;
+
+  for (size_t i = 0; i < levels.size(); ++i) {
+    Level &level = levels[i];
+    const size_t order = level.order;
+    const Level *upper = i + 1 < levels.size() ? &levels[i + 1] : NULL;
+
+    size_t j = 0;
+    for (size_t k = 0; k < level.size(); ++k) {
+      const uint32_t *key = &level.keys[k * order];
+      Node &node = m_built[levelStart[i] + k];
+      node.word = key[order - 1];
+      node.prob = level.probs[k];
+      node.backoff = level.backoffs[k];
+
+      node.firstChild = node.endChild = 0;
+      if (upper) {
+        node.firstChild = levelStart[i + 1] + j;
+        while (j < upper->size() && std::equal(key, key + order, &upper->keys[j * upper->order])) {
+          ++j;
+        }
+        node.endChild = levelStart[i + 1] + j;
+      }
+    }
+
+    if (i) {
+      Level empty;
+      levels[i - 1].keys.swap(empty.keys);
+      levels[i - 1].probs.swap(empty.probs);
+      levels[i - 1].backoffs.swap(empty.backoffs);
+    }
+  }
+  levels.clear();
+
+  m_nodes = &m_built[0];
+}
+
+void ArpaTrie::Save(const std::string &path) const
+{
+  BinaryHeader header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.order = m_order;
+  header.numWords = m_vocab.size();
+  header.numNodes = m_numNodes;
+  header.vocabBytes = 0;
+  for (size_t i = 0; i < m_vocab.size(); ++i) {
+    header.vocabBytes += m_vocab[i].size() + 1;
+  }
+
+  util::scoped_fd file(util::CreateOrThrow(path.c_str()));
+  util::WriteOrThrow(file.get(), &header, sizeof(header));
+  util::WriteOrThrow(file.get(), m_nodes, m_numNodes * sizeof(Node));
+  for (size_t i = 0; i < m_vocab.size(); ++i) {
+    util::WriteOrThrow(file.get(), m_vocab[i].c_str(), m_vocab[i].size() + 1);
+  }
+}
+
+void ArpaTrie::LoadBinary(const std::string &path, util::LoadMethod method)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(path.c_str()));
+  uint64_t size = util::SizeOrThrow(file.get());
+  UTIL_THROW_IF2(size < sizeof(BinaryHeader), "Not a binary LM: " << path);
+  util::MapRead(method, file.get(), 0, size, m_mem);
+
+  const char *begin = static_cast<const char*>(m_mem.get());
+  const BinaryHeader &header = *reinterpret_cast<const BinaryHeader*>(begin);
+  UTIL_THROW_IF2(memcmp(header.magic, kMagic, sizeof(kMagic)), "Not a binary LM: " << path);
+  UTIL_THROW_IF2(size != sizeof(BinaryHeader) + header.numNodes * sizeof(Node) + header.vocabBytes,
+                 "Truncated binary LM: " << path);
+
+  m_order = header.order;
+  m_numNodes = header.numNodes;
+  m_nodes = reinterpret_cast<const Node*>(begin + sizeof(BinaryHeader));
+
+  const char *word = reinterpret_cast<const char*>(m_nodes + m_numNodes);
+  for (uint64_t i = 0; i < header.numWords; ++i) {
+    m_vocab.push_back(word);
+    word += m_vocab.back().size() + 1;
+  }
+}
+
+const ArpaTrie::Node *ArpaTrie::Find(const Node &parent, uint32_t word) const
+{
+  const Node *begin = m_nodes + parent.firstChild;
+  const Node *end = m_nodes + parent.endChild;
+
+  // word ids are spread evenly enough for interpolation to narrow large
+  // ranges quickly, the rest is binary search
+  for (size_t step = 0; step < MAX_INTERPOLATION_STEPS && end - begin > MIN_INTERPOLATION_SIZE; ++step) {
+    uint32_t first = begin->word, last = (end - 1)->word;
+    if (word < first || word > last) {
+      return NULL;
+    }
+    const Node *pivot = begin + (uint64_t) (word - first) * (end - begin - 1) / (last - first);
+    if (pivot->word < word) {
+      begin = pivot + 1;
+    } else if (pivot->word > word) {
+      end = pivot;
+    } else {
+      return pivot;
+    }
+  }
+
+  const Node *found = std::lower_bound(begin, end, word, WordLess());
+  return found != end && found->word == word ? found : NULL;
+}
+
+const ArpaTrie::Node *ArpaTrie::Score(const uint32_t *words, size_t size, float &prob) const
+{
+  const Node *node = GetUnigram(words[0]);
+  if (node == NULL || !node->IsNgram()) {
+    return NULL;
+  }
+
+  // longest n-gram ending in words[0]
+  const Node *ret = node;
+  size_t matched = 1;
+  prob = node->prob;
+  for (size_t i = 1; i < size; ++i) {
+    node = Find(*node, words[i]);
+    if (node == NULL) {
+      break;
+    }
+    if (node->IsNgram()) {
+      ret = node;
+      matched = i + 1;
+      prob = node->prob;
+    }
+  }
+
+  // backoff of the histories that were longer than that
+  if (matched < size) {
+    const Node *history = GetUnigram(words[1]);
+    for (size_t length = 1; history && length < size; ++length) {
+      if (length >= matched) {
+        prob += history->backoff;
+      }
+      history = length + 1 < size ? Find(*history, words[length + 1]) : NULL;
+    }
+  }
+
+  return ret;
+}
+
+}
@@ -0,0 +1,106 @@
+/*
+ * ArpaTrie.h
+ *
+ *  Flattened n-gram trie for the in-memory LanguageModel.
+ */
+
+#pragma once
+
+#include <deque>
+#include <limits>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "util/mmap.hh"
+
+namespace Moses2
+{
+
+/** N-grams of an ARPA file in a sorted, array based trie.
+ *
+ * Words are numbered in the order of the unigram section. An n-gram is
+ * stored backwards: the path from the root is the last word, then the word
+ * before it and so on. Level 1 is indexed by word id, the children of any
+ * other node are a sorted range of the node array and are found by
+ * interpolation search.
+ *
+ * The trie can be written to a binary file which is memory mapped when
+ * loaded, so that a lazily loaded LM only reads the pages it uses.
+ */
+class ArpaTrie
+{
+public:
+  struct Node {
+    uint32_t word;
+    uint32_t firstChild, endChild;
+    float prob, backoff;
+
+    //! false for nodes which only lead to longer n-grams
+    bool IsNgram() const {
+      return prob != std::numeric_limits<float>::infinity();
+    }
+  };
+
+  static const uint32_t NO_WORD = 0xffffffff;
+
+  ArpaTrie();
+
+  //! whether path is a binary trie written by Save()
+  static bool IsBinary(const std::string &path);
+
+  //! parses an ARPA file, with threads parsing n-gram sections in parallel
+  void LoadArpa(const std::string &path, size_t threads);
+  void LoadBinary(const std::string &path, util::LoadMethod method);
+  void Save(const std::string &path) const;
+
+  size_t GetOrder() const {
+    return m_order;
+  }
+  size_t GetNumWords() const {
+    return m_vocab.size();
+  }
+  const std::string &GetWord(uint32_t id) const {
+    return m_vocab[id];
+  }
+
+  const Node *GetUnigram(uint32_t word) const {
+    return word < m_vocab.size() ? m_nodes + 1 + word : NULL;
+  }
+  const Node *Find(const Node &parent, uint32_t word) const;
+
+  /** log prob of words[0] given words[1], words[2] ..., with backoff.
+   * Returns the node of the longest n-gram found, NULL if words[0] is
+   * not in the LM. Probabilities are as in the ARPA file (log10).
+   */
+  const Node *Score(const uint32_t *words, size_t size, float &prob) const;
+
+private:
+  // n-grams of one order while building, keys stored backwards
+  struct Level {
+    size_t order;
+    std::vector<uint32_t> keys;
+    std::vector<float> probs, backoffs;
+
+    size_t size() const {
+      return probs.size();
+    }
+    void Sort();
+  };
+
+  class ParseTask;
+  class SortTask;
+
+  size_t m_order;
+  std::deque<std::string> m_vocab;
+
+  // either built, or mapped from a binary file
+  std::vector<Node> m_built;
+  util::scoped_memory m_mem;
+  const Node *m_nodes;
+  size_t m_numNodes;
+
+  void Build(std::vector<Level> &levels);
+};
+
+}
@@ -0,0 +1,233 @@
+/*
+ * ArpaTrieTest.cpp
+ *
+ *  Checks ArpaTrie against a naive backoff scorer.
+ */
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#define BOOST_TEST_MODULE ArpaTrie
+#include <boost/test/unit_test.hpp>
+
+#include "ArpaTrie.h"
+
+using namespace Moses2;
+using namespace std;
+
+namespace
+{
+
+typedef vector<string> Ngram;
+
+// an ARPA file, and the same n-grams in a map for the naive scorer
+class TestLM
+{
+public:
+  TestLM(size_t order, size_t numWords, size_t maxNgrams, bool withUnk)
+    : m_seed(12345) {
+    m_path = (boost::filesystem::temp_directory_path()
+              / boost::filesystem::unique_path("arpa-trie-test-%%%%-%%%%")).string();
+
+    m_words.push_back("<s>");
+    m_words.push_back("</s>");
+    if (withUnk) {
+      m_words.push_back("<unk>");
+    }
+    for (size_t i = 0; m_words.size() < numWords; ++i) {
+      m_words.push_back("w" + boost::lexical_cast<string>(i));
+    }
+
+    vector<vector<Ngram> > levels(order);
+    for (size_t i = 0; i < m_words.size(); ++i) {
+      levels[0].push_back(Ngram(1, m_words[i]));
+    }
+    // higher orders extend a random lower order n-gram by a random word.
+    // Their suffixes need not be in the LM, so the trie has to add prefix
+    // nodes without a probability
+    for (size_t n = 1; n < order; ++n) {
+      map<Ngram, bool> seen;
+      for (size_t i = 0; i < maxNgrams; ++i) {
+        Ngram ngram = levels[n - 1][Random() % levels[n - 1].size()];
+        ngram.push_back(m_words[Random() % m_words.size()]);
+        if (!seen[ngram]) {
+          seen[ngram] = true;
+          levels[n].push_back(ngram);
+        }
+      }
+    }
+
+    ofstream out(m_path.c_str());
+    out.precision(9);
+    out << "\n\\data\\\n";
+    for (size_t n = 0; n < order; ++n) {
+      out << "ngram " << n + 1 << "=" << levels[n].size() << "\n";
+    }
+    for (size_t n = 0; n < order; ++n) {
+      out << "\n\\" << n + 1 << "-grams:\n";
+      for (size_t i = 0; i < levels[n].size(); ++i) {
+        const Ngram &ngram = levels[n][i];
+        // multiples of 1/64 survive the text form exactly
+        float prob = ngram[0] == "<s>" && n == 0 ? -99 : -(float) (Random() % 256) / 64;
+        float backoff = n + 1 < order ? -(float) (Random() % 64) / 64 : 0;
+        m_ngrams[ngram] = make_pair(prob, backoff);
+
+        out << prob << "\t" << ngram[0];
+        for (size_t j = 1; j < ngram.size(); ++j) {
+          out << " " << ngram[j];
+        }
+        if (n + 1 < order) {
+          out << "\t" << backoff;
+        }
+        out << "\n";
+      }
+    }
+    out << "\n\\end\\\n";
+  }
+
+  ~TestLM() {
+    boost::filesystem::remove(m_path);
+  }
+
+  const string &GetPath() const {
+    return m_path;
+  }
+  const vector<string> &GetWords() const {
+    return m_words;
+  }
+
+  /** log10 prob of words[0] given the history words[1], words[2] ..., or
+   * false if words[0] is not in the LM. Words are "" if not in the LM.
+   */
+  bool Score(const vector<string> &words, float &prob) const {
+    size_t history = words.size() - 1;
+    prob = 0;
+    for (;; --history) {
+      Ngram ngram(words.rend() - history - 1, words.rend());
+      map<Ngram, pair<float, float> >::const_iterator found = m_ngrams.find(ngram);
+      if (found != m_ngrams.end()) {
+        prob += found->second.first;
+        return true;
+      }
+      if (history == 0) {
+        return false;
+      }
+      ngram.pop_back();
+      found = m_ngrams.find(ngram);
+      if (found != m_ngrams.end()) {
+        prob += found->second.second;
+      }
+    }
+  }
+
+private:
+  size_t m_seed;
+  string m_path;
+  vector<string> m_words;
+  map<Ngram, pair<float, float> > m_ngrams;
+
+  size_t Random() {
+    m_seed = m_seed * 1103515245 + 12345;
+    return (m_seed >> 16) & 0x7fff;
+  }
+};
+
+// scores every sequence of up to order words from the vocabulary and one
+// word that is not in it, with trie and with lm
+void CheckAll(const ArpaTrie &trie, const TestLM &lm, size_t order)
+{
+  BOOST_REQUIRE_EQUAL(trie.GetOrder(), order);
+  BOOST_REQUIRE_EQUAL(trie.GetNumWords(), lm.GetWords().size());
+
+  // ids of the trie, and the unknown word last
+  const size_t numIds = trie.GetNumWords() + 1;
+  vector<string> strings(numIds);
+  for (size_t id = 0; id < trie.GetNumWords(); ++id) {
+    strings[id] = trie.GetWord(id);
+  }
+
+  size_t checked = 0, found = 0;
+  for (size_t size = 1; size <= order; ++size) {
+    vector<size_t> ind(size, 0);
+    while (true) {
+      vector<uint32_t> ids(size);
+      vector<string> words(size);
+      for (size_t i = 0; i < size; ++i) {
+        ids[i] = ind[i] + 1 == numIds ? ArpaTrie::NO_WORD : ind[i];
+        words[i] = strings[ind[i]];
+      }
+
+      float expected = 0, prob = 0;
+      bool inLM = lm.Score(words, expected);
+      const ArpaTrie::Node *node = trie.Score(&ids[0], size, prob);
+      BOOST_CHECK_EQUAL(node != NULL, inLM);
+      if (node && inLM) {
+        BOOST_CHECK_EQUAL(prob, expected);
+        BOOST_CHECK(node->IsNgram());
+        ++found;
+      }
+      ++checked;
+
+      size_t i = 0;
+      while (i < size && ++ind[i] == numIds) {
+        ind[i++] = 0;
+      }
+      if (i == size) {
+        break;
+      }
+    }
+  }
+  BOOST_CHECK_GT(found, checked / 2);
+}
+
+void CheckLM(size_t order, size_t numWords, size_t maxNgrams, bool withUnk)
+{
+  TestLM lm(order, numWords, maxNgrams, withUnk);
+  ArpaTrie built;
+  built.LoadArpa(lm.GetPath(), 4);
+  CheckAll(built, lm, order);
+
+  const string binary = lm.GetPath() + ".bin";
+  BOOST_CHECK(!ArpaTrie::IsBinary(lm.GetPath()));
+  built.Save(binary);
+  BOOST_CHECK(ArpaTrie::IsBinary(binary));
+
+  util::LoadMethod methods[] = { util::LAZY, util::READ };
+  for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); ++i) {
+    ArpaTrie loaded;
+    loaded.LoadBinary(binary, methods[i]);
+    CheckAll(loaded, lm, order);
+  }
+  boost::filesystem::remove(binary);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(arpa_trie)
+
+BOOST_AUTO_TEST_CASE(unigrams)
+{
+  CheckLM(1, 20, 0, true);
+}
+
+BOOST_AUTO_TEST_CASE(trigrams_with_unk)
+{
+  CheckLM(3, 30, 2000, true);
+}
+
+BOOST_AUTO_TEST_CASE(fourgrams_without_unk)
+{
+  CheckLM(4, 12, 1500, false);
+}
+
+// more lines than one parse task takes, so several tasks parse each order
+BOOST_AUTO_TEST_CASE(many_chunks)
+{
+  CheckLM(3, 45, 150000, true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -57,6 +57,11 @@ public:
                                    const SCFG::Hypothesis &hypo, int featureID, Scores &scores,
                                    FFState &state) const;
 
+  //! scores are log probs
+  virtual SCORE GetWhenAppliedUpperBound(const System &system) const {
+    return NonPositiveScoresBound(system);
+  }
+
 protected:
   std::string m_path;
   FactorType m_factorType;
@@ -84,7 +84,7 @@ private:
 /////////////////////////////////////////////////////////////////
 KENLMBatch::KENLMBatch(size_t startInd, const std::string &line)
   :StatefulFeatureFunction(startInd, line)
-  ,m_numHypos(0)
+  ,m_prefetchDistance(8)
 {
   cerr << "KENLMBatch::KENLMBatch" << endl;
   ReadParameters();
@@ -201,20 +201,27 @@ void KENLMBatch::EvaluateWhenApplied(const ManagerBase &mgr,
     std::swap(state0, state1);
   }
 
+  FinishScore(system, hypo, stateCast.state, state0, adjust_end, end, score, scores);
+}
+
+void KENLMBatch::FinishScore(const System &system, const Hypothesis &hypo,
+                             Model::State &outState, const Model::State *state0,
+                             size_t adjustEnd, size_t end, float score, Scores &scores) const
+{
   if (hypo.GetBitmap().IsComplete()) {
     // Score end of sentence.
     std::vector<lm::WordIndex> indices(m_ngram->Order() - 1);
     const lm::WordIndex *last = LastIDs(hypo, &indices.front());
     score += m_ngram->FullScoreForgotState(&indices.front(), last,
-                                           m_ngram->GetVocabulary().EndSentence(), stateCast.state).prob;
-  } else if (adjust_end < end) {
+                                           m_ngram->GetVocabulary().EndSentence(), outState).prob;
+  } else if (adjustEnd < end) {
     // Get state after adding a long phrase.
     std::vector<lm::WordIndex> indices(m_ngram->Order() - 1);
     const lm::WordIndex *last = LastIDs(hypo, &indices.front());
-    m_ngram->GetState(&indices.front(), last, stateCast.state);
-  } else if (state0 != &stateCast.state) {
+    m_ngram->GetState(&indices.front(), last, outState);
+  } else if (state0 != &outState) {
     // Short enough phrase that we can just reuse the state.
-    stateCast.state = *state0;
+    outState = *state0;
   }
 
   score = TransformLMScore(score);
@@ -299,6 +306,8 @@ void KENLMBatch::SetParameter(const std::string& key,
     // ignore
   } else if (key == "factor") {
     m_factorType = Scan<FactorType>(value);
+  } else if (key == "prefetch-distance") {
+    m_prefetchDistance = Scan<size_t>(value);
   } else if (key == "lazyken") {
     m_load_method =
       boost::lexical_cast<bool>(value) ?
@@ -324,38 +333,133 @@ void KENLMBatch::SetParameter(const std::string& key,
   //cerr << "SetParameter done" << endl;
 }
 
+namespace
+{
+struct QueryOrderer {
+  template<typename T>
+  bool operator()(const T &a, const T &b) const {
+    if (a.key != b.key) {
+      return a.key < b.key;
+    }
+    if (a.word != b.word) {
+      return a.word < b.word;
+    }
+    return *a.in < *b.in;
+  }
+};
+}
+
+/* Score the whole batch wave by wave: wave k holds the k-th word of every
+ * hypothesis' target phrase. Queries within a wave are independent so we can
+ * sort them, prefetch the hash buckets of queries further down the wave while
+ * scoring the current one, and only score identical (state, word) queries
+ * once. Each hypothesis sees exactly the same sequence of Score() calls as
+ * EvaluateWhenApplied() would make, so the results are identical.
+ */
 void KENLMBatch::EvaluateWhenAppliedBatch(
+  const System &system,
   const Batch &batch) const
 {
-  {
-    // write lock
-    boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
-    m_batches.push_back(&batch);
-    m_numHypos += batch.size();
+  const size_t statefulInd = GetStatefulInd();
+  const size_t order = m_ngram->Order();
+
+  std::vector<Pending> pending;
+  pending.reserve(batch.size());
+
+  BOOST_FOREACH(Hypothesis *hypo, batch) {
+    const lm::ngram::State &in_state =
+      static_cast<const KenLMState&>(*hypo->GetPrevHypo()->GetState(statefulInd)).state;
+    KenLMState &stateCast = static_cast<KenLMState&>(*hypo->GetState(statefulInd));
+
+    if (!hypo->GetTargetPhrase().GetSize()) {
+      stateCast.state = in_state;
+      continue;
+    }
+
+    pending.resize(pending.size() + 1);
+    Pending &p = pending.back();
+    p.hypo = hypo;
+    p.prevState = &in_state;
+    p.state0 = &stateCast.state;
+    p.state1 = &p.aux;
+    p.position = hypo->GetCurrTargetWordsRange().GetStartPos();
+    p.end = hypo->GetCurrTargetWordsRange().GetEndPos() + 1;
+    p.adjustEnd = std::min(p.end, p.position + order - 1);
+    p.score = 0;
   }
-  //cerr << "m_numHypos=" << m_numHypos << endl;
 
-  if (m_numHypos > 0) {
-    // process batch
-    EvaluateWhenAppliedBatch();
+  std::vector<Query> queries;
+  queries.reserve(pending.size());
+
+  for (size_t wave = 0; ; ++wave) {
+    queries.clear();
+    BOOST_FOREACH(Pending &p, pending) {
+      if (p.position >= p.adjustEnd) {
+        continue;
+      }
+      Query q;
+      if (wave == 0) {
+        q.in = p.prevState;
+        q.out = p.state0;
+      } else {
+        q.in = p.state0;
+        q.out = p.state1;
+      }
+      q.word = TranslateID(p.hypo->GetWord(p.position));
+      q.score = &p.score;
+      // bigram bucket first, so probes of the same region of the tables are
+      // adjacent and identical queries end up next to each other
+      q.key = lm::ngram::detail::CombineWordHash(q.word, q.in->length ? q.in->words[0] : 0);
+      queries.push_back(q);
+    }
 
-    m_batches.clear();
-    m_numHypos = 0;
+    if (queries.empty()) {
+      break;
+    }
+    ScoreQueries(queries);
+
+    BOOST_FOREACH(Pending &p, pending) {
+      if (p.position >= p.adjustEnd) {
+        continue;
+      }
+      if (wave) {
+        std::swap(p.state0, p.state1);
+      }
+      ++p.position;
+    }
+  }
 
-    m_threadNeeded.notify_all();
-  } else {
-    boost::mutex::scoped_lock lock(m_mutex);
-    m_threadNeeded.wait(lock);
+  BOOST_FOREACH(Pending &p, pending) {
+    KenLMState &stateCast = static_cast<KenLMState&>(*p.hypo->GetState(statefulInd));
+    FinishScore(system, *p.hypo, stateCast.state, p.state0, p.adjustEnd, p.end,
+                p.score, p.hypo->GetScores());
   }
 }
 
-void KENLMBatch::EvaluateWhenAppliedBatch() const
+void KENLMBatch::ScoreQueries(std::vector<Query> &queries) const
 {
-  BOOST_FOREACH(const Batch *batch, m_batches) {
-    //cerr << "batch=" << batch->size() << endl;
-    BOOST_FOREACH(Hypothesis *hypo, *batch) {
-      hypo->EvaluateWhenApplied(*this);
+  std::sort(queries.begin(), queries.end(), QueryOrderer());
+
+  const size_t num = queries.size();
+  for (size_t i = 0; i < std::min(m_prefetchDistance, num); ++i) {
+    m_ngram->Prefetch(*queries[i].in, queries[i].word);
+  }
+
+  float score = 0;
+  for (size_t i = 0; i < num; ++i) {
+    if (i + m_prefetchDistance < num) {
+      const Query &ahead = queries[i + m_prefetchDistance];
+      m_ngram->Prefetch(*ahead.in, ahead.word);
+    }
+
+    Query &q = queries[i];
+    if (i && queries[i - 1].word == q.word && *queries[i - 1].in == *q.in) {
+      // same n-gram as the previous query. Reuse its result
+      *q.out = *queries[i - 1].out;
+    } else {
+      score = m_ngram->Score(*q.in, q.word, *q.out);
     }
+    *q.score += score;
   }
 }
 
@@ -61,7 +61,14 @@ public:
                                    const SCFG::Hypothesis &hypo, int featureID, Scores &scores,
                                    FFState &state) const;
 
+  //! scores are log probs
+  virtual SCORE GetWhenAppliedUpperBound(const System &system) const {
+    return NonPositiveScoresBound(system);
+  }
+
+  //! score every hypothesis of the batch with interleaved, prefetched n-gram queries
   virtual void EvaluateWhenAppliedBatch(
+    const System &system,
     const Batch &batch) const;
 
 protected:
@@ -86,16 +93,34 @@ protected:
 
   std::vector<lm::WordIndex> m_lmIdLookup;
 
-  // batch
-  mutable std::vector<const Batch*> m_batches;
-  mutable size_t m_numHypos;
-
-  mutable boost::shared_mutex m_accessLock;
-
-  mutable boost::mutex m_mutex;
-  mutable boost::condition_variable m_threadNeeded;
-
-  void EvaluateWhenAppliedBatch() const;
+  // number of queries issued ahead of the one being scored
+  size_t m_prefetchDistance;
+
+  // one hypothesis' progress through its target phrase, in the batch
+  struct Pending {
+    Hypothesis *hypo;
+    const Model::State *prevState;
+    Model::State *state0, *state1;
+    Model::State aux;
+    size_t position, adjustEnd, end;
+    float score;
+  };
+
+  // one n-gram query of the current wave
+  struct Query {
+    uint64_t key;
+    const Model::State *in;
+    lm::WordIndex word;
+    Model::State *out;
+    float *score;
+  };
+
+  void ScoreQueries(std::vector<Query> &queries) const;
+
+  //! sentence end, long phrases, state and OOV handling shared by both paths
+  void FinishScore(const System &system, const Hypothesis &hypo,
+                   Model::State &outState, const Model::State *state0,
+                   size_t adjustEnd, size_t end, float score, Scores &scores) const;
 
 };
 
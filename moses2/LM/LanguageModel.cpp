@@ -5,6 +5,7 @@
  *      Author: hieu
  */
 #include <vector>
+#include <boost/thread.hpp>
 #include "LanguageModel.h"
 #include "../Phrase.h"
 #include "../System.h"
@@ -13,7 +14,6 @@
 #include "../PhraseBased/TargetPhraseImpl.h"
 #include "../FF/PointerState.h"
 #include "../legacy/Util2.h"
-#include "../legacy/InputFileStream.h"
 #include "../legacy/Bitmap.h"
 #include "../legacy/Util2.h"
 
@@ -52,7 +52,9 @@ struct LMState: public PointerState {
 
 ////////////////////////////////////////////////////////////////////////////////////////
 LanguageModel::LanguageModel(size_t startInd, const std::string &line) :
-  StatefulFeatureFunction(startInd, line), m_oov(-100)
+  StatefulFeatureFunction(startInd, line), m_order(0)
+  , m_loadThreads(boost::thread::hardware_concurrency())
+  , m_load(util::POPULATE_OR_READ), m_oov(-100)
 {
   ReadParameters();
 }
@@ -69,42 +71,30 @@ void LanguageModel::Load(System &system)
   m_bos = fc.AddFactor(BOS_, system, false);
   m_eos = fc.AddFactor(EOS_, system, false);
 
-  InputFileStream infile(m_path);
-  size_t lineNum = 0;
-  string line;
-  while (getline(infile, line)) {
-    if (++lineNum % 100000 == 0) {
-      cerr << lineNum << " ";
-    }
-
-    vector<string> substrings = Tokenize(line, "\t");
-
-    if (substrings.size() < 2) continue;
-
-    assert(substrings.size() == 2 || substrings.size() == 3);
-
-    SCORE prob = TransformLMScore(Scan<SCORE>(substrings[0]));
-    if (substrings[1] == "<unk>") {
-      m_oov = prob;
-      continue;
+  if (ArpaTrie::IsBinary(m_path)) {
+    m_trie.LoadBinary(m_path, m_load);
+  } else {
+    m_trie.LoadArpa(m_path, m_loadThreads);
+    if (!m_savePath.empty()) {
+      m_trie.Save(m_savePath);
     }
+  }
+  if (m_order == 0 || m_order > m_trie.GetOrder()) {
+    m_order = m_trie.GetOrder();
+  }
 
-    SCORE backoff = 0.f;
-    if (substrings.size() == 3) {
-      backoff = TransformLMScore(Scan<SCORE>(substrings[2]));
+  // unknown words are scored as <unk>, if the LM has it
+  m_unk = ArpaTrie::NO_WORD;
+  for (uint32_t id = 0; id < m_trie.GetNumWords(); ++id) {
+    const Factor *factor = fc.AddFactor(m_trie.GetWord(id), system, false);
+    if (factor->GetId() >= m_factorToWord.size()) {
+      m_factorToWord.resize(factor->GetId() + 1, ArpaTrie::NO_WORD);
     }
-
-    // ngram
-    vector<string> key = Tokenize(substrings[1], " ");
-
-    vector<const Factor*> factorKey(key.size());
-    for (size_t i = 0; i < key.size(); ++i) {
-      factorKey[factorKey.size() - i - 1] = fc.AddFactor(key[i], system, false);
+    m_factorToWord[factor->GetId()] = id;
+    if (m_trie.GetWord(id) == "<unk>") {
+      m_unk = id;
     }
-
-    m_root.insert(factorKey, LMScores(prob, backoff));
   }
-
 }
 
 void LanguageModel::SetParameter(const std::string& key,
@@ -116,6 +106,24 @@ void LanguageModel::SetParameter(const std::string& key,
     m_factorType = Scan<FactorType>(value);
   } else if (key == "order") {
     m_order = Scan<size_t>(value);
+  } else if (key == "threads") {
+    m_loadThreads = Scan<size_t>(value);
+  } else if (key == "save") {
+    m_savePath = value;
+  } else if (key == "load") {
+    if (value == "lazy") {
+      m_load = util::LAZY;
+    } else if (value == "populate_or_lazy") {
+      m_load = util::POPULATE_OR_LAZY;
+    } else if (value == "populate_or_read" || value == "populate") {
+      m_load = util::POPULATE_OR_READ;
+    } else if (value == "read") {
+      m_load = util::READ;
+    } else if (value == "parallel_read") {
+      m_load = util::PARALLEL_READ;
+    } else {
+      UTIL_THROW2("load method not supported" << value);
+    }
   } else {
     StatefulFeatureFunction::SetParameter(key, value);
   }
@@ -244,64 +252,30 @@ std::pair<SCORE, void*> LanguageModel::Score(
   //cerr << "context=";
   //DebugContext(context);
 
-  std::pair<SCORE, void*> ret;
+  uint32_t *words = (uint32_t*) alloca(context.size() * sizeof(uint32_t));
+  for (size_t i = 0; i < context.size(); ++i) {
+    size_t id = context[i]->GetId();
+    words[i] = id < m_factorToWord.size() ? m_factorToWord[id] : ArpaTrie::NO_WORD;
+    if (words[i] == ArpaTrie::NO_WORD) {
+      words[i] = m_unk;
+    }
+  }
 
-  typedef Node<const Factor*, LMScores> LMNode;
-  const LMNode *node = m_root.getNode(context);
+  std::pair<SCORE, void*> ret;
+  float prob;
+  const ArpaTrie::Node *node = m_trie.Score(words, context.size(), prob);
   if (node) {
-    ret.first = node->getValue().prob;
+    ret.first = TransformLMScore(prob);
     ret.second = (void*) node;
   } else {
-    SCORE backoff = 0;
-    std::vector<const Factor*> backOffContext(context.begin() + 1,
-        context.end());
-    node = m_root.getNode(backOffContext);
-    if (node) {
-      backoff = node->getValue().backoff;
-    }
-
-    std::vector<const Factor*> newContext(context.begin(), context.end() - 1);
-    std::pair<SCORE, void*> newRet = Score(newContext);
-
-    ret.first = backoff + newRet.first;
-    ret.second = newRet.second;
+    ret.first = m_oov;
+    ret.second = NULL;
   }
 
   //cerr << "score=" << ret.first << endl;
   return ret;
 }
 
-SCORE LanguageModel::BackoffScore(
-  const std::vector<const Factor*> &context) const
-{
-  //cerr << "backoff=";
-  //DebugContext(context);
-
-  SCORE ret;
-  size_t stoppedAtInd;
-  const Node<const Factor*, LMScores> &node = m_root.getNode(context,
-      stoppedAtInd);
-
-  if (stoppedAtInd == context.size()) {
-    // found entire ngram
-    ret = node.getValue().backoff;
-  } else {
-    if (stoppedAtInd == 0) {
-      ret = m_oov;
-      stoppedAtInd = 1;
-    } else {
-      ret = node.getValue().backoff;
-    }
-
-    // recursive
-    std::vector<const Factor*> backoff(context.begin() + stoppedAtInd,
-                                       context.end());
-    ret += BackoffScore(backoff);
-  }
-
-  return ret;
-}
-
 void LanguageModel::DebugContext(
   const std::vector<const Factor*> &context) const
 {
@@ -9,33 +9,13 @@
 
 #include "../FF/StatefulFeatureFunction.h"
 #include "../TypeDef.h"
-#include "../InMemoryTrie/InMemoryTrie.h"
+#include "ArpaTrie.h"
 #include "../legacy/Factor.h"
 #include "../legacy/Util2.h"
 
 namespace Moses2
 {
 
-////////////////////////////////////////////////////////////////////////////////////////
-struct LMScores {
-  LMScores() {
-  }
-
-  LMScores(const LMScores &copy) :
-    prob(copy.prob), backoff(copy.backoff) {
-  }
-
-  LMScores(float inProb, float inBackoff) :
-    prob(inProb), backoff(inBackoff) {
-  }
-
-  void Debug(std::ostream &out, const System &system) const {
-    out << "(" << prob << "," << backoff << ")" << std::flush;
-  }
-
-  float prob, backoff;
-};
-
 ////////////////////////////////////////////////////////////////////////////////////////
 class LanguageModel: public StatefulFeatureFunction
 {
@@ -69,12 +49,25 @@ public:
                                    const SCFG::Hypothesis &hypo, int featureID, Scores &scores,
                                    FFState &state) const;
 
+  //! scores are log probs
+  virtual SCORE GetWhenAppliedUpperBound(const System &system) const {
+    return NonPositiveScoresBound(system);
+  }
+
 protected:
   std::string m_path;
   FactorType m_factorType;
   size_t m_order;
 
-  InMemoryTrie<const Factor*, LMScores> m_root;
+  // ARPA files are parsed with this many threads. A binary trie is
+  // mapped with m_load; "save" writes the parsed trie as a binary file
+  size_t m_loadThreads;
+  util::LoadMethod m_load;
+  std::string m_savePath;
+
+  ArpaTrie m_trie;
+  std::vector<uint32_t> m_factorToWord; // factor id -> trie word id
+  uint32_t m_unk;
   SCORE m_oov;
   const Factor *m_bos;
   const Factor *m_eos;
@@ -83,7 +76,6 @@ protected:
                    const Factor *factor) const;
   std::pair<SCORE, void*> Score(
     const std::vector<const Factor*> &context) const;
-  SCORE BackoffScore(const std::vector<const Factor*> &context) const;
 
   void DebugContext(const std::vector<const Factor*> &context) const;
 };
@@ -2,6 +2,7 @@
 #include <memory>
 #include <boost/pool/pool_alloc.hpp>
 #include "Main.h"
+#include "BatchScheduler.h"
 #include "System.h"
 #include "Phrase.h"
 #include "TranslationTask.h"
@@ -39,15 +40,23 @@ int main(int argc, char** argv)
 
   //cerr << "system.numThreads=" << system.options.server.numThreads << endl;
 
-  Moses2::ThreadPool pool(system.options.server.numThreads, system.cpuAffinityOffset, system.cpuAffinityOffsetIncr);
-  //cerr << "CREATED POOL" << endl;
-
   if (params.GetParam("server")) {
     std::cerr << "RUN SERVER" << std::endl;
     run_as_server(system);
+  } else if (system.batchWindow) {
+    std::cerr << "RUN BATCH WITH SCHEDULER" << std::endl;
+    batch_run_scheduled(params, system);
   } else {
+    Moses2::ThreadPool pool(system.options.server.numThreads, system.cpuAffinityOffset, system.cpuAffinityOffsetIncr,
+                            system.numa ? &system.numaStats : NULL);
+    //cerr << "CREATED POOL" << endl;
+
     std::cerr << "RUN BATCH" << std::endl;
+    double start = util::WallTime();
     batch_run(params, system, pool);
+    if (system.numa) {
+      system.numaStats.Output(cerr, util::WallTime() - start);
+    }
   }
 
   cerr << "Decoding took " << timer.get_elapsed_time() << endl;
@@ -101,6 +110,21 @@ void batch_run(Moses2::Parameter &params, Moses2::System &system, Moses2::Thread
   //util::PrintUsage(std::cerr);
 
 }
+////////////////////////////////////////////////////////////////////////////////////////////////
+void batch_run_scheduled(Moses2::Parameter &params, Moses2::System &system)
+{
+  istream &inStream = GetInputStream(params);
+
+  Moses2::BatchScheduler scheduler(system, system.options.server.numThreads,
+                                   system.batchWindow, system.cpuAffinityOffset, system.cpuAffinityOffsetIncr);
+  scheduler.Run(inStream);
+  scheduler.OutputStats(cerr);
+
+  if (&inStream != &cin) {
+    delete &inStream;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 void Temp()
 {
@@ -0,0 +1,118 @@
+/*
+ * Numa.cpp
+ *
+ */
+#ifdef HAVE_NUMA
+#include <numa.h>
+#endif
+#include "Numa.h"
+
+using namespace std;
+
+namespace Moses2
+{
+
+namespace
+{
+std::vector<size_t> FindNodes()
+{
+  std::vector<size_t> ret;
+#ifdef HAVE_NUMA
+  if (numa_available() >= 0) {
+    // node ids can have gaps, and a cpuset can leave out some nodes
+    struct bitmask *mask = numa_get_run_node_mask();
+    for (int node = 0; node <= numa_max_node(); ++node) {
+      if (numa_bitmask_isbitset(mask, node)) {
+        ret.push_back(node);
+      }
+    }
+    numa_bitmask_free(mask);
+  }
+#endif
+  if (ret.empty()) {
+    ret.push_back(0);
+  }
+  return ret;
+}
+}
+
+const std::vector<size_t> &Numa::GetNodes()
+{
+  static const std::vector<size_t> nodes = FindNodes();
+  return nodes;
+}
+
+bool Numa::RunOnNode(size_t node)
+{
+#ifdef HAVE_NUMA
+  if (numa_available() >= 0) {
+    if (numa_run_on_node(node) != 0) {
+      return false;
+    }
+    numa_set_localalloc();
+    return true;
+  }
+#endif
+  return node == 0;
+}
+
+void Numa::InterleaveMemory()
+{
+#ifdef HAVE_NUMA
+  if (numa_available() >= 0 && GetNumNodes() > 1) {
+    numa_set_interleave_mask(numa_all_nodes_ptr);
+  }
+#endif
+}
+
+void Numa::LocalMemory()
+{
+#ifdef HAVE_NUMA
+  if (numa_available() >= 0) {
+    numa_set_localalloc();
+  }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////
+NumaStats::NumaStats()
+{
+  const std::vector<size_t> &ids = Numa::GetNodes();
+  for (size_t i = 0; i < ids.size(); ++i) {
+    Node node = { ids[i], 0, 0 };
+    m_nodes.push_back(node);
+  }
+}
+
+void NumaStats::Add(size_t node, double decodeTime)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  for (size_t i = 0; i < m_nodes.size(); ++i) {
+    if (m_nodes[i].id == node) {
+      ++m_nodes[i].numTasks;
+      m_nodes[i].busyTime += decodeTime;
+      return;
+    }
+  }
+}
+
+std::vector<NumaStats::Node> NumaStats::Get() const
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  return m_nodes;
+}
+
+void NumaStats::Output(std::ostream &out, double wallTime) const
+{
+  std::vector<Node> nodes = Get();
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const Node &node = nodes[i];
+    out << "NUMA node " << node.id << ": " << node.numTasks << " sentences, "
+        << (wallTime > 0 ? node.numTasks / wallTime : 0) << " sentences/s, "
+        << (node.busyTime > 0 ? node.numTasks / node.busyTime : 0)
+        << " sentences per busy thread-second" << endl;
+  }
+}
+
+}
+
@@ -0,0 +1,74 @@
+/*
+ * Numa.h
+ *
+ * Placement of model memory and decoding threads on NUMA machines, enabled
+ * by the numa parameter. Without libnuma, every machine is a single node.
+ */
+#pragma once
+#include <iostream>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+
+namespace Moses2
+{
+
+class Numa
+{
+public:
+  /** ids of the nodes this process may run on, in increasing order. They
+   * needn't be 0 to n-1. Just node 0 if the machine isn't NUMA or moses2 was
+   * built without libnuma
+   */
+  static const std::vector<size_t> &GetNodes();
+
+  static size_t GetNumNodes() {
+    return GetNodes().size();
+  }
+
+  //! node which decoding thread threadInd runs on: threads go round robin
+  static size_t GetThreadNode(size_t threadInd) {
+    const std::vector<size_t> &nodes = GetNodes();
+    return nodes[threadInd % nodes.size()];
+  }
+
+  /** restrict the calling thread to the cpus of node, and allocate its
+   * memory there. Returns false if it couldn't
+   */
+  static bool RunOnNode(size_t node);
+
+  /** pages first touched by the calling thread from now on, including pages
+   * of files it maps, are spread over all nodes. Used while loading models,
+   * so that no node is remote for every thread
+   */
+  static void InterleaveMemory();
+
+  //! undo InterleaveMemory(): allocate on the node the thread runs on
+  static void LocalMemory();
+};
+
+//! sentences decoded by the decoding threads of each node
+class NumaStats
+{
+public:
+  struct Node {
+    size_t id;
+    size_t numTasks;
+    double busyTime;
+  };
+
+  NumaStats();
+
+  //! node is an id from Numa::GetNodes()
+  void Add(size_t node, double decodeTime);
+  std::vector<Node> Get() const;
+
+  //! per node throughput over wallTime seconds
+  void Output(std::ostream &out, double wallTime) const;
+
+protected:
+  mutable boost::mutex m_mutex;
+  std::vector<Node> m_nodes;
+};
+
+}
+
@@ -0,0 +1,73 @@
+/*
+ * Search.cpp
+ *
+ */
+
+#include <boost/foreach.hpp>
+#include "Search.h"
+#include "../Hypothesis.h"
+#include "../Manager.h"
+#include "../../System.h"
+
+using namespace std;
+
+namespace Moses2
+{
+namespace NSBatch
+{
+
+Search::Search(Manager &mgr)
+  :NSNormal::Search(mgr)
+  ,m_batch(mgr.GetPool())
+{
+}
+
+Search::~Search()
+{
+}
+
+void Search::Decode()
+{
+  Start();
+
+  for (size_t stackInd = 0; stackInd < m_stacks.GetSize(); ++stackInd) {
+    const Batch &batch = CollectExtensions(stackInd);
+    if (!batch.empty()) {
+      mgr.system.featureFunctions.EvaluateWhenAppliedBatch(batch);
+    }
+    AddExtensions(stackInd);
+  }
+}
+
+const Batch &Search::CollectExtensions(size_t stackInd)
+{
+  NSNormal::Search::Decode(stackInd);
+  return m_batch;
+}
+
+void Search::AddExtensions(size_t stackInd)
+{
+  BOOST_FOREACH(Hypothesis *hypo, m_batch) {
+    m_stacks.Add(hypo, mgr.GetHypoRecycle(), mgr.arcLists);
+  }
+  m_batch.clear();
+
+  // delete stack to save mem
+  if (stackInd < m_stacks.GetSize() - 1) {
+    m_stacks.Delete(stackInd);
+  }
+}
+
+void Search::Extend(const Hypothesis &hypo, const TargetPhraseImpl &tp,
+                    const InputPath &path, const Bitmap &newBitmap, SCORE estimatedScore)
+{
+  Hypothesis *newHypo = Hypothesis::Create(mgr.GetSystemPool(), mgr);
+  newHypo->Init(mgr, hypo, path, tp, newBitmap, estimatedScore);
+
+  // scored and added to the stacks once the whole stack has been extended
+  m_batch.push_back(newHypo);
+}
+
+}
+}
+
@@ -0,0 +1,47 @@
+/*
+ * Search.h
+ *
+ * Same search as NSNormal but the stateful feature functions see every
+ * extension of a stack at once, through EvaluateWhenAppliedBatch().
+ */
+#pragma once
+
+#include "../Normal/Search.h"
+#include "../../TypeDef.h"
+
+namespace Moses2
+{
+
+namespace NSBatch
+{
+
+class Search: public NSNormal::Search
+{
+public:
+  Search(Manager &mgr);
+  virtual ~Search();
+
+  virtual void Decode();
+
+  /* the steps of Decode(), so that Manager::DecodeTogether() can score the
+   * extensions of several sentences at once: Start(), then for each stack
+   * CollectExtensions(), score them, and AddExtensions()
+   */
+  size_t GetNumStacks() const {
+    return m_stacks.GetSize();
+  }
+  //! the extensions of the hypos of the stack, not scored by the stateful FFs
+  const Batch &CollectExtensions(size_t stackInd);
+  void AddExtensions(size_t stackInd);
+
+protected:
+  Batch m_batch;
+
+  virtual void Extend(const Hypothesis &hypo, const TargetPhraseImpl &tp,
+                      const InputPath &path, const Bitmap &newBitmap, SCORE estimatedScore);
+
+};
+
+}
+}
+
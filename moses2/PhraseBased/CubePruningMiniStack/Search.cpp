@@ -15,6 +15,7 @@
 #include "../../InputPathsBase.h"
 #include "../../InputPathBase.h"
 #include "../../System.h"
+#include "../../FF/StatefulFeatureFunction.h"
 #include "../../TranslationTask.h"
 #include "../../legacy/Util2.h"
 #include "../../PhraseBased/TargetPhrases.h"
@@ -40,7 +41,13 @@ Search::Search(Manager &mgr) :
 
   , m_queueItemRecycler(MemPoolAllocator<QueueItem*>(mgr.GetPool()))
 
+  , m_whenAppliedUpperBound(0)
 {
+  const std::vector<const StatefulFeatureFunction*> &sfffs =
+    mgr.system.featureFunctions.GetStatefulFeatureFunctions();
+  BOOST_FOREACH(const StatefulFeatureFunction *sfff, sfffs) {
+    m_whenAppliedUpperBound += sfff->GetWhenAppliedUpperBound(mgr.system);
+  }
 }
 
 Search::~Search()
@@ -132,12 +139,20 @@ void Search::Decode(size_t stackInd)
     Hypothesis *hypo = item->hypo;
 
     if (mgr.system.options.cube.lazy_scoring) {
-      hypo->EvaluateWhenApplied();
+      // don't score hypos that the stack would discard even if the stateful
+      // features added the most they could to them
+      if (mgr.system.options.cube.early_rejection
+          && m_stack.IsBelowThreshold(*hypo, hypo->GetFutureScore() + m_whenAppliedUpperBound)) {
+        hypoRecycler.Recycle(hypo);
+      } else {
+        hypo->EvaluateWhenApplied();
+        m_stack.Add(hypo, hypoRecycler, mgr.arcLists);
+      }
+    } else {
+      //cerr << "hypo=" << *hypo << " " << hypo->GetBitmap() << endl;
+      m_stack.Add(hypo, hypoRecycler, mgr.arcLists);
     }
 
-    //cerr << "hypo=" << *hypo << " " << hypo->GetBitmap() << endl;
-    m_stack.Add(hypo, hypoRecycler, mgr.arcLists);
-
     edge->CreateNext(mgr, item, m_queue, m_seenPositions, m_queueItemRecycler);
 
     ++pops;
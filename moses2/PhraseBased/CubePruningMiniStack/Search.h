@@ -50,6 +50,9 @@ protected:
 
   QueueItemRecycler m_queueItemRecycler;
 
+  // lazy scoring: most the stateful features can add to a hypo's score
+  SCORE m_whenAppliedUpperBound;
+
   // CUBE PRUNING
   // decoding
   void Decode(size_t stackInd);
@@ -50,6 +50,12 @@ void Stack::Add(Hypothesis *hypo, Recycler<HypothesisBase*> &hypoRecycle,
   coll.Add(m_mgr, hypo, hypoRecycle, arcLists);
 }
 
+bool Stack::IsBelowThreshold(const Hypothesis &hypo, SCORE futureScore)
+{
+  HypoCoverage key(&hypo.GetBitmap(), hypo.GetInputPath().range.GetEndPos());
+  return GetMiniStack(key).IsBelowThreshold(m_mgr, futureScore);
+}
+
 const Hypothesis *Stack::GetBestHypo() const
 {
   SCORE bestScore = -std::numeric_limits<SCORE>::infinity();
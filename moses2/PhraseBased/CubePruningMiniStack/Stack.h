@@ -54,6 +54,9 @@ public:
   void Add(Hypothesis *hypo, Recycler<HypothesisBase*> &hypoRecycle,
            ArcLists &arcLists);
 
+  //! whether Add() would discard hypo if it had this future score
+  bool IsBelowThreshold(const Hypothesis &hypo, SCORE futureScore);
+
   Moses2::HypothesisColl &GetMiniStack(const HypoCoverage &key);
 
   const Hypothesis *GetBestHypo() const;
@@ -4,6 +4,7 @@
  *  Created on: 23 Oct 2015
  *      Author: hieu
  */
+#include <algorithm>
 #include <boost/foreach.hpp>
 #include <boost/functional/hash.hpp>
 #include <boost/unordered_set.hpp>
@@ -15,6 +16,7 @@
 #include "Sentence.h"
 
 #include "Normal/Search.h"
+#include "Batch/Search.h"
 #include "CubePruningMiniStack/Search.h"
 
 /*
@@ -94,8 +96,7 @@ void Manager::Init()
     m_search = new NSNormal::Search(*this);
     break;
   case NormalBatch:
-    //m_search = new NSBatch::Search(*this);
-    UTIL_THROW2("Not implemented");
+    m_search = new NSBatch::Search(*this);
     break;
   case CubePruning:
   case CubePruningMiniStack:
@@ -130,6 +131,49 @@ void Manager::Decode()
   //cerr << "Finished Decode " << this << endl;
 }
 
+void Manager::DecodeTogether(const std::vector<Manager*> &mgrs)
+{
+  if (mgrs.size() < 2 || mgrs[0]->system.options.search.algo != NormalBatch) {
+    BOOST_FOREACH(Manager *mgr, mgrs) {
+      mgr->Decode();
+    }
+    return;
+  }
+
+  std::vector<NSBatch::Search*> searches;
+  size_t numStacks = 0;
+  BOOST_FOREACH(Manager *mgr, mgrs) {
+    mgr->Init();
+    NSBatch::Search *search = static_cast<NSBatch::Search*>(mgr->m_search);
+    search->Start();
+    numStacks = std::max(numStacks, search->GetNumStacks());
+    searches.push_back(search);
+  }
+
+  // the extensions of the same stack of every sentence
+  MemPool pool;
+  Batch batch(pool);
+  for (size_t stackInd = 0; stackInd < numStacks; ++stackInd) {
+    batch.clear();
+    BOOST_FOREACH(NSBatch::Search *search, searches) {
+      if (stackInd < search->GetNumStacks()) {
+        const Batch &extensions = search->CollectExtensions(stackInd);
+        batch.insert(batch.end(), extensions.begin(), extensions.end());
+      }
+    }
+
+    if (!batch.empty()) {
+      mgrs[0]->system.featureFunctions.EvaluateWhenAppliedBatch(batch);
+    }
+
+    BOOST_FOREACH(NSBatch::Search *search, searches) {
+      if (stackInd < search->GetNumStacks()) {
+        search->AddExtensions(stackInd);
+      }
+    }
+  }
+}
+
 void Manager::CalcFutureScore()
 {
   const Sentence &sentence = static_cast<const Sentence&>(GetInput());
@@ -253,7 +297,10 @@ std::string Manager::OutputNBest()
       ok = true;
     }
 
-    if (ok) {
+    if (ok && system.nbestWriter) {
+      ++bestInd;
+      path->OutputToBinary(out, transId, system);
+    } else if (ok) {
       ++bestInd;
       out << transId << " ||| ";
       path->OutputToStream(out, system);
@@ -11,6 +11,7 @@
 #include <cstddef>
 #include <string>
 #include <deque>
+#include <vector>
 #include "../ManagerBase.h"
 #include "../Phrase.h"
 #include "../TargetPhrase.h"
@@ -58,6 +59,15 @@ public:
   }
 
   void Decode();
+
+  /** decodes the sentences in lockstep, stack by stack, so that the stateful
+   * feature functions score the extensions of all of them at once. Only the
+   * NormalBatch search can, the others decode one sentence after another.
+   * They share the pools of the calling thread, so none may be deleted
+   * before the output of all of them has been taken
+   */
+  static void DecodeTogether(const std::vector<Manager*> &mgrs);
+
   std::string OutputBest() const;
   std::string OutputNBest();
   std::string OutputTransOpt();
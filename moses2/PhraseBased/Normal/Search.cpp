@@ -38,7 +38,7 @@ Search::~Search()
   // TODO Auto-generated destructor stub
 }
 
-void Search::Decode()
+void Search::Start()
 {
   // init stacks
   const Sentence &sentence = static_cast<const Sentence&>(mgr.GetInput());
@@ -51,6 +51,11 @@ void Search::Decode()
   initHypo->EmptyHypothesisState(mgr.GetInput());
 
   m_stacks.Add(initHypo, mgr.GetHypoRecycle(), mgr.arcLists);
+}
+
+void Search::Decode()
+{
+  Start();
 
   for (size_t stackInd = 0; stackInd < m_stacks.GetSize(); ++stackInd) {
     Decode(stackInd);
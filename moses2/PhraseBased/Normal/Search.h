@@ -33,17 +33,20 @@ public:
   virtual void Decode();
   const Hypothesis *GetBestHypo() const;
 
+  //! stacks for the sentence, with the empty hypothesis in the first one
+  void Start();
+
   void AddInitialTrellisPaths(TrellisPaths<TrellisPath> &paths) const;
 
 protected:
   Stacks m_stacks;
 
-  void Decode(size_t stackInd);
+  virtual void Decode(size_t stackInd);
   void Extend(const Hypothesis &hypo, const InputPath &path);
   void Extend(const Hypothesis &hypo, const TargetPhrases &tps,
               const InputPath &path, const Bitmap &newBitmap, SCORE estimatedScore);
-  void Extend(const Hypothesis &hypo, const TargetPhraseImpl &tp,
-              const InputPath &path, const Bitmap &newBitmap, SCORE estimatedScore);
+  virtual void Extend(const Hypothesis &hypo, const TargetPhraseImpl &tp,
+                      const InputPath &path, const Bitmap &newBitmap, SCORE estimatedScore);
 
 };
 
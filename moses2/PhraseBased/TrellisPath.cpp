@@ -12,6 +12,7 @@
 #include "../TrellisPaths.h"
 #include "../System.h"
 #include "../SubPhrase.h"
+#include "moses/BinaryNBest.h"
 
 using namespace std;
 
@@ -103,6 +104,15 @@ void TrellisPath::OutputToStream(std::ostream &out, const System &system) const
   out << GetScores().GetTotalScore();
 }
 
+void TrellisPath::OutputToBinary(std::ostream &out, long translationId, const System &system) const
+{
+  std::vector<SCORE> values;
+  GetScores().GetBreakdown(values, system);
+  system.nbestWriter->Write(out, translationId, OutputTargetPhrase(system), values,
+                            std::vector<std::pair<std::string, float> >(),
+                            GetScores().GetTotalScore(), StringPiece());
+}
+
 std::string TrellisPath::OutputTargetPhrase(const System &system) const
 {
   std::stringstream out;
@@ -66,6 +66,8 @@ public:
   std::string Debug(const System &system) const;
 
   void OutputToStream(std::ostream &out, const System &system) const;
+  //! the path as a record of the binary n-best list, see System::nbestWriter
+  void OutputToBinary(std::ostream &out, long translationId, const System &system) const;
   std::string OutputTargetPhrase(const System &system) const;
 
   //! create a set of next best paths by wiggling 1 of the node at a time.
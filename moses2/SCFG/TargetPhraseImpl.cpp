@@ -50,11 +50,7 @@ TargetPhraseImpl::TargetPhraseImpl(MemPool &pool,
                                    size_t size)
   :Moses2::TargetPhrase<SCFG::Word>(pool, pt, system, size)
   ,m_alignNonTerm(&AlignmentInfoCollection::Instance().GetEmptyAlignmentInfo())
-
 {
-  m_scores = new (pool.Allocate<Scores>()) Scores(system, pool,
-      system.featureFunctions.GetNumScores());
-
 }
 
 TargetPhraseImpl::~TargetPhraseImpl()
@@ -15,6 +15,7 @@
 #include "../../System.h"
 #include "../../Scores.h"
 #include "../../legacy/Util2.h"
+#include "moses/BinaryNBest.h"
 
 using namespace std;
 
@@ -50,9 +51,20 @@ void KBestExtractor::OutputToStream(std::stringstream &strm)
   const ArcList &arcList = arcLists.GetArcList(hypo);
   NBests &nbests = m_nbestColl.GetOrCreateNBests(m_mgr, arcList);
 
+  std::vector<SCORE> values;
   size_t ind = 0;
   while (nbests.Extend(m_mgr, m_nbestColl, ind)) {
     const NBest &deriv = nbests.Get(ind);
+    if (m_mgr.system.nbestWriter) {
+      deriv.GetScores().GetBreakdown(values, m_mgr.system);
+      m_mgr.system.nbestWriter->Write(strm, m_mgr.GetTranslationId(),
+                                      deriv.GetStringExclSentenceMarkers(), values,
+                                      std::vector<std::pair<std::string, float> >(),
+                                      deriv.GetScores().GetTotalScore(), StringPiece());
+      ++ind;
+      continue;
+    }
+
     strm << m_mgr.GetTranslationId() << " ||| ";
     //cerr << "1" << flush;
     strm << deriv.GetStringExclSentenceMarkers();
@@ -246,6 +246,17 @@ void Scores::OutputBreakdown(std::ostream &out, const System &system) const
   }
 }
 
+void Scores::GetBreakdown(std::vector<SCORE> &values, const System &system) const
+{
+  values.clear();
+  BOOST_FOREACH(const FeatureFunction *ff, system.featureFunctions.GetFeatureFunctions()) {
+    if (ff->IsTuneable()) {
+      values.insert(values.end(), m_scores + ff->GetStartInd(),
+                    m_scores + ff->GetStartInd() + ff->GetNumScores());
+    }
+  }
+}
+
 // static functions to work out estimated scores
 SCORE Scores::CalcWeightedScore(const System &system,
                                 const FeatureFunction &featureFunction, SCORE scores[])
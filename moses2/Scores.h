@@ -64,6 +64,8 @@ public:
   std::string Debug(const System &system) const;
 
   void OutputBreakdown(std::ostream &out, const System &system) const;
+  //! the values OutputBreakdown() prints, for the binary n-best list
+  void GetBreakdown(std::vector<SCORE> &values, const System &system) const;
 
   // static functions to work out estimated scores
   static SCORE CalcWeightedScore(const System &system,
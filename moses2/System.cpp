@@ -6,6 +6,7 @@
  */
 #include <string>
 #include <iostream>
+#include <fstream>
 #include <boost/foreach.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
@@ -14,6 +15,7 @@
 #include "TranslationModel/UnknownWordPenalty.h"
 #include "legacy/Util2.h"
 #include "util/exception.hh"
+#include "moses/BinaryNBest.h"
 
 using namespace std;
 
@@ -30,19 +32,36 @@ System::System(const Parameter &paramsArg) :
 
   params.SetParameter(cpuAffinityOffset, "cpu-affinity-offset", -1);
   params.SetParameter(cpuAffinityOffsetIncr, "cpu-affinity-increment", 1);
+  params.SetParameter<size_t>(batchWindow, "batch-window", 0);
+  params.SetParameter(numa, "numa", false);
 
   const PARAM_VEC *section;
 
   // output collectors
-  if (options.nbest.nbest_size) {
-    nbestCollector.reset(new OutputCollector(options.nbest.output_file_path));
-  }
-
   if (!options.output.detailed_transrep_filepath.empty()) {
     detailedTranslationCollector.reset(new OutputCollector(options.output.detailed_transrep_filepath));
   }
 
   featureFunctions.Create();
+
+  // after the feature functions, which name the values of the binary n-best list
+  if (options.nbest.nbest_size && options.nbest.binary) {
+    const std::string &path = options.nbest.output_file_path;
+    nbestStream.reset(new std::ofstream(path.c_str(), std::ios::out | std::ios::binary));
+    UTIL_THROW_IF2(!nbestStream->good(), "Failed to open binary n-best file " << path);
+
+    // same values as Scores::OutputBreakdown()
+    std::vector<std::pair<std::string, size_t> > labels;
+    BOOST_FOREACH(const FeatureFunction *ff, featureFunctions.GetFeatureFunctions()) {
+      if (ff->IsTuneable()) {
+        labels.push_back(std::make_pair(ff->GetName(), ff->GetNumScores()));
+      }
+    }
+    nbestWriter.reset(new Moses::BinaryNBestWriter(*nbestStream, labels));
+    nbestCollector.reset(new OutputCollector(nbestStream.get()));
+  } else if (options.nbest.nbest_size) {
+    nbestCollector.reset(new OutputCollector(options.nbest.output_file_path));
+  }
   LoadWeights();
 
   if (params.GetParam("show-weights")) {
@@ -51,11 +70,22 @@ System::System(const Parameter &paramsArg) :
     //return;
   }
 
+  // models are read by every decoding thread. Spread them over the nodes
+  // rather than leave them all on the node of the loading thread
+  if (numa) {
+    cerr << "Interleaving models over " << Numa::GetNumNodes() << " NUMA nodes" << endl;
+    Numa::InterleaveMemory();
+  }
+
   cerr << "START featureFunctions.Load()" << endl;
   featureFunctions.Load();
   cerr << "START LoadMappings()" << endl;
   LoadMappings();
   cerr << "END LoadMappings()" << endl;
+
+  if (numa) {
+    Numa::LocalMemory();
+  }
   LoadDecodeGraphBackoff();
   cerr << "END LoadDecodeGraphBackoff()" << endl;
 
@@ -14,6 +14,7 @@
 #include "FF/FeatureFunctions.h"
 #include "Weights.h"
 #include "MemPool.h"
+#include "Numa.h"
 #include "Recycler.h"
 #include "legacy/FactorCollection.h"
 #include "legacy/Parameter.h"
@@ -22,6 +23,11 @@
 #include "legacy/OutputCollector.h"
 #include "parameters/AllOptions.h"
 
+namespace Moses
+{
+class BinaryNBestWriter;
+}
+
 namespace Moses2
 {
 namespace NSCubePruning
@@ -46,11 +52,19 @@ public:
   std::vector<size_t> maxChartSpans;
   bool isPb;
 
+  // binary n-best output, outlives the collector writing to it
+  boost::shared_ptr<std::ostream> nbestStream;
+  boost::shared_ptr<Moses::BinaryNBestWriter> nbestWriter;
   mutable boost::shared_ptr<OutputCollector> bestCollector, nbestCollector, detailedTranslationCollector;
 
   // moses.ini params
   int cpuAffinityOffset;
   int cpuAffinityOffsetIncr;
+  size_t batchWindow;
+  bool numa;
+
+  // filled by the decoding threads if numa is set
+  mutable NumaStats numaStats;
 
   System(const Parameter &paramsArg);
   virtual ~System();
@@ -0,0 +1,442 @@
+// $Id$
+// vim:tabstop=2
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#include <set>
+
+#include "PhraseDecoder.h"
+#include "PhraseTableCompact.h"
+#include "../../System.h"
+#include "../../SubPhrase.h"
+#include "../../AlignmentInfoCollection.h"
+#include "../../legacy/FactorCollection.h"
+#include "../../legacy/Util2.h"
+#include "util/exception.hh"
+
+using namespace std;
+
+namespace Moses2
+{
+
+PhraseDecoder::PhraseDecoder(const PhraseTableCompact &phraseTable,
+                             const std::vector<FactorType> &input,
+                             const std::vector<FactorType> &output,
+                             size_t numScoreComponent,
+                             size_t cacheSize)
+  : m_coding(None), m_numScoreComponent(numScoreComponent),
+    m_containsAlignmentInfo(true), m_maxRank(0), m_maxPhraseLength(0),
+    m_symbolTree(0), m_multipleScoreTrees(false),
+    m_scoreTrees(1), m_alignTree(0),
+    m_decodingCache(cacheSize),
+    m_phraseTable(phraseTable), m_input(input), m_output(output),
+    m_separator(" ||| ")
+{ }
+
+PhraseDecoder::~PhraseDecoder()
+{
+  delete m_symbolTree;
+
+  for(size_t i = 0; i < m_scoreTrees.size(); i++)
+    delete m_scoreTrees[i];
+
+  delete m_alignTree;
+}
+
+inline unsigned PhraseDecoder::GetSourceSymbolId(const std::string& symbol) const
+{
+  boost::unordered_map<std::string, unsigned>::const_iterator it
+  = m_sourceSymbolsMap.find(symbol);
+  if(it != m_sourceSymbolsMap.end())
+    return it->second;
+  return m_sourceSymbols.size();
+}
+
+inline size_t PhraseDecoder::GetREncType(unsigned encodedSymbol) const
+{
+  return (encodedSymbol >> 30) + 1;
+}
+
+inline size_t PhraseDecoder::GetPREncType(unsigned encodedSymbol) const
+{
+  return (encodedSymbol >> 31) + 1;
+}
+
+inline bool PhraseDecoder::GetTranslation(unsigned srcIdx, size_t rank, unsigned &trgIdx) const
+{
+  if(srcIdx >= m_lexicalTableIndex.size())
+    return false;
+  size_t srcTrgIdx = m_lexicalTableIndex[srcIdx] + rank;
+  if(srcTrgIdx >= m_lexicalTable.size())
+    return false;
+  trgIdx = m_lexicalTable[srcTrgIdx].second;
+  return true;
+}
+
+inline unsigned PhraseDecoder::DecodeREncSymbol1(unsigned encodedSymbol) const
+{
+  return encodedSymbol &= ~(3 << 30);
+}
+
+inline unsigned PhraseDecoder::DecodeREncSymbol2Rank(unsigned encodedSymbol) const
+{
+  return encodedSymbol &= ~(255 << 24);
+}
+
+inline unsigned PhraseDecoder::DecodeREncSymbol2Position(unsigned encodedSymbol) const
+{
+  encodedSymbol &= ~(3 << 30);
+  encodedSymbol >>= 24;
+  return encodedSymbol;
+}
+
+inline unsigned PhraseDecoder::DecodeREncSymbol3(unsigned encodedSymbol) const
+{
+  return encodedSymbol &= ~(3 << 30);
+}
+
+inline unsigned PhraseDecoder::DecodePREncSymbol1(unsigned encodedSymbol) const
+{
+  return encodedSymbol &= ~(1 << 31);
+}
+
+inline int PhraseDecoder::DecodePREncSymbol2Left(unsigned encodedSymbol) const
+{
+  return ((encodedSymbol >> 25) & 63) - 32;
+}
+
+inline int PhraseDecoder::DecodePREncSymbol2Right(unsigned encodedSymbol) const
+{
+  return ((encodedSymbol >> 19) & 63) - 32;
+}
+
+inline unsigned PhraseDecoder::DecodePREncSymbol2Rank(unsigned encodedSymbol) const
+{
+  return (encodedSymbol & 524287);
+}
+
+size_t PhraseDecoder::Load(System &system, std::FILE* in)
+{
+  size_t start = std::ftell(in);
+  size_t read = 0;
+
+  read += std::fread(&m_coding, sizeof(m_coding), 1, in);
+  size_t numScoreComponent;
+  read += std::fread(&numScoreComponent, sizeof(numScoreComponent), 1, in);
+  UTIL_THROW_IF2(numScoreComponent != m_numScoreComponent,
+                 "Phrase table has " << numScoreComponent << " scores, "
+                 << m_numScoreComponent << " expected");
+  read += std::fread(&m_containsAlignmentInfo, sizeof(m_containsAlignmentInfo), 1, in);
+  read += std::fread(&m_maxRank, sizeof(m_maxRank), 1, in);
+  read += std::fread(&m_maxPhraseLength, sizeof(m_maxPhraseLength), 1, in);
+
+  if(m_coding == REnc) {
+    m_sourceSymbols.load(in);
+    for(size_t i = 0; i < m_sourceSymbols.size(); ++i)
+      m_sourceSymbolsMap[m_sourceSymbols[i].str()] = i;
+
+    size_t size;
+    read += std::fread(&size, sizeof(size_t), 1, in);
+    m_lexicalTableIndex.resize(size);
+    read += std::fread(&m_lexicalTableIndex[0], sizeof(size_t), size, in);
+
+    read += std::fread(&size, sizeof(size_t), 1, in);
+    m_lexicalTable.resize(size);
+    read += std::fread(&m_lexicalTable[0], sizeof(SrcTrg), size, in);
+  }
+
+  // resolve all target symbols now, decoding then only copies words
+  StringVector<unsigned char, unsigned, std::allocator> targetSymbols;
+  targetSymbols.load(in);
+  FactorCollection &vocab = system.GetVocab();
+  m_targetWords.resize(targetSymbols.size());
+  for(size_t i = 0; i < targetSymbols.size(); ++i) {
+    std::vector<std::string> toks = Tokenize(targetSymbols[i].str(), "|");
+    for(size_t j = 0; j < toks.size() && j < m_output.size(); ++j)
+      m_targetWords[i][m_output[j]] = vocab.AddFactor(toks[j], system, false);
+  }
+
+  m_symbolTree = new CanonicalHuffman<unsigned>(in);
+
+  read += std::fread(&m_multipleScoreTrees, sizeof(m_multipleScoreTrees), 1, in);
+  if(m_multipleScoreTrees) {
+    m_scoreTrees.resize(m_numScoreComponent);
+    for(size_t i = 0; i < m_numScoreComponent; i++)
+      m_scoreTrees[i] = new CanonicalHuffman<float>(in);
+  } else {
+    m_scoreTrees.resize(1);
+    m_scoreTrees[0] = new CanonicalHuffman<float>(in);
+  }
+
+  if(m_containsAlignmentInfo)
+    m_alignTree = new CanonicalHuffman<AlignPoint>(in);
+
+  size_t end = std::ftell(in);
+  return end - start;
+}
+
+std::string PhraseDecoder::GetWordString(const Word &word,
+    const std::vector<FactorType> &factors) const
+{
+  std::string ret = word[factors[0]]->GetString().as_string();
+  for(size_t i = 1; i < factors.size(); ++i) {
+    ret += "|";
+    ret += word[factors[i]]->GetString().as_string();
+  }
+  return ret;
+}
+
+std::string PhraseDecoder::MakeSourceKey(const Phrase<Word> &sourcePhrase) const
+{
+  std::string key;
+  for(size_t i = 0; i < sourcePhrase.GetSize(); ++i) {
+    if(i)
+      key += " ";
+    key += GetWordString(sourcePhrase[i], m_input);
+  }
+  return key + m_separator;
+}
+
+TargetPhraseVectorPtr PhraseDecoder::CreateTargetPhraseCollection(
+  const Phrase<Word> &sourcePhrase, bool topLevel) const
+{
+  TargetPhraseVectorPtr tpv(new TargetPhraseVector());
+  size_t bitsLeft = 0;
+
+  if(m_coding == PREnc) {
+    std::pair<TargetPhraseVectorPtr, size_t> cachedPhraseColl
+    = m_decodingCache.Retrieve(sourcePhrase);
+
+    // Has been cached and is complete or does not need to be completed
+    if(cachedPhraseColl.first != NULL && (!topLevel || cachedPhraseColl.second == 0))
+      return cachedPhraseColl.first;
+
+    // Has been cached, but is incomplete
+    else if(cachedPhraseColl.first != NULL) {
+      bitsLeft = cachedPhraseColl.second;
+      tpv->assign(cachedPhraseColl.first->begin(), cachedPhraseColl.first->end());
+    }
+  }
+
+  // Retrieve source phrase identifier
+  size_t sourcePhraseId = m_phraseTable.m_hash[MakeSourceKey(sourcePhrase)];
+  if(sourcePhraseId == m_phraseTable.m_hash.GetSize())
+    return TargetPhraseVectorPtr();
+
+  // Retrieve compressed and encoded target phrase collection
+  std::string encodedPhraseCollection;
+  if(m_phraseTable.m_inMemory)
+    encodedPhraseCollection = m_phraseTable.m_targetPhrasesMemory[sourcePhraseId].str();
+  else
+    encodedPhraseCollection = m_phraseTable.m_targetPhrasesMapped[sourcePhraseId].str();
+
+  BitWrapper<> encodedBitStream(encodedPhraseCollection);
+  if(m_coding == PREnc && bitsLeft)
+    encodedBitStream.SeekFromEnd(bitsLeft);
+
+  // Decompress and decode target phrase collection
+  return DecodeCollection(tpv, encodedBitStream, sourcePhrase, topLevel);
+}
+
+TargetPhraseVectorPtr PhraseDecoder::DecodeCollection(
+  TargetPhraseVectorPtr tpv, BitWrapper<> &encodedBitStream,
+  const Phrase<Word> &sourcePhrase, bool topLevel) const
+{
+  bool extending = tpv->size();
+  size_t bitsLeft = encodedBitStream.TellFromEnd();
+
+  std::vector<unsigned> sourceWords;
+  if(m_coding == REnc) {
+    for(size_t i = 0; i < sourcePhrase.GetSize(); i++)
+      sourceWords.push_back(GetSourceSymbolId(GetWordString(sourcePhrase[i], m_input)));
+  }
+
+  unsigned phraseStopSymbol = 0;
+  AlignPoint alignStopSymbol(-1, -1);
+
+  std::set<AlignPointSizeT> alignment;
+  const bool useAlignment = m_phraseTable.m_useAlignmentInfo;
+
+  enum DecodeState { New, Symbol, Score, Alignment, Add } state = New;
+
+  size_t srcSize = sourcePhrase.GetSize();
+
+  TPCompact* targetPhrase = NULL;
+  while(encodedBitStream.TellFromEnd()) {
+
+    if(state == New) {
+      tpv->push_back(TPCompact());
+      targetPhrase = &tpv->back();
+      targetPhrase->scores.reserve(m_numScoreComponent);
+
+      alignment.clear();
+
+      state = Symbol;
+    }
+
+    if(state == Symbol) {
+      unsigned symbol = m_symbolTree->Read(encodedBitStream);
+      if(symbol == phraseStopSymbol) {
+        state = Score;
+      } else {
+        std::vector<Word> &words = targetPhrase->words;
+        unsigned trgIdx = symbol;
+
+        if(m_coding == REnc) {
+          size_t type = GetREncType(symbol);
+
+          if(type == 1) {
+            trgIdx = DecodeREncSymbol1(symbol);
+          } else if (type == 2) {
+            size_t rank = DecodeREncSymbol2Rank(symbol);
+            size_t srcPos = DecodeREncSymbol2Position(symbol);
+
+            if(srcPos >= sourceWords.size()
+                || !GetTranslation(sourceWords[srcPos], rank, trgIdx))
+              return TargetPhraseVectorPtr();
+
+            if(useAlignment)
+              alignment.insert(AlignPointSizeT(srcPos, words.size()));
+          } else if(type == 3) {
+            size_t rank = DecodeREncSymbol3(symbol);
+            size_t srcPos = words.size();
+
+            if(srcPos >= sourceWords.size()
+                || !GetTranslation(sourceWords[srcPos], rank, trgIdx))
+              return TargetPhraseVectorPtr();
+
+            if(useAlignment)
+              alignment.insert(AlignPointSizeT(srcPos, srcPos));
+          }
+        } else if(m_coding == PREnc) {
+          // if the symbol is just a word
+          if(GetPREncType(symbol) == 1) {
+            trgIdx = DecodePREncSymbol1(symbol);
+          }
+          // if the symbol is a subphrase pointer
+          else {
+            int left = DecodePREncSymbol2Left(symbol);
+            int right = DecodePREncSymbol2Right(symbol);
+            unsigned rank = DecodePREncSymbol2Rank(symbol);
+
+            int srcStart = left + words.size();
+            int srcEnd   = srcSize - right - 1;
+
+            // false positive consistency check
+            if(0 > srcStart || srcStart > srcEnd || unsigned(srcEnd) >= srcSize)
+              return TargetPhraseVectorPtr();
+
+            // false positive consistency check
+            if(m_maxRank && rank > m_maxRank)
+              return TargetPhraseVectorPtr();
+
+            // set subphrase by default to itself
+            TargetPhraseVectorPtr subTpv = tpv;
+
+            // if range smaller than source phrase retrieve subphrase
+            if(unsigned(srcEnd - srcStart + 1) != srcSize) {
+              SubPhrase<Word> subPhrase = sourcePhrase.GetSubPhrase(srcStart, srcEnd - srcStart + 1);
+              subTpv = CreateTargetPhraseCollection(subPhrase, false);
+            } else {
+              // false positive consistency check
+              if(rank >= tpv->size()-1)
+                return TargetPhraseVectorPtr();
+            }
+
+            // false positive consistency check
+            if(subTpv == NULL || rank >= subTpv->size())
+              return TargetPhraseVectorPtr();
+
+            // insert the subphrase into the main target phrase
+            const TPCompact& subTp = subTpv->at(rank);
+            if(useAlignment && subTp.alignment) {
+              // reconstruct the alignment data based on the alignment of the subphrase
+              for(AlignmentInfo::const_iterator it = subTp.alignment->begin();
+                  it != subTp.alignment->end(); it++) {
+                alignment.insert(AlignPointSizeT(srcStart + it->first,
+                                                 words.size() + it->second));
+              }
+            }
+            // subTp may live in *tpv, copy before growing words
+            std::vector<Word> subWords(subTp.words);
+            words.insert(words.end(), subWords.begin(), subWords.end());
+            continue;
+          }
+        }
+
+        if(trgIdx >= m_targetWords.size())
+          return TargetPhraseVectorPtr();
+        words.push_back(m_targetWords[trgIdx]);
+      }
+    } else if(state == Score) {
+      size_t idx = m_multipleScoreTrees ? targetPhrase->scores.size() : 0;
+      float score = m_scoreTrees[idx]->Read(encodedBitStream);
+      targetPhrase->scores.push_back(score);
+
+      if(targetPhrase->scores.size() == m_numScoreComponent) {
+        if(m_containsAlignmentInfo)
+          state = Alignment;
+        else
+          state = Add;
+      }
+    } else if(state == Alignment) {
+      AlignPoint alignPoint = m_alignTree->Read(encodedBitStream);
+      if(alignPoint == alignStopSymbol) {
+        state = Add;
+      } else {
+        if(useAlignment)
+          alignment.insert(AlignPointSizeT(alignPoint));
+      }
+    }
+
+    if(state == Add) {
+      if(useAlignment) {
+        size_t targetSize = targetPhrase->words.size();
+        for(std::set<AlignPointSizeT>::iterator it = alignment.begin(); it != alignment.end(); it++) {
+          if(it->first >= srcSize || it->second >= targetSize)
+            return TargetPhraseVectorPtr();
+        }
+        targetPhrase->alignment = AlignmentInfoCollection::Instance().Add(alignment);
+      }
+
+      if(m_coding == PREnc) {
+        if(!m_maxRank || tpv->size() <= m_maxRank)
+          bitsLeft = encodedBitStream.TellFromEnd();
+
+        if(!topLevel && m_maxRank && tpv->size() >= m_maxRank)
+          break;
+      }
+
+      if(encodedBitStream.TellFromEnd() <= 8)
+        break;
+
+      state = New;
+    }
+  }
+
+  if(m_coding == PREnc && !extending) {
+    bitsLeft = bitsLeft > 8 ? bitsLeft : 0;
+    m_decodingCache.Cache(sourcePhrase, tpv, bitsLeft, m_maxRank);
+  }
+
+  return tpv;
+}
+
+}
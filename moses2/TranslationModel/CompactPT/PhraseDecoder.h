@@ -0,0 +1,135 @@
+// $Id$
+// vim:tabstop=2
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+#include "../../TypeDef.h"
+#include "../../Word.h"
+#include "../../Phrase.h"
+#include "StringVector.h"
+#include "CanonicalHuffman.h"
+#include "TargetPhraseCollectionCache.h"
+
+namespace Moses2
+{
+
+class System;
+class PhraseTableCompact;
+
+/** Decodes the target phrase collections of a .minphr file, as written by
+ * processPhraseTableMin, into TPCompact vectors. Decoded collections are
+ * kept in a cache shared by all threads; with PREnc coding they are also
+ * the collections that later phrases refer to by rank. Nothing is
+ * modified after loading, so one decoder serves all threads.
+ **/
+class PhraseDecoder
+{
+protected:
+  typedef std::pair<unsigned char, unsigned char> AlignPoint;
+  typedef std::pair<unsigned, unsigned> SrcTrg;
+  typedef std::pair<size_t, size_t> AlignPointSizeT;
+
+  enum Coding { None, REnc, PREnc } m_coding;
+
+  size_t m_numScoreComponent;
+  bool m_containsAlignmentInfo;
+  size_t m_maxRank;
+  size_t m_maxPhraseLength;
+
+  boost::unordered_map<std::string, unsigned> m_sourceSymbolsMap;
+  StringVector<unsigned char, unsigned, std::allocator> m_sourceSymbols;
+
+  // target symbols, resolved to factors when loading
+  std::vector<Word> m_targetWords;
+
+  std::vector<size_t> m_lexicalTableIndex;
+  std::vector<SrcTrg> m_lexicalTable;
+
+  CanonicalHuffman<unsigned>* m_symbolTree;
+
+  bool m_multipleScoreTrees;
+  std::vector<CanonicalHuffman<float>*> m_scoreTrees;
+
+  CanonicalHuffman<AlignPoint>* m_alignTree;
+
+  mutable TargetPhraseCollectionCache m_decodingCache;
+
+  const PhraseTableCompact &m_phraseTable;
+
+  const std::vector<FactorType> &m_input;
+  const std::vector<FactorType> &m_output;
+
+  std::string m_separator;
+
+  unsigned GetSourceSymbolId(const std::string& s) const;
+
+  size_t GetREncType(unsigned encodedSymbol) const;
+  size_t GetPREncType(unsigned encodedSymbol) const;
+
+  bool GetTranslation(unsigned srcIdx, size_t rank, unsigned &trgIdx) const;
+
+  unsigned DecodeREncSymbol1(unsigned encodedSymbol) const;
+  unsigned DecodeREncSymbol2Rank(unsigned encodedSymbol) const;
+  unsigned DecodeREncSymbol2Position(unsigned encodedSymbol) const;
+  unsigned DecodeREncSymbol3(unsigned encodedSymbol) const;
+
+  unsigned DecodePREncSymbol1(unsigned encodedSymbol) const;
+  int DecodePREncSymbol2Left(unsigned encodedSymbol) const;
+  int DecodePREncSymbol2Right(unsigned encodedSymbol) const;
+  unsigned DecodePREncSymbol2Rank(unsigned encodedSymbol) const;
+
+  std::string GetWordString(const Word &word, const std::vector<FactorType> &factors) const;
+  std::string MakeSourceKey(const Phrase<Word> &sourcePhrase) const;
+
+  TargetPhraseVectorPtr DecodeCollection(TargetPhraseVectorPtr tpv,
+                                         BitWrapper<> &encodedBitStream,
+                                         const Phrase<Word> &sourcePhrase,
+                                         bool topLevel) const;
+
+public:
+  PhraseDecoder(const PhraseTableCompact &phraseTable,
+                const std::vector<FactorType> &input,
+                const std::vector<FactorType> &output,
+                size_t numScoreComponent,
+                size_t cacheSize);
+
+  ~PhraseDecoder();
+
+  size_t Load(System &system, std::FILE* in);
+
+  size_t GetMaxSourcePhraseLength() const {
+    return m_maxPhraseLength;
+  }
+
+  /** all translations of sourcePhrase, or an empty pointer if there are none.
+   * Sub-phrase collections needed by PREnc may be incomplete (topLevel = false).
+   **/
+  TargetPhraseVectorPtr CreateTargetPhraseCollection(const Phrase<Word> &sourcePhrase,
+      bool topLevel = false) const;
+};
+
+}
@@ -0,0 +1,194 @@
+// $Id$
+// vim:tabstop=2
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#include <cstdio>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/foreach.hpp>
+
+#include "PhraseTableCompact.h"
+#include "PhraseDecoder.h"
+#include "../../System.h"
+#include "../../Scores.h"
+#include "../../FF/FeatureFunctions.h"
+#include "../../PhraseBased/InputPath.h"
+#include "../../PhraseBased/Manager.h"
+#include "../../PhraseBased/TargetPhraseImpl.h"
+#include "../../PhraseBased/TargetPhrases.h"
+#include "../../legacy/Util2.h"
+#include "util/exception.hh"
+
+using namespace std;
+using namespace boost::algorithm;
+
+namespace Moses2
+{
+
+PhraseTableCompact::PhraseTableCompact(size_t startInd, const std::string &line)
+  :PhraseTable(startInd, line)
+  ,m_inMemory(false)
+  ,m_useAlignmentInfo(true)
+  ,m_decodingCacheSize(256 * 1024 * 1024)
+  ,m_hash(10, 16)
+  ,m_phraseDecoder(NULL)
+{
+  ReadParameters();
+}
+
+PhraseTableCompact::~PhraseTableCompact()
+{
+  delete m_phraseDecoder;
+}
+
+void PhraseTableCompact::SetParameter(const std::string& key, const std::string& value)
+{
+  if (key == "in-memory") {
+    m_inMemory = Scan<bool>(value);
+  } else if (key == "use-alignment-info") {
+    m_useAlignmentInfo = Scan<bool>(value);
+  } else if (key == "decoding-cache-size") {
+    // in MB
+    m_decodingCacheSize = Scan<size_t>(value) * 1024 * 1024;
+  } else {
+    PhraseTable::SetParameter(key, value);
+  }
+}
+
+void PhraseTableCompact::Load(System &system)
+{
+  std::string tFilePath = m_path;
+
+  std::string suffix = ".minphr";
+  if (!ends_with(tFilePath, suffix)) tFilePath += suffix;
+  UTIL_THROW_IF2(!FileExists(tFilePath), "File " << tFilePath << " does not exist.");
+
+  m_phraseDecoder = new PhraseDecoder(*this, m_input, m_output,
+                                      GetNumScores(), m_decodingCacheSize);
+
+  std::FILE* pFile = std::fopen(tFilePath.c_str() , "r");
+
+  // source phrase index is always kept in memory; lookups must not load
+  // ranges concurrently
+  size_t indexSize = m_hash.Load(pFile);
+
+  size_t coderSize = m_phraseDecoder->Load(system, pFile);
+
+  size_t phraseSize;
+  if(m_inMemory)
+    // Load target phrase collections into memory
+    phraseSize = m_targetPhrasesMemory.load(pFile, false);
+  else
+    // Keep target phrase collections on disk
+    phraseSize = m_targetPhrasesMapped.load(pFile, true);
+
+  UTIL_THROW_IF2(indexSize == 0 || coderSize == 0 || phraseSize == 0,
+                 "Not successfully loaded");
+}
+
+void PhraseTableCompact::Lookup(const Manager &mgr, InputPathsBase &inputPaths) const
+{
+  BOOST_FOREACH(InputPathBase *pathBase, inputPaths) {
+    InputPath *path = static_cast<InputPath*>(pathBase);
+
+    if (SatisfyBackoff(mgr, *path)) {
+      TargetPhrases *tpsPtr = Lookup(mgr, mgr.GetPool(), *path);
+      path->AddTargetPhrases(*this, tpsPtr);
+    }
+  }
+}
+
+TargetPhrases *PhraseTableCompact::Lookup(const Manager &mgr, MemPool &pool,
+    InputPath &inputPath) const
+{
+  const Phrase<Moses2::Word> &sourcePhrase = inputPath.subPhrase;
+
+  // There is no such source phrase if source phrase is longer than longest
+  // observed source phrase during compilation
+  if (sourcePhrase.GetSize() > m_phraseDecoder->GetMaxSourcePhraseLength()) {
+    return NULL;
+  }
+
+  TargetPhraseVectorPtr tpv
+  = m_phraseDecoder->CreateTargetPhraseCollection(sourcePhrase, true);
+  if (tpv == NULL || tpv->empty()) {
+    return NULL;
+  }
+
+  const System &system = mgr.system;
+  const FeatureFunctions &ffs = system.featureFunctions;
+
+  TargetPhrases *tps = new (pool.Allocate<TargetPhrases>()) TargetPhrases(pool, tpv->size());
+  BOOST_FOREACH(const TPCompact &tpc, *tpv) {
+    TargetPhraseImpl *tp =
+      new (pool.Allocate<TargetPhraseImpl>()) TargetPhraseImpl(pool, *this,
+          system, tpc.words.size());
+
+    for (size_t i = 0; i < tpc.words.size(); ++i) {
+      (*tp)[i] = tpc.words[i];
+    }
+
+    tp->GetScores().PlusEquals(system, *this, tpc.scores);
+
+    if (tpc.alignment) {
+      tp->Parent::SetAlignTerm(*tpc.alignment);
+    }
+
+    ffs.EvaluateInIsolation(pool, system, sourcePhrase, *tp);
+    tps->AddTargetPhrase(*tp);
+  }
+
+  tps->SortAndPrune(m_tableLimit);
+  ffs.EvaluateAfterTablePruning(pool, *tps, sourcePhrase);
+
+  return tps;
+}
+
+// SCFG ///////////////////////////////////////////////////////////////////////////////////////////
+void PhraseTableCompact::InitActiveChart(
+  MemPool &pool,
+  const SCFG::Manager &mgr,
+  SCFG::InputPath &path) const
+{
+  UTIL_THROW2("Not implemented");
+}
+
+void PhraseTableCompact::Lookup(MemPool &pool,
+                                const SCFG::Manager &mgr,
+                                size_t maxChartSpan,
+                                const SCFG::Stacks &stacks,
+                                SCFG::InputPath &path) const
+{
+  UTIL_THROW2("Not implemented");
+}
+
+void PhraseTableCompact::LookupGivenNode(
+  MemPool &pool,
+  const SCFG::Manager &mgr,
+  const SCFG::ActiveChartEntry &prevEntry,
+  const SCFG::Word &wordSought,
+  const Moses2::Hypotheses *hypos,
+  const Moses2::Range &subPhraseRange,
+  SCFG::InputPath &outPath) const
+{
+  UTIL_THROW2("Not implemented");
+}
+
+}
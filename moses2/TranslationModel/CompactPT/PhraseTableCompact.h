@@ -0,0 +1,90 @@
+// $Id$
+// vim:tabstop=2
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#pragma once
+
+#include <string>
+
+#include "../PhraseTable.h"
+#include "BlockHashIndex.h"
+#include "StringVector.h"
+#include "MmapAllocator.h"
+
+namespace Moses2
+{
+
+class PhraseDecoder;
+
+/** Phrase table in the compact format of processPhraseTableMin (.minphr).
+ * Collections are decoded on demand into TargetPhraseImpl objects in the
+ * manager's pool; the decoded form is kept in a cache shared by all threads.
+ **/
+class PhraseTableCompact: public PhraseTable
+{
+  friend class PhraseDecoder;
+
+public:
+  PhraseTableCompact(size_t startInd, const std::string &line);
+  virtual ~PhraseTableCompact();
+
+  void Load(System &system);
+  virtual void SetParameter(const std::string& key, const std::string& value);
+
+  void Lookup(const Manager &mgr, InputPathsBase &inputPaths) const;
+  TargetPhrases *Lookup(const Manager &mgr, MemPool &pool,
+                        InputPath &inputPath) const;
+
+  // SCFG
+  virtual void InitActiveChart(
+    MemPool &pool,
+    const SCFG::Manager &mgr,
+    SCFG::InputPath &path) const;
+
+  virtual void Lookup(MemPool &pool,
+                      const SCFG::Manager &mgr,
+                      size_t maxChartSpan,
+                      const SCFG::Stacks &stacks,
+                      SCFG::InputPath &path) const;
+
+protected:
+  bool m_inMemory; // load target phrases rather than map them. Off by default, as in moses
+  bool m_useAlignmentInfo;
+  size_t m_decodingCacheSize; // bytes
+
+  // lookups only read ranges loaded by Load()
+  mutable BlockHashIndex m_hash;
+  PhraseDecoder* m_phraseDecoder;
+
+  StringVector<unsigned char, size_t, MmapAllocator>  m_targetPhrasesMapped;
+  StringVector<unsigned char, size_t, std::allocator> m_targetPhrasesMemory;
+
+  virtual void LookupGivenNode(
+    MemPool &pool,
+    const SCFG::Manager &mgr,
+    const SCFG::ActiveChartEntry &prevEntry,
+    const SCFG::Word &wordSought,
+    const Moses2::Hypotheses *hypos,
+    const Moses2::Range &subPhraseRange,
+    SCFG::InputPath &outPath) const;
+};
+
+}
@@ -19,21 +19,128 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <boost/functional/hash.hpp>
+
 #include "TargetPhraseCollectionCache.h"
 
 namespace Moses2
 {
 
-boost::thread_specific_ptr<TargetPhraseCollectionCache::CacheMap>
-TargetPhraseCollectionCache::m_phraseCache;
+#ifdef WITH_THREADS
+#define LOCK_SHARD(shard) boost::mutex::scoped_lock lock((shard).m_mutex)
+#else
+#define LOCK_SHARD(shard)
+#endif
 
 PhraseCompact::PhraseCompact(const Phrase<Word> &copy)
 {
+  reserve(copy.GetSize());
   for (size_t i = 0; i < copy.GetSize(); ++i) {
     const Word &word = copy[i];
     push_back(word);
   }
 }
 
+size_t hash_value(const PhraseCompact &phrase)
+{
+  size_t seed = 0;
+  for (size_t i = 0; i < phrase.size(); ++i) {
+    boost::hash_combine(seed, phrase[i].hash());
+  }
+  return seed;
+}
+
+TargetPhraseCollectionCache::TargetPhraseCollectionCache(size_t maxBytes)
+  : m_maxBytes(maxBytes)
+{
+}
+
+void TargetPhraseCollectionCache::Cache(const Phrase<Word> &sourcePhrase,
+                                        TargetPhraseVectorPtr tpv,
+                                        size_t bitsLeft, size_t maxRank)
+{
+  // copy outside of the lock, most calls add a new entry
+  if(maxRank && tpv->size() > maxRank)
+    tpv.reset(new TargetPhraseVector(tpv->begin(), tpv->begin() + maxRank));
+  PhraseCompact key(sourcePhrase);
+  size_t bytes = EstimateBytes(key, *tpv);
+
+  Shard &shard = GetShard(key);
+  LOCK_SHARD(shard);
+
+  // check if source phrase is already in cache, if so just mark it used
+  EntryMap::iterator it = shard.m_map.find(key);
+  if(it != shard.m_map.end()) {
+    shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, it->second);
+    return;
+  }
+
+  Entry entry;
+  entry.m_tpv = tpv;
+  entry.m_bitsLeft = bitsLeft;
+  entry.m_bytes = bytes;
+  shard.m_lru.push_front(entry);
+
+  it = shard.m_map.insert(std::make_pair(key, shard.m_lru.begin())).first;
+  shard.m_lru.front().m_source = &it->first;
+  shard.m_bytes += bytes;
+
+  Reduce(shard);
 }
 
+std::pair<TargetPhraseVectorPtr, size_t>
+TargetPhraseCollectionCache::Retrieve(const Phrase<Word> &sourcePhrase)
+{
+  PhraseCompact key(sourcePhrase);
+  Shard &shard = GetShard(key);
+  LOCK_SHARD(shard);
+
+  EntryMap::iterator it = shard.m_map.find(key);
+  if(it == shard.m_map.end()) {
+    return std::make_pair(TargetPhraseVectorPtr(), 0);
+  }
+
+  shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, it->second);
+  const Entry &entry = *it->second;
+  return std::make_pair(entry.m_tpv, entry.m_bitsLeft);
+}
+
+void TargetPhraseCollectionCache::Reduce(Shard &shard)
+{
+  size_t maxBytes = m_maxBytes / NumShards;
+  // always keep the entry just added
+  while(shard.m_bytes > maxBytes && shard.m_lru.size() > 1) {
+    const Entry &entry = shard.m_lru.back();
+    shard.m_bytes -= entry.m_bytes;
+    shard.m_map.erase(*entry.m_source);
+    shard.m_lru.pop_back();
+  }
+}
+
+void TargetPhraseCollectionCache::CleanUp()
+{
+  for(size_t i = 0; i < NumShards; ++i) {
+    Shard &shard = m_shards[i];
+    LOCK_SHARD(shard);
+    shard.m_map.clear();
+    shard.m_lru.clear();
+    shard.m_bytes = 0;
+  }
+}
+
+size_t TargetPhraseCollectionCache::EstimateBytes(const PhraseCompact &sourcePhrase,
+    const TargetPhraseVector &tpv)
+{
+  // map node, list node and shared vector, roughly
+  size_t bytes = sizeof(PhraseCompact) + sourcePhrase.size() * sizeof(Word)
+                 + sizeof(Entry) + 4 * sizeof(void*)
+                 + sizeof(TargetPhraseVector);
+
+  for(TargetPhraseVector::const_iterator it = tpv.begin(); it != tpv.end(); ++it) {
+    bytes += sizeof(TPCompact) + it->words.size() * sizeof(Word)
+             + it->scores.size() * sizeof(float);
+  }
+  return bytes;
+}
+
+}
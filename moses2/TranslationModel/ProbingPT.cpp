@@ -70,6 +70,7 @@ std::pair<bool, uint64_t> ProbingPT::ActiveChartEntryProbing::GetKey(const SCFG:
 ProbingPT::ProbingPT(size_t startInd, const std::string &line)
   :PhraseTable(startInd, line)
   ,load_method(util::POPULATE_OR_READ)
+  ,m_zeroCopyLimit(0)
 {
   ReadParameters();
 }
@@ -136,6 +137,10 @@ void ProbingPT::Load(System &system)
   // alignments
   CreateAlignmentMap(system, m_path + "/Alignments.dat");
 
+  // only the pt scores are weighted here. Lex RO etc scores aren't
+  m_weights = system.weights.GetWeights(*this);
+  m_weights.resize(m_engine->num_scores, 0);
+
   // cache
   CreateCache(system);
 }
@@ -156,6 +161,8 @@ void ProbingPT::SetParameter(const std::string& key, const std::string& value)
     } else {
       UTIL_THROW2("load method not supported" << value);
     }
+  } else if (key == "zero-copy-limit") {
+    m_zeroCopyLimit = Scan<size_t>(value);
   } else {
     PhraseTable::SetParameter(key, value);
   }
@@ -267,6 +274,10 @@ TargetPhrases *ProbingPT::CreateTargetPhrases(MemPool &pool,
     const char *offset = m_engine->memTPS + query_result.second;
     uint64_t *numTP = (uint64_t*) offset;
 
+    if (m_zeroCopyLimit && *numTP > m_zeroCopyLimit) {
+      return CreateTargetPhrasesZeroCopy(pool, system, sourcePhrase, offset);
+    }
+
     tps = new (pool.Allocate<TargetPhrases>()) TargetPhrases(pool, *numTP);
 
     offset += sizeof(uint64_t);
@@ -288,6 +299,72 @@ TargetPhrases *ProbingPT::CreateTargetPhrases(MemPool &pool,
   return tps;
 }
 
+TargetPhrases *ProbingPT::CreateTargetPhrasesZeroCopy(MemPool &pool,
+    const System &system, const Phrase<Moses2::Word> &sourcePhrase,
+    const char *offset) const
+{
+  uint64_t numTP = *(uint64_t*) offset;
+  offset += sizeof(uint64_t);
+
+  // rank views of the mapped records. Nothing is allocated from the pool yet
+  if (m_views.get() == NULL) {
+    m_views.reset(new TargetPhraseViews());
+  }
+  TargetPhraseViews &views = *m_views;
+  views.resize(numTP);
+  for (size_t i = 0; i < numTP; ++i) {
+    views[i].offset = offset;
+    views[i].score = GetWeightedScore(offset);
+    offset += GetTargetPhraseSize(offset);
+  }
+
+  size_t numCreate = std::min<size_t>(numTP, m_zeroCopyLimit);
+  std::nth_element(views.begin(), views.begin() + numCreate, views.end());
+
+  // only the survivors are created and scored by the other FF
+  TargetPhrases *tps = new (pool.Allocate<TargetPhrases>()) TargetPhrases(pool, numCreate);
+  const FeatureFunctions &ffs = system.featureFunctions;
+  for (size_t i = 0; i < numCreate; ++i) {
+    const char *tpOffset = views[i].offset;
+    TargetPhraseImpl *tp = CreateTargetPhrase(pool, system, tpOffset);
+    ffs.EvaluateInIsolation(pool, system, sourcePhrase, *tp);
+    tps->AddTargetPhrase(*tp);
+  }
+
+  tps->SortAndPrune(m_tableLimit);
+  ffs.EvaluateAfterTablePruning(pool, *tps, sourcePhrase);
+  return tps;
+}
+
+SCORE ProbingPT::GetWeightedScore(const char *offset) const
+{
+  const SCORE *scores = (const SCORE*) (offset + sizeof(probingpt::TargetPhraseInfo));
+
+  const size_t numScores = m_engine->num_scores;
+  SCORE ret = 0;
+  if (m_engine->logProb) {
+    for (size_t i = 0; i < numScores; ++i) {
+      ret += scores[i] * m_weights[i];
+    }
+  } else {
+    for (size_t i = 0; i < numScores; ++i) {
+      ret += FloorScore(TransformScore(scores[i])) * m_weights[i];
+    }
+  }
+  return ret;
+}
+
+size_t ProbingPT::GetTargetPhraseSize(const char *offset) const
+{
+  const probingpt::TargetPhraseInfo *tpInfo = (const probingpt::TargetPhraseInfo*) offset;
+  size_t numRealWords = tpInfo->numWords / m_output.size();
+  size_t totalNumScores = m_engine->num_scores + m_engine->num_lex_scores;
+
+  return sizeof(probingpt::TargetPhraseInfo)
+         + sizeof(SCORE) * totalNumScores
+         + sizeof(uint32_t) * numRealWords * m_output.size();
+}
+
 TargetPhraseImpl *ProbingPT::CreateTargetPhrase(
   MemPool &pool,
   const System &system,
@@ -104,6 +104,23 @@ protected:
   uint64_t m_unkId;
   probingpt::QueryEngine *m_engine;
 
+  // zero-copy lookup. Target phrases are ranked by their weighted pt score
+  // straight from the mapped file and only the best m_zeroCopyLimit are
+  // turned into TargetPhraseImpl. 0 = off
+  struct TargetPhraseView {
+    const char *offset;
+    SCORE score;
+
+    bool operator<(const TargetPhraseView &other) const {
+      return score > other.score;
+    }
+  };
+  typedef std::vector<TargetPhraseView> TargetPhraseViews;
+
+  size_t m_zeroCopyLimit;
+  std::vector<SCORE> m_weights; // this pt's weights, set at load time
+  mutable boost::thread_specific_ptr<TargetPhraseViews> m_views;
+
   void CreateAlignmentMap(System &system, const std::string path);
 
   TargetPhrases *Lookup(const Manager &mgr, MemPool &pool,
@@ -112,6 +129,10 @@ protected:
                                      const Phrase<Moses2::Word> &sourcePhrase, uint64_t key) const;
   TargetPhraseImpl *CreateTargetPhrase(MemPool &pool, const System &system,
                                        const char *&offset) const;
+  TargetPhrases *CreateTargetPhrasesZeroCopy(MemPool &pool, const System &system,
+      const Phrase<Moses2::Word> &sourcePhrase, const char *offset) const;
+  SCORE GetWeightedScore(const char *offset) const;
+  size_t GetTargetPhraseSize(const char *offset) const;
 
   inline const std::pair<bool, const Factor*> *GetTargetFactor(uint32_t probingId) const {
     if (probingId >= m_targetVocab.size()) {
@@ -23,6 +23,7 @@
 #ifdef WITH_THREADS
 #include <boost/thread/locks.hpp>
 #endif
+#include <cstring>
 #include <ostream>
 #include <string>
 #include "FactorCollection.h"
@@ -35,58 +36,123 @@ using namespace std;
 namespace Moses2
 {
 
+FactorCollection::Table::Table(size_t size) :
+  mask(size - 1), slots(new boost::atomic<const FactorFriend*>[size])
+{
+  for (size_t i = 0; i < size; ++i) {
+    slots[i].store(NULL, boost::memory_order_relaxed);
+  }
+}
+
+FactorCollection::Table::~Table()
+{
+  delete[] slots;
+}
+
+FactorCollection::Shard::Shard() :
+  table(new Table(128)), size(0)
+{
+}
+
+FactorCollection::Shard::~Shard()
+{
+  delete table.load();
+  for (size_t i = 0; i < retired.size(); ++i) {
+    delete retired[i];
+  }
+}
+
+const FactorFriend *FactorCollection::Find(const Table &table, uint64_t hash,
+    const StringPiece &factorString)
+{
+  for (size_t i = hash & table.mask;; i = (i + 1) & table.mask) {
+    const FactorFriend *factor = table.slots[i].load(
+                                   boost::memory_order_acquire);
+    if (factor == NULL || factor->in.m_string == factorString) {
+      return factor;
+    }
+  }
+}
+
+void FactorCollection::Insert(Table &table, uint64_t hash,
+                              const FactorFriend *factor)
+{
+  size_t i = hash & table.mask;
+  while (table.slots[i].load(boost::memory_order_relaxed)) {
+    i = (i + 1) & table.mask;
+  }
+  table.slots[i].store(factor, boost::memory_order_release);
+}
+
+FactorCollection::Table *FactorCollection::Grow(Shard &shard)
+{
+  // caller holds shard.writeLock
+  Table *oldTable = shard.table.load(boost::memory_order_relaxed);
+  Table *newTable = new Table(2 * (oldTable->mask + 1));
+  for (size_t i = 0; i <= oldTable->mask; ++i) {
+    const FactorFriend *factor = oldTable->slots[i].load(
+                                   boost::memory_order_relaxed);
+    if (factor) {
+      StringPiece str = factor->in.m_string;
+      Insert(*newTable, util::MurmurHashNative(str.data(), str.size()), factor);
+    }
+  }
+  shard.table.store(newTable, boost::memory_order_release);
+  shard.retired.push_back(oldTable);
+  return newTable;
+}
+
 const Factor *FactorCollection::AddFactor(const StringPiece &factorString,
     const System &system, bool isNonTerminal)
 {
-  FactorFriend to_ins;
-  to_ins.in.m_string = factorString;
-  to_ins.in.m_id = (isNonTerminal) ? m_factorIdNonTerminal : m_factorId;
-  Set & set = (isNonTerminal) ? m_set : m_setNonTerminal;
-  // If we're threaded, hope a read-only lock is sufficient.
+  uint64_t hash = util::MurmurHashNative(factorString.data(),
+                                         factorString.size());
+  Shard &shard = GetShard(hash, isNonTerminal);
+
+  // lock-free for factors that already exist, which is nearly all of them
+  const FactorFriend *ret = Find(
+                              *shard.table.load(boost::memory_order_acquire), hash, factorString);
+  if (ret) return &ret->in;
+
 #ifdef WITH_THREADS
-  {
-    // read=lock scope
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-    Set::const_iterator i = set.find(to_ins);
-    if (i != set.end()) return &i->in;
-  }
-  boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
-#endif // WITH_THREADS
-  std::pair<Set::iterator, bool> ret(set.insert(to_ins));
-  if (ret.second) {
-    ret.first->in.m_string.set(
-      memcpy(m_string_backing.Allocate(factorString.size()),
-             factorString.data(), factorString.size()), factorString.size());
-    if (isNonTerminal) {
-      m_factorIdNonTerminal++;
-      UTIL_THROW_IF2(m_factorIdNonTerminal >= moses_MaxNumNonterminals,
-                     "Number of non-terminals exceeds maximum size reserved. Adjust parameter moses_MaxNumNonterminals, then recompile");
-    } else {
-      m_factorId++;
-    }
+  boost::mutex::scoped_lock lock(shard.writeLock);
+#endif
+  Table *table = shard.table.load(boost::memory_order_relaxed);
+  ret = Find(*table, hash, factorString);
+  if (ret) return &ret->in;
+
+  // keep load factor <= 0.5
+  if (2 * (shard.size + 1) > table->mask + 1) {
+    table = Grow(shard);
   }
 
-  const Factor *factor = &ret.first->in;
+  FactorFriend *factor =
+    new (shard.factorBacking.Allocate(sizeof(FactorFriend))) FactorFriend();
+  factor->in.m_string.set(
+    memcpy(shard.stringBacking.Allocate(factorString.size()),
+           factorString.data(), factorString.size()), factorString.size());
+  if (isNonTerminal) {
+    factor->in.m_id = m_factorIdNonTerminal++;
+    UTIL_THROW_IF2(factor->in.m_id + 1 >= moses_MaxNumNonterminals,
+                   "Number of non-terminals exceeds maximum size reserved. Adjust parameter moses_MaxNumNonterminals, then recompile");
+  } else {
+    factor->in.m_id = m_factorId++;
+  }
 
-  return factor;
+  Insert(*table, hash, factor);
+  ++shard.size;
+  return &factor->in;
 }
 
 const Factor *FactorCollection::GetFactor(const StringPiece &factorString,
     bool isNonTerminal)
 {
-  FactorFriend to_find;
-  to_find.in.m_string = factorString;
-  to_find.in.m_id = (isNonTerminal) ? m_factorIdNonTerminal : m_factorId;
-  Set & set = (isNonTerminal) ? m_set : m_setNonTerminal;
-  {
-    // read=lock scope
-#ifdef WITH_THREADS
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-#endif // WITH_THREADS
-    Set::const_iterator i = set.find(to_find);
-    if (i != set.end()) return &i->in;
-  }
-  return NULL;
+  uint64_t hash = util::MurmurHashNative(factorString.data(),
+                                         factorString.size());
+  const Shard &shard = GetShard(hash, isNonTerminal);
+  const FactorFriend *ret = Find(
+                              *shard.table.load(boost::memory_order_acquire), hash, factorString);
+  return ret ? &ret->in : NULL;
 }
 
 FactorCollection::~FactorCollection()
@@ -96,12 +162,16 @@ FactorCollection::~FactorCollection()
 // friend
 ostream& operator<<(ostream& out, const FactorCollection& factorCollection)
 {
-#ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(factorCollection.m_accessLock);
-#endif
-  for (FactorCollection::Set::const_iterator i = factorCollection.m_set.begin();
-       i != factorCollection.m_set.end(); ++i) {
-    out << i->in;
+  for (size_t i = 0; i < FactorCollection::NumShards; ++i) {
+    const FactorCollection::Table &table =
+      *factorCollection.m_shards[i].table.load(boost::memory_order_acquire);
+    for (size_t j = 0; j <= table.mask; ++j) {
+      const FactorFriend *factor = table.slots[j].load(
+                                     boost::memory_order_acquire);
+      if (factor) {
+        out << factor->in;
+      }
+    }
   }
   return out;
 }
@@ -144,6 +144,8 @@ Parameter::Parameter()
            "How many hypotheses should be created for each coverage. (default = 0)");
   AddParam(cube_opts, "cube-pruning-lazy-scoring", "cbls",
            "Don't fully score a hypothesis until it is popped");
+  AddParam(cube_opts, "cube-pruning-early-rejection", "cber",
+           "With lazy scoring, discard a popped hypothesis without scoring it if the stateful features can't lift it over the stack threshold (default = true)");
   //AddParam(cube_opts, "cube-pruning-deterministic-search", "cbds",
   //    "Break ties deterministically during search");
 
@@ -273,6 +275,8 @@ Parameter::Parameter()
   //    "print out labels for each weight type in n-best list. default is true");
   //AddParam(nbest_opts, "n-best-trees",
   //    "Write n-best target-side trees to n-best-list");
+  AddParam(nbest_opts, "n-best-binary",
+           "Write the n-best-list in the binary format read by mert's extractor. Default is false");
   AddParam(nbest_opts, "n-best-factor",
            "factor to compute the maximum number of contenders (=factor*nbest-size). value 0 means infinity, i.e. no threshold. default is 0");
   //AddParam(nbest_opts, "report-all-factors-in-n-best",
@@ -308,6 +312,12 @@ Parameter::Parameter()
            "Max. number of seconds the server will keep a persistent connection alive.");
   AddParam(server_opts,"server-timeout",
            "Max. number of seconds the server will wait for a client to submit a request once a connection has been established.");
+  AddParam(server_opts,"server-queue-limit",
+           "Max. No. of translation requests waiting for a decoding thread. Further requests are refused. Default 0 = no limit.");
+  AddParam(server_opts,"server-batch-size",
+           "Max. No. of short waiting requests one decoding thread decodes together, with search-algorithm 4. Default 1.");
+  AddParam(server_opts,"server-batch-max-words",
+           "Requests of up to this many words are batched. Default 10.");
 
   po::options_description irstlm_opts("IRSTLM Options");
   //AddParam(irstlm_opts, "clean-lm-cache",
@@ -358,6 +368,10 @@ Parameter::Parameter()
   AddParam(misc_opts, "cpu-affinity-offset", "CPU Affinity. Default = -1 (no affinity)");
   AddParam(misc_opts, "cpu-affinity-increment",
            "Set to 1 (default) to put each thread on different cores. 0 to run all threads on one core");
+  AddParam(misc_opts, "batch-window",
+           "Number of input sentences read ahead in batch mode and scheduled longest-first on work-stealing queues. Default = 0 (FIFO thread pool)");
+  AddParam(misc_opts, "numa",
+           "Interleave models over the NUMA nodes, run decoding threads round-robin on the nodes and report per-node throughput. Overrides cpu-affinity-offset. Default = false");
 
   // Compact phrase table and reordering table.
   po::options_description cpt_opts(
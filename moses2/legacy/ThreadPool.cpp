@@ -29,6 +29,8 @@
 #include <thread>
 
 #include "ThreadPool.h"
+#include "../Numa.h"
+#include "util/usage.hh"
 
 using namespace std;
 
@@ -39,8 +41,8 @@ namespace Moses2
   do { errno = en; perror(msg); exit(EXIT_FAILURE); } while (0)
 
 ThreadPool::ThreadPool(size_t numThreads, int cpuAffinityOffset,
-                       int cpuAffinityIncr) :
-  m_stopped(false), m_stopping(false), m_queueLimit(0)
+                       int cpuAffinityIncr, NumaStats *numaStats) :
+  m_stopped(false), m_stopping(false), m_queueLimit(0), m_numaStats(numaStats)
 {
 #if defined(_WIN32) || defined(_WIN64)
   size_t numCPU = std::thread::hardware_concurrency();
@@ -53,10 +55,10 @@ ThreadPool::ThreadPool(size_t numThreads, int cpuAffinityOffset,
 
   for (size_t i = 0; i < numThreads; ++i) {
     boost::thread *thread = m_threads.create_thread(
-                              boost::bind(&ThreadPool::Execute, this));
+                              boost::bind(&ThreadPool::Execute, this, i));
 
 #ifdef __linux
-    if (cpuAffinityOffset >= 0) {
+    if (cpuAffinityOffset >= 0 && m_numaStats == NULL) {
       int s;
 
       boost::thread::native_handle_type handle = thread->native_handle();
@@ -89,8 +91,13 @@ ThreadPool::ThreadPool(size_t numThreads, int cpuAffinityOffset,
   }
 }
 
-void ThreadPool::Execute()
+void ThreadPool::Execute(size_t threadInd)
 {
+  size_t node = Numa::GetThreadNode(threadInd);
+  if (m_numaStats && !Numa::RunOnNode(node)) {
+    cerr << "Couldn't run thread " << threadInd << " on NUMA node " << node << endl;
+  }
+
   do {
     boost::shared_ptr<Task> task;
     {
@@ -109,7 +116,13 @@ void ThreadPool::Execute()
       // must read from task before run. otherwise task may be deleted by main thread
       // race condition
       task->DeleteAfterExecution();
-      task->Run();
+      if (m_numaStats) {
+        double start = util::WallTime();
+        task->Run();
+        m_numaStats->Add(node, util::WallTime() - start);
+      } else {
+        task->Run();
+      }
     }
     m_threadAvailable.notify_all();
   } while (!m_stopped);
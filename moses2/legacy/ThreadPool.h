@@ -40,6 +40,7 @@
 
 namespace Moses2
 {
+class NumaStats;
 
 /**
  * Classes to implement a ThreadPool.
@@ -63,9 +64,11 @@ class ThreadPool
 public:
   /**
    * Construct a thread pool of a fixed size.
+   * If numaStats is given, threads run round-robin on the NUMA nodes
+   * instead of following cpuAffinityOffset, and record their tasks in it.
    **/
   explicit ThreadPool(size_t numThreads, int cpuAffinityOffset = -1,
-                      int cpuAffinityIncr = 1);
+                      int cpuAffinityIncr = 1, NumaStats *numaStats = NULL);
 
   ~ThreadPool() {
     Stop();
@@ -93,7 +96,7 @@ private:
   /**
    * The main loop executed by each thread.
    **/
-  void Execute();
+  void Execute(size_t threadInd);
 
   std::queue<boost::shared_ptr<Task> > m_tasks;
   boost::thread_group m_threads;
@@ -103,6 +106,7 @@ private:
   bool m_stopped;
   bool m_stopping;
   size_t m_queueLimit;
+  NumaStats *m_numaStats;
 };
 
 class TestTask: public Task
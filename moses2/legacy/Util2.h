@@ -287,6 +287,16 @@ inline float UntransformLMScore(float logNScore)
   return logNScore / 2.30258509299405f;
 }
 
+//! nearest-rank percentile p (0 to 1) of an ascending vector, 0 if empty
+inline float Percentile(const std::vector<float> &sorted, float p)
+{
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t ind = (size_t) (p * (sorted.size() - 1) + 0.5f);
+  return sorted[ind];
+}
+
 inline bool FileExists(const std::string& filePath)
 {
   std::ifstream ifs(filePath.c_str());
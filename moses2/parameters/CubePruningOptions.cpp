@@ -11,6 +11,7 @@ CubePruningOptions()
   : pop_limit(DEFAULT_CUBE_PRUNING_POP_LIMIT)
   , diversity(DEFAULT_CUBE_PRUNING_DIVERSITY)
   , lazy_scoring(false)
+  , early_rejection(true)
   , deterministic_search(false)
 {}
 
@@ -23,6 +24,7 @@ init(Parameter const& param)
   param.SetParameter(diversity, "cube-pruning-diversity",
                      DEFAULT_CUBE_PRUNING_DIVERSITY);
   param.SetParameter(lazy_scoring, "cube-pruning-lazy-scoring", false);
+  param.SetParameter(early_rejection, "cube-pruning-early-rejection", true);
   //param.SetParameter(deterministic_search, "cube-pruning-deterministic-search", false);
   return true;
 }
@@ -54,6 +56,20 @@ update(std::map<std::string,xmlrpc_c::value>const& params)
     }
   }
 
+  si = params.find("cube-pruning-early-rejection");
+  if (si != params.end()) {
+    std::string spec = xmlrpc_c::value_string(si->second);
+    if (spec == "true" or spec == "on" or spec == "1")
+      early_rejection = true;
+    else if (spec == "false" or spec == "off" or spec == "0")
+      early_rejection = false;
+    else {
+      char const* msg
+      = "Error parsing specification for cube-pruning-early-rejection";
+      xmlrpc_c::fault(msg, xmlrpc_c::fault::CODE_PARSE);
+    }
+  }
+
   si = params.find("cube-pruning-deterministic-search");
   if (si != params.end()) {
     std::string spec = xmlrpc_c::value_string(si->second);
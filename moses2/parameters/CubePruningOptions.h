@@ -11,6 +11,7 @@ struct
   size_t  pop_limit;
   size_t  diversity;
   bool lazy_scoring;
+  bool early_rejection;
   bool deterministic_search;
 
   bool init(Parameter const& param);
@@ -19,6 +19,8 @@ struct NBestOptions : public OptionsBaseClass {
 
   bool include_all_factors;
 
+  bool binary; // BinaryNBest format, for tuning
+
   std::string output_file_path;
 
   bool init(Parameter const& param);
@@ -38,6 +38,9 @@ ServerOptions::
 ServerOptions()
   : is_serial(false)
   , numThreads(15) // why 15?
+  , queueLimit(0)
+  , batchSize(1)
+  , batchMaxWords(10)
   , sessionTimeout(1800) // = 30 min
   , sessionCacheSize(25)
   , port(8080)
@@ -64,6 +67,11 @@ init(Parameter const& P)
   P.SetParameter(this->logfile, "server-log", std::string("/dev/null"));
   P.SetParameter(this->numThreads, "threads", uint32_t(15));
 
+  // request queue between the abyss threads and the decoding threads
+  P.SetParameter(this->queueLimit, "server-queue-limit", size_t(0));
+  P.SetParameter(this->batchSize, "server-batch-size", size_t(1));
+  P.SetParameter(this->batchMaxWords, "server-batch-max-words", size_t(10));
+
   // defaults reflect recommended defaults (according to Hieu)
   // -> http://xmlrpc-c.sourceforge.net/doc/libxmlrpc_server_abyss.html#max_conn
   P.SetParameter(this->maxConn,"server-maxconn", 15);
@@ -14,7 +14,10 @@ class Parameter;
 struct
     ServerOptions {
   bool is_serial;
-  uint32_t numThreads; // might not be used any more, actually
+  uint32_t numThreads; // decoding threads of the request queue
+  size_t queueLimit; // requests waiting beyond this are refused. 0 = no limit
+  size_t batchSize; // max short requests decoded together by one thread
+  size_t batchMaxWords; // requests up to this length are short
 
   size_t sessionTimeout;   // this is related to Moses translation sessions
   size_t sessionCacheSize; // this is related to Moses translation sessions
@@ -0,0 +1,162 @@
+/*
+ * RequestQueue.cpp
+ *
+ */
+#include <algorithm>
+#include <iostream>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include "RequestQueue.h"
+#include "TranslationRequest.h"
+#include "util/usage.hh"
+
+using namespace std;
+
+namespace Moses2
+{
+
+RequestQueue::RequestQueue(size_t numThreads, size_t maxQueued,
+                           size_t batchSize, size_t batchMaxWords,
+                           NumaStats *numaStats)
+  :m_maxQueued(maxQueued)
+  ,m_batchSize(std::max<size_t>(batchSize, 1))
+  ,m_batchMaxWords(batchMaxWords)
+  ,m_numaStats(numaStats)
+  ,m_stopping(false)
+  ,m_running(0)
+  ,m_accepted(0)
+  ,m_rejected(0)
+  ,m_batches(0)
+  ,m_queueTimes(NUM_SAMPLES)
+  ,m_decodeTimes(NUM_SAMPLES)
+  ,m_numSamples(0)
+{
+  for (size_t i = 0; i < std::max<size_t>(numThreads, 1); ++i) {
+    m_threads.create_thread(boost::bind(&RequestQueue::Execute, this, i));
+  }
+}
+
+RequestQueue::~RequestQueue()
+{
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_stopping = true;
+  }
+  m_workAvailable.notify_all();
+  m_threads.join_all();
+}
+
+bool RequestQueue::Submit(boost::shared_ptr<TranslationRequest> request,
+                          size_t inputSize)
+{
+  Item item;
+  item.request = request;
+  item.inputSize = inputSize;
+  item.submitTime = util::WallTime();
+
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (m_maxQueued && m_items.size() >= m_maxQueued) {
+      ++m_rejected;
+      return false;
+    }
+    m_items.push_back(item);
+    ++m_accepted;
+  }
+  m_workAvailable.notify_one();
+  return true;
+}
+
+void RequestQueue::Execute(size_t threadInd)
+{
+  size_t node = Numa::GetThreadNode(threadInd);
+  if (m_numaStats && !Numa::RunOnNode(node)) {
+    cerr << "Couldn't run thread " << threadInd << " on NUMA node " << node << endl;
+  }
+
+  std::vector<Item> batch;
+  std::vector<boost::shared_ptr<TranslationRequest> > requests;
+  while (true) {
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (m_items.empty() && !m_stopping) {
+        m_workAvailable.wait(lock);
+      }
+      if (m_items.empty()) {
+        break;
+      }
+      TakeBatch(batch);
+    }
+
+    double start = util::WallTime();
+    if (batch.size() == 1) {
+      batch[0].request->Run();
+    } else {
+      requests.clear();
+      BOOST_FOREACH(const Item &item, batch) {
+        requests.push_back(item.request);
+      }
+      TranslationRequest::RunTogether(requests);
+    }
+    double end = util::WallTime();
+    if (m_numaStats) {
+      m_numaStats->Add(node, end - start);
+    }
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    BOOST_FOREACH(const Item &item, batch) {
+      size_t ind = m_numSamples++ % NUM_SAMPLES;
+      m_queueTimes[ind] = start - item.submitTime;
+      m_decodeTimes[ind] = end - start;
+    }
+    m_running -= batch.size();
+  }
+}
+
+void RequestQueue::TakeBatch(std::vector<Item> &batch)
+{
+  // called with m_mutex held. A short request takes the other short
+  // requests waiting with it, in order, and they are decoded in one pass
+  batch.clear();
+  batch.push_back(m_items.front());
+  m_items.pop_front();
+
+  if (m_batchSize > 1 && batch[0].inputSize <= m_batchMaxWords) {
+    std::deque<Item>::iterator iter = m_items.begin();
+    while (iter != m_items.end() && batch.size() < m_batchSize) {
+      if (iter->inputSize <= m_batchMaxWords) {
+        batch.push_back(*iter);
+        iter = m_items.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+    if (batch.size() > 1) {
+      ++m_batches;
+    }
+  }
+
+  m_running += batch.size();
+}
+
+RequestQueue::Stats RequestQueue::GetStats() const
+{
+  Stats ret;
+  boost::mutex::scoped_lock lock(m_mutex);
+  ret.queued = m_items.size();
+  ret.running = m_running;
+  ret.accepted = m_accepted;
+  ret.rejected = m_rejected;
+  ret.batches = m_batches;
+
+  size_t num = m_numSamples < NUM_SAMPLES ? m_numSamples : NUM_SAMPLES;
+  ret.queueTimes.assign(m_queueTimes.begin(), m_queueTimes.begin() + num);
+  ret.decodeTimes.assign(m_decodeTimes.begin(), m_decodeTimes.begin() + num);
+  if (m_numaStats) {
+    ret.nodes = m_numaStats->Get();
+  }
+  return ret;
+}
+
+}
+
@@ -0,0 +1,74 @@
+/*
+ * RequestQueue.h
+ *
+ * Queue between the abyss threads, which accept xmlrpc calls, and a fixed
+ * number of decoding threads. Calls beyond a limit are refused rather than
+ * queued, and short requests that wait together are decoded together.
+ */
+#pragma once
+#include <deque>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include "../Numa.h"
+
+namespace Moses2
+{
+class TranslationRequest;
+
+class RequestQueue
+{
+public:
+  struct Stats {
+    size_t queued, running;
+    size_t accepted, rejected, batches;
+    // seconds, of the most recent requests
+    std::vector<float> queueTimes, decodeTimes;
+    // empty unless threads are placed on NUMA nodes
+    std::vector<NumaStats::Node> nodes;
+  };
+
+  /** maxQueued = 0: no limit. batchSize = 1: no batching. Requests of at
+   * most batchMaxWords words are batched. If numaStats is given, threads
+   * run round-robin on the NUMA nodes and record their requests in it
+   */
+  RequestQueue(size_t numThreads, size_t maxQueued,
+               size_t batchSize, size_t batchMaxWords,
+               NumaStats *numaStats = NULL);
+  virtual ~RequestQueue();
+
+  //! false, and the request is not run, if the queue is full
+  bool Submit(boost::shared_ptr<TranslationRequest> request, size_t inputSize);
+
+  Stats GetStats() const;
+
+protected:
+  struct Item {
+    boost::shared_ptr<TranslationRequest> request;
+    size_t inputSize;
+    double submitTime;
+  };
+
+  // number of recent requests kept for the percentiles
+  static const size_t NUM_SAMPLES = 1024;
+
+  size_t m_maxQueued, m_batchSize, m_batchMaxWords;
+  NumaStats *m_numaStats;
+
+  mutable boost::mutex m_mutex;
+  boost::condition_variable m_workAvailable;
+  std::deque<Item> m_items;
+  bool m_stopping;
+
+  size_t m_running, m_accepted, m_rejected, m_batches;
+  std::vector<float> m_queueTimes, m_decodeTimes;
+  size_t m_numSamples;
+
+  boost::thread_group m_threads;
+
+  void Execute(size_t threadInd);
+  void TakeBatch(std::vector<Item> &batch);
+};
+
+}
+
@@ -8,6 +8,7 @@
 #include "../System.h"
 #include "Server.h"
 #include "Translator.h"
+#include "ServerStats.h"
 #include "../parameters/ServerOptions.h"
 
 using namespace std;
@@ -15,11 +16,30 @@ using namespace std;
 namespace Moses2
 {
 
+namespace
+{
+// only the batch search decodes several sentences in one pass
+size_t GetBatchSize(const ServerOptions &server_options, const System &system)
+{
+  if (server_options.batchSize > 1 && system.options.search.algo != NormalBatch) {
+    cerr << "server-batch-size needs search-algorithm " << NormalBatch
+         << ", requests are decoded one at a time" << endl;
+    return 1;
+  }
+  return server_options.batchSize;
+}
+}
+
 Server::Server(ServerOptions &server_options, System &system)
   :m_server_options(server_options)
+  ,m_requestQueue(server_options.numThreads, server_options.queueLimit,
+                  GetBatchSize(server_options, system), server_options.batchMaxWords,
+                  system.numa ? &system.numaStats : NULL)
   ,m_translator(new Translator(*this, system))
+  ,m_stats(new ServerStats(m_requestQueue))
 {
   m_registry.addMethod("translate", m_translator);
+  m_registry.addMethod("stats", m_stats);
 }
 
 Server::~Server()
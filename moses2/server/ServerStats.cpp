@@ -0,0 +1,70 @@
+/*
+ * ServerStats.cpp
+ *
+ */
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "ServerStats.h"
+#include "RequestQueue.h"
+#include "../legacy/Util2.h"
+
+using namespace std;
+
+namespace Moses2
+{
+
+namespace
+{
+// in milliseconds
+xmlrpc_c::value PackPercentiles(std::vector<float> vec)
+{
+  std::sort(vec.begin(), vec.end());
+  std::map<std::string, xmlrpc_c::value> ret;
+  ret["p50"] = xmlrpc_c::value_double(1000 * Percentile(vec, 0.5f));
+  ret["p90"] = xmlrpc_c::value_double(1000 * Percentile(vec, 0.9f));
+  ret["p99"] = xmlrpc_c::value_double(1000 * Percentile(vec, 0.99f));
+  ret["max"] = xmlrpc_c::value_double(vec.empty() ? 0 : 1000 * vec.back());
+  return xmlrpc_c::value_struct(ret);
+}
+}
+
+ServerStats::ServerStats(const RequestQueue &queue)
+  : m_queue(queue)
+{
+  this->_signature = "S:";
+  this->_help = "Returns queue length, request counts and queue and decode "
+                "time percentiles (ms) of recent translation requests, and "
+                "requests and decoding time (s) per NUMA node";
+}
+
+void ServerStats::execute(xmlrpc_c::paramList const& paramList,
+                          xmlrpc_c::value *const  retvalP)
+{
+  RequestQueue::Stats stats = m_queue.GetStats();
+
+  std::map<std::string, xmlrpc_c::value> ret;
+  ret["queued"] = xmlrpc_c::value_int(stats.queued);
+  ret["running"] = xmlrpc_c::value_int(stats.running);
+  ret["accepted"] = xmlrpc_c::value_int(stats.accepted);
+  ret["rejected"] = xmlrpc_c::value_int(stats.rejected);
+  ret["batches"] = xmlrpc_c::value_int(stats.batches);
+  ret["queue-time"] = PackPercentiles(stats.queueTimes);
+  ret["decode-time"] = PackPercentiles(stats.decodeTimes);
+
+  if (stats.nodes.size()) {
+    std::vector<xmlrpc_c::value> nodes;
+    for (size_t i = 0; i < stats.nodes.size(); ++i) {
+      std::map<std::string, xmlrpc_c::value> node;
+      node["id"] = xmlrpc_c::value_int(stats.nodes[i].id);
+      node["requests"] = xmlrpc_c::value_int(stats.nodes[i].numTasks);
+      node["busy-time"] = xmlrpc_c::value_double(stats.nodes[i].busyTime);
+      nodes.push_back(xmlrpc_c::value_struct(node));
+    }
+    ret["numa-nodes"] = xmlrpc_c::value_array(nodes);
+  }
+  *retvalP = xmlrpc_c::value_struct(ret);
+}
+
+} /* namespace Moses2 */
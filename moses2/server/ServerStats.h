@@ -0,0 +1,27 @@
+/*
+ * ServerStats.h
+ *
+ * xmlrpc method "stats": load and latency of the translation request queue
+ */
+#pragma once
+#include <xmlrpc-c/base.hpp>
+#include <xmlrpc-c/registry.hpp>
+
+namespace Moses2
+{
+class RequestQueue;
+
+class ServerStats : public xmlrpc_c::method
+{
+public:
+  explicit ServerStats(const RequestQueue &queue);
+
+  void execute(xmlrpc_c::paramList const& paramList,
+               xmlrpc_c::value *   const  retvalP);
+
+protected:
+  const RequestQueue &m_queue;
+};
+
+} /* namespace Moses2 */
+
@@ -1,6 +1,7 @@
 #include <boost/foreach.hpp>
 #include "TranslationRequest.h"
 #include "../ManagerBase.h"
+#include "../PhraseBased/Manager.h"
 #include "../System.h"
 
 using namespace std;
@@ -22,6 +23,13 @@ TranslationRequest(xmlrpc_c::paramList const& paramList,
 
 }
 
+TranslationRequest::
+~TranslationRequest()
+{
+  // still there if the request queue refused the request
+  delete m_mgr;
+}
+
 boost::shared_ptr<TranslationRequest>
 TranslationRequest::
 create(Translator* translator,
@@ -44,7 +52,36 @@ TranslationRequest::
 Run()
 {
   m_mgr->Decode();
+  Finish();
+
+  delete m_mgr;
+  m_mgr = NULL;
+}
+
+void
+TranslationRequest::
+RunTogether(const std::vector<boost::shared_ptr<TranslationRequest> > &requests)
+{
+  std::vector<Manager*> mgrs;
+  BOOST_FOREACH(const boost::shared_ptr<TranslationRequest> &request, requests) {
+    mgrs.push_back(static_cast<Manager*>(request->m_mgr));
+  }
+  Manager::DecodeTogether(mgrs);
+
+  // deleting a manager resets the pools of this thread, which they all use
+  BOOST_FOREACH(const boost::shared_ptr<TranslationRequest> &request, requests) {
+    request->Finish();
+  }
+  BOOST_FOREACH(const boost::shared_ptr<TranslationRequest> &request, requests) {
+    delete request->m_mgr;
+    request->m_mgr = NULL;
+  }
+}
 
+void
+TranslationRequest::
+Finish()
+{
   string out;
   out = m_mgr->OutputBest();
   m_retData["text"] = xmlrpc_c::value_string(out);
@@ -54,8 +91,6 @@ Run()
     m_done = true;
   }
   m_cond.notify_one();
-
-  delete m_mgr;
 }
 
 void TranslationRequest::pack_hypothesis(const Manager& manager, Hypothesis const* h,
@@ -46,6 +46,8 @@ protected:
 
 public:
 
+  virtual ~TranslationRequest();
+
   static
   boost::shared_ptr<TranslationRequest>
   create(Translator* translator,
@@ -75,6 +77,17 @@ public:
   void
   Run();
 
+  /** decodes the requests together, see Manager::DecodeTogether(). For the
+   * phrase-based decoder only
+   */
+  static
+  void
+  RunTogether(const std::vector<boost::shared_ptr<TranslationRequest> > &requests);
+
+protected:
+  //! the output of the decoded sentence, to the waiting xmlrpc call
+  void
+  Finish();
 
 };
 
@@ -15,9 +15,25 @@ using namespace std;
 namespace Moses2
 {
 
+namespace
+{
+size_t CountTokens(const std::string &line)
+{
+  size_t ret = 0;
+  bool inToken = false;
+  for (size_t i = 0; i < line.size(); ++i) {
+    bool isSpace = (line[i] == ' ' || line[i] == '\t');
+    if (!isSpace && !inToken) {
+      ++ret;
+    }
+    inToken = !isSpace;
+  }
+  return ret;
+}
+}
+
 Translator::Translator(Server& server, System &system)
   : m_server(server),
-    m_threadPool(server.options().numThreads),
     m_system(system),
     m_translationId(0)
 {
@@ -57,7 +73,10 @@ void Translator::execute(xmlrpc_c::paramList const& paramList,
   boost::mutex mut;
   boost::shared_ptr<TranslationRequest> task;
   task = TranslationRequest::create(this, paramList,cond,mut, m_system, line, translationId);
-  m_threadPool.Submit(task);
+  if (!m_server.GetRequestQueue().Submit(task, CountTokens(line))) {
+    throw xmlrpc_c::fault("Server busy: too many requests waiting, try again later",
+                          xmlrpc_c::fault::CODE_LIMIT_EXCEEDED);
+  }
   boost::unique_lock<boost::mutex> lock(mut);
   while (!task->IsDone()) {
     cond.wait(lock);
@@ -10,7 +10,6 @@
 #include <xmlrpc-c/base.hpp>
 #include <xmlrpc-c/registry.hpp>
 #include <xmlrpc-c/server_abyss.hpp>
-#include "../legacy/ThreadPool.h"
 
 namespace Moses2
 {
@@ -29,7 +28,6 @@ public:
 
 protected:
   Server& m_server;
-  Moses2::ThreadPool m_threadPool;
   System &m_system;
   long m_translationId;
   boost::shared_mutex m_accessLock;
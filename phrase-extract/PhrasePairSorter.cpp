@@ -0,0 +1,374 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2010 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "PhrasePairSorter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "OutputFileStream.h"
+#include "util/exception.hh"
+
+namespace MosesTraining
+{
+
+PhrasePairLayout::PhrasePairLayout(size_t maxPhraseLength)
+  : m_maxPhraseLength(maxPhraseLength)
+{
+  UTIL_THROW_IF2(maxPhraseLength == 0 || maxPhraseLength > 255,
+                 "phrase length " << maxPhraseLength << " out of range for sorting");
+  m_alignmentOffset = sizeof(Header) + 2 * maxPhraseLength * sizeof(WORD_ID);
+  m_entrySize = m_alignmentOffset + 2 * MaxAlignmentLength();
+  // keep the header and words of consecutive records aligned
+  m_entrySize += (sizeof(uint32_t) - m_entrySize % sizeof(uint32_t)) % sizeof(uint32_t);
+}
+
+PhrasePairLine::PhrasePairLine(const PhrasePairLayout &layout, Vocabulary &vocab,
+                               Vocabulary &orientations, ExtractFileType type,
+                               bool includeSentenceId, const void *record)
+  : m_header(PhrasePairLayout::GetHeader(record))
+  , m_words(PhrasePairLayout::GetWords(record))
+  , m_alignment(layout.GetAlignment(record))
+  , m_vocab(vocab)
+  , m_orientations(orientations)
+  , m_type(type)
+  , m_includeSentenceId(includeSentenceId)
+  , m_stage(0)
+  , m_index(0)
+  , m_space(false)
+{
+}
+
+bool PhrasePairLine::NextWord(const WORD_ID *words, size_t length, StringPiece &piece)
+{
+  if (m_space) {
+    m_space = false;
+    piece = StringPiece(" ", 1);
+    return true;
+  }
+  if (m_index < length) {
+    const std::string &word = m_vocab.getWord(words[m_index++]);
+    piece = StringPiece(word.data(), word.size());
+    m_space = true;
+    return true;
+  }
+  m_index = 0;
+  return false;
+}
+
+// Lines as written by ExtractTask::addPhrase():
+//   direct:      "f1 f2 ||| e1 e2 ||| 0-0 1-1"       (+ " ||| id")
+//   inverse:     "e1 e2 ||| f1 f2 ||| 0-0 1-1"
+//   orientation: "f1 f2 ||| e1 e2 ||| mono mono"
+bool PhrasePairLine::Next(StringPiece &piece)
+{
+  const WORD_ID *source = m_words;
+  const WORD_ID *target = m_words + m_header.sourceLength;
+  const bool inverse = (m_type == ExtractInverse);
+
+  switch (m_stage) {
+  case 0:
+    if (inverse ? NextWord(target, m_header.targetLength, piece)
+        : NextWord(source, m_header.sourceLength, piece)) {
+      return true;
+    }
+    m_stage = 1;
+    piece = StringPiece("||| ", 4);
+    return true;
+  case 1:
+    if (inverse ? NextWord(source, m_header.sourceLength, piece)
+        : NextWord(target, m_header.targetLength, piece)) {
+      return true;
+    }
+    if (m_type == ExtractOrientation) {
+      m_stage = 3;
+      piece = StringPiece("||| ", 4);
+    } else {
+      m_stage = 2;
+      piece = StringPiece("|||", 3);
+    }
+    return true;
+  case 2:
+    if (m_index < m_header.alignmentLength) {
+      const uint8_t *point = m_alignment + 2 * m_index++;
+      int length = inverse
+                   ? sprintf(m_buffer, " %u-%u", (unsigned) point[1], (unsigned) point[0])
+                   : sprintf(m_buffer, " %u-%u", (unsigned) point[0], (unsigned) point[1]);
+      piece = StringPiece(m_buffer, length);
+      return true;
+    }
+    m_stage = 4;
+    if (m_type == ExtractDirect && m_includeSentenceId) {
+      int length = sprintf(m_buffer, " ||| %u", (unsigned) m_header.sentenceId);
+      piece = StringPiece(m_buffer, length);
+      return true;
+    }
+    return false;
+  case 3: {
+    m_stage = 4;
+    const std::string &orientation = m_orientations.getWord(m_header.orientation);
+    piece = StringPiece(orientation.data(), orientation.size());
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+namespace
+{
+const StringPiece kSeparator("|||", 3);
+
+/* -1, 0 or 1 as the byte order of two tokens of a line, each followed by
+ * a space or, if last, by the end of the line, which comes first
+ */
+int CompareTokens(const StringPiece &first, bool firstLast,
+                  const StringPiece &second, bool secondLast)
+{
+  size_t length = std::min(first.size(), second.size());
+  int cmp = memcmp(first.data(), second.data(), length);
+  if (cmp) {
+    return cmp < 0 ? -1 : 1;
+  }
+  // compare what follows the shorter token with the next byte of the other
+  int next1 = first.size() > length ? (unsigned char) first[length] : (firstLast ? -1 : ' ');
+  int next2 = second.size() > length ? (unsigned char) second[length] : (secondLast ? -1 : ' ');
+  return next1 < next2 ? -1 : (next1 > next2 ? 1 : 0);
+}
+
+unsigned NumDigits(uint64_t number)
+{
+  unsigned ret = 1;
+  for (; number >= 10; number /= 10) {
+    ++ret;
+  }
+  return ret;
+}
+
+/* -1, 0 or 1 as the byte order of the decimal strings of two numbers,
+ * where a string comes before any longer string it is a prefix of
+ */
+int CompareDecimal(uint64_t first, uint64_t second)
+{
+  unsigned digits1 = NumDigits(first), digits2 = NumDigits(second);
+  for (unsigned i = digits1; i < digits2; ++i) {
+    second /= 10;
+  }
+  for (unsigned i = digits2; i < digits1; ++i) {
+    first /= 10;
+  }
+  if (first != second) {
+    return first < second ? -1 : 1;
+  }
+  return digits1 < digits2 ? -1 : (digits1 > digits2 ? 1 : 0);
+}
+}
+
+// Lines consist of words, which never come last, "|||" and, at the end,
+// alignment points, sentence ids or the orientation. Records are compared
+// as these tokens, so that no line is printed.
+bool PhrasePairOrder::operator()(const void *first, const void *second) const
+{
+  const PhrasePairLayout::Header &header1 = PhrasePairLayout::GetHeader(first);
+  const PhrasePairLayout::Header &header2 = PhrasePairLayout::GetHeader(second);
+  const WORD_ID *words1 = PhrasePairLayout::GetWords(first);
+  const WORD_ID *words2 = PhrasePairLayout::GetWords(second);
+  const bool inverse = (m_type == ExtractInverse);
+  const bool sentenceId = (m_type == ExtractDirect && m_includeSentenceId);
+
+  // the two phrases, each followed by "|||"
+  for (size_t phrase = 0; phrase < 2; ++phrase) {
+    const bool source = (phrase == 0) != inverse;
+    const WORD_ID *phrase1 = source ? words1 : words1 + header1.sourceLength;
+    const WORD_ID *phrase2 = source ? words2 : words2 + header2.sourceLength;
+    size_t length1 = source ? header1.sourceLength : header1.targetLength;
+    size_t length2 = source ? header2.sourceLength : header2.targetLength;
+
+    size_t i = 0;
+    while (i < length1 && i < length2 && phrase1[i] == phrase2[i]) {
+      ++i;
+    }
+    if (i == length1 && i == length2) {
+      continue;
+    }
+    // "|||" ends a line if only the alignment would follow, and there is none
+    bool last1 = phrase == 1 && m_type != ExtractOrientation && !sentenceId && header1.alignmentLength == 0;
+    bool last2 = phrase == 1 && m_type != ExtractOrientation && !sentenceId && header2.alignmentLength == 0;
+    StringPiece token1 = kSeparator, token2 = kSeparator;
+    if (i < length1) {
+      token1 = m_vocab->getWord(phrase1[i]);
+      last1 = false;
+    }
+    if (i < length2) {
+      token2 = m_vocab->getWord(phrase2[i]);
+      last2 = false;
+    }
+    return CompareTokens(token1, last1, token2, last2) < 0;
+  }
+
+  if (m_type == ExtractOrientation) {
+    if (header1.orientation == header2.orientation) {
+      return false;
+    }
+    return CompareTokens(m_orientations->getWord(header1.orientation), true,
+                         m_orientations->getWord(header2.orientation), true) < 0;
+  }
+
+  // alignment points "s-t", or "t-s" in the inverse file
+  const uint8_t *alignment1 = m_layout->GetAlignment(first);
+  const uint8_t *alignment2 = m_layout->GetAlignment(second);
+  const size_t firstIndex = inverse ? 1 : 0;
+  for (size_t i = 0; i < header1.alignmentLength && i < header2.alignmentLength; ++i) {
+    const uint8_t *point1 = alignment1 + 2 * i;
+    const uint8_t *point2 = alignment2 + 2 * i;
+    int cmp = CompareDecimal(point1[firstIndex], point2[firstIndex]);
+    if (!cmp) {
+      cmp = CompareDecimal(point1[1 - firstIndex], point2[1 - firstIndex]);
+    }
+    if (cmp) {
+      return cmp < 0;
+    }
+  }
+  if (header1.alignmentLength != header2.alignmentLength) {
+    // the line with fewer points ends, or goes on with " ||| id", which
+    // comes after a digit
+    return (header1.alignmentLength < header2.alignmentLength) != sentenceId;
+  }
+  return sentenceId && CompareDecimal(header1.sentenceId, header2.sentenceId) < 0;
+}
+
+PhrasePairSorter::PhrasePairSorter(const std::string &fileNameExtract, bool gzOutput,
+                                   size_t maxPhraseLength,
+                                   bool translationFlag, bool orientationFlag,
+                                   bool includeSentenceId,
+                                   size_t memory, const std::string &tempPrefix)
+  : m_layout(maxPhraseLength)
+  , m_includeSentenceId(includeSentenceId)
+{
+  const char *suffixes[NumExtractFileTypes] = { "", ".inv", ".o" };
+  m_files[ExtractDirect].active = translationFlag;
+  m_files[ExtractInverse].active = translationFlag;
+  m_files[ExtractOrientation].active = orientationFlag;
+
+  size_t numActive = (translationFlag ? 2 : 0) + (orientationFlag ? 1 : 0);
+  m_memory = memory / std::max<size_t>(numActive, 1);
+
+  util::stream::ChainConfig chainConfig;
+  chainConfig.entry_size = m_layout.EntrySize();
+  chainConfig.block_count = 2;
+  chainConfig.total_memory = m_memory;
+
+  util::stream::SortConfig sortConfig;
+  sortConfig.temp_prefix = tempPrefix;
+  sortConfig.buffer_size = std::max(m_memory / 16, m_layout.EntrySize());
+  sortConfig.total_memory = std::max(m_memory, 4 * sortConfig.buffer_size);
+
+  for (size_t i = 0; i < NumExtractFileTypes; ++i) {
+    File &file = m_files[i];
+    file.count = 0;
+    if (!file.active) {
+      continue;
+    }
+    file.fileName = fileNameExtract + suffixes[i] + ".sorted" + (gzOutput ? ".gz" : "");
+    file.chain.reset(new util::stream::Chain(chainConfig));
+    *file.chain >> file.stream;
+    PhrasePairOrder order(m_layout, m_vocab, m_orientations, (ExtractFileType) i, includeSentenceId);
+    file.sort.reset(new Sort(*file.chain, sortConfig, order));
+  }
+}
+
+PhrasePairSorter::~PhrasePairSorter()
+{
+}
+
+void PhrasePairSorter::Add(File &file, const std::vector<uint8_t> &records)
+{
+  const size_t entrySize = m_layout.EntrySize();
+  for (size_t offset = 0; offset < records.size(); offset += entrySize) {
+    memcpy(file.stream.Get(), &records[offset], entrySize);
+    ++file.stream;
+    ++file.count;
+  }
+}
+
+void PhrasePairSorter::AddTranslations(const std::vector<uint8_t> &records)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  Add(m_files[ExtractDirect], records);
+  Add(m_files[ExtractInverse], records);
+}
+
+void PhrasePairSorter::AddOrientations(const std::vector<uint8_t> &records)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  Add(m_files[ExtractOrientation], records);
+}
+
+void PhrasePairSorter::Finish()
+{
+  // let all files finish sorting their last blocks before merging any
+  for (size_t i = 0; i < NumExtractFileTypes; ++i) {
+    if (m_files[i].active) {
+      m_files[i].stream.Poison();
+    }
+  }
+
+  boost::thread_group writers;
+  for (size_t i = 0; i < NumExtractFileTypes; ++i) {
+    if (m_files[i].active) {
+      writers.create_thread(boost::bind(&PhrasePairSorter::Write, this, (ExtractFileType) i));
+    }
+  }
+  writers.join_all();
+}
+
+void PhrasePairSorter::Write(ExtractFileType type)
+{
+  File &file = m_files[type];
+  file.chain->Wait(true);
+
+  Moses::OutputFileStream out;
+  UTIL_THROW_IF2(!out.Open(file.fileName), "could not open " << file.fileName);
+
+  file.sort->Output(*file.chain);
+  util::stream::Stream sorted;
+  *file.chain >> sorted >> util::stream::kRecycle;
+
+  std::string line;
+  for (; sorted; ++sorted) {
+    line.clear();
+    PhrasePairLine pieces(m_layout, m_vocab, m_orientations, type, m_includeSentenceId, sorted.Get());
+    StringPiece piece;
+    while (pieces.Next(piece)) {
+      line.append(piece.data(), piece.size());
+    }
+    line += '\n';
+    out << line;
+  }
+  file.chain->Wait(true);
+  out.Close();
+}
+
+}
+
@@ -0,0 +1,217 @@
+#pragma once
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2010 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "tables-core.h"
+#include "util/string_piece.hh"
+#include "util/stream/chain.hh"
+#include "util/stream/sort.hh"
+#include "util/stream/stream.hh"
+
+namespace MosesTraining
+{
+
+/** Fixed-size binary form of an extracted phrase pair, so that util::stream
+ * can sort it. Words are ids in PhrasePairSorter's vocabulary, alignment
+ * points are positions within the phrases, in the order extract writes them.
+ */
+class PhrasePairLayout
+{
+public:
+  struct Header {
+    uint32_t sentenceId;
+    WORD_ID orientation;
+    uint8_t sourceLength;
+    uint8_t targetLength;
+    uint16_t alignmentLength;
+  };
+
+  explicit PhrasePairLayout(size_t maxPhraseLength);
+
+  size_t EntrySize() const {
+    return m_entrySize;
+  }
+  size_t MaxAlignmentLength() const {
+    return m_maxPhraseLength * m_maxPhraseLength;
+  }
+
+  static const Header &GetHeader(const void *record) {
+    return *static_cast<const Header*>(record);
+  }
+  static Header &GetHeader(void *record) {
+    return *static_cast<Header*>(record);
+  }
+  // source words followed by target words
+  static const WORD_ID *GetWords(const void *record) {
+    return reinterpret_cast<const WORD_ID*>(static_cast<const uint8_t*>(record) + sizeof(Header));
+  }
+  static WORD_ID *GetWords(void *record) {
+    return reinterpret_cast<WORD_ID*>(static_cast<uint8_t*>(record) + sizeof(Header));
+  }
+  // (source, target) position pairs
+  const uint8_t *GetAlignment(const void *record) const {
+    return static_cast<const uint8_t*>(record) + m_alignmentOffset;
+  }
+  uint8_t *GetAlignment(void *record) const {
+    return static_cast<uint8_t*>(record) + m_alignmentOffset;
+  }
+
+private:
+  size_t m_maxPhraseLength;
+  size_t m_alignmentOffset;
+  size_t m_entrySize;
+};
+
+/** The three files extract writes for phrase-based models. */
+enum ExtractFileType {
+  ExtractDirect,
+  ExtractInverse,
+  ExtractOrientation,
+  NumExtractFileTypes
+};
+
+/** Produces the text of the line extract would have written for a record,
+ * a piece at a time.
+ */
+class PhrasePairLine
+{
+public:
+  PhrasePairLine(const PhrasePairLayout &layout, Vocabulary &vocab,
+                 Vocabulary &orientations, ExtractFileType type,
+                 bool includeSentenceId, const void *record);
+
+  //! next piece of the line. False at the end of the line
+  bool Next(StringPiece &piece);
+
+private:
+  const PhrasePairLayout::Header &m_header;
+  const WORD_ID *m_words;
+  const uint8_t *m_alignment;
+  Vocabulary &m_vocab;
+  Vocabulary &m_orientations;
+  ExtractFileType m_type;
+  bool m_includeSentenceId;
+
+  int m_stage;
+  size_t m_index;
+  bool m_space;
+  char m_buffer[32];
+
+  bool NextWord(const WORD_ID *words, size_t length, StringPiece &piece);
+};
+
+/** Less-than over records, equal to LC_ALL=C sort over the lines. Compares
+ * word ids, alignment points and sentence ids, and looks up only the first
+ * pair of words that differ.
+ */
+class PhrasePairOrder
+{
+public:
+  PhrasePairOrder(const PhrasePairLayout &layout, Vocabulary &vocab,
+                  Vocabulary &orientations, ExtractFileType type,
+                  bool includeSentenceId)
+    : m_layout(&layout)
+    , m_vocab(&vocab)
+    , m_orientations(&orientations)
+    , m_type(type)
+    , m_includeSentenceId(includeSentenceId) {
+  }
+
+  bool operator()(const void *first, const void *second) const;
+
+private:
+  const PhrasePairLayout *m_layout;
+  Vocabulary *m_vocab;
+  Vocabulary *m_orientations;
+  ExtractFileType m_type;
+  bool m_includeSentenceId;
+};
+
+/** Replaces writing extract files and sorting them with an external sort.
+ * Extraction threads Add() packed phrase pairs, which are sorted in memory
+ * or, beyond the memory limit, with an external merge sort through
+ * util::stream::Sort. Finish() writes the sorted files, e.g. extract.sorted.gz
+ * and extract.inv.sorted.gz, ready to be scored.
+ */
+class PhrasePairSorter
+{
+public:
+  PhrasePairSorter(const std::string &fileNameExtract, bool gzOutput,
+                   size_t maxPhraseLength,
+                   bool translationFlag, bool orientationFlag,
+                   bool includeSentenceId,
+                   size_t memory, const std::string &tempPrefix);
+  ~PhrasePairSorter();
+
+  const PhrasePairLayout &GetLayout() const {
+    return m_layout;
+  }
+
+  //! words of all phrases share one vocabulary. Thread-safe
+  WORD_ID StoreWord(const std::string &word) {
+    return m_vocab.storeIfNew(word);
+  }
+  WORD_ID StoreOrientation(const std::string &orientationInfo) {
+    return m_orientations.storeIfNew(orientationInfo);
+  }
+
+  /** Append packed records, EntrySize() bytes each. Translation records go
+   * to the direct and the inverse file. Thread-safe.
+   */
+  void AddTranslations(const std::vector<uint8_t> &records);
+  void AddOrientations(const std::vector<uint8_t> &records);
+
+  //! sort and write all files. Call once, after the last Add
+  void Finish();
+
+private:
+  typedef util::stream::Sort<PhrasePairOrder> Sort;
+
+  struct File {
+    bool active;
+    std::string fileName;
+    boost::scoped_ptr<util::stream::Chain> chain;
+    util::stream::Stream stream;
+    boost::scoped_ptr<Sort> sort;
+    uint64_t count;
+  };
+
+  PhrasePairLayout m_layout;
+  bool m_includeSentenceId;
+  size_t m_memory;
+  Vocabulary m_vocab;
+  Vocabulary m_orientations;
+
+  boost::mutex m_mutex;
+  File m_files[NumExtractFileTypes];
+
+  void Add(File &file, const std::vector<uint8_t> &records);
+  void Write(ExtractFileType type);
+};
+
+}
+
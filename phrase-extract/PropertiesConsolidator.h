@@ -20,12 +20,11 @@
 
 #pragma once
 
+#include <ostream>
 #include <string>
 #include <map>
 #include <vector>
 
-#include "OutputFileStream.h"
-
 
 namespace MosesTraining
 {
@@ -46,13 +45,13 @@ public:
 
   bool GetPOSPropertyValueFromPropertiesString(const std::string &propertiesString, std::vector<std::string>& out) const;
 
-  void ProcessPropertiesString(const std::string &propertiesString, Moses::OutputFileStream& out) const;
+  void ProcessPropertiesString(const std::string &propertiesString, std::ostream& out) const;
 
 protected:
 
-  void ProcessSourceLabelsPropertyValue(const std::string &value, Moses::OutputFileStream& out) const;
-  void ProcessPOSPropertyValue(const std::string &value, Moses::OutputFileStream& out) const;
-  void ProcessTargetSyntacticPreferencesPropertyValue(const std::string &value, Moses::OutputFileStream& out) const;
+  void ProcessSourceLabelsPropertyValue(const std::string &value, std::ostream& out) const;
+  void ProcessPOSPropertyValue(const std::string &value, std::ostream& out) const;
+  void ProcessTargetSyntacticPreferencesPropertyValue(const std::string &value, std::ostream& out) const;
 
   bool m_sourceLabelsFlag;
   std::map<std::string,size_t> m_sourceLabels;
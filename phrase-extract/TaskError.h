@@ -0,0 +1,61 @@
+#pragma once
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2010 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include <boost/exception_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace MosesTraining
+{
+
+/** The first exception thrown by the tasks of a Moses::ThreadPool. An
+ * exception must not leave Task::Run, or the worker thread terminates the
+ * process, so tasks keep it here and the thread that owns the pool rethrows
+ * it once the pool has stopped, as a single-threaded run would have thrown it.
+ */
+class TaskError
+{
+public:
+  //! keeps the exception being handled, unless an earlier one is kept
+  void SetCurrent() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (!m_error) {
+      m_error = boost::current_exception();
+    }
+  }
+
+  //! later tasks may skip their work, their output is not written anyway
+  bool IsSet() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return bool(m_error);
+  }
+
+  void Rethrow() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (m_error) {
+      boost::rethrow_exception(m_error);
+    }
+  }
+
+private:
+  mutable boost::mutex m_mutex;
+  boost::exception_ptr m_error;
+};
+
+}
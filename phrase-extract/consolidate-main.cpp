@@ -18,14 +18,20 @@
  ***********************************************************************/
 
 #include <cstdlib>
+#include <sstream>
 #include <vector>
 #include <string>
 
+#include <boost/shared_ptr.hpp>
+
 #include "util/exception.hh"
+#include "moses/OutputCollector.h"
+#include "moses/ThreadPool.h"
 #include "moses/Util.h"
 #include "InputFileStream.h"
 #include "OutputFileStream.h"
 #include "PropertiesConsolidator.h"
+#include "TaskError.h"
 
 
 bool countsProperty = false;
@@ -42,6 +48,7 @@ bool targetSyntacticPreferencesFlag = false;
 bool sparseCountBinFeatureFlag = false;
 
 std::vector< int > countBin;
+size_t threadCount = 1;
 float minScore0 = 0;
 float minScore2 = 0;
 
@@ -54,6 +61,16 @@ void processFiles( const std::string&, const std::string&, const std::string&, c
 void loadCountOfCounts( const std::string& );
 void breakdownCoreAndSparse( const std::string &combined, std::string &core, std::string &sparse );
 bool getLine( Moses::InputFileStream &file, std::vector< std::string > &item );
+void consolidateLine( const std::vector< std::string > &itemDirect,
+                      const std::vector< std::string > &itemIndirect,
+                      int i,
+                      const MosesTraining::PropertiesConsolidator &propertiesConsolidator,
+                      std::ostream &out );
+#ifdef WITH_THREADS
+void consolidateParallel( Moses::InputFileStream &fileDirect, Moses::InputFileStream &fileIndirect,
+                          const MosesTraining::PropertiesConsolidator &propertiesConsolidator,
+                          std::ostream &out );
+#endif
 
 
 inline float maybeLogProb( float a )
@@ -84,7 +101,8 @@ int main(int argc, char* argv[])
               "[--KneserNey counts-of-counts-file] [--LowCountFeature] "
               "[--SourceLabels source-labels-file] "
               "[--PartsOfSpeech parts-of-speech-file] "
-              "[--MinScore id:threshold[,id:threshold]*]"
+              "[--MinScore id:threshold[,id:threshold]*] "
+              "[--Threads num]"
               << std::endl;
     exit(1);
   }
@@ -184,6 +202,15 @@ int main(int argc, char* argv[])
           UTIL_THROW2("MinScore currently only supported for indirect (0) and direct (2) phrase translation probabilities");
         }
       }
+    } else if (strcmp(argv[i],"--Threads") == 0) {
+      UTIL_THROW_IF2(i+1==argc, "specify number of threads!");
+#ifdef WITH_THREADS
+      threadCount = std::max(1, std::atoi( argv[++i] ));
+      std::cerr << "consolidating with " << threadCount << " threads" << std::endl;
+#else
+      ++i;
+      std::cerr << "WARNING: thread support not compiled in, consolidating with 1 thread" << std::endl;
+#endif
     } else {
       UTIL_THROW2("unknown option " << argv[i]);
     }
@@ -268,192 +295,299 @@ void processFiles( const std::string& fileNameDirect,
     propertiesConsolidator.ActivateTargetSyntacticPreferencesProcessing(fileNameTargetSyntacticPreferencesLabelSet);
   }
 
-  // loop through all extracted phrase translations
-  int i=0;
-  while(true) {
-    // Print progress dots to stderr.
-    i++;
-    if (i%100000 == 0) std::cerr << "." << std::flush;
-
-    std::vector< std::string > itemDirect, itemIndirect;
-    if (! getLine(fileIndirect, itemIndirect) ||
-        ! getLine(fileDirect, itemDirect))
-      break;
-
-    // direct: target source alignment probabilities
-    // indirect: source target probabilities
-
-    // consistency checks
-    UTIL_THROW_IF2(itemDirect[0].compare( itemIndirect[0] ) != 0,
-                   "target phrase does not match in line " << i << ": '" << itemDirect[0] << "' != '" << itemIndirect[0] << "'");
-    UTIL_THROW_IF2(itemDirect[1].compare( itemIndirect[1] ) != 0,
-                   "source phrase does not match in line " << i << ": '" << itemDirect[1] << "' != '" << itemIndirect[1] << "'");
-
-    // SCORES ...
-    std::string directScores, directSparseScores, indirectScores, indirectSparseScores;
-    breakdownCoreAndSparse( itemDirect[3], directScores, directSparseScores );
-    breakdownCoreAndSparse( itemIndirect[3], indirectScores, indirectSparseScores );
-
-    std::vector<std::string> directCounts;
-    Moses::Tokenize( directCounts, itemDirect[4] );
-    std::vector<std::string> indirectCounts;
-    Moses::Tokenize( indirectCounts, itemIndirect[4] );
-    float countF  = std::atof( directCounts[0].c_str() );
-    float countE  = std::atof( indirectCounts[0].c_str() );
-    float countEF = std::atof( indirectCounts[1].c_str() );
-    float n1_F, n1_E;
-    if (kneserNeyFlag) {
-      n1_F = std::atof( directCounts[2].c_str() );
-      n1_E = std::atof( indirectCounts[2].c_str() );
+#ifdef WITH_THREADS
+  if (threadCount > 1) {
+    consolidateParallel( fileDirect, fileIndirect, propertiesConsolidator, fileConsolidated );
+  } else
+#endif
+  {
+    // loop through all extracted phrase translations
+    int i=0;
+    while(true) {
+      // Print progress dots to stderr.
+      i++;
+      if (i%100000 == 0) std::cerr << "." << std::flush;
+
+      std::vector< std::string > itemDirect, itemIndirect;
+      if (! getLine(fileIndirect, itemIndirect) ||
+          ! getLine(fileDirect, itemDirect))
+        break;
+
+      consolidateLine( itemDirect, itemIndirect, i, propertiesConsolidator, fileConsolidated );
     }
+  }
 
-    // Good Turing discounting
-    float adjustedCountEF = countEF;
-    if (goodTuringFlag && countEF+0.99999 < goodTuringDiscount.size()-1)
-      adjustedCountEF *= goodTuringDiscount[(int)(countEF+0.99998)];
-    float adjustedCountEF_indirect = adjustedCountEF;
-
-    // Kneser Ney discounting [Foster et al, 2006]
-    if (kneserNeyFlag) {
-      float D = kneserNey_D3;
-      if (countEF < 2) D = kneserNey_D1;
-      else if (countEF < 3) D = kneserNey_D2;
-      if (D > countEF) D = countEF - 0.01; // sanity constraint
-
-      float p_b_E = n1_E / totalCount; // target phrase prob based on distinct
-      float alpha_F = D * n1_F / countF; // available mass
-      adjustedCountEF = countEF - D + countF * alpha_F * p_b_E;
-
-      // for indirect
-      float p_b_F = n1_F / totalCount; // target phrase prob based on distinct
-      float alpha_E = D * n1_E / countE; // available mass
-      adjustedCountEF_indirect = countEF - D + countE * alpha_E * p_b_F;
-    }
+  fileDirect.Close();
+  fileIndirect.Close();
+  fileConsolidated.Close();
 
-    // drop due to MinScore thresholding
-    if ((minScore0 > 0 && adjustedCountEF_indirect/countE < minScore0) ||
-        (minScore2 > 0 && adjustedCountEF         /countF < minScore2)) {
-      continue;
-    }
+  // We've been printing progress dots to stderr.  End the line.
+  std::cerr << std::endl;
+}
 
-    // output phrase pair
-    fileConsolidated << itemDirect[0] << " ||| ";
-
-    if (partsOfSpeechFlag) {
-      // write POS factor from property
-      std::vector<std::string> targetTokens;
-      Moses::Tokenize( targetTokens, itemDirect[1] );
-      std::vector<std::string> propertyValuePOS;
-      propertiesConsolidator.GetPOSPropertyValueFromPropertiesString(itemDirect[5], propertyValuePOS);
-      size_t targetTerminalIndex = 0;
-      for (std::vector<std::string>::const_iterator targetTokensIt=targetTokens.begin();
-           targetTokensIt!=targetTokens.end(); ++targetTokensIt) {
-        fileConsolidated << *targetTokensIt;
-        if (!isNonTerminal(*targetTokensIt)) {
-          assert(propertyValuePOS.size() > targetTerminalIndex);
-          fileConsolidated << "|" << propertyValuePOS[targetTerminalIndex];
-          ++targetTerminalIndex;
-        }
-        fileConsolidated << " ";
-      }
-      fileConsolidated << "|||";
 
-    } else {
+void consolidateLine( const std::vector< std::string > &itemDirect,
+                      const std::vector< std::string > &itemIndirect,
+                      int i,
+                      const MosesTraining::PropertiesConsolidator &propertiesConsolidator,
+                      std::ostream &out )
+{
+  // direct: target source alignment probabilities
+  // indirect: source target probabilities
+
+  // consistency checks
+  UTIL_THROW_IF2(itemDirect[0].compare( itemIndirect[0] ) != 0,
+                 "target phrase does not match in line " << i << ": '" << itemDirect[0] << "' != '" << itemIndirect[0] << "'");
+  UTIL_THROW_IF2(itemDirect[1].compare( itemIndirect[1] ) != 0,
+                 "source phrase does not match in line " << i << ": '" << itemDirect[1] << "' != '" << itemIndirect[1] << "'");
+
+  // SCORES ...
+  std::string directScores, directSparseScores, indirectScores, indirectSparseScores;
+  breakdownCoreAndSparse( itemDirect[3], directScores, directSparseScores );
+  breakdownCoreAndSparse( itemIndirect[3], indirectScores, indirectSparseScores );
+
+  std::vector<std::string> directCounts;
+  Moses::Tokenize( directCounts, itemDirect[4] );
+  std::vector<std::string> indirectCounts;
+  Moses::Tokenize( indirectCounts, itemIndirect[4] );
+  float countF  = std::atof( directCounts[0].c_str() );
+  float countE  = std::atof( indirectCounts[0].c_str() );
+  float countEF = std::atof( indirectCounts[1].c_str() );
+  float n1_F, n1_E;
+  if (kneserNeyFlag) {
+    n1_F = std::atof( directCounts[2].c_str() );
+    n1_E = std::atof( indirectCounts[2].c_str() );
+  }
 
-      fileConsolidated << itemDirect[1] << " |||";
-    }
+  // Good Turing discounting
+  float adjustedCountEF = countEF;
+  if (goodTuringFlag && countEF+0.99999 < goodTuringDiscount.size()-1)
+    adjustedCountEF *= goodTuringDiscount[(int)(countEF+0.99998)];
+  float adjustedCountEF_indirect = adjustedCountEF;
+
+  // Kneser Ney discounting [Foster et al, 2006]
+  if (kneserNeyFlag) {
+    float D = kneserNey_D3;
+    if (countEF < 2) D = kneserNey_D1;
+    else if (countEF < 3) D = kneserNey_D2;
+    if (D > countEF) D = countEF - 0.01; // sanity constraint
+
+    float p_b_E = n1_E / totalCount; // target phrase prob based on distinct
+    float alpha_F = D * n1_F / countF; // available mass
+    adjustedCountEF = countEF - D + countF * alpha_F * p_b_E;
+
+    // for indirect
+    float p_b_F = n1_F / totalCount; // target phrase prob based on distinct
+    float alpha_E = D * n1_E / countE; // available mass
+    adjustedCountEF_indirect = countEF - D + countE * alpha_E * p_b_F;
+  }
+
+  // drop due to MinScore thresholding
+  if ((minScore0 > 0 && adjustedCountEF_indirect/countE < minScore0) ||
+      (minScore2 > 0 && adjustedCountEF         /countF < minScore2)) {
+    return;
+  }
 
+  // output phrase pair
+  out << itemDirect[0] << " ||| ";
 
-    // prob indirect
-    if (!onlyDirectFlag) {
-      fileConsolidated << " " << maybeLogProb(adjustedCountEF_indirect/countE);
-      fileConsolidated << " " << indirectScores;
+  if (partsOfSpeechFlag) {
+    // write POS factor from property
+    std::vector<std::string> targetTokens;
+    Moses::Tokenize( targetTokens, itemDirect[1] );
+    std::vector<std::string> propertyValuePOS;
+    propertiesConsolidator.GetPOSPropertyValueFromPropertiesString(itemDirect[5], propertyValuePOS);
+    size_t targetTerminalIndex = 0;
+    for (std::vector<std::string>::const_iterator targetTokensIt=targetTokens.begin();
+         targetTokensIt!=targetTokens.end(); ++targetTokensIt) {
+      out << *targetTokensIt;
+      if (!isNonTerminal(*targetTokensIt)) {
+        assert(propertyValuePOS.size() > targetTerminalIndex);
+        out << "|" << propertyValuePOS[targetTerminalIndex];
+        ++targetTerminalIndex;
+      }
+      out << " ";
     }
+    out << "|||";
 
-    // prob direct
-    fileConsolidated << " " << maybeLogProb(adjustedCountEF/countF);
-    fileConsolidated << " " << directScores;
+  } else {
 
-    // phrase count feature
-    if (phraseCountFlag) {
-      fileConsolidated << " " << maybeLogProb(2.718);
-    }
+    out << itemDirect[1] << " |||";
+  }
 
-    // low count feature
-    if (lowCountFlag) {
-      fileConsolidated << " " << maybeLogProb(std::exp(-1.0/countEF));
-    }
 
-    // count bin feature (as a core feature)
-    if (countBin.size()>0 && !sparseCountBinFeatureFlag) {
-      bool foundBin = false;
-      for(size_t i=0; i < countBin.size(); i++) {
-        if (!foundBin && countEF <= countBin[i]) {
-          fileConsolidated << " " << maybeLogProb(2.718);
-          foundBin = true;
-        } else {
-          fileConsolidated << " " << maybeLogProb(1);
-        }
+  // prob indirect
+  if (!onlyDirectFlag) {
+    out << " " << maybeLogProb(adjustedCountEF_indirect/countE);
+    out << " " << indirectScores;
+  }
+
+  // prob direct
+  out << " " << maybeLogProb(adjustedCountEF/countF);
+  out << " " << directScores;
+
+  // phrase count feature
+  if (phraseCountFlag) {
+    out << " " << maybeLogProb(2.718);
+  }
+
+  // low count feature
+  if (lowCountFlag) {
+    out << " " << maybeLogProb(std::exp(-1.0/countEF));
+  }
+
+  // count bin feature (as a core feature)
+  if (countBin.size()>0 && !sparseCountBinFeatureFlag) {
+    bool foundBin = false;
+    for(size_t i=0; i < countBin.size(); i++) {
+      if (!foundBin && countEF <= countBin[i]) {
+        out << " " << maybeLogProb(2.718);
+        foundBin = true;
+      } else {
+        out << " " << maybeLogProb(1);
       }
-      fileConsolidated << " " << maybeLogProb( foundBin ? 1 : 2.718 );
     }
+    out << " " << maybeLogProb( foundBin ? 1 : 2.718 );
+  }
 
-    // alignment
-    fileConsolidated << " |||";
-    if (!itemDirect[2].empty()) {
-      fileConsolidated << " " << itemDirect[2];;
-    }
+  // alignment
+  out << " |||";
+  if (!itemDirect[2].empty()) {
+    out << " " << itemDirect[2];;
+  }
 
-    // counts, for debugging
-    fileConsolidated << " ||| " << countE << " " << countF << " " << countEF;
-
-    // sparse features
-    fileConsolidated << " |||";
-    if (directSparseScores.compare("") != 0)
-      fileConsolidated << " " << directSparseScores;
-    if (indirectSparseScores.compare("") != 0)
-      fileConsolidated << " " << indirectSparseScores;
-
-    // count bin feature (as a sparse feature)
-    if (sparseCountBinFeatureFlag) {
-      bool foundBin = false;
-      for(size_t i=0; i < countBin.size(); i++) {
-        if (!foundBin && countEF <= countBin[i]) {
-          fileConsolidated << " cb_";
-          if (i == 0 && countBin[i] > 1)
-            fileConsolidated << "1_";
-          else if (i > 0 && countBin[i-1]+1 < countBin[i])
-            fileConsolidated << (countBin[i-1]+1) << "_";
-          fileConsolidated << countBin[i] << " 1";
-          foundBin = true;
-        }
-      }
-      if (!foundBin) {
-        fileConsolidated << " cb_max 1";
+  // counts, for debugging
+  out << " ||| " << countE << " " << countF << " " << countEF;
+
+  // sparse features
+  out << " |||";
+  if (directSparseScores.compare("") != 0)
+    out << " " << directSparseScores;
+  if (indirectSparseScores.compare("") != 0)
+    out << " " << indirectSparseScores;
+
+  // count bin feature (as a sparse feature)
+  if (sparseCountBinFeatureFlag) {
+    bool foundBin = false;
+    for(size_t i=0; i < countBin.size(); i++) {
+      if (!foundBin && countEF <= countBin[i]) {
+        out << " cb_";
+        if (i == 0 && countBin[i] > 1)
+          out << "1_";
+        else if (i > 0 && countBin[i-1]+1 < countBin[i])
+          out << (countBin[i-1]+1) << "_";
+        out << countBin[i] << " 1";
+        foundBin = true;
       }
     }
-
-    // arbitrary key-value pairs
-    fileConsolidated << " |||";
-    if (itemDirect.size() >= 6) {
-      propertiesConsolidator.ProcessPropertiesString(itemDirect[5], fileConsolidated);
+    if (!foundBin) {
+      out << " cb_max 1";
     }
+  }
 
-    if (countsProperty) {
-      fileConsolidated << " {{Counts " << countE << " " << countF << " " << countEF << "}}";
-    }
+  // arbitrary key-value pairs
+  out << " |||";
+  if (itemDirect.size() >= 6) {
+    propertiesConsolidator.ProcessPropertiesString(itemDirect[5], out);
+  }
 
-    fileConsolidated << std::endl;
+  if (countsProperty) {
+    out << " {{Counts " << countE << " " << countF << " " << countEF << "}}";
   }
 
-  fileDirect.Close();
-  fileIndirect.Close();
-  fileConsolidated.Close();
+  out << std::endl;
+}
+
+#ifdef WITH_THREADS
+namespace
+{
+
+// Consolidates a block of consecutive lines. Lines are independent of each
+// other, the blocks only exist to keep the per-task overhead down.
+class ConsolidateTask : public Moses::Task
+{
+public:
+  ConsolidateTask( int chunkId, int lineOffset,
+                   std::vector< std::string > &linesDirect,
+                   std::vector< std::string > &linesIndirect,
+                   const MosesTraining::PropertiesConsolidator &propertiesConsolidator,
+                   Moses::OutputCollector &collector, MosesTraining::TaskError &error )
+    : m_chunkId(chunkId)
+    , m_lineOffset(lineOffset)
+    , m_propertiesConsolidator(propertiesConsolidator)
+    , m_collector(collector)
+    , m_error(error) {
+    m_linesDirect.swap(linesDirect);
+    m_linesIndirect.swap(linesIndirect);
+  }
+
+  void Run() {
+    if (m_error.IsSet()) return;
+    try {
+      std::ostringstream out;
+      std::vector< std::string > itemDirect, itemIndirect;
+      for (size_t j = 0; j < m_linesDirect.size(); ++j) {
+        Moses::TokenizeMultiCharSeparator( itemDirect, m_linesDirect[j], " ||| " );
+        Moses::TokenizeMultiCharSeparator( itemIndirect, m_linesIndirect[j], " ||| " );
+        consolidateLine( itemDirect, itemIndirect, m_lineOffset + j + 1, m_propertiesConsolidator, out );
+        itemDirect.clear();
+        itemIndirect.clear();
+      }
+      m_collector.Write( m_chunkId, out.str() );
+    } catch (...) {
+      m_error.SetCurrent();
+    }
+  }
+
+private:
+  int m_chunkId;
+  int m_lineOffset;
+  std::vector< std::string > m_linesDirect, m_linesIndirect;
+  const MosesTraining::PropertiesConsolidator &m_propertiesConsolidator;
+  Moses::OutputCollector &m_collector;
+  MosesTraining::TaskError &m_error;
+};
 
-  // We've been printing progress dots to stderr.  End the line.
-  std::cerr << std::endl;
 }
 
+void consolidateParallel( Moses::InputFileStream &fileDirect, Moses::InputFileStream &fileIndirect,
+                          const MosesTraining::PropertiesConsolidator &propertiesConsolidator,
+                          std::ostream &out )
+{
+  const size_t chunkLines = 10000;
+
+  Moses::OutputCollector collector( &out );
+  MosesTraining::TaskError error;
+  Moses::ThreadPool pool( threadCount );
+  // bounds the number of chunks held in memory
+  pool.SetQueueLimit( threadCount * 2 );
+
+  std::vector< std::string > linesDirect, linesIndirect;
+  std::string lineDirect, lineIndirect;
+  int chunkId = 0, i = 0;
+  while (!error.IsSet() && getline(fileIndirect, lineIndirect) && getline(fileDirect, lineDirect)) {
+    // Print progress dots to stderr.
+    if (++i % 100000 == 0) std::cerr << "." << std::flush;
+
+    linesDirect.push_back( lineDirect );
+    linesIndirect.push_back( lineIndirect );
+    if (linesDirect.size() == chunkLines) {
+      int lineOffset = i - linesDirect.size();
+      boost::shared_ptr<Moses::Task> task(
+        new ConsolidateTask( chunkId++, lineOffset, linesDirect, linesIndirect, propertiesConsolidator, collector, error ) );
+      pool.Submit( task );
+    }
+  }
+  if (!linesDirect.empty()) {
+    int lineOffset = i - linesDirect.size();
+    boost::shared_ptr<Moses::Task> task(
+      new ConsolidateTask( chunkId++, lineOffset, linesDirect, linesIndirect, propertiesConsolidator, collector, error ) );
+    pool.Submit( task );
+  }
+  pool.Stop( true );
+  error.Rethrow();
+}
+#endif
 
 void breakdownCoreAndSparse( const std::string &combined, std::string &core, std::string &sparse )
 {
@@ -12,12 +12,17 @@
 #include <vector>
 #include <limits>
 
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
 #include "tables-core.h"
 #include "InputFileStream.h"
 #include "OutputFileStream.h"
 #include "PhraseExtractionOptions.h"
+#include "PhrasePairSorter.h"
 #include "SentenceAlignmentWithSyntax.h"
 #include "SyntaxNode.h"
+#include "moses/ThreadPool.h"
 #include "moses/Util.h"
 
 using namespace std;
@@ -68,7 +73,7 @@ bool isAligned (SentenceAlignmentWithSyntax &, int, int);
 int sentenceOffset = 0;
 
 
-class ExtractTask
+class ExtractTask : public Moses::Task
 {
 public:
   ExtractTask(
@@ -78,15 +83,22 @@ public:
     Moses::OutputFileStream &extractFileInv,
     Moses::OutputFileStream &extractFileOrientation,
     Moses::OutputFileStream &extractFileContext,
-    Moses::OutputFileStream &extractFileContextInv):
+    Moses::OutputFileStream &extractFileContextInv,
+    PhrasePairSorter *sorter = NULL):
     m_sentence(sentence),
     m_options(initoptions),
     m_extractFile(extractFile),
     m_extractFileInv(extractFileInv),
     m_extractFileOrientation(extractFileOrientation),
     m_extractFileContext(extractFileContext),
-    m_extractFileContextInv(extractFileContextInv) {}
+    m_extractFileContextInv(extractFileContextInv),
+    m_sorter(sorter) {}
   void Run();
+
+  //! take ownership of the sentence, for tasks run by a thread pool
+  void OwnSentence() {
+    m_ownedSentence.reset(&m_sentence);
+  }
 private:
   vector< string > m_extractedPhrases;
   vector< string > m_extractedPhrasesInv;
@@ -97,6 +109,7 @@ private:
   void extractBase();
   void extract();
   void addPhrase(int, int, int, int, const std::string &);
+  void addPackedPhrase(int, int, int, int, const std::string &);
   void writePhrasesToFile();
   bool checkPlaceholders(int startE, int endE, int startF, int endF) const;
   bool isPlaceholder(const string &word) const;
@@ -120,6 +133,15 @@ private:
   Moses::OutputFileStream &m_extractFileOrientation;
   Moses::OutputFileStream &m_extractFileContext;
   Moses::OutputFileStream &m_extractFileContextInv;
+
+  // --Sort: phrase pairs are packed into records instead of text
+  PhrasePairSorter *m_sorter;
+  vector< WORD_ID > m_sourceIds;
+  vector< WORD_ID > m_targetIds;
+  vector< uint8_t > m_packedPhrases;
+  vector< uint8_t > m_packedPhrasesOri;
+
+  boost::scoped_ptr<SentenceAlignmentWithSyntax> m_ownedSentence;
 };
 }
 
@@ -131,7 +153,8 @@ int main(int argc, char* argv[])
   if (argc < 6) {
     cerr << "syntax: extract en de align extract max-length [orientation [ --model [wbe|phrase|hier]-[msd|mslr|mono] ] ";
     cerr << "| --OnlyOutputSpanInfo | --NoTTable | --GZOutput | --IncludeSentenceId | --SentenceOffset n | --InstanceWeights filename ";
-    cerr << "| --TargetConstituentConstrained | --TargetConstituentBoundaries ]" << std::endl;
+    cerr << "| --TargetConstituentConstrained | --TargetConstituentBoundaries ";
+    cerr << "| --Sort [--SortMemory MB] [--SortTempPrefix prefix] [--Threads n] ]" << std::endl;
     exit(1);
   }
 
@@ -145,6 +168,12 @@ int main(int argc, char* argv[])
   const char* const &fileNameA = argv[3];
   const string fileNameExtract = string(argv[4]);
   PhraseExtractionOptions options(atoi(argv[5]));
+  bool sortFlag = false;
+  size_t sortMemory = 1024;
+  string sortTempPrefix = fileNameExtract + ".tmp";
+#ifdef WITH_THREADS
+  int thread_count = 1;
+#endif
 
   for(int i=6; i<argc; i++) {
     if (strcmp(argv[i],"--OnlyOutputSpanInfo") == 0) {
@@ -232,6 +261,33 @@ int main(int argc, char* argv[])
       }
 
       options.initAllModelsOutputFlag(true);
+    } else if (strcmp(argv[i], "--Sort") == 0) {
+      sortFlag = true;
+    } else if (strcmp(argv[i], "--SortMemory") == 0) {
+      if (i+1 >= argc || argv[i+1][0] < '0' || argv[i+1][0] > '9') {
+        cerr << "extract: syntax error, used switch --SortMemory without a number" << endl;
+        exit(1);
+      }
+      sortMemory = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--SortTempPrefix") == 0) {
+      if (i+1 >= argc) {
+        cerr << "extract: syntax error, used switch --SortTempPrefix without a prefix" << endl;
+        exit(1);
+      }
+      sortTempPrefix = argv[++i];
+    } else if (strcmp(argv[i],"-threads") == 0 ||
+               strcmp(argv[i],"--threads") == 0 ||
+               strcmp(argv[i],"--Threads") == 0) {
+      if (i+1 >= argc || argv[i+1][0] < '0' || argv[i+1][0] > '9') {
+        cerr << "extract: syntax error, used switch " << argv[i] << " without a number" << endl;
+        exit(1);
+      }
+#ifdef WITH_THREADS
+      thread_count = atoi(argv[++i]);
+#else
+      ++i;
+      cerr << "WARNING: thread support not compiled in, extracting with 1 thread" << endl;
+#endif
     } else if (strcmp(argv[i], "--Placeholders") == 0) {
       ++i;
       string str = argv[i];
@@ -249,6 +305,34 @@ int main(int argc, char* argv[])
     options.initWordType(REO_MSD);
   }
 
+  // extract straight into sorted files, extract.sorted etc.
+  // Only the plain text formats can be packed for sorting
+  boost::scoped_ptr<PhrasePairSorter> sorter;
+  if (sortFlag) {
+    if (options.isOnlyOutputSpanInfo() || options.isFlexScoreFlag() || options.debug ||
+        options.getInstanceWeightsFile().length() ||
+        options.isTargetConstituentBoundariesFlag() || options.isTargetConstituentConstrainedFlag()) {
+      cerr << "extract: --Sort does not support --OnlyOutputSpanInfo, --FlexibilityScore, --Debug, "
+           << "--InstanceWeights or target constituent options" << endl;
+      exit(1);
+    }
+    sorter.reset(new PhrasePairSorter(fileNameExtract, options.isGzOutput(), options.maxPhraseLength,
+                                      options.isTranslationFlag(), options.isOrientationFlag(),
+                                      options.isIncludeSentenceIdFlag(),
+                                      sortMemory << 20, sortTempPrefix));
+  }
+#ifdef WITH_THREADS
+  if (thread_count > 1 && !sorter) {
+    cerr << "extract: --Threads requires --Sort" << endl;
+    exit(1);
+  }
+  boost::scoped_ptr<Moses::ThreadPool> pool;
+  if (sorter && thread_count > 1) {
+    pool.reset(new Moses::ThreadPool(thread_count));
+    pool->SetQueueLimit(thread_count * 100);
+  }
+#endif
+
   // open input files
   Moses::InputFileStream eFile(fileNameE);
   Moses::InputFileStream fFile(fileNameF);
@@ -266,12 +350,14 @@ int main(int argc, char* argv[])
   }
 
   // open output files
-  if (options.isTranslationFlag()) {
+  if (sorter) {
+    // written by PhrasePairSorter::Finish()
+  } else if (options.isTranslationFlag()) {
     string fileNameExtractInv = fileNameExtract + ".inv" + (options.isGzOutput()?".gz":"");
     extractFile.Open( (fileNameExtract + (options.isGzOutput()?".gz":"")).c_str());
     extractFileInv.Open(fileNameExtractInv.c_str());
   }
-  if (options.isOrientationFlag()) {
+  if (options.isOrientationFlag() && !sorter) {
     string fileNameExtractOrientation = fileNameExtract + ".o" + (options.isGzOutput()?".gz":"");
     extractFileOrientation.Open(fileNameExtractOrientation.c_str());
   }
@@ -302,10 +388,12 @@ int main(int argc, char* argv[])
       getline(*iwFileP, weightString);
     }
 
-    SentenceAlignmentWithSyntax sentence
+    // heap allocated so that a pooled task can own it
+    SentenceAlignmentWithSyntax *sentenceP = new SentenceAlignmentWithSyntax
     (targetLabelCollection, sourceLabelCollection,
      targetTopLabelCollection, sourceTopLabelCollection,
      targetSyntax, false);
+    SentenceAlignmentWithSyntax &sentence = *sentenceP;
     // cout << "read in: " << englishString << " & " << foreignString << " & " << alignmentString << endl;
     //az: output src, tgt, and alingment line
     if (options.isOnlyOutputSpanInfo()) {
@@ -322,10 +410,19 @@ int main(int argc, char* argv[])
       if (options.placeholders.size()) {
         sentence.invertAlignment();
       }
-      ExtractTask *task = new ExtractTask(i-1, sentence, options, extractFile , extractFileInv, extractFileOrientation, extractFileContext, extractFileContextInv);
-      task->Run();
-      delete task;
-
+      ExtractTask *task = new ExtractTask(i-1, sentence, options, extractFile , extractFileInv, extractFileOrientation, extractFileContext, extractFileContextInv, sorter.get());
+      task->OwnSentence();
+#ifdef WITH_THREADS
+      if (pool) {
+        pool->Submit(boost::shared_ptr<Moses::Task>(task));
+      } else
+#endif
+      {
+        task->Run();
+        delete task;
+      }
+    } else {
+      delete sentenceP;
     }
     if (options.isOnlyOutputSpanInfo()) cout << "LOG: PHRASES_END:" << endl; //az: mark end of phrases
   }
@@ -334,8 +431,18 @@ int main(int argc, char* argv[])
   fFile.Close();
   aFile.Close();
 
+#ifdef WITH_THREADS
+  if (pool) {
+    pool->Stop(true);
+  }
+#endif
+  if (sorter) {
+    cerr << endl << "sorting";
+    sorter->Finish();
+  }
+
   //az: only close if we actually opened it
-  if (!options.isOnlyOutputSpanInfo()) {
+  if (!options.isOnlyOutputSpanInfo() && !sorter) {
     if (options.isTranslationFlag()) {
       extractFile.Close();
       extractFileInv.Close();
@@ -359,6 +466,22 @@ namespace MosesTraining
 {
 void ExtractTask::Run()
 {
+  if (m_sorter) {
+    m_sourceIds.clear();
+    m_targetIds.clear();
+    for (size_t i = 0; i < m_sentence.source.size(); ++i) {
+      m_sourceIds.push_back(m_sorter->StoreWord(m_sentence.source[i]));
+    }
+    for (size_t i = 0; i < m_sentence.target.size(); ++i) {
+      m_targetIds.push_back(m_sorter->StoreWord(m_sentence.target[i]));
+    }
+    extract();
+    if (!m_packedPhrases.empty()) m_sorter->AddTranslations(m_packedPhrases);
+    if (!m_packedPhrasesOri.empty()) m_sorter->AddOrientations(m_packedPhrasesOri);
+    m_packedPhrases.clear();
+    m_packedPhrasesOri.clear();
+    return;
+  }
   extract();
   writePhrasesToFile();
   m_extractedPhrases.clear();
@@ -891,6 +1014,11 @@ void ExtractTask::addPhrase( int startE, int endE, int startF, int endF,
     return;
   }
 
+  if (m_sorter) {
+    addPackedPhrase(startE, endE, startF, endF, orientationInfo);
+    return;
+  }
+
   ostringstream outextractstr;
   ostringstream outextractstrInv;
   ostringstream outextractstrOrientation;
@@ -1040,6 +1168,52 @@ void ExtractTask::addPhrase( int startE, int endE, int startF, int endF,
 }
 
 
+// same content as the lines addPhrase() writes, packed for PhrasePairSorter
+void ExtractTask::addPackedPhrase( int startE, int endE, int startF, int endF,
+                                   const std::string &orientationInfo)
+{
+  const PhrasePairLayout &layout = m_sorter->GetLayout();
+  vector< uint8_t > &packed = m_options.isTranslationFlag() ? m_packedPhrases : m_packedPhrasesOri;
+  size_t offset = packed.size();
+  packed.resize(offset + layout.EntrySize(), 0);
+  void *record = &packed[offset];
+
+  PhrasePairLayout::Header &header = PhrasePairLayout::GetHeader(record);
+  header.sentenceId = m_sentence.sentenceID;
+  header.orientation = m_options.isOrientationFlag() ? m_sorter->StoreOrientation(orientationInfo) : 0;
+  header.sourceLength = endF - startF + 1;
+  header.targetLength = endE - startE + 1;
+
+  WORD_ID *words = PhrasePairLayout::GetWords(record);
+  words = std::copy(m_sourceIds.begin() + startF, m_sourceIds.begin() + endF + 1, words);
+  std::copy(m_targetIds.begin() + startE, m_targetIds.begin() + endE + 1, words);
+
+  uint8_t *alignment = layout.GetAlignment(record);
+  size_t alignmentLength = 0;
+  if (m_options.isSingleWordHeuristicFlag() && (startE==endE) && (startF==endF)) {
+    alignment[0] = alignment[1] = 0;
+    alignmentLength = 1;
+  } else {
+    for(int ei=startE; ei<=endE; ei++) {
+      for(unsigned int i=0; i<m_sentence.alignedToT[ei].size(); i++) {
+        if (alignmentLength == layout.MaxAlignmentLength()) {
+          cerr << "extract: too many alignment points in sentence " << m_sentence.sentenceID << " for --Sort" << endl;
+          exit(1);
+        }
+        int fi = m_sentence.alignedToT[ei][i];
+        alignment[2 * alignmentLength] = fi-startF;
+        alignment[2 * alignmentLength + 1] = ei-startE;
+        ++alignmentLength;
+      }
+    }
+  }
+  header.alignmentLength = alignmentLength;
+
+  if (m_options.isTranslationFlag() && m_options.isOrientationFlag()) {
+    m_packedPhrasesOri.insert(m_packedPhrasesOri.end(), packed.begin() + offset, packed.end());
+  }
+}
+
 void ExtractTask::writePhrasesToFile()
 {
 
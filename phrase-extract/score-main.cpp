@@ -26,6 +26,7 @@
 #include <vector>
 #include <algorithm>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
 
 #include "ScoreFeature.h"
@@ -34,8 +35,12 @@
 #include "score.h"
 #include "InputFileStream.h"
 #include "OutputFileStream.h"
+#include "TaskError.h"
 
+#include "moses/OutputCollector.h"
+#include "moses/ThreadPool.h"
 #include "moses/Util.h"
+#include "util/string_piece.hh"
 
 using namespace boost::algorithm;
 using namespace MosesTraining;
@@ -96,6 +101,12 @@ std::vector<float> orientationClassPriorsR2L(4,0); // mono swap dleft dright
 Vocabulary vcbT;
 Vocabulary vcbS;
 
+#ifdef WITH_THREADS
+// guards the count of counts and the label sets and counts above,
+// which all chunks add to when scoring with several threads
+boost::mutex aggregatesMutex;
+#endif
+
 } // namespace
 
 
@@ -104,6 +115,14 @@ void processLine( std::string line,
                   PHRASE *phraseSource, PHRASE *phraseTarget, ALIGNMENT *targetToSourceAlignment,
                   std::string &additionalPropertiesString,
                   float &count, float &pcfgSum );
+void scoreExtract( std::istream &extractFile, std::ostream &phraseTableFile,
+                   const ScoreFeatureManager &featureManager, const MaybeLog &maybeLogProb,
+                   int lineOffset );
+#ifdef WITH_THREADS
+void scoreExtractParallel( std::istream &extractFile, std::ostream &phraseTableFile,
+                           const ScoreFeatureManager &featureManager, const MaybeLog &maybeLogProb,
+                           size_t threadCount );
+#endif
 void writeCountOfCounts( const std::string &fileNameCountOfCounts );
 void writeLeftHandSideLabelCounts( const boost::unordered_map<std::string,float> &countsLabelLHS,
                                    const boost::unordered_map<std::string, boost::unordered_map<std::string,float>* > &jointCountsLabelLHS,
@@ -154,7 +173,8 @@ int main(int argc, char* argv[])
               "[--TargetSyntacticPreferences] "
               "[--UnpairedExtractFormat] "
               "[--ConditionOnTargetLHS] "
-              "[--CrossedNonTerm]"
+              "[--CrossedNonTerm] "
+              "[--Threads num]"
               << std::endl;
     std::cerr << featureManager.usage() << std::endl;
     exit(1);
@@ -172,6 +192,9 @@ int main(int argc, char* argv[])
   std::string fileNameLeftHandSideTargetSyntacticPreferencesLabelCounts;
   std::string fileNameLeftHandSideRuleTargetTargetSyntacticPreferencesLabelCounts;
   std::string fileNamePhraseOrientationPriors;
+#ifdef WITH_THREADS
+  size_t threadCount = 1;
+#endif
   // All unknown args are passed to feature manager.
   std::vector<std::string> featureArgs;
 
@@ -290,6 +313,18 @@ int main(int argc, char* argv[])
     } else if (strcmp(argv[i],"--TargetConstituentBoundaries") == 0) {
       targetConstituentBoundariesFlag = true;
       std::cerr << "including target constituent boundaries information" << std::endl;
+    } else if (strcmp(argv[i],"--Threads") == 0) {
+      if (i+1==argc) {
+        std::cerr << "ERROR: specify number of threads!" << std::endl;
+        exit(1);
+      }
+#ifdef WITH_THREADS
+      threadCount = std::max(1, std::atoi( argv[++i] ));
+      std::cerr << "scoring with " << threadCount << " threads" << std::endl;
+#else
+      ++i;
+      std::cerr << "WARNING: thread support not compiled in, scoring with 1 thread" << std::endl;
+#endif
     } else {
       featureArgs.push_back(argv[i]);
       ++i;
@@ -351,6 +386,58 @@ int main(int argc, char* argv[])
   }
 
   // loop through all extracted phrase translations
+#ifdef WITH_THREADS
+  if (threadCount > 1) {
+    scoreExtractParallel( extractFile, *phraseTableFile, featureManager, maybeLogProb, threadCount );
+  } else
+#endif
+  {
+    scoreExtract( extractFile, *phraseTableFile, featureManager, maybeLogProb, 0 );
+  }
+
+  // We've been printing progress dots to stderr.  End the line.
+  std::cerr << std::endl;
+
+  phraseTableFile->flush();
+  if (phraseTableFile != &std::cout) {
+    delete phraseTableFile;
+  }
+
+  // output count of count statistics
+  if (goodTuringFlag || kneserNeyFlag) {
+    writeCountOfCounts( fileNameCountOfCounts );
+  }
+
+  // source syntax labels
+  if (sourceSyntaxLabelsFlag && !inverseFlag) {
+    writeLabelSet( sourceLabelSet, fileNameSourceLabelSet );
+  }
+  if (sourceSyntaxLabelsFlag && sourceSyntaxLabelCountsLHSFlag && !inverseFlag) {
+    writeLeftHandSideLabelCounts( sourceLHSCounts,
+                                  targetLHSAndSourceLHSJointCounts,
+                                  fileNameLeftHandSideSourceLabelCounts,
+                                  fileNameLeftHandSideTargetSourceLabelCounts );
+  }
+
+  // parts-of-speech
+  if (partsOfSpeechFlag && !inverseFlag) {
+    writeLabelSet( partsOfSpeechSet, fileNamePartsOfSpeechSet );
+  }
+
+  // target syntactic preferences labels
+  if (targetSyntacticPreferencesFlag && !inverseFlag) {
+    writeLabelSet( targetSyntacticPreferencesLabelSet, fileNameTargetSyntacticPreferencesLabelSet );
+    writeLeftHandSideLabelCounts( targetSyntacticPreferencesLHSCounts,
+                                  ruleTargetLHSAndTargetSyntacticPreferencesLHSJointCounts,
+                                  fileNameLeftHandSideTargetSyntacticPreferencesLabelCounts,
+                                  fileNameLeftHandSideRuleTargetTargetSyntacticPreferencesLabelCounts );
+  }
+}
+
+void scoreExtract( std::istream &extractFile, std::ostream &phraseTableFile,
+                   const ScoreFeatureManager &featureManager, const MaybeLog &maybeLogProb,
+                   int lineOffset )
+{
   std::string line, lastLine;
   ExtractionPhrasePair *phrasePair = NULL;
   std::vector< ExtractionPhrasePair* > phrasePairsWithSameSource;
@@ -362,7 +449,7 @@ int main(int argc, char* argv[])
   std::string tmpAdditionalPropertiesString;
   float tmpCount=0.0f, tmpPcfgSum=0.0f;
 
-  int i=0;
+  int i=lineOffset;
   if ( getline(extractFile, line) ) {
     ++i;
     tmpPhraseSource = new PHRASE();
@@ -447,7 +534,7 @@ int main(int argc, char* argv[])
 
       if ( !phrasePairsWithSameSource.empty() &&
            !sourceMatch ) {
-        processPhrasePairs( phrasePairsWithSameSource, *phraseTableFile, featureManager, maybeLogProb );
+        processPhrasePairs( phrasePairsWithSameSource, phraseTableFile, featureManager, maybeLogProb );
         for ( std::vector< ExtractionPhrasePair* >::const_iterator iter=phrasePairsWithSameSource.begin();
               iter!=phrasePairsWithSameSource.end(); ++iter) {
           delete *iter;
@@ -479,53 +566,110 @@ int main(int argc, char* argv[])
 
   }
 
-  // We've been printing progress dots to stderr.  End the line.
-  std::cerr << std::endl;
-
-  processPhrasePairs( phrasePairsWithSameSource, *phraseTableFile, featureManager, maybeLogProb );
+  processPhrasePairs( phrasePairsWithSameSource, phraseTableFile, featureManager, maybeLogProb );
   for ( std::vector< ExtractionPhrasePair* >::const_iterator iter=phrasePairsWithSameSource.begin();
         iter!=phrasePairsWithSameSource.end(); ++iter) {
     delete *iter;
   }
   phrasePairsWithSameSource.clear();
+}
 
+#ifdef WITH_THREADS
+namespace
+{
 
-  phraseTableFile->flush();
-  if (phraseTableFile != &std::cout) {
-    delete phraseTableFile;
+// One chunk of the sorted extract, cut where the source phrase changes,
+// so that all phrase pairs with the same source are scored by one task.
+class ScoreTask : public Moses::Task
+{
+public:
+  ScoreTask( int chunkId, int lineOffset, std::string &extract,
+             Moses::OutputCollector &collector, TaskError &error,
+             const ScoreFeatureManager &featureManager, const MaybeLog &maybeLogProb )
+    : m_chunkId(chunkId)
+    , m_lineOffset(lineOffset)
+    , m_collector(collector)
+    , m_error(error)
+    , m_featureManager(featureManager)
+    , m_maybeLogProb(maybeLogProb) {
+    m_extract.swap(extract);
+  }
+
+  void Run() {
+    if (m_error.IsSet()) return;
+    try {
+      std::istringstream in(m_extract);
+      std::ostringstream out;
+      scoreExtract( in, out, m_featureManager, m_maybeLogProb, m_lineOffset );
+      std::string().swap(m_extract);
+      m_collector.Write( m_chunkId, out.str() );
+    } catch (...) {
+      m_error.SetCurrent();
+    }
   }
 
-  // output count of count statistics
-  if (goodTuringFlag || kneserNeyFlag) {
-    writeCountOfCounts( fileNameCountOfCounts );
-  }
+private:
+  int m_chunkId;
+  int m_lineOffset;
+  std::string m_extract;
+  Moses::OutputCollector &m_collector;
+  TaskError &m_error;
+  const ScoreFeatureManager &m_featureManager;
+  const MaybeLog &m_maybeLogProb;
+};
 
-  // source syntax labels
-  if (sourceSyntaxLabelsFlag && !inverseFlag) {
-    writeLabelSet( sourceLabelSet, fileNameSourceLabelSet );
-  }
-  if (sourceSyntaxLabelsFlag && sourceSyntaxLabelCountsLHSFlag && !inverseFlag) {
-    writeLeftHandSideLabelCounts( sourceLHSCounts,
-                                  targetLHSAndSourceLHSJointCounts,
-                                  fileNameLeftHandSideSourceLabelCounts,
-                                  fileNameLeftHandSideTargetSourceLabelCounts );
-  }
+// the grouping key of an extract line: everything before the first " ||| "
+StringPiece sourceOf( const std::string &line )
+{
+  size_t pos = line.find(" ||| ");
+  return StringPiece( line.data(), pos == std::string::npos ? line.size() : pos );
+}
 
-  // parts-of-speech
-  if (partsOfSpeechFlag && !inverseFlag) {
-    writeLabelSet( partsOfSpeechSet, fileNamePartsOfSpeechSet );
-  }
+}
 
-  // target syntactic preferences labels
-  if (targetSyntacticPreferencesFlag && !inverseFlag) {
-    writeLabelSet( targetSyntacticPreferencesLabelSet, fileNameTargetSyntacticPreferencesLabelSet );
-    writeLeftHandSideLabelCounts( targetSyntacticPreferencesLHSCounts,
-                                  ruleTargetLHSAndTargetSyntacticPreferencesLHSJointCounts,
-                                  fileNameLeftHandSideTargetSyntacticPreferencesLabelCounts,
-                                  fileNameLeftHandSideRuleTargetTargetSyntacticPreferencesLabelCounts );
+void scoreExtractParallel( std::istream &extractFile, std::ostream &phraseTableFile,
+                           const ScoreFeatureManager &featureManager, const MaybeLog &maybeLogProb,
+                           size_t threadCount )
+{
+  // lines per chunk, at least. A chunk is only cut where the source changes
+  const size_t chunkLines = 100000;
+
+  Moses::OutputCollector collector( &phraseTableFile );
+  TaskError error;
+  Moses::ThreadPool pool( threadCount );
+  // bounds the number of chunks held in memory
+  pool.SetQueueLimit( threadCount * 2 );
+
+  std::string line, lastSource, chunk;
+  size_t numLines = 0;
+  int chunkId = 0, lineOffset = 0, i = 0;
+  while ( !error.IsSet() && getline(extractFile, line) ) {
+    StringPiece source = sourceOf( line );
+    if ( numLines >= chunkLines && source != StringPiece(lastSource) ) {
+      boost::shared_ptr<Moses::Task> task(
+        new ScoreTask( chunkId++, lineOffset, chunk, collector, error, featureManager, maybeLogProb ) );
+      pool.Submit( task );
+      chunk.clear();
+      numLines = 0;
+      lineOffset = i;
+    }
+    if ( numLines == 0 || source != StringPiece(lastSource) ) {
+      lastSource.assign( source.data(), source.size() );
+    }
+    chunk += line;
+    chunk += '\n';
+    ++numLines;
+    ++i;
+  }
+  if ( numLines ) {
+    boost::shared_ptr<Moses::Task> task(
+      new ScoreTask( chunkId++, lineOffset, chunk, collector, error, featureManager, maybeLogProb ) );
+    pool.Submit( task );
   }
+  pool.Stop( true );
+  error.Rethrow();
 }
-
+#endif
 
 void processLine( std::string line,
                   int lineID, bool includeSentenceIdFlag, int &sentenceId,
@@ -725,6 +869,9 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
 
   // collect count of count statistics
   if (goodTuringFlag || kneserNeyFlag) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(aggregatesMutex);
+#endif
     totalDistinct++;
     int countInt = count + 0.99999;
     if ((countInt <= COC_MAX) &&
@@ -874,7 +1021,12 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
 
   // parts-of-speech
   if (partsOfSpeechFlag && !inverseFlag) {
-    phrasePair.UpdateVocabularyFromValueTokens("POS", partsOfSpeechSet);
+    {
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(aggregatesMutex);
+#endif
+      phrasePair.UpdateVocabularyFromValueTokens("POS", partsOfSpeechSet);
+    }
     const std::string *bestPartOfSpeech = phrasePair.FindBestPropertyValue("POS");
     if (bestPartOfSpeech) {
       phraseTableFile << " {{POS " << *bestPartOfSpeech << "}}";
@@ -891,6 +1043,9 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
     // source syntax labels
     if (sourceSyntaxLabelsFlag) {
       std::string sourceLabelCounts;
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(aggregatesMutex);
+#endif
       sourceLabelCounts = phrasePair.CollectAllLabelsSeparateLHSAndRHS("SourceLabels",
                           sourceLabelSet,
                           sourceLHSCounts,
@@ -908,6 +1063,9 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
     // target syntactic preferences labels
     if (targetSyntacticPreferencesFlag) {
       std::string targetSyntacticPreferencesLabelCounts;
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(aggregatesMutex);
+#endif
       targetSyntacticPreferencesLabelCounts = phrasePair.CollectAllLabelsSeparateLHSAndRHS("TargetPreferences",
                                               targetSyntacticPreferencesLabelSet,
                                               targetSyntacticPreferencesLHSCounts,
@@ -1,5 +1,7 @@
 // $Id$
 //#include "beammain.h"
+#include <boost/functional/hash.hpp>
+
 #include "util/tokenize.hh"
 #include "tables-core.h"
 
@@ -11,23 +13,53 @@ using namespace std;
 namespace MosesTraining
 {
 
+Vocabulary::Vocabulary()
+  : m_blocks( MaxBlocks, NULL )
+  , m_size( 0 )
+{
+}
+
+Vocabulary::~Vocabulary()
+{
+  for( size_t i = 0; i < m_blocks.size() && m_blocks[i]; ++i )
+    delete [] m_blocks[i];
+}
+
 WORD_ID Vocabulary::storeIfNew( const WORD& word )
 {
-  map<WORD, WORD_ID>::iterator i = lookup.find( word );
+  Shard &shard = m_shards[ boost::hash_value( word ) % NumShards ];
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock( shard.mutex );
+#endif
+  map<WORD, WORD_ID>::iterator i = shard.lookup.find( word );
 
-  if( i != lookup.end() )
+  if( i != shard.lookup.end() )
     return i->second;
 
-  WORD_ID id = vocab.size();
-  vocab.push_back( word );
-  lookup[ word ] = id;
+  WORD_ID id;
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock storeLock( m_storeMutex );
+#endif
+    id = m_size++;
+    WORD *&block = m_blocks[ id >> BlockBits ];
+    if( block == NULL )
+      block = new WORD[ BlockSize ];
+    block[ id & (BlockSize - 1) ] = word;
+  }
+  // other threads only learn about id through this shard, after the unlock
+  shard.lookup[ word ] = id;
   return id;
 }
 
 WORD_ID Vocabulary::getWordID( const WORD& word )
 {
-  map<WORD, WORD_ID>::iterator i = lookup.find( word );
-  if( i == lookup.end() )
+  Shard &shard = m_shards[ boost::hash_value( word ) % NumShards ];
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock( shard.mutex );
+#endif
+  map<WORD, WORD_ID>::iterator i = shard.lookup.find( word );
+  if( i == shard.lookup.end() )
     return 0;
   return i->second;
 }
@@ -10,24 +10,58 @@
 #include <string>
 #include <queue>
 #include <map>
+#include <vector>
 #include <cmath>
 
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
 namespace MosesTraining
 {
 
 typedef std::string WORD;
 typedef unsigned int WORD_ID;
 
+// storeIfNew() and getWordID() may be called from several threads at once,
+// e.g. by score --Threads. Words are kept in blocks that never move, so
+// getWord() does not need a lock.
 class Vocabulary
 {
 public:
-  std::map<WORD, WORD_ID>  lookup;
-  std::vector< WORD > vocab;
+  Vocabulary();
+  ~Vocabulary();
   WORD_ID storeIfNew( const WORD& );
   WORD_ID getWordID( const WORD& );
   inline WORD &getWord( const WORD_ID id ) {
-    return vocab[ id ];
+    return m_blocks[ id >> BlockBits ][ id & (BlockSize - 1) ];
   }
+
+private:
+  enum {
+    NumShards = 64,
+    BlockBits = 16,
+    BlockSize = 1 << BlockBits,
+    MaxBlocks = 1 << 16
+  };
+
+  struct Shard {
+#ifdef WITH_THREADS
+    boost::mutex mutex;
+#endif
+    std::map<WORD, WORD_ID> lookup;
+  };
+
+  Shard m_shards[NumShards];
+  std::vector< WORD* > m_blocks;
+#ifdef WITH_THREADS
+  boost::mutex m_storeMutex;
+#endif
+  WORD_ID m_size;
+
+  // no copying: the blocks are owned
+  Vocabulary(const Vocabulary&);
+  Vocabulary &operator=(const Vocabulary&);
 };
 
 typedef std::vector< WORD_ID > PHRASE;
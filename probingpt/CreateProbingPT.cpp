@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <string>
 #include <boost/program_options.hpp>
 #include "util/usage.hh"
@@ -18,6 +19,7 @@ int main(int argc, char* argv[])
   bool log_prob = false;
   bool scfg = false;
   int max_cache_size = 50000;
+  size_t threads = 1;
 
   namespace po = boost::program_options;
   po::options_description desc("Options");
@@ -30,6 +32,7 @@ int main(int argc, char* argv[])
   ("log-prob", "log (and floor) probabilities before storing")
   ("max-cache-size", po::value<int>()->default_value(max_cache_size), "Maximum number of high-count source lines to write to cache file. 0=no cache, negative=no limit")
   ("scfg", "Rules are SCFG in Moses format (ie. with non-terms and LHS")
+  ("threads", po::value<size_t>()->default_value(threads), "Number of threads storing rules")
 
   ;
 
@@ -60,15 +63,16 @@ int main(int argc, char* argv[])
   if (vm.count("max-cache-size")) max_cache_size = vm["max-cache-size"].as<int>();
   if (vm.count("log-prob")) log_prob = true;
   if (vm.count("scfg")) scfg = true;
+  if (vm.count("threads")) threads = std::max<size_t>(vm["threads"].as<size_t>(), 1);
 
 
   if (scfg) {
     inPath = ReformatSCFGFile(inPath);
   }
 
-  probingpt::createProbingPT(inPath, outPath, num_scores, num_lex_scores, log_prob, max_cache_size, scfg);
+  probingpt::createProbingPT(inPath, outPath, num_scores, num_lex_scores, log_prob, max_cache_size, scfg, threads);
 
-  //util::PrintUsage(std::cout);
+  util::PrintUsage(std::cerr);
   return 0;
 }
 
@@ -16,35 +16,89 @@ using namespace std;
 namespace probingpt
 {
 
-StoreTarget::StoreTarget(const std::string &basepath)
+namespace
+{
+// bound the per-thread caches of target words and alignments
+const size_t MAX_CACHE_SIZE = 1000000;
+}
+
+TargetFiles::TargetFiles(const std::string &basepath)
   :m_basePath(basepath)
+  ,m_size(0)
   ,m_vocab(basepath + "/TargetVocab.dat")
 {
   std::string path = basepath + "/TargetColl.dat";
-  m_fileTargetColl.open(path.c_str(),
-                        std::ios::out | std::ios::binary | std::ios::ate | std::ios::trunc);
-  if (!m_fileTargetColl.is_open()) {
-    throw "can't create file ";
+  m_fileTargetColl.reset(util::CreateOrThrow(path.c_str()));
+}
+
+TargetFiles::~TargetFiles()
+{
+  // vocab
+  m_vocab.Save();
+}
+
+uint32_t TargetFiles::GetVocabId(const std::string &word)
+{
+  boost::mutex::scoped_lock lock(m_vocabMutex);
+  return m_vocab.GetVocabId(word);
+}
+
+uint32_t TargetFiles::GetAlignId(const std::vector<size_t> &align)
+{
+  boost::mutex::scoped_lock lock(m_alignMutex);
+  Alignments::iterator iter = m_aligns.find(align);
+  if (iter == m_aligns.end()) {
+    uint32_t ind = m_aligns.size();
+    m_aligns[align] = ind;
+    return ind;
+  } else {
+    return iter->second;
   }
+}
 
+uint64_t TargetFiles::Write(const void *data, size_t size)
+{
+  // threads write their buffers concurrently, each at the range it reserved
+  uint64_t ret = m_size.fetch_add(size);
+  util::ErsatzPWrite(m_fileTargetColl.get(), data, size, ret);
+  return ret;
+}
+
+void TargetFiles::SaveAlignment()
+{
+  std::string path = m_basePath + "/Alignments.dat";
+  probingpt::OutputFileStream file(path);
+
+  BOOST_FOREACH(Alignments::value_type &valPair, m_aligns) {
+    file << valPair.second << "\t";
+
+    const std::vector<size_t> &aligns = valPair.first;
+    BOOST_FOREACH(size_t align, aligns) {
+      file << align << " ";
+    }
+    file << endl;
+  }
+
+}
+
+///////////////////////////////////////////////////////////////////////
+StoreTarget::StoreTarget(TargetFiles &files)
+  :m_files(files)
+{
 }
 
 StoreTarget::~StoreTarget()
 {
   assert(m_coll.empty());
-  m_fileTargetColl.close();
-
-  // vocab
-  m_vocab.Save();
 }
 
 uint64_t StoreTarget::Save()
 {
-  uint64_t ret = m_fileTargetColl.tellp();
+  uint64_t ret = m_buffer.size();
 
-  // save to disk
+  // save to buffer
   uint64_t numTP = m_coll.size();
-  m_fileTargetColl.write((char*) &numTP, sizeof(uint64_t));
+  m_buffer.append((char*) &numTP, sizeof(uint64_t));
 
   for (size_t i = 0; i < m_coll.size(); ++i) {
     Save(*m_coll[i]);
@@ -58,6 +112,13 @@ uint64_t StoreTarget::Save()
   return ret;
 }
 
+uint64_t StoreTarget::Flush()
+{
+  uint64_t ret = m_files.Write(m_buffer.data(), m_buffer.size());
+  m_buffer.clear();
+  return ret;
+}
+
 void StoreTarget::Save(const target_text &rule)
 {
   // metadata for each tp
@@ -68,41 +129,24 @@ void StoreTarget::Save(const target_text &rule)
   tpInfo.propLength = rule.property.size();
 
   //cerr << "TPInfo=" << sizeof(TPInfo);
-  m_fileTargetColl.write((char*) &tpInfo, sizeof(TargetPhraseInfo));
+  m_buffer.append((char*) &tpInfo, sizeof(TargetPhraseInfo));
 
   // scores
   for (size_t i = 0; i < rule.prob.size(); ++i) {
     float prob = rule.prob[i];
-    m_fileTargetColl.write((char*) &prob, sizeof(prob));
+    m_buffer.append((char*) &prob, sizeof(prob));
   }
 
   // tp
   for (size_t i = 0; i < rule.target_phrase.size(); ++i) {
     uint32_t vocabId = rule.target_phrase[i];
-    m_fileTargetColl.write((char*) &vocabId, sizeof(vocabId));
+    m_buffer.append((char*) &vocabId, sizeof(vocabId));
   }
 
   // prop TODO
 
 }
 
-void StoreTarget::SaveAlignment()
-{
-  std::string path = m_basePath + "/Alignments.dat";
-  probingpt::OutputFileStream file(path);
-
-  BOOST_FOREACH(Alignments::value_type &valPair, m_aligns) {
-    file << valPair.second << "\t";
-
-    const std::vector<size_t> &aligns = valPair.first;
-    BOOST_FOREACH(size_t align, aligns) {
-      file << align << " ";
-    }
-    file << endl;
-  }
-
-}
-
 void StoreTarget::Append(const line_text &line, bool log_prob, bool scfg)
 {
   target_text *rule = new target_text;
@@ -134,7 +178,7 @@ void StoreTarget::Append(const line_text &line, bool log_prob, bool scfg)
       StringPiece factor = *itFactor;
 
       string factorStr = factor.as_string();
-      uint32_t vocabId = m_vocab.GetVocabId(factorStr);
+      uint32_t vocabId = GetVocabId(factorStr);
 
       rule->target_phrase.push_back(vocabId);
 
@@ -217,12 +261,30 @@ void StoreTarget::Append(const line_text &line, bool log_prob, bool scfg)
   m_coll.push_back(rule);
 }
 
+uint32_t StoreTarget::GetVocabId(const std::string &word)
+{
+  boost::unordered_map<std::string, uint32_t>::iterator iter =
+    m_vocab.find(word);
+  if (iter == m_vocab.end()) {
+    if (m_vocab.size() >= MAX_CACHE_SIZE) {
+      m_vocab.clear();
+    }
+    uint32_t ind = m_files.GetVocabId(word);
+    m_vocab[word] = ind;
+    return ind;
+  } else {
+    return iter->second;
+  }
+}
+
 uint32_t StoreTarget::GetAlignId(const std::vector<size_t> &align)
 {
-  boost::unordered_map<std::vector<size_t>, uint32_t>::iterator iter =
-    m_aligns.find(align);
+  Alignments::iterator iter = m_aligns.find(align);
   if (iter == m_aligns.end()) {
-    uint32_t ind = m_aligns.size();
+    if (m_aligns.size() >= MAX_CACHE_SIZE) {
+      m_aligns.clear();
+    }
+    uint32_t ind = m_files.GetAlignId(align);
     m_aligns[align] = ind;
     return ind;
   } else {
@@ -11,6 +11,9 @@
 #include <inttypes.h>
 #include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include "util/file.hh"
 #include "StoreVocab.h"
 
 namespace probingpt
@@ -19,26 +22,64 @@ namespace probingpt
 class line_text;
 class target_text;
 
+/** The files of the target side, shared by all threads of createProbingPT:
+ * TargetColl.dat, the target vocabulary and the alignments. Thread-safe.
+ */
+class TargetFiles
+{
+public:
+  TargetFiles(const std::string &basepath);
+  virtual ~TargetFiles();
+
+  uint32_t GetVocabId(const std::string &word);
+  uint32_t GetAlignId(const std::vector<size_t> &align);
+
+  //! reserve size bytes at the end of TargetColl.dat, write data there and return the offset
+  uint64_t Write(const void *data, size_t size);
+
+  void SaveAlignment();
+
+protected:
+  std::string m_basePath;
+  util::scoped_fd m_fileTargetColl;
+  boost::atomic<uint64_t> m_size;
+
+  boost::mutex m_vocabMutex;
+  StoreVocab<uint32_t> m_vocab;
+
+  typedef boost::unordered_map<std::vector<size_t>, uint32_t> Alignments;
+  boost::mutex m_alignMutex;
+  Alignments m_aligns;
+};
+
+/** Collects the target phrases of one source phrase at a time and encodes
+ * them into a buffer, which Flush() writes to TargetColl.dat in one piece.
+ * One per thread. Vocabulary and alignment ids are cached, so that the lock
+ * of TargetFiles is only taken for words the thread has not seen yet.
+ */
 class StoreTarget
 {
 public:
-  StoreTarget(const std::string &basepath);
+  StoreTarget(TargetFiles &files);
   virtual ~StoreTarget();
 
+  //! encode the collected target phrases, return their position in the buffer
   uint64_t Save();
-  void SaveAlignment();
+  //! write the buffer, return the offset of its start in TargetColl.dat
+  uint64_t Flush();
 
   void Append(const line_text &line, bool log_prob, bool scfg);
 protected:
-  std::string m_basePath;
-  std::fstream m_fileTargetColl;
-  StoreVocab<uint32_t> m_vocab;
+  TargetFiles &m_files;
+  std::string m_buffer;
 
+  boost::unordered_map<std::string, uint32_t> m_vocab;
   typedef boost::unordered_map<std::vector<size_t>, uint32_t> Alignments;
   Alignments m_aligns;
 
   std::vector<target_text*> m_coll;
 
+  uint32_t GetVocabId(const std::string &word);
   uint32_t GetAlignId(const std::vector<size_t> &align);
   void Save(const target_text &rule);
 
@@ -5,7 +5,8 @@
 #include "StoreTarget.h"
 #include "StoreVocab.h"
 #include "moses2/legacy/Util2.h"
-#include "InputFileStream.h"
+#include "util/thread_pool.hh"
+#include "util/usage.hh"
 
 using namespace std;
 
@@ -13,59 +14,280 @@ namespace probingpt
 {
 
 ///////////////////////////////////////////////////////////////////////
-void Node::Add(Table &table, const SourcePhrase &sourcePhrase, size_t pos)
+ShardedTable::ShardedTable(char *mem, size_t size)
+  :m_table(mem, size)
+  ,m_begin(reinterpret_cast<Entry*>(mem))
+  ,m_buckets(size / sizeof(Entry))
+  ,m_entries(0)
 {
-  if (pos < sourcePhrase.size()) {
-    uint64_t vocabId = sourcePhrase[pos];
-
-    Node *child;
-    Children::iterator iter = m_children.find(vocabId);
-    if (iter == m_children.end()) {
-      // New node. Write other children then discard them
-      BOOST_FOREACH(Children::value_type &valPair, m_children) {
-        Node &otherChild = valPair.second;
-        otherChild.Write(table);
+  // a probe rarely runs further than a few buckets, so large shards keep
+  // almost every entry in its own shard
+  m_shardSize = std::min<size_t>(m_buckets, 1 << 16);
+  m_locks.reset(new boost::mutex[(m_buckets + m_shardSize - 1) / m_shardSize]);
+}
+
+void ShardedTable::Insert(const Entry &entry)
+{
+  size_t shard = (m_table.Ideal(entry.key) - m_begin) / m_shardSize;
+  Entry *end = m_begin + std::min(m_buckets, (shard + 1) * m_shardSize);
+
+  bool placed;
+  {
+    boost::mutex::scoped_lock lock(m_locks[shard]);
+    placed = Insert(entry, end);
+  }
+  if (!placed) {
+    boost::mutex::scoped_lock lock(m_overflowMutex);
+    m_overflow.push_back(entry);
+  }
+}
+
+void ShardedTable::InsertPrefix(uint64_t key)
+{
+  Entry entry;
+  entry.key = key;
+  entry.value = NONE;
+  Insert(entry);
+}
+
+void ShardedTable::Finish()
+{
+  for (size_t i = 0; i < m_overflow.size(); ++i) {
+    Insert(m_overflow[i], NULL);
+  }
+  m_overflow.clear();
+}
+
+// probe from the ideal bucket up to end, or through the whole table if end
+// is NULL. Return false if the probe reached end first
+bool ShardedTable::Insert(const Entry &entry, Entry *end)
+{
+  for (Entry *i = m_table.Ideal(entry.key); i != end; ) {
+    if (i->key == 0) {
+      UTIL_THROW_IF2(++m_entries >= m_buckets,
+                     "Hash table with " << m_buckets << " buckets is full");
+      *i = entry;
+      return true;
+    }
+    if (i->key == entry.key) {
+      if (entry.value == NONE) {
+        // the key is there already, with or without rules
+        return true;
+      }
+      if (i->value == NONE) {
+        i->value = entry.value;
+        return true;
+      }
+      // different source phrase with the same key. Keep both, as Table::Insert() would
+    }
+    if (++i == m_begin + m_buckets) {
+      if (end) {
+        return false;
+      }
+      i = m_begin;
+    }
+  }
+  return false;
+}
+
+///////////////////////////////////////////////////////////////////////
+namespace
+{
+
+//! source phrase of a phrase table line, as splitLine() returns it
+StringPiece GetSourcePhrase(const StringPiece &line)
+{
+  return Trim(*util::TokenIter<util::MultiCharacter>(line, util::MultiCharacter("|||")));
+}
+
+//! lines of whole source phrases, so that each source phrase is stored by one thread
+struct Batch {
+  std::string text;
+  bool first; // starts the phrase table
+};
+
+typedef std::priority_queue<CacheItem*, std::vector<CacheItem*>, CacheItemOrderer> Cache;
+
+//! what the threads of createProbingPT() share
+struct StoreShared {
+  StoreShared(const std::string &basepath, char *mem, size_t size)
+    :targetFiles(basepath)
+    ,sourceEntries(mem, size)
+    ,sourceVocab(basepath + "/source_vocabids")
+    ,totalSourceCount(0)
+  {}
+
+  bool log_prob;
+  bool scfg;
+  int max_cache_size;
+
+  TargetFiles targetFiles;
+  ShardedTable sourceEntries;
+
+  boost::mutex sourceVocabMutex;
+  StoreVocab<uint64_t> sourceVocab;
+
+  boost::mutex cacheMutex;
+  Cache cache;
+  float totalSourceCount;
+};
+
+/** Stores the target phrases of a batch, and adds its source phrases to the
+ * hash table, the source vocabulary and the cache. One per thread.
+ */
+class StoreBatch
+{
+public:
+  typedef Batch *Request;
+
+  explicit StoreBatch(StoreShared *shared)
+    :m_shared(*shared)
+    ,m_storeTarget(shared->targetFiles)
+  {}
+
+  void operator()(Batch *batch);
+
+private:
+  StoreShared &m_shared;
+  StoreTarget m_storeTarget;
+
+  // reused between batches
+  std::vector<Entry> m_entries;
+  std::vector<uint64_t> m_prefixes;
+  boost::unordered_map<uint64_t, std::string> m_sourceWords;
+  std::vector<CacheItem*> m_cache;
+  float m_sourceCount;
+
+  void AddSource(const StringPiece &source);
+  void AddCache(const line_text &line);
+};
+
+void StoreBatch::operator()(Batch *batch)
+{
+  m_entries.clear();
+  m_prefixes.clear();
+  m_sourceWords.clear();
+  m_cache.clear();
+  m_sourceCount = 0;
+
+  StringPiece prevSource;
+  for (util::TokenIter<util::SingleCharacter, true> it(batch->text, util::SingleCharacter('\n')); it; ++it) {
+    line_text line = splitLine(*it, m_shared.scfg);
+
+    if (line.source_phrase != prevSource) {
+      if (!prevSource.empty()) {
+        AddSource(prevSource);
+      }
+
+      // the cache is updated from the 1st line of each source phrase but the first
+      if (!prevSource.empty() || !batch->first) {
+        AddCache(line);
+      }
+      prevSource = line.source_phrase;
+    }
+    m_storeTarget.Append(line, m_shared.log_prob, m_shared.scfg);
+  }
+  if (!prevSource.empty()) {
+    AddSource(prevSource);
+  }
+
+  // the positions of the target phrases are relative to the buffer until now
+  uint64_t offset = m_storeTarget.Flush();
+  for (size_t i = 0; i < m_entries.size(); ++i) {
+    m_entries[i].value += offset;
+    m_shared.sourceEntries.Insert(m_entries[i]);
+  }
+  for (size_t i = 0; i < m_prefixes.size(); ++i) {
+    m_shared.sourceEntries.InsertPrefix(m_prefixes[i]);
+  }
+
+  {
+    boost::mutex::scoped_lock lock(m_shared.sourceVocabMutex);
+    for (boost::unordered_map<uint64_t, std::string>::const_iterator iter = m_sourceWords.begin();
+         iter != m_sourceWords.end(); ++iter) {
+      m_shared.sourceVocab.Insert(iter->first, iter->second);
+    }
+  }
+
+  if (!m_cache.empty()) {
+    boost::mutex::scoped_lock lock(m_shared.cacheMutex);
+    m_shared.totalSourceCount += m_sourceCount;
+    for (size_t i = 0; i < m_cache.size(); ++i) {
+      m_shared.cache.push(m_cache[i]);
+      if (m_shared.max_cache_size > 0 && m_shared.cache.size() > m_shared.max_cache_size) {
+        delete m_shared.cache.top();
+        m_shared.cache.pop();
       }
-      m_children.clear();
-
-      // create new node
-      child = &m_children[vocabId];
-      assert(!child->done);
-      child->key = key + (vocabId << pos);
-    } else {
-      child = &iter->second;
     }
+  }
+
+  delete batch;
+}
+
+void StoreBatch::AddSource(const StringPiece &source)
+{
+  //Create an entry for the source phrase:
+  Entry sourceEntry;
+  sourceEntry.value = m_storeTarget.Save();
+  //The key is the sum of hashes of individual words bitshifted by their position in the phrase.
+  //Probably not entirerly correct, but fast and seems to work fine in practise.
+  std::vector<uint64_t> vocabid_source = getVocabIDs(source);
+  sourceEntry.key = getKey(vocabid_source);
+  m_entries.push_back(sourceEntry);
+
+  if (m_shared.scfg) {
+    // prefixes, so that the decoder knows which longer source phrases to look up
+    for (size_t endPos = 0; endPos + 1 < vocabid_source.size(); ++endPos) {
+      m_prefixes.push_back(getKey(CreatePrefix(vocabid_source, endPos)));
+    }
+  }
 
-    child->Add(table, sourcePhrase, pos + 1);
-  } else {
-    // this node was written previously 'cos it has rules
-    done = true;
+  //Add source phrases to vocabularyIDs
+  for (util::TokenIter<util::SingleCharacter> itWord(source, util::SingleCharacter(' ')); itWord; ++itWord) {
+    for (util::TokenIter<util::SingleCharacter> itFactor(*itWord, util::SingleCharacter('|')); itFactor; ++itFactor) {
+      uint64_t hash = getHash(*itFactor);
+      if (m_sourceWords.find(hash) == m_sourceWords.end()) {
+        m_sourceWords[hash] = itFactor->as_string();
+      }
+    }
   }
 }
 
-void Node::Write(Table &table)
+void StoreBatch::AddCache(const line_text &line)
 {
-  //cerr << "START write " << done << " " << key << endl;
-  BOOST_FOREACH(Children::value_type &valPair, m_children) {
-    Node &child = valPair.second;
-    child.Write(table);
+  if (!m_shared.max_cache_size) {
+    return;
   }
 
-  if (!done) {
-    // save
-    Entry sourceEntry;
-    sourceEntry.value = NONE;
-    sourceEntry.key = key;
+  std::string countStr = line.counts.as_string();
+  countStr = Moses2::Trim(countStr);
+  if (!countStr.empty()) {
+    std::vector<float> toks = Moses2::Tokenize<float>(countStr);
+    //cerr << "CACHE:" << line.source_phrase << " " << countStr << " " << toks[1] << endl;
+
+    if (toks.size() >= 2) {
+      m_sourceCount += toks[1];
 
-    //Put into table
-    table.Insert(sourceEntry);
+      // compute key for CURRENT source
+      std::vector<uint64_t> currVocabidSource = getVocabIDs(line.source_phrase);
+      uint64_t currKey = getKey(currVocabidSource);
+
+      CacheItem *item = new CacheItem(
+        Moses2::Trim(line.source_phrase.as_string()),
+        currKey,
+        toks[1]);
+      m_cache.push_back(item);
+    }
   }
 }
 
+}
+
 ///////////////////////////////////////////////////////////////////////
 void createProbingPT(const std::string &phrasetable_path,
                      const std::string &basepath, int num_scores, int num_lex_scores,
-                     bool log_prob, int max_cache_size, bool scfg)
+                     bool log_prob, int max_cache_size, bool scfg,
+                     size_t num_threads)
 {
 #if defined(_WIN32) || defined(_WIN64)
   std::cerr << "Create not implemented for Windows" << std::endl;
@@ -75,153 +297,69 @@ void createProbingPT(const std::string &phrasetable_path,
   //Get basepath and create directory if missing
   mkdir(basepath.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
 
-  StoreTarget storeTarget(basepath);
-
-  //Get uniq lines:
-  unsigned long uniq_entries = countUniqueSource(phrasetable_path);
-
-  //Source phrase vocabids
-  StoreVocab<uint64_t> sourceVocab(basepath + "/source_vocabids");
-
-  //Read the file
-  util::FilePiece filein(phrasetable_path.c_str());
+  //Get uniq lines, and the prefixes stored for SCFG rules:
+  unsigned long uniq_entries = countUniqueSource(phrasetable_path, scfg);
 
   //Init the probing hash table
   size_t size = Table::Size(uniq_entries, 1.2);
   char * mem = new char[size];
   memset(mem, 0, size);
-  Table sourceEntries(mem, size);
 
-  std::priority_queue<CacheItem*, std::vector<CacheItem*>, CacheItemOrderer> cache;
-  float totalSourceCount = 0;
+  StoreShared shared(basepath, mem, size);
+  shared.log_prob = log_prob;
+  shared.scfg = scfg;
+  shared.max_cache_size = max_cache_size;
 
-  //Keep track of the size of each group of target phrases
+  //Read the file, in batches of whole source phrases
+  util::FilePiece filein(phrasetable_path.c_str());
+  const size_t batchSize = 1 << 22;
   size_t line_num = 0;
+  double start = util::WallTime();
+  {
+    util::ThreadPool<StoreBatch> pool(2 * num_threads, num_threads, &shared, NULL);
 
-  //Read everything and processs
-  std::string prevSource;
-
-  Node sourcePhrases;
-  sourcePhrases.done = true;
-  sourcePhrases.key = 0;
-
-  while (true) {
+    Batch *batch = new Batch;
+    batch->first = true;
+    std::string prevSource;
     try {
-      //Process line read
-      line_text line;
-      line = splitLine(filein.ReadLine(), scfg);
-      //cerr << "line=" << line.source_phrase << endl;
-
-      ++line_num;
-      if (line_num % 1000000 == 0) {
-        std::cerr << line_num << " " << std::flush;
-      }
-
-      //Add source phrases to vocabularyIDs
-      add_to_map(sourceVocab, line.source_phrase);
-
-      if (prevSource.empty()) {
-        // 1st line
-        prevSource = line.source_phrase.as_string();
-        storeTarget.Append(line, log_prob, scfg);
-      } else if (prevSource == line.source_phrase) {
-        //If we still have the same line, just append to it:
-        storeTarget.Append(line, log_prob, scfg);
-      } else {
-        assert(prevSource != line.source_phrase);
-
-        //Create a new entry even
-
-        // save
-        uint64_t targetInd = storeTarget.Save();
-
-        // next line
-        storeTarget.Append(line, log_prob, scfg);
-
-        //Create an entry for the previous source phrase:
-        Entry sourceEntry;
-        sourceEntry.value = targetInd;
-        //The key is the sum of hashes of individual words bitshifted by their position in the phrase.
-        //Probably not entirerly correct, but fast and seems to work fine in practise.
-        std::vector<uint64_t> vocabid_source = getVocabIDs(prevSource);
-        if (scfg) {
-          // storing prefixes?
-          sourcePhrases.Add(sourceEntries, vocabid_source);
+      while (true) {
+        StringPiece line = filein.ReadLine();
+        StringPiece source = GetSourcePhrase(line);
+        if (batch->text.size() >= batchSize && source != prevSource) {
+          pool.Produce(batch);
+          batch = new Batch;
+          batch->first = false;
         }
-        sourceEntry.key = getKey(vocabid_source);
-
-        /*
-        cerr << "prevSource=" << prevSource << flush
-            << " vocabids=" << Debug(vocabid_source) << flush
-            << " key=" << sourceEntry.key << endl;
-        */
-        //Put into table
-        sourceEntries.Insert(sourceEntry);
-
-        // update cache - CURRENT source phrase, not prev
-        if (max_cache_size) {
-          std::string countStr = line.counts.as_string();
-          countStr = Moses2::Trim(countStr);
-          if (!countStr.empty()) {
-            std::vector<float> toks = Moses2::Tokenize<float>(countStr);
-            //cerr << "CACHE:" << line.source_phrase << " " << countStr << " " << toks[1] << endl;
-
-            if (toks.size() >= 2) {
-              totalSourceCount += toks[1];
-
-              // compute key for CURRENT source
-              std::vector<uint64_t> currVocabidSource = getVocabIDs(line.source_phrase.as_string());
-              uint64_t currKey = getKey(currVocabidSource);
-
-              CacheItem *item = new CacheItem(
-                Moses2::Trim(line.source_phrase.as_string()),
-                currKey,
-                toks[1]);
-              cache.push(item);
-
-              if (max_cache_size > 0 && cache.size() > max_cache_size) {
-                cache.pop();
-              }
-            }
-          }
+        if (source != prevSource) {
+          prevSource.assign(source.data(), source.size());
         }
+        batch->text.append(line.data(), line.size());
+        batch->text += '\n';
 
-        //Set prevLine
-        prevSource = line.source_phrase.as_string();
+        ++line_num;
+        if (line_num % 1000000 == 0) {
+          std::cerr << line_num << " " << std::flush;
+        }
       }
-
-    } catch (util::EndOfFileException e) {
+    } catch (const util::EndOfFileException &e) {
       std::cerr
           << "Reading phrase table finished, writing remaining files to disk."
           << std::endl;
-
-      //After the final entry is constructed we need to add it to the phrase_table
-      //Create an entry for the previous source phrase:
-      uint64_t targetInd = storeTarget.Save();
-
-      Entry sourceEntry;
-      sourceEntry.value = targetInd;
-
-      //The key is the sum of hashes of individual words. Probably not entirerly correct, but fast
-      std::vector<uint64_t> vocabid_source = getVocabIDs(prevSource);
-      sourceEntry.key = getKey(vocabid_source);
-
-      //Put into table
-      sourceEntries.Insert(sourceEntry);
-
-      break;
     }
+    pool.Produce(batch);
   }
+  std::cerr << "Stored " << line_num << " rules in "
+            << (util::WallTime() - start) << " s with " << num_threads << " threads" << std::endl;
 
-  sourcePhrases.Write(sourceEntries);
+  shared.sourceEntries.Finish();
 
-  storeTarget.SaveAlignment();
+  shared.targetFiles.SaveAlignment();
 
   serialize_table(mem, size, (basepath + "/probing_hash.dat"));
 
-  sourceVocab.Save();
+  shared.sourceVocab.Save();
 
-  serialize_cache(cache, (basepath + "/cache"), totalSourceCount);
+  serialize_cache(shared.cache, (basepath + "/cache"), shared.totalSourceCount);
 
   delete[] mem;
 
@@ -237,20 +375,46 @@ void createProbingPT(const std::string &phrasetable_path,
 #endif
 }
 
-size_t countUniqueSource(const std::string &path)
+size_t countUniqueSource(const std::string &path, bool scfg)
 {
   size_t ret = 0;
-  InputFileStream strme(path);
+  util::FilePiece strme(path.c_str());
 
-  std::string line, prevSource;
-  while (std::getline(strme, line)) {
-    std::vector<std::string> toks = Moses2::TokenizeMultiCharSeparator(line, "|||");
-    assert(toks.size() != 0);
-
-    if (prevSource != toks[0]) {
-      prevSource = toks[0];
+  std::string prevSource;
+  std::vector<StringPiece> words, prevWords;
+  try {
+    while (true) {
+      StringPiece source = GetSourcePhrase(strme.ReadLine());
+      if (ret != 0 && source == prevSource) {
+        continue;
+      }
       ++ret;
+
+      if (scfg) {
+        // prefixes not shared with the previous source phrase. Sorting keeps
+        // most shared prefixes together, so this bounds the prefix entries
+        words.clear();
+        for (util::TokenIter<util::SingleCharacter, true> it(source, util::SingleCharacter(' ')); it; ++it) {
+          words.push_back(*it);
+        }
+        size_t shared = 0;
+        while (shared < words.size() && shared < prevWords.size() && words[shared] == prevWords[shared]) {
+          ++shared;
+        }
+        if (words.size() > shared + 1) {
+          ret += words.size() - 1 - shared;
+        }
+      }
+
+      prevSource.assign(source.data(), source.size());
+      if (scfg) {
+        prevWords.clear();
+        for (util::TokenIter<util::SingleCharacter, true> it(prevSource, util::SingleCharacter(' ')); it; ++it) {
+          prevWords.push_back(*it);
+        }
+      }
     }
+  } catch (const util::EndOfFileException &e) {
   }
 
   return ret;
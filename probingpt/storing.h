@@ -8,8 +8,13 @@
 #include <iostream>
 #include <string>
 #include <queue>
+#include <vector>
 #include <sys/stat.h> //mkdir
 
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "hash.h" //Includes line_splitter
 #include "probing_hash_utils.h"
 #include "vocabid.h"
@@ -22,27 +27,44 @@ namespace probingpt
 typedef std::vector<uint64_t> SourcePhrase;
 
 
-class Node
+/** Fills the probing hash table from several threads. The buckets are split
+ * into shards, each with its own lock, and an entry is placed within the shard
+ * of its ideal bucket. The few entries whose probe runs past the end of their
+ * shard are kept and inserted by Finish(), once the other threads are done, so
+ * lookups find every entry just like after Table::Insert().
+ */
+class ShardedTable
 {
-  typedef boost::unordered_map<uint64_t, Node> Children;
-  Children m_children;
-
 public:
-  uint64_t key;
-  bool done;
+  ShardedTable(char *mem, size_t size);
 
-  Node()
-    :done(false)
-  {}
+  //! source phrase with rules. Replaces the entry of a prefix with the same key
+  void Insert(const Entry &entry);
 
-  void Add(Table &table, const SourcePhrase &sourcePhrase, size_t pos = 0);
-  void Write(Table &table);
-};
+  //! prefix of a source phrase without rules of its own, once per key
+  void InsertPrefix(uint64_t key);
+
+  //! insert the entries that did not fit into their shard. Not thread-safe
+  void Finish();
 
+private:
+  Table m_table;
+  Entry *m_begin;
+  size_t m_buckets;
+  size_t m_shardSize;
+  boost::scoped_array<boost::mutex> m_locks;
+  boost::atomic<uint64_t> m_entries;
+
+  boost::mutex m_overflowMutex;
+  std::vector<Entry> m_overflow;
+
+  bool Insert(const Entry &entry, Entry *end);
+};
 
 void createProbingPT(const std::string &phrasetable_path,
                      const std::string &basepath, int num_scores, int num_lex_scores,
-                     bool log_prob, int max_cache_size, bool scfg);
+                     bool log_prob, int max_cache_size, bool scfg,
+                     size_t num_threads = 1);
 uint64_t getKey(const std::vector<uint64_t> &source_phrase);
 
 std::vector<uint64_t> CreatePrefix(const std::vector<uint64_t> &vocabid_source, size_t endPos);
@@ -57,7 +79,7 @@ std::string Debug(const std::vector<T> &vec)
   return strm.str();
 }
 
-size_t countUniqueSource(const std::string &path);
+size_t countUniqueSource(const std::string &path, bool scfg);
 
 class CacheItem
 {